@@ -11,7 +11,15 @@
 #include "parsec/data_internal.h"
 #include "parsec/utils/debug.h"
 #include "parsec/papi_sde.h"
+#include "parsec/parsec_hwloc.h"
+#include "parsec/execution_stream.h"
 #include <limits.h>
+#if defined(PARSEC_HAVE_UNISTD_H)
+#include <unistd.h>
+#endif  /* defined(PARSEC_HAVE_UNISTD_H) */
+#if defined(PARSEC_HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif  /* defined(PARSEC_HAVE_SYS_MMAN_H) */
 
 #if defined(PARSEC_PROF_TRACE_ACTIVE_ARENA_SET)
 
@@ -52,8 +60,323 @@ extern int arena_memory_used_key, arena_memory_unused_key;
 
 #define PARSEC_ARENA_MIN_ALIGNMENT(align) ((ptrdiff_t)(align*((sizeof(parsec_arena_chunk_t)-1)/align+1)))
 
+/* Size of the allocation holding a chunk of count elements of the arena */
+#define PARSEC_ARENA_CHUNK_SIZE(arena, count)                           \
+    PARSEC_ALIGN((arena)->elem_size * (count) + (arena)->alignment + sizeof(parsec_arena_chunk_t), \
+                 (arena)->alignment, size_t)
+
+/*
+ * A chunk of memory the arena did not allocate, see parsec_arena_adopt_copy.
+ * Its size_class is PARSEC_ARENA_ADOPTED, and its release is delegated.
+ */
+#define PARSEC_ARENA_ADOPTED (-2)
+typedef struct parsec_arena_adopted_chunk_s {
+    parsec_arena_chunk_t   chunk;
+    parsec_arena_release_fn_t release;
+    void                  *cb_data;
+} parsec_arena_adopted_chunk_t;
+
 size_t parsec_arena_max_allocated_memory = SIZE_MAX;  /* unlimited */
 size_t parsec_arena_max_cached_memory    = 256*1024*1024; /* limited to 256MB */
+int    parsec_arena_size_classes         = 0;
+
+/*
+ * The size-class pool. Class 0 holds chunks of 2^MIN_SHIFT bytes, and
+ * each power of two (2^p, 2^(p+1)] is split in STEPS classes of
+ * 2^p * (STEPS + s) / STEPS bytes, s = 1..STEPS. The chunks larger than
+ * the last class are allocated by the arena as before.
+ */
+#define PARSEC_ARENA_SC_MIN_SHIFT  8
+#define PARSEC_ARENA_SC_MAX_SHIFT  30
+#define PARSEC_ARENA_SC_STEPS      4
+#define PARSEC_ARENA_SC_NB_CLASSES ((PARSEC_ARENA_SC_MAX_SHIFT - PARSEC_ARENA_SC_MIN_SHIFT) * PARSEC_ARENA_SC_STEPS + 1)
+#define PARSEC_ARENA_SC_HUGE_PAGE  ((size_t)2*1024*1024)
+/* Chunks in the first segment of a class, each new segment of the class
+ * doubles it until the segment fills a huge page */
+#define PARSEC_ARENA_SC_FIRST_CHUNKS 16
+
+typedef struct parsec_arena_sc_segment_s {
+    struct parsec_arena_sc_segment_s *next;
+    void                             *base;
+    size_t                            size;
+    int                               mapped;  /**< allocated with mmap (otherwise with posix_memalign) */
+} parsec_arena_sc_segment_t;
+
+typedef struct parsec_arena_sc_pool_s {
+    int                        nb_nodes;
+    parsec_lifo_t             *free;       /**< nb_nodes x PARSEC_ARENA_SC_NB_CLASSES free lists */
+    parsec_atomic_lock_t       lock;       /**< protects the creation of the segments */
+    parsec_arena_sc_segment_t *segments;
+    int                       *nb_segments; /**< segments cut for each free list */
+    volatile int32_t           in_use;     /**< chunks currently allocated from the pool */
+    volatile int64_t           cached;     /**< bytes of the free chunks whose pages are resident */
+    size_t                     page_size;
+    int                        no_hugetlb; /**< explicit huge pages are not available */
+} parsec_arena_sc_pool_t;
+
+static parsec_arena_sc_pool_t * volatile parsec_arena_sc_pool = NULL;
+static parsec_atomic_lock_t parsec_arena_sc_init_lock = PARSEC_ATOMIC_UNLOCKED;
+
+static inline size_t parsec_arena_sc_size(int sc)
+{
+    int p, s;
+    if( 0 == sc ) return (size_t)1 << PARSEC_ARENA_SC_MIN_SHIFT;
+    p = PARSEC_ARENA_SC_MIN_SHIFT + (sc - 1) / PARSEC_ARENA_SC_STEPS;
+    s = (sc - 1) % PARSEC_ARENA_SC_STEPS + 1;
+    return ((size_t)1 << p) / PARSEC_ARENA_SC_STEPS * (PARSEC_ARENA_SC_STEPS + s);
+}
+
+/* Smallest class that holds size bytes, -1 if size is larger than the last class */
+static inline int parsec_arena_sc_class(size_t size)
+{
+    size_t step;
+    int p;
+    if( size <= ((size_t)1 << PARSEC_ARENA_SC_MIN_SHIFT) ) return 0;
+    if( size > ((size_t)1 << PARSEC_ARENA_SC_MAX_SHIFT) ) return -1;
+    for( p = PARSEC_ARENA_SC_MIN_SHIFT; ((size_t)2 << p) < size; p++ ) ;
+    step = ((size_t)1 << p) / PARSEC_ARENA_SC_STEPS;
+    return (p - PARSEC_ARENA_SC_MIN_SHIFT) * PARSEC_ARENA_SC_STEPS +
+        (int)((size - ((size_t)1 << p) + step - 1) / step);
+}
+
+static parsec_arena_sc_pool_t *parsec_arena_sc_pool_get(void)
+{
+    parsec_arena_sc_pool_t *pool = parsec_arena_sc_pool;
+    int i;
+
+    if( NULL != pool ) return pool;
+    parsec_atomic_lock(&parsec_arena_sc_init_lock);
+    if( NULL == (pool = parsec_arena_sc_pool) ) {
+        pool = (parsec_arena_sc_pool_t*)calloc(1, sizeof(parsec_arena_sc_pool_t));
+        pool->nb_nodes = parsec_hwloc_nb_numa_nodes();
+        pool->free = (parsec_lifo_t*)malloc(pool->nb_nodes * PARSEC_ARENA_SC_NB_CLASSES * sizeof(parsec_lifo_t));
+        for( i = 0; i < pool->nb_nodes * PARSEC_ARENA_SC_NB_CLASSES; i++ )
+            PARSEC_OBJ_CONSTRUCT(&pool->free[i], parsec_lifo_t);
+        pool->nb_segments = (int*)calloc(pool->nb_nodes * PARSEC_ARENA_SC_NB_CLASSES, sizeof(int));
+#if defined(PARSEC_HAVE_UNISTD_H)
+        pool->page_size = (size_t)sysconf(_SC_PAGESIZE);
+#else
+        pool->page_size = 4096;
+#endif  /* defined(PARSEC_HAVE_UNISTD_H) */
+        parsec_atomic_lock_init(&pool->lock);
+        parsec_atomic_wmb();
+        parsec_arena_sc_pool = pool;
+    }
+    parsec_atomic_unlock(&parsec_arena_sc_init_lock);
+    return pool;
+}
+
+/*
+ * Allocates size bytes. If huge, size is a multiple of the huge page size
+ * and the memory is aligned on a huge page; otherwise size is a multiple
+ * of the page size.
+ */
+static void *parsec_arena_sc_map(parsec_arena_sc_pool_t *pool, size_t size, int huge, int *mapped)
+{
+    void *base = NULL;
+#if defined(PARSEC_HAVE_SYS_MMAN_H)
+    char *mem;
+    size_t head;
+
+    *mapped = 1;
+    if( !huge ) {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if( MAP_FAILED == base ) return NULL;
+#if defined(MADV_HUGEPAGE)
+        if( size >= PARSEC_ARENA_SC_HUGE_PAGE )
+            (void)madvise(base, size, MADV_HUGEPAGE);
+#endif  /* defined(MADV_HUGEPAGE) */
+        return base;
+    }
+#if defined(MAP_HUGETLB)
+    if( !pool->no_hugetlb ) {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if( MAP_FAILED != base ) return base;
+        /* No huge pages reserved, rely on the transparent huge pages */
+        pool->no_hugetlb = 1;
+    }
+#else
+    (void)pool;
+#endif  /* defined(MAP_HUGETLB) */
+    mem = (char*)mmap(NULL, size + PARSEC_ARENA_SC_HUGE_PAGE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if( MAP_FAILED == (void*)mem ) return NULL;
+    head = PARSEC_ALIGN_PAD_AMOUNT(mem, PARSEC_ARENA_SC_HUGE_PAGE);
+    if( 0 != head ) munmap(mem, head);
+    munmap(mem + head + size, PARSEC_ARENA_SC_HUGE_PAGE - head);
+    base = mem + head;
+#if defined(MADV_HUGEPAGE)
+    (void)madvise(base, size, MADV_HUGEPAGE);
+#endif  /* defined(MADV_HUGEPAGE) */
+#else
+    *mapped = 0;
+    if( 0 != posix_memalign(&base, huge ? PARSEC_ARENA_SC_HUGE_PAGE : pool->page_size, size) ) return NULL;
+#endif  /* defined(PARSEC_HAVE_SYS_MMAN_H) */
+    return base;
+}
+
+static void parsec_arena_sc_unmap(parsec_arena_sc_segment_t *segment)
+{
+#if defined(PARSEC_HAVE_SYS_MMAN_H)
+    if( segment->mapped ) {
+        munmap(segment->base, segment->size);
+        return;
+    }
+#endif  /* defined(PARSEC_HAVE_SYS_MMAN_H) */
+    free(segment->base);
+}
+
+/*
+ * Cuts a new segment, bound to the NUMA node numa_id, into chunks of
+ * class sc. Returns one chunk and pushes the others in the free list.
+ * The segments of a class hold PARSEC_ARENA_SC_FIRST_CHUNKS chunks, then
+ * twice as many each time, until they fill a huge page. A class that
+ * would leave more than an eighth of a huge page unused, or whose chunks
+ * do not fit twice in a huge page, uses segments of whole chunks instead.
+ * Called with the pool lock held.
+ */
+static parsec_arena_chunk_t *parsec_arena_sc_grow(parsec_arena_sc_pool_t *pool, int numa_id, int sc)
+{
+    size_t chunk_size = parsec_arena_sc_size(sc), size, offset, nb_chunks;
+    size_t per_huge_page = PARSEC_ARENA_SC_HUGE_PAGE / chunk_size;
+    int idx = numa_id * PARSEC_ARENA_SC_NB_CLASSES + sc, shift, huge = 0;
+    parsec_arena_sc_segment_t *segment;
+    parsec_arena_chunk_t *chunk = NULL;
+    char *base;
+    int mapped;
+
+    shift = (pool->nb_segments[idx] < 16) ? pool->nb_segments[idx] : 16;
+    nb_chunks = (size_t)PARSEC_ARENA_SC_FIRST_CHUNKS << shift;
+    if( per_huge_page < 2 ) {
+        nb_chunks = 1;
+    } else if( (nb_chunks >= per_huge_page) &&
+               ((PARSEC_ARENA_SC_HUGE_PAGE % chunk_size) <= PARSEC_ARENA_SC_HUGE_PAGE / 8) ) {
+        nb_chunks = per_huge_page;
+        huge = 1;
+    } else if( nb_chunks > per_huge_page ) {
+        nb_chunks = per_huge_page;
+    }
+    size = huge ? PARSEC_ARENA_SC_HUGE_PAGE : PARSEC_ALIGN(nb_chunks * chunk_size, pool->page_size, size_t);
+    if( NULL == (base = (char*)parsec_arena_sc_map(pool, size, huge, &mapped)) )
+        return NULL;
+    pool->nb_segments[idx]++;
+    /* Place the pages on the node of the requesting thread, and fault
+     * them now rather than on the first touch of each chunk */
+    if( pool->nb_nodes > 1 )
+        (void)parsec_hwloc_membind_numa(base, size, numa_id);
+    for( offset = 0; offset < size; offset += pool->page_size )
+        ((volatile char*)base)[offset] = 0;
+
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_ARENAS, size);
+
+    segment = (parsec_arena_sc_segment_t*)malloc(sizeof(parsec_arena_sc_segment_t));
+    segment->base = base;
+    segment->size = size;
+    segment->mapped = mapped;
+    segment->next = pool->segments;
+    pool->segments = segment;
+
+    for( offset = 0; offset + chunk_size <= size; offset += chunk_size ) {
+        parsec_arena_chunk_t *c = (parsec_arena_chunk_t*)(base + offset);
+        PARSEC_OBJ_CONSTRUCT(&c->item, parsec_list_item_t);
+        c->size_class = (int16_t)sc;
+        c->numa_id = (int16_t)numa_id;
+        if( NULL == chunk ) {
+            chunk = c;
+            continue;
+        }
+        c->resident = 1;
+        (void)parsec_atomic_fetch_add_int64(&pool->cached, (int64_t)chunk_size);
+        parsec_lifo_push(&pool->free[idx], &c->item);
+    }
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "Arena:\tnew segment of %zu bytes on NUMA node %d for %zu chunks of %zu bytes",
+                         size, numa_id, size / chunk_size, chunk_size);
+    return chunk;
+}
+
+/* Chunk of at least size bytes from the size-class pool, NULL if size has no class */
+static parsec_arena_chunk_t *parsec_arena_sc_get(size_t size)
+{
+    parsec_arena_sc_pool_t *pool = parsec_arena_sc_pool_get();
+    parsec_execution_stream_t *es = parsec_my_execution_stream();
+    int sc = parsec_arena_sc_class(size), numa_id = 0;
+    parsec_arena_chunk_t *chunk;
+    parsec_lifo_t *list;
+
+    if( sc < 0 ) return NULL;
+    if( (NULL != es) && (es->numa_id < pool->nb_nodes) )
+        numa_id = es->numa_id;
+    list = &pool->free[numa_id * PARSEC_ARENA_SC_NB_CLASSES + sc];
+    if( NULL == (chunk = (parsec_arena_chunk_t*)parsec_lifo_pop(list)) ) {
+        parsec_atomic_lock(&pool->lock);
+        if( NULL == (chunk = (parsec_arena_chunk_t*)parsec_lifo_pop(list)) )
+            chunk = parsec_arena_sc_grow(pool, numa_id, sc);
+        parsec_atomic_unlock(&pool->lock);
+        if( NULL == chunk ) return NULL;
+    } else if( chunk->resident ) {
+        (void)parsec_atomic_fetch_add_int64(&pool->cached, -(int64_t)parsec_arena_sc_size(sc));
+    }
+    (void)parsec_atomic_fetch_inc_int32(&pool->in_use);
+    return chunk;
+}
+
+/*
+ * Returns a chunk to the free list of its class and node. Beyond
+ * arena_max_cached bytes of free chunks in the pool, the pages of the
+ * chunk (except the one holding its header) are given back to the
+ * system; they are faulted again, on the same node, when the chunk is
+ * reused. The chunks smaller than a page cannot be trimmed.
+ */
+static void parsec_arena_sc_put(parsec_arena_chunk_t *chunk)
+{
+    parsec_arena_sc_pool_t *pool = parsec_arena_sc_pool;
+    size_t chunk_size = parsec_arena_sc_size(chunk->size_class);
+
+    chunk->resident = 1;
+    if( (size_t)parsec_atomic_fetch_add_int64(&pool->cached, (int64_t)chunk_size) + chunk_size
+        > parsec_arena_max_cached_memory ) {
+#if defined(PARSEC_HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED)
+        char *start = PARSEC_ALIGN_PTR((char*)chunk + sizeof(parsec_arena_chunk_t), pool->page_size, char*);
+        char *end = (char*)((uintptr_t)((char*)chunk + chunk_size) & ~((uintptr_t)pool->page_size - 1));
+        if( (start < end) && (0 == madvise(start, end - start, MADV_DONTNEED)) ) {
+            chunk->resident = 0;
+            (void)parsec_atomic_fetch_add_int64(&pool->cached, -(int64_t)chunk_size);
+        }
+#endif  /* defined(PARSEC_HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED) */
+    }
+    parsec_lifo_push(&pool->free[chunk->numa_id * PARSEC_ARENA_SC_NB_CLASSES + chunk->size_class], &chunk->item);
+    (void)parsec_atomic_fetch_dec_int32(&pool->in_use);
+}
+
+void parsec_arena_size_classes_fini(void)
+{
+    parsec_arena_sc_pool_t *pool = parsec_arena_sc_pool;
+    parsec_arena_sc_segment_t *segment;
+    int i;
+
+    if( NULL == pool ) return;
+    if( 0 != pool->in_use ) {
+        /* Keep the pool for the chunks that are still in use */
+        PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Arena:\t%d chunks of the size-class pool are still in use",
+                             pool->in_use);
+        return;
+    }
+    parsec_arena_sc_pool = NULL;
+    for( i = 0; i < pool->nb_nodes * PARSEC_ARENA_SC_NB_CLASSES; i++ ) {
+        /* The chunks live in the segments, just forget them */
+        while( NULL != parsec_lifo_pop(&pool->free[i]) ) ;
+        PARSEC_OBJ_DESTRUCT(&pool->free[i]);
+    }
+    free(pool->free);
+    free(pool->nb_segments);
+    while( NULL != (segment = pool->segments) ) {
+        pool->segments = segment->next;
+        PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_ARENAS, -(int64_t)segment->size);
+        parsec_arena_sc_unmap(segment);
+        free(segment);
+    }
+    free(pool);
+}
 
 
 int parsec_arena_construct_ex(parsec_arena_t* arena,
@@ -81,6 +404,7 @@ int parsec_arena_construct_ex(parsec_arena_t* arena,
     arena->max_used     = (max_allocated_memory / elem_size > (size_t)INT32_MAX)? INT32_MAX: max_allocated_memory / elem_size;
     arena->released     = 0;
     arena->max_released = (max_cached_memory / elem_size > (size_t)INT32_MAX)? INT32_MAX: max_cached_memory / elem_size;
+    arena->size_classes = parsec_arena_size_classes;
     arena->data_malloc  = parsec_data_allocate;
     arena->data_free    = parsec_data_free;
     return PARSEC_SUCCESS;
@@ -112,6 +436,7 @@ static void parsec_arena_destructor(parsec_arena_t* arena)
             PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "Arena:\tfree element base ptr %p, data ptr %p (from arena %p)",
                                 item, ((parsec_arena_chunk_t*)item)->data, arena);
             TRACE_FREE(arena_memory_free_key, -arena->elem_size, item);
+            PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_ARENAS, -(int64_t)PARSEC_ARENA_CHUNK_SIZE(arena, 1));
             arena->data_free(item);
         }
         PARSEC_OBJ_DESTRUCT(&arena->area_lifo);
@@ -141,9 +466,15 @@ parsec_arena_get_chunk( parsec_arena_t *arena, size_t size, parsec_data_allocate
         if( size < sizeof( parsec_list_item_t ) )
             size = sizeof( parsec_list_item_t );
         item = (parsec_list_item_t *)alloc( size );
+        if( NULL == item ) {
+            if(arena->max_used != INT32_MAX)
+                (void)parsec_atomic_fetch_dec_int32(&arena->used);
+            return NULL;
+        }
         TRACE_MALLOC(arena_memory_alloc_key, size, item);
+        PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_ARENAS, size);
         PARSEC_OBJ_CONSTRUCT(item, parsec_list_item_t);
-        assert(NULL != item);
+        ((parsec_arena_chunk_t*)item)->size_class = -1;
     }
     PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Arena:\tpop a data of size %zu from arena %p, aligned by %zu, base ptr %p, data ptr %p, sizeof prefix %zu(%zd)",
                 arena->elem_size, arena, arena->alignment, item, ((parsec_arena_chunk_t*)item)->data, sizeof(parsec_arena_chunk_t),
@@ -155,8 +486,25 @@ static void
 parsec_arena_release_chunk(parsec_arena_t* arena,
                           parsec_arena_chunk_t *chunk)
 {
+    if( PARSEC_ARENA_ADOPTED == chunk->size_class ) {
+        parsec_arena_adopted_chunk_t *adopted = (parsec_arena_adopted_chunk_t*)chunk;
+        PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Arena:\trelease an adopted tile of size %zu x %zu from arena %p, data ptr %p",
+                arena->elem_size, chunk->count, arena, chunk->data);
+        adopted->release(adopted->cb_data);
+        free(adopted);
+        return;
+    }
     TRACE_FREE(arena_memory_unused_key, -arena->elem_size*chunk->count, chunk);
 
+    if( chunk->size_class >= 0 ) {
+        PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Arena:\treturn a tile of size %zu x %zu from arena %p to the size class %d of NUMA node %d, base ptr %p, data ptr %p",
+                arena->elem_size, chunk->count, arena, chunk->size_class, chunk->numa_id, chunk, chunk->data);
+        TRACE_FREE(arena_memory_free_key, -arena->elem_size*chunk->count, chunk);
+        if(arena->max_used != INT32_MAX)
+            (void)parsec_atomic_fetch_sub_int32(&arena->used, chunk->count);
+        parsec_arena_sc_put(chunk);
+        return;
+    }
     if( (chunk->count == 1) && (arena->released < arena->max_released) ) {
         PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Arena:\tpush a data of size %zu from arena %p, aligned by %zu, base ptr %p, data ptr %p, sizeof prefix %zu(%zd)",
                 arena->elem_size, arena, arena->alignment, chunk, chunk->data, sizeof(parsec_arena_chunk_t),
@@ -171,11 +519,41 @@ parsec_arena_release_chunk(parsec_arena_t* arena,
             arena->elem_size, chunk->count, arena, arena->alignment, chunk, chunk->data, sizeof(parsec_arena_chunk_t),
             PARSEC_ARENA_MIN_ALIGNMENT(arena->alignment));
     TRACE_FREE(arena_memory_free_key, -arena->elem_size*chunk->count, chunk);
-    if(arena->max_used != 0 && arena->max_used != INT32_MAX)
+    if(arena->max_used != INT32_MAX)
         (void)parsec_atomic_fetch_sub_int32(&arena->used, chunk->count);
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_ARENAS, -(int64_t)PARSEC_ARENA_CHUNK_SIZE(arena, chunk->count));
     arena->data_free(chunk);
 }
 
+/*
+ * Takes a chunk for count elements of the arena from the size-class pool.
+ * Leaves *pchunk to NULL if the pool cannot provide it (too large, or out
+ * of memory), the arena then allocates it as usual.
+ */
+static int parsec_arena_sc_allocate(parsec_arena_t *arena, size_t count,
+                                    parsec_arena_chunk_t **pchunk, size_t *psize)
+{
+    size_t size = PARSEC_ALIGN(arena->elem_size * count + arena->alignment + sizeof(parsec_arena_chunk_t),
+                               arena->alignment, size_t);
+
+    if(arena->max_used != INT32_MAX) {
+        int32_t current = parsec_atomic_fetch_add_int32(&arena->used, count) + count;
+        if(current > arena->max_used) {
+            (void)parsec_atomic_fetch_sub_int32(&arena->used, count);
+            return PARSEC_ERR_OUT_OF_RESOURCE;
+        }
+    }
+    *pchunk = parsec_arena_sc_get(size);
+    if( NULL == *pchunk ) {
+        if(arena->max_used != INT32_MAX)
+            (void)parsec_atomic_fetch_sub_int32(&arena->used, count);
+        return PARSEC_SUCCESS;
+    }
+    TRACE_MALLOC(arena_memory_alloc_key, size, *pchunk);
+    *psize = size;
+    return PARSEC_SUCCESS;
+}
+
 int  parsec_arena_allocate_device_private(parsec_data_copy_t *copy,
                                           parsec_arena_t *arena,
                                           size_t count, int device,
@@ -188,7 +566,14 @@ int  parsec_arena_allocate_device_private(parsec_data_copy_t *copy,
     assert(device == copy->device_index);
     (void)device;
 
-    if( count == 1 ) {
+    chunk = NULL;
+    if( arena->size_classes && (parsec_data_allocate == arena->data_malloc) ) {
+        int rc = parsec_arena_sc_allocate(arena, count, &chunk, &size);
+        if( PARSEC_SUCCESS != rc ) return rc;
+    }
+    if( NULL != chunk ) {
+        /* the chunk comes from the size-class pool */
+    } else if( count == 1 ) {
         size = PARSEC_ALIGN(arena->elem_size + arena->alignment + sizeof(parsec_arena_chunk_t),
                             arena->alignment, size_t);
         chunk = (parsec_arena_chunk_t *)parsec_arena_get_chunk( arena, size, arena->data_malloc );
@@ -204,9 +589,16 @@ int  parsec_arena_allocate_device_private(parsec_data_copy_t *copy,
         size = PARSEC_ALIGN(arena->elem_size * count + arena->alignment + sizeof(parsec_arena_chunk_t),
                             arena->alignment, size_t);
         chunk = (parsec_arena_chunk_t*)arena->data_malloc(size);
+        if(NULL == chunk) {
+            if(arena->max_used != INT32_MAX)
+                (void)parsec_atomic_fetch_sub_int32(&arena->used, count);
+            return PARSEC_ERR_OUT_OF_RESOURCE;
+        }
         PARSEC_OBJ_CONSTRUCT(&chunk->item, parsec_list_item_t);
+        chunk->size_class = -1;
 
         TRACE_MALLOC(arena_memory_alloc_key, size, chunk);
+        PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_ARENAS, size);
     }
     if(NULL == chunk) return PARSEC_ERR_OUT_OF_RESOURCE;  /* no more */
 
@@ -268,6 +660,7 @@ parsec_data_copy_t *parsec_arena_get_copy(parsec_arena_t *arena,
     PARSEC_OBJ_RELEASE(data);
 
     if( PARSEC_SUCCESS != rc ) {
+        copy->flags &= ~PARSEC_DATA_FLAG_ARENA;  /* no chunk to give back */
         PARSEC_OBJ_RELEASE(copy);
         return NULL;
     }
@@ -275,6 +668,51 @@ parsec_data_copy_t *parsec_arena_get_copy(parsec_arena_t *arena,
     return copy;
 }
 
+parsec_data_copy_t *parsec_arena_adopt_copy(parsec_arena_t *arena,
+                                            void *ptr, size_t count, int device,
+                                            parsec_datatype_t dtt,
+                                            parsec_arena_release_fn_t release,
+                                            void *cb_data)
+{
+    parsec_arena_adopted_chunk_t *adopted;
+    parsec_data_t *data;
+    parsec_data_copy_t *copy;
+
+    assert(0 == (((uintptr_t)ptr) % arena->alignment));
+    adopted = (parsec_arena_adopted_chunk_t*)malloc(sizeof(parsec_arena_adopted_chunk_t));
+    if( NULL == adopted ) {
+        return NULL;
+    }
+    data = parsec_data_new();
+    if( NULL == data ) {
+        free(adopted);
+        return NULL;
+    }
+    data->nb_elts = count * arena->elem_size;
+    copy = parsec_data_copy_new( data, device, dtt,
+                                 PARSEC_DATA_FLAG_ARENA |
+                                 PARSEC_DATA_FLAG_PARSEC_OWNED |
+                                 PARSEC_DATA_FLAG_PARSEC_MANAGED);
+    /* The copy holds the data from now on, see parsec_arena_get_copy */
+    PARSEC_OBJ_RELEASE(data);
+    if(NULL == copy) {
+        free(adopted);
+        return NULL;
+    }
+
+    PARSEC_OBJ_CONSTRUCT(&adopted->chunk.item, parsec_list_item_t);
+    adopted->chunk.origin     = arena;
+    adopted->chunk.count      = count;
+    adopted->chunk.data       = ptr;
+    adopted->chunk.size_class = PARSEC_ARENA_ADOPTED;
+    adopted->release          = release;
+    adopted->cb_data          = cb_data;
+
+    copy->device_private = ptr;
+    copy->arena_chunk = &adopted->chunk;
+    return copy;
+}
+
 void parsec_arena_release(parsec_data_copy_t* copy)
 {
     parsec_data_t *data;
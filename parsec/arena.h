@@ -35,6 +35,12 @@ extern size_t parsec_arena_max_allocated_memory;
  */
 extern size_t parsec_arena_max_cached_memory;
 
+/**
+ * When not zero, the arenas constructed afterwards allocate their chunks
+ * from the size-class pool (see parsec_arena_t).
+ */
+extern int parsec_arena_size_classes;
+
 #define PARSEC_ALIGN(x,a,t) (((x)+((t)(a)-1)) & ~(((t)(a)-1)))
 #define PARSEC_ALIGN_PTR(x,a,t) ((t)PARSEC_ALIGN((uintptr_t)x, a, uintptr_t))
 #define PARSEC_ALIGN_PAD_AMOUNT(x,s) ((~((uintptr_t)(x))+1) & ((uintptr_t)(s)-1))
@@ -45,6 +51,20 @@ extern size_t parsec_arena_max_cached_memory;
  *
  * Typically, network messages and data generated by tasks
  * are stored into arenas.
+ *
+ * By default, an arena caches the released chunks of exactly elem_size
+ * bytes, and allocates and frees all the other chunks with data_malloc
+ * and data_free. In size-class mode (see parsec_arena_size_classes),
+ * the chunks of all sizes come from a pool shared by all the arenas
+ * that use the default allocator: the sizes are rounded up to one of
+ * four classes per power of two, and each NUMA node has a free list per
+ * class. A chunk is taken from the free list of the NUMA node of the
+ * requesting execution stream; when it is empty, a new segment, bound
+ * to this node and touched once, is cut into chunks of this class. The
+ * segments of a class grow up to a 2MB huge page. The segments are kept
+ * until the end of the process, and the chunks return to the free list
+ * of their node; beyond arena_max_cached bytes of free chunks in the
+ * pool, the memory of the released chunks is given back to the system.
  */
 struct parsec_arena_s {
     parsec_object_t       super;
@@ -57,6 +77,7 @@ struct parsec_arena_s {
     volatile int32_t      released;      /**< elements currently released but still cached in the freelist */
     int32_t               max_released;  /**< when more that max elements are released, they are really freed
                                           *   instead of joining the lifo */
+    int32_t               size_classes;  /**< chunks come from the size-class pool (if data_malloc is the default) */
     /** some host hardware requires special allocation functions (Cuda, pinning,
      *  Open CL, ...). Defaults are to use C malloc/free
      */
@@ -74,6 +95,9 @@ struct parsec_arena_chunk_s {
     uint32_t           count;    /**< Number of basic elements pointed by param in this chunck */
     parsec_arena_t    *origin;   /**< Arena in which this chunck should be released */
     void              *data;     /**< Actual data pointed by this chunck */
+    int16_t            size_class; /**< Class of the chunk in the size-class pool, -1 if it does not come from the pool */
+    int16_t            numa_id;  /**< NUMA node of the chunk in the size-class pool */
+    int16_t            resident; /**< In the free list of the size-class pool, the pages of the chunk are resident */
 };
 
 /* for SSE, 16 is mandatory, most cache are 64 bit aligned */
@@ -158,8 +182,43 @@ int  parsec_arena_allocate_device_private(parsec_data_copy_t *copy,
                                           size_t count, int device,
                                           parsec_datatype_t dtt);
 
+/**
+ * @brief Called with its cb_data when a copy created by
+ *   parsec_arena_adopt_copy is released.
+ */
+typedef void (*parsec_arena_release_fn_t)(void *cb_data);
+
+/**
+ * @brief Create a new data copy, as parsec_arena_get_copy, on the memory at
+ *   @p ptr instead of memory allocated by the arena. This memory must be
+ *   aligned as the arena requires, and hold @p count elements of the arena.
+ *   When the copy is released, @p release is called with @p cb_data instead
+ *   of giving the memory back to the arena.
+ *
+ * @param arena the arena of the elements
+ * @param ptr the memory of the elements
+ * @param count the number of elements
+ * @param device the device of the data copy (a CPU device)
+ * @param dtt the datatype associated with the data copy created
+ * @param release called when the copy is released
+ * @param cb_data the argument of @p release
+ * @return parsec_data_copy_t* the new data copy, or NULL if there is not
+ *   enough resource to create it (@p release is not called).
+ */
+parsec_data_copy_t *parsec_arena_adopt_copy(parsec_arena_t *arena,
+                                            void *ptr, size_t count, int device,
+                                            parsec_datatype_t dtt,
+                                            parsec_arena_release_fn_t release,
+                                            void *cb_data);
+
 void parsec_arena_release(parsec_data_copy_t* ptr);
 
+/**
+ * @brief Releases the memory of the size-class pool, if none of its chunks
+ *   is still in use. Called by parsec_fini.
+ */
+void parsec_arena_size_classes_fini(void);
+
 END_C_DECLS
 
 /** @} */
@@ -232,7 +232,11 @@ LIFO_STATIC_INLINE int parsec_lifo_nolock_is_empty( parsec_lifo_t* lifo ) {
     return (NULL == lifo->lifo_head.data.item);
 }
 
-#if defined(PARSEC_ATOMIC_HAS_ATOMIC_CAS_INT128)
+/*
+ * PARSEC_LIFO_LOCKED_POP selects the implementation used without a counted
+ * pointer on any architecture, so that the tests can exercise it.
+ */
+#if defined(PARSEC_ATOMIC_HAS_ATOMIC_CAS_INT128) && !defined(PARSEC_LIFO_LOCKED_POP)
 /* Add one element to the FIFO. Returns true if successful, false otherwise.
  */
 LIFO_STATIC_INLINE int
@@ -336,7 +340,7 @@ LIFO_STATIC_INLINE parsec_list_item_t* parsec_lifo_try_pop( parsec_lifo_t* lifo
     return NULL;
 }
 
-#elif defined(PARSEC_ATOMIC_HAS_ATOMIC_LLSC_PTR)
+#elif defined(PARSEC_ATOMIC_HAS_ATOMIC_LLSC_PTR) && !defined(PARSEC_LIFO_LOCKED_POP)
 
 LIFO_STATIC_INLINE void _parsec_lifo_release_cpu (void)
 {
@@ -451,19 +455,28 @@ LIFO_STATIC_INLINE parsec_list_item_t* parsec_lifo_try_pop( parsec_lifo_t* lifo
 
 #else /* defined(PARSEC_ATOMIC_HAS_ATOMIC_CAS_INT128) || defined(PARSEC_ATOMIC_HAS_ATOMIC_LLSC_PTR) */
 
-/* Add one element to the LIFO. We will return the last head of the list
- * to allow the upper level to detect if this element is the first one in the
- * list (if the list was empty before this operation).
+/* Without a counted pointer, the pops are serialized by a lock: an item
+ * cannot be popped and pushed back while another thread pops it, so the
+ * head can be updated with a pointer compare-and-swap, and the pushes
+ * do not need to take the lock.
  */
 LIFO_STATIC_INLINE void parsec_lifo_push(parsec_lifo_t *lifo,
                                     parsec_list_item_t *item)
 {
+#if defined(PARSEC_DEBUG_PARANOID)
+    assert( (uintptr_t)item % PARSEC_LIFO_ALIGNMENT(lifo) == 0 );
+#endif
     PARSEC_ITEM_ATTACH(lifo, item);
-    parsec_atomic_lock(&lifo->lifo_head.data.guard.lock);
-    parsec_list_item_t *next = (parsec_list_item_t *) lifo->lifo_head.data.item;
-    item->list_next = next;
-    lifo->lifo_head.data.item = item;
-    parsec_atomic_unlock(&lifo->lifo_head.data.guard.lock);
+
+    do {
+        parsec_list_item_t *next = (parsec_list_item_t *) lifo->lifo_head.data.item;
+
+        item->list_next = next;
+        parsec_atomic_wmb ();
+        if (parsec_atomic_cas_ptr(&lifo->lifo_head.data.item, next, item)) {
+            return;
+        }
+    } while (1);
 }
 
 LIFO_STATIC_INLINE void parsec_lifo_chain(parsec_lifo_t* lifo,
@@ -474,13 +487,34 @@ LIFO_STATIC_INLINE void parsec_lifo_chain(parsec_lifo_t* lifo,
 #endif
     PARSEC_ITEMS_ATTACH(lifo, ring);
 
-    parsec_atomic_lock(&lifo->lifo_head.data.guard.lock);
     parsec_list_item_t* tail = (parsec_list_item_t*) ring->list_prev;
 
-    parsec_list_item_t *next = (parsec_list_item_t*) lifo->lifo_head.data.item;
-    tail->list_next = next;
-    lifo->lifo_head.data.item = ring;
-    parsec_atomic_unlock(&lifo->lifo_head.data.guard.lock);
+    do {
+        parsec_list_item_t *next = (parsec_list_item_t*) lifo->lifo_head.data.item;
+
+        tail->list_next = next;
+        parsec_atomic_wmb ();
+        if (parsec_atomic_cas_ptr(&lifo->lifo_head.data.item, next, ring)) {
+            return;
+        }
+    } while (1);
+}
+
+/* Pops one element with the pop lock held */
+LIFO_STATIC_INLINE parsec_list_item_t *parsec_lifo_locked_pop(parsec_lifo_t* lifo)
+{
+    parsec_list_item_t *item;
+
+    do {
+        item = (parsec_list_item_t*)lifo->lifo_head.data.item;
+        if (NULL == item) {
+            return NULL;
+        }
+        parsec_atomic_rmb ();
+    } while (!parsec_atomic_cas_ptr(&lifo->lifo_head.data.item, item, (parsec_list_item_t*)item->list_next));
+    item->list_next = NULL;
+    PARSEC_ITEM_DETACH(item);
+    return item;
 }
 
 /* Retrieve one element from the LIFO. If we reach the NULL item then the LIFO
@@ -496,11 +530,7 @@ LIFO_STATIC_INLINE parsec_list_item_t *parsec_lifo_pop(parsec_lifo_t* lifo)
     }
 
     parsec_atomic_lock(&lifo->lifo_head.data.guard.lock);
-    if ((item = lifo->lifo_head.data.item) != NULL) {
-        lifo->lifo_head.data.item = (parsec_list_item_t*)item->list_next;
-        item->list_next = NULL;
-        PARSEC_ITEM_DETACH(item);
-    }
+    item = parsec_lifo_locked_pop(lifo);
     parsec_atomic_unlock(&lifo->lifo_head.data.guard.lock);
     return item;
 }
@@ -517,12 +547,7 @@ LIFO_STATIC_INLINE parsec_list_item_t *parsec_lifo_try_pop(parsec_lifo_t* lifo)
     if (!parsec_atomic_trylock(&lifo->lifo_head.data.guard.lock)) {
         return NULL;
     }
-
-    if ((item = lifo->lifo_head.data.item) != NULL) {
-        lifo->lifo_head.data.item = (parsec_list_item_t*)item->list_next;
-        item->list_next = NULL;
-        PARSEC_ITEM_DETACH(item);
-    }
+    item = parsec_lifo_locked_pop(lifo);
     parsec_atomic_unlock(&lifo->lifo_head.data.guard.lock);
     return item;
 }
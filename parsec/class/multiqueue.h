@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#ifndef MULTIQUEUE_H_HAS_BEEN_INCLUDED
+#define MULTIQUEUE_H_HAS_BEEN_INCLUDED
+
+#include "parsec/parsec_config.h"
+#include "parsec/class/list_item.h"
+#include "parsec/sys/atomic.h"
+#include <stdint.h>
+
+/**
+ * @defgroup parsec_internal_classes_multiqueue Relaxed Priority MultiQueue
+ * @ingroup parsec_internal_classes
+ * @{
+ *
+ *  @brief Concurrent, relaxed priority queue of parsec_list_item_t
+ *
+ *  @details The MultiQueue (H. Rihani, P. Sanders, R. Dementiev,
+ *  "MultiQueues: Simple Relaxed Concurrent Priority Queues", SPAA'15)
+ *  is made of c*P sequential binary heaps, each protected by its own
+ *  lock. An insertion goes into a randomly chosen heap; a removal looks
+ *  at the top of two randomly chosen heaps and pops the one with the
+ *  highest priority. Locks are only ever taken with a trylock: when a
+ *  heap is busy, the operation simply picks other heaps, so no thread
+ *  waits for another one.
+ *
+ *  The order is relaxed: an element returned by pop is not always the
+ *  one with the highest priority, but its expected rank among the
+ *  elements of the queue is O(nb_heaps), independently of the number
+ *  of elements. The number of heaps (the relaxation) trades priority
+ *  fidelity for a lower contention.
+ *
+ *  Elements are ordered by the int found at a given offset in the
+ *  element (the same convention as the sorted lists, see
+ *  A_HIGHER_PRIORITY_THAN_B); the priority is read once, when the
+ *  element is pushed. Elements are not linked through their list_next
+ *  / list_prev fields while they are in the queue.
+ */
+
+BEGIN_C_DECLS
+
+/** Size used to keep the heaps of the queue on separate cache lines */
+#define PARSEC_MULTIQUEUE_CACHE_LINE_SIZE 64
+
+typedef struct parsec_multiqueue_entry_s {
+    int                 priority;  /**< Priority of the element, read when pushed */
+    parsec_list_item_t *item;
+} parsec_multiqueue_entry_t;
+
+/**
+ * @brief One of the sequential heaps of a MultiQueue
+ */
+typedef struct parsec_multiqueue_heap_s {
+    parsec_atomic_lock_t       lock;
+    volatile int32_t           size;      /**< Number of elements, readable without the lock */
+    volatile int               top;       /**< Priority of the first element, meaningful if size > 0 */
+    int32_t                    capacity;
+    parsec_multiqueue_entry_t *entries;   /**< Binary max-heap of the elements */
+    char                       pad[PARSEC_MULTIQUEUE_CACHE_LINE_SIZE - sizeof(parsec_atomic_lock_t) -
+                                   2 * sizeof(int32_t) - sizeof(int) - sizeof(void*)];
+} parsec_multiqueue_heap_t;
+
+/**
+ * @brief The state of a thread using a MultiQueue
+ *
+ * @details Each thread keeps its random state, and counts the heaps it
+ *   found busy, so that the operations do not update any shared
+ *   variable besides the heaps they lock.
+ */
+typedef struct parsec_multiqueue_thread_s {
+    uint32_t seed;     /**< Random state (see parsec_multiqueue_rand), must not be 0 */
+    uint32_t nb_busy;  /**< Number of failed trylocks of the thread (contention statistics) */
+} parsec_multiqueue_thread_t;
+
+/**
+ * @brief A MultiQueue object
+ */
+typedef struct parsec_multiqueue_s parsec_multiqueue_t;
+PARSEC_DECLSPEC PARSEC_OBJ_CLASS_DECLARATION(parsec_multiqueue_t);
+
+struct parsec_multiqueue_s {
+    parsec_object_t           super;
+    int                       nb_heaps;
+    size_t                    offset;         /**< Offset of the priority in the elements */
+    parsec_multiqueue_heap_t *heaps;
+};
+
+/**
+ * @brief Set the number of heaps of a MultiQueue, and how to read the
+ *   priority of its elements
+ *
+ * @details Must be called after the queue has been constructed, and
+ *   before it is used. A queue that is not initialized has a single
+ *   heap (it is then a strict priority queue) and no priority.
+ *
+ * @param[inout] mq the queue to initialize
+ * @param[in] nb_heaps the number of heaps, typically a small multiple
+ *   of the number of threads that use the queue
+ * @param[in] offset the offset of the int priority in the elements
+ *
+ * @remark this function is not thread safe
+ */
+PARSEC_DECLSPEC void
+parsec_multiqueue_init(parsec_multiqueue_t *mq, int nb_heaps, size_t offset);
+
+/**
+ * @brief Push an element in the queue
+ *
+ * @param[inout] mq the queue
+ * @param[inout] item the element to push
+ * @param[inout] th the state of the calling thread
+ *
+ * @remark this function is thread safe
+ */
+PARSEC_DECLSPEC void
+parsec_multiqueue_push(parsec_multiqueue_t *mq, parsec_list_item_t *item, parsec_multiqueue_thread_t *th);
+
+/**
+ * @brief Push a ring of elements in the queue
+ *
+ * @details All the elements of the ring are pushed in the same heap,
+ *   with one lock acquisition.
+ *
+ * @param[inout] mq the queue
+ * @param[inout] ring the ring of elements to push
+ * @param[inout] th the state of the calling thread
+ *
+ * @remark this function is thread safe
+ */
+PARSEC_DECLSPEC void
+parsec_multiqueue_push_ring(parsec_multiqueue_t *mq, parsec_list_item_t *ring, parsec_multiqueue_thread_t *th);
+
+/**
+ * @brief Pop an element of (approximately) highest priority
+ *
+ * @param[inout] mq the queue
+ * @param[inout] th the state of the calling thread
+ * @return an element, or NULL if the queue is empty
+ *
+ * @remark this function is thread safe
+ */
+PARSEC_DECLSPEC parsec_list_item_t*
+parsec_multiqueue_pop(parsec_multiqueue_t *mq, parsec_multiqueue_thread_t *th);
+
+/**
+ * @brief Returns (approximately) how many elements are in the queue
+ *
+ * @param[in] mq the queue
+ * @return the number of elements at the time of the call
+ *
+ * @remark this function is thread safe, but the result may be outdated
+ *   when the function returns.
+ */
+PARSEC_DECLSPEC long long int
+parsec_multiqueue_approx_size(parsec_multiqueue_t *mq);
+
+/**
+ * @brief Draw a pseudo-random number (xorshift32)
+ *
+ * @param[inout] seed the random state, must not be 0
+ * @return the next pseudo-random number
+ */
+static inline uint32_t
+parsec_multiqueue_rand(uint32_t *seed)
+{
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+END_C_DECLS
+
+/** @} */
+
+#endif  /* MULTIQUEUE_H_HAS_BEEN_INCLUDED */
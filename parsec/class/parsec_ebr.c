@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/parsec_config.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "parsec/sys/atomic.h"
+#include "parsec/sys/tls.h"
+#include "parsec/class/parsec_ebr.h"
+
+/* Number of pending retired pointers above which a thread that retires
+ * one more tries to release them, without waiting for a quiescent point */
+#define PARSEC_EBR_RECLAIM_THRESHOLD 64
+
+/* The state of a thread is its epoch, shifted by one bit to mark whether
+ * it is in a critical section */
+#define PARSEC_EBR_ACTIVE ((int64_t)1)
+
+typedef struct parsec_ebr_retired_s {
+    struct parsec_ebr_retired_s *next;
+    void                        *ptr;
+    parsec_ebr_free_fn_t         free_fn;
+} parsec_ebr_retired_t;
+
+/**
+ * The state of a thread, and the memory it retired during the last three
+ * epochs (the memory retired during the epoch e is in the list e % 3).
+ * The threads are chained when they first enter a critical section or
+ * retire some memory, and are kept until the end of the process.
+ */
+typedef struct parsec_ebr_thread_s {
+    struct parsec_ebr_thread_s *next;
+    volatile int64_t            state;
+    int                         nesting;
+    int                         nb_retired;
+    int64_t                     epochs[3];
+    parsec_ebr_retired_t       *retired[3];
+} parsec_ebr_thread_t;
+
+static volatile int64_t parsec_ebr_epoch = 0;
+static parsec_ebr_thread_t * volatile parsec_ebr_threads = NULL;
+
+static PARSEC_TLS_DECLARE(parsec_ebr_tls);
+static volatile int32_t parsec_ebr_tls_ready = 0;
+
+static parsec_ebr_thread_t *parsec_ebr_thread(void)
+{
+    parsec_ebr_thread_t *t;
+
+    /* The structures may be used before parsec_init, create the key on first use */
+    if( 2 != parsec_ebr_tls_ready ) {
+        if( parsec_atomic_cas_int32(&parsec_ebr_tls_ready, 0, 1) ) {
+            PARSEC_TLS_KEY_CREATE(parsec_ebr_tls);
+            parsec_atomic_wmb();
+            parsec_ebr_tls_ready = 2;
+        }
+        while( 2 != parsec_ebr_tls_ready ) ;
+    }
+    t = (parsec_ebr_thread_t*)PARSEC_TLS_GET_SPECIFIC(parsec_ebr_tls);
+    if( NULL != t ) return t;
+
+    t = (parsec_ebr_thread_t*)calloc(1, sizeof(parsec_ebr_thread_t));
+    do {
+        t->next = parsec_ebr_threads;
+    } while( !parsec_atomic_cas_ptr(&parsec_ebr_threads, t->next, t) );
+    PARSEC_TLS_SET_SPECIFIC(parsec_ebr_tls, t);
+    return t;
+}
+
+void parsec_ebr_enter(void)
+{
+    parsec_ebr_thread_t *t = parsec_ebr_thread();
+
+    if( 0 == t->nesting++ ) {
+        t->state = (parsec_ebr_epoch << 1) | PARSEC_EBR_ACTIVE;
+        /* The reads of the critical section come after the announcement */
+        parsec_mfence();
+    }
+}
+
+void parsec_ebr_exit(void)
+{
+    parsec_ebr_thread_t *t = (parsec_ebr_thread_t*)PARSEC_TLS_GET_SPECIFIC(parsec_ebr_tls);
+
+    assert( (NULL != t) && (t->nesting > 0) );
+    if( 0 == --t->nesting ) {
+        /* The reads of the critical section complete before it ends */
+        parsec_mfence();
+        t->state &= ~PARSEC_EBR_ACTIVE;
+    }
+}
+
+/* Advances the global epoch if all the threads in a critical section
+ * entered it during the current epoch. Returns the global epoch. */
+static int64_t parsec_ebr_try_advance(void)
+{
+    int64_t epoch = parsec_ebr_epoch, state;
+    parsec_ebr_thread_t *t;
+
+    parsec_mfence();
+    for( t = parsec_ebr_threads; NULL != t; t = t->next ) {
+        state = t->state;
+        if( (state & PARSEC_EBR_ACTIVE) && ((state >> 1) != epoch) )
+            return epoch;
+    }
+    if( parsec_atomic_cas_int64(&parsec_ebr_epoch, epoch, epoch + 1) )
+        return epoch + 1;
+    return parsec_ebr_epoch;
+}
+
+static int parsec_ebr_release(parsec_ebr_retired_t *r)
+{
+    parsec_ebr_retired_t *next;
+    int nb = 0;
+
+    for( ; NULL != r; r = next, nb++ ) {
+        next = r->next;
+        r->free_fn(r->ptr);
+        free(r);
+    }
+    return nb;
+}
+
+/* Releases the lists of t retired at least two epochs before epoch */
+static void parsec_ebr_reclaim(parsec_ebr_thread_t *t, int64_t epoch)
+{
+    int i;
+
+    for( i = 0; i < 3; i++ ) {
+        if( (NULL != t->retired[i]) && (t->epochs[i] + 2 <= epoch) ) {
+            t->nb_retired -= parsec_ebr_release(t->retired[i]);
+            t->retired[i] = NULL;
+        }
+    }
+}
+
+void parsec_ebr_retire(void *ptr, parsec_ebr_free_fn_t free_fn)
+{
+    parsec_ebr_thread_t *t = parsec_ebr_thread();
+    parsec_ebr_retired_t *r = (parsec_ebr_retired_t*)malloc(sizeof(parsec_ebr_retired_t));
+    int64_t epoch;
+    int i;
+
+    r->ptr = ptr;
+    r->free_fn = free_fn;
+    /* The epoch is read after ptr was unlinked */
+    parsec_mfence();
+    epoch = parsec_ebr_epoch;
+    i = (int)(epoch % 3);
+    if( (NULL != t->retired[i]) && (t->epochs[i] != epoch) ) {
+        /* These were retired three epochs ago at least */
+        t->nb_retired -= parsec_ebr_release(t->retired[i]);
+        t->retired[i] = NULL;
+    }
+    t->epochs[i] = epoch;
+    r->next = t->retired[i];
+    t->retired[i] = r;
+    if( ++t->nb_retired >= PARSEC_EBR_RECLAIM_THRESHOLD )
+        parsec_ebr_reclaim(t, parsec_ebr_try_advance());
+}
+
+void parsec_ebr_quiescent(void)
+{
+    parsec_ebr_thread_t *t;
+    int i;
+
+    if( 2 != parsec_ebr_tls_ready )
+        return;
+    t = (parsec_ebr_thread_t*)PARSEC_TLS_GET_SPECIFIC(parsec_ebr_tls);
+    if( NULL == t )
+        return;
+    assert( 0 == t->nesting );
+    /* Two epochs are needed to release the memory retired during the current one */
+    for( i = 0; (i < 2) && (0 != t->nb_retired); i++ ) {
+        parsec_ebr_reclaim(t, parsec_ebr_try_advance());
+    }
+}
+
+void parsec_ebr_fini(void)
+{
+    parsec_ebr_thread_t *t;
+    int i;
+
+    for( t = parsec_ebr_threads; NULL != t; t = t->next ) {
+        assert( 0 == t->nesting );
+        for( i = 0; i < 3; i++ ) {
+            t->nb_retired -= parsec_ebr_release(t->retired[i]);
+            t->retired[i] = NULL;
+        }
+    }
+}
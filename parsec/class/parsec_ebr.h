@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#ifndef PARSEC_EBR_H_HAS_BEEN_INCLUDED
+#define PARSEC_EBR_H_HAS_BEEN_INCLUDED
+
+#include "parsec/parsec_config.h"
+
+BEGIN_C_DECLS
+
+/**
+ * @defgroup parsec_internal_classes_ebr Epoch-Based Reclamation
+ * @ingroup parsec_internal_classes
+ * @{
+ *
+ *  @brief Deferred release of the memory of lock-free structures
+ *
+ *  @details
+ *    A lock-free structure cannot release the memory it unlinks as long
+ *    as a concurrent thread may still read it. The threads that read such
+ *    memory do it in a critical section (parsec_ebr_enter and
+ *    parsec_ebr_exit), and the thread that unlinks some memory retires it
+ *    (parsec_ebr_retire) instead of releasing it.
+ *
+ *    A global epoch is advanced when all the threads in a critical section
+ *    have entered it during the current epoch. The memory retired during
+ *    an epoch is released once the global epoch is two epochs ahead, as no
+ *    critical section that may have seen it can still be running.
+ *
+ *    The retired memory is released by the thread that retired it, at its
+ *    quiescent points (parsec_ebr_quiescent, called by the execution
+ *    streams between the tasks they execute), or when it retires more.
+ *    Threads that are outside of critical sections never delay the
+ *    release of the memory, and no thread ever waits for it, so the
+ *    critical sections only need to be short to keep the retired memory
+ *    bounded.
+ */
+
+/**
+ * @brief Type of the functions that release retired memory
+ */
+typedef void (*parsec_ebr_free_fn_t)(void *ptr);
+
+/**
+ * @brief Enters a critical section: the memory read from now on is not
+ *   released until parsec_ebr_exit. Critical sections can be nested.
+ *
+ * @remark this function is thread safe
+ */
+void parsec_ebr_enter(void);
+
+/**
+ * @brief Leaves the critical section entered by the matching
+ *   parsec_ebr_enter.
+ *
+ * @remark this function is thread safe
+ */
+void parsec_ebr_exit(void);
+
+/**
+ * @brief Releases ptr with free_fn once no critical section can read it
+ *   anymore. ptr must have been unlinked from the structures it belongs
+ *   to, so that no critical section entered from now on can find it.
+ *
+ * @remark this function is thread safe, and can be called in a critical
+ *   section
+ */
+void parsec_ebr_retire(void *ptr, parsec_ebr_free_fn_t free_fn);
+
+/**
+ * @brief Quiescent point of the calling thread, which must not be in a
+ *   critical section: tries to advance the global epoch, and releases
+ *   the memory retired by the calling thread that is safe to release.
+ *   This is cheap when the calling thread did not retire anything.
+ *
+ * @remark this function is thread safe
+ */
+void parsec_ebr_quiescent(void);
+
+/**
+ * @brief Releases all the retired memory, whatever the thread that
+ *   retired it. No thread can be in a critical section.
+ *
+ * @remark this function is not thread safe
+ */
+void parsec_ebr_fini(void);
+
+/** @} */
+
+END_C_DECLS
+
+#endif  /* PARSEC_EBR_H_HAS_BEEN_INCLUDED */
@@ -10,10 +10,16 @@
 #include "parsec/class/list.h"
 #include "parsec/utils/mca_param.h"
 #include "parsec/utils/debug.h"
+#include "parsec/utils/mem_footprint.h"
+#include "parsec/class/parsec_ebr.h"
 #include <stdio.h>
+#include <stdlib.h>
 
 #undef HELPFIRST
 
+/* Number of keys of the batch operations that are sorted on the stack */
+#define PARSEC_HASH_TABLE_BATCH_ON_STACK 32
+
 /**
  * @brief Bucket for hash tables. There is no need to have this structure public, it
  *        should only be used in this file.
@@ -115,6 +121,8 @@ void parsec_hash_table_init(parsec_hash_table_t *ht, int64_t offset, int nb_bits
 
     head = malloc(sizeof(parsec_hash_table_head_t));
     head->buckets      = malloc( (1ULL<<nb_bits) * sizeof(parsec_hash_table_bucket_t));
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_HASH_TABLES,
+                             sizeof(parsec_hash_table_head_t) + (1ULL<<nb_bits) * sizeof(parsec_hash_table_bucket_t));
     head->nb_bits      = nb_bits;
     head->used_buckets = 0;
     head->next         = NULL;
@@ -264,6 +272,44 @@ void parsec_hash_table_lock_bucket_handle(parsec_hash_table_t *ht,
     handle->hash = hash;
 }
 
+static void parsec_hash_table_head_free(void *ptr)
+{
+    parsec_hash_table_head_t *head = (parsec_hash_table_head_t*)ptr;
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_HASH_TABLES,
+                             -(int64_t)(sizeof(parsec_hash_table_head_t) + (1ULL<<head->nb_bits) * sizeof(parsec_hash_table_bucket_t)));
+    free(head->buckets);
+    free(head);
+}
+
+/**
+ * Retires the old heads whose items were all removed or moved to the
+ * current head. The removals unlink them from the lookup chain, but may
+ * miss some when two neighbors are unlinked at once. This is called with
+ * the write lock held, which keeps out the threads that hold the read
+ * lock, but not the callers of the nolock functions that do not: these
+ * read the heads in epoch-based reclamation critical sections, and the
+ * heads are released once they left them.
+ */
+static void parsec_hash_table_release_empty_heads(parsec_hash_table_t *ht)
+{
+    parsec_hash_table_head_t *head, *prev, **pfree;
+
+    for( prev = ht->rw_hash, head = prev->next; NULL != head; head = prev->next ) {
+        if( 0 == head->used_buckets )
+            prev->next = head->next;
+        else
+            prev = head;
+    }
+    for( pfree = &ht->rw_hash->next_to_free; NULL != (head = *pfree); ) {
+        if( 0 != head->used_buckets ) {
+            pfree = &head->next_to_free;
+            continue;
+        }
+        *pfree = head->next_to_free;
+        parsec_ebr_retire(head, parsec_hash_table_head_free);
+    }
+}
+
 static void parsec_hash_table_resize(parsec_hash_table_t *ht)
 {
     parsec_atomic_lock_t unlocked = PARSEC_ATOMIC_UNLOCKED;
@@ -283,6 +329,8 @@ static void parsec_hash_table_resize(parsec_hash_table_t *ht)
 
     head = malloc(sizeof(parsec_hash_table_head_t));
     head->buckets      = malloc((1ULL<<nb_bits) * sizeof(parsec_hash_table_bucket_t));
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_HASH_TABLES,
+                             sizeof(parsec_hash_table_head_t) + (1ULL<<nb_bits) * sizeof(parsec_hash_table_bucket_t));
     head->nb_bits      = nb_bits;
     head->used_buckets = 0;
     head->next         = old_head;
@@ -294,6 +342,8 @@ static void parsec_hash_table_resize(parsec_hash_table_t *ht)
         head->buckets[i].cur_len = 0;
         head->buckets[i].first_item = NULL;
     }
+
+    parsec_hash_table_release_empty_heads(ht);
 }
 
 void parsec_hash_table_unlock_bucket_impl(parsec_hash_table_t *ht, parsec_key_t key, const char *file, int line)
@@ -353,27 +403,38 @@ void parsec_hash_table_fini(parsec_hash_table_t *ht)
             }
             free(head->buckets);
             head->buckets = NULL;
+            PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_HASH_TABLES,
+                                     -(int64_t)((1ULL<<head->nb_bits) * sizeof(parsec_hash_table_bucket_t)));
         }
         next = head->next_to_free;
         head->next_to_free = NULL;
+        PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_HASH_TABLES, -(int64_t)sizeof(parsec_hash_table_head_t));
         free(head);
         head = next;
     }
     ht->rw_hash = NULL;
 }
 
-void parsec_hash_table_nolock_insert(parsec_hash_table_t *ht, parsec_hash_table_item_t *item)
+static void __parsec_hash_table_nolock_insert_handle(parsec_hash_table_t *ht,
+                                                     const parsec_key_handle_t *handle,
+                                                     parsec_hash_table_item_t *item);
+static void *__parsec_hash_table_nolock_find_handle(parsec_hash_table_t *ht,
+                                                    const parsec_key_handle_t *handle);
+static void *__parsec_hash_table_nolock_remove_handle(parsec_hash_table_t *ht,
+                                                      const parsec_key_handle_t *handle);
+
+static void __parsec_hash_table_nolock_insert(parsec_hash_table_t *ht, parsec_hash_table_item_t *item)
 {
     uint64_t hash, hash64;
     parsec_key_t key = item->key;
     hash64 = ht->key_functions.key_hash(key, ht->hash_data);
     hash = parsec_hash_table_universal_rehash(hash64, ht->rw_hash->nb_bits);
     parsec_key_handle_t handle = {.key = key, .hash64 = hash64, .hash = hash};
-    parsec_hash_table_nolock_insert_handle(ht, &handle, item);
+    __parsec_hash_table_nolock_insert_handle(ht, &handle, item);
 }
 
 
-void parsec_hash_table_nolock_insert_handle(parsec_hash_table_t *ht,
+static void __parsec_hash_table_nolock_insert_handle(parsec_hash_table_t *ht,
                                             const parsec_key_handle_t *handle,
                                             parsec_hash_table_item_t *item)
 {
@@ -449,7 +510,7 @@ static void *parsec_hash_table_nolock_remove_from_old_tables(parsec_hash_table_t
                          parsec_atomic_cas_ptr(&prev_head->next, head, head->next);
                      }
                  }
-                 parsec_hash_table_nolock_insert(ht, current_item);
+                 __parsec_hash_table_nolock_insert(ht, current_item);
                  if( NULL == prev_item )
                      current_item = head->buckets[hash].first_item;
                  else
@@ -506,7 +567,7 @@ static void *parsec_hash_table_nolock_find_in_old_tables(parsec_hash_table_t *ht
                         parsec_atomic_cas_ptr(&prev_head->next, head, head->next);
                     }
                 }
-                parsec_hash_table_nolock_insert(ht, current_item);
+                __parsec_hash_table_nolock_insert(ht, current_item);
                 parsec_atomic_unlock( &head->buckets[hash].lock );
                 return BASEADDROF(current_item, ht);
             }
@@ -519,17 +580,17 @@ static void *parsec_hash_table_nolock_find_in_old_tables(parsec_hash_table_t *ht
 }
 #endif
 
-void *parsec_hash_table_nolock_find(parsec_hash_table_t *ht, parsec_key_t key)
+static void *__parsec_hash_table_nolock_find(parsec_hash_table_t *ht, parsec_key_t key)
 {
     uint64_t hash;
     uint64_t hash64 = ht->key_functions.key_hash(key, ht->hash_data);
     hash = parsec_hash_table_universal_rehash(hash64, ht->rw_hash->nb_bits);
     parsec_key_handle_t handle = {.key = key, .hash64 = hash64, .hash = hash};
-    return parsec_hash_table_nolock_find_handle(ht, &handle);
+    return __parsec_hash_table_nolock_find_handle(ht, &handle);
 }
 
 
-void *parsec_hash_table_nolock_find_handle(parsec_hash_table_t *ht,
+static void *__parsec_hash_table_nolock_find_handle(parsec_hash_table_t *ht,
                                            const parsec_key_handle_t* handle)
 {
     parsec_hash_table_item_t *current_item;
@@ -554,7 +615,7 @@ void *parsec_hash_table_nolock_find_handle(parsec_hash_table_t *ht,
     item = parsec_hash_table_nolock_remove_from_old_tables(ht, key);
     if( NULL != item ) {
         current_item = ITEMADDROF(item, ht);
-        parsec_hash_table_nolock_insert(ht, current_item);
+        __parsec_hash_table_nolock_insert(ht, current_item);
     }
 #else
     item = parsec_hash_table_nolock_find_in_old_tables(ht, handle->key);
@@ -562,16 +623,16 @@ void *parsec_hash_table_nolock_find_handle(parsec_hash_table_t *ht,
     return item;
 }
 
-void *parsec_hash_table_nolock_remove(parsec_hash_table_t *ht, parsec_key_t key)
+static void *__parsec_hash_table_nolock_remove(parsec_hash_table_t *ht, parsec_key_t key)
 {
     uint64_t hash64 = ht->key_functions.key_hash(key, ht->hash_data);
     uint64_t hash = parsec_hash_table_universal_rehash(hash64, ht->rw_hash->nb_bits);
     parsec_key_handle_t handle = {.key = key, .hash64 = hash64, .hash = hash};
-    return parsec_hash_table_nolock_remove_handle(ht, &handle);
+    return __parsec_hash_table_nolock_remove_handle(ht, &handle);
 }
 
 
-void *parsec_hash_table_nolock_remove_handle(parsec_hash_table_t *ht,
+static void *__parsec_hash_table_nolock_remove_handle(parsec_hash_table_t *ht,
                                              const parsec_key_handle_t* handle)
 {
     parsec_hash_table_item_t *current_item, *prev_item;
@@ -602,6 +663,64 @@ void *parsec_hash_table_nolock_remove_handle(parsec_hash_table_t *ht,
 }
 
 
+/*
+ * The nolock functions may be called without the read lock, while another
+ * thread resizes the table: they access the heads in critical sections.
+ */
+void parsec_hash_table_nolock_insert(parsec_hash_table_t *ht, parsec_hash_table_item_t *item)
+{
+    parsec_ebr_enter();
+    __parsec_hash_table_nolock_insert(ht, item);
+    parsec_ebr_exit();
+}
+
+void parsec_hash_table_nolock_insert_handle(parsec_hash_table_t *ht,
+                                            const parsec_key_handle_t *handle,
+                                            parsec_hash_table_item_t *item)
+{
+    parsec_ebr_enter();
+    __parsec_hash_table_nolock_insert_handle(ht, handle, item);
+    parsec_ebr_exit();
+}
+
+void *parsec_hash_table_nolock_find(parsec_hash_table_t *ht, parsec_key_t key)
+{
+    void *item;
+    parsec_ebr_enter();
+    item = __parsec_hash_table_nolock_find(ht, key);
+    parsec_ebr_exit();
+    return item;
+}
+
+void *parsec_hash_table_nolock_find_handle(parsec_hash_table_t *ht,
+                                           const parsec_key_handle_t* handle)
+{
+    void *item;
+    parsec_ebr_enter();
+    item = __parsec_hash_table_nolock_find_handle(ht, handle);
+    parsec_ebr_exit();
+    return item;
+}
+
+void *parsec_hash_table_nolock_remove(parsec_hash_table_t *ht, parsec_key_t key)
+{
+    void *item;
+    parsec_ebr_enter();
+    item = __parsec_hash_table_nolock_remove(ht, key);
+    parsec_ebr_exit();
+    return item;
+}
+
+void *parsec_hash_table_nolock_remove_handle(parsec_hash_table_t *ht,
+                                             const parsec_key_handle_t* handle)
+{
+    void *item;
+    parsec_ebr_enter();
+    item = __parsec_hash_table_nolock_remove_handle(ht, handle);
+    parsec_ebr_exit();
+    return item;
+}
+
 void parsec_hash_table_insert_impl(parsec_hash_table_t *ht, parsec_hash_table_item_t *item, const char *file, int line)
 {
     uint64_t hash;
@@ -612,7 +731,7 @@ void parsec_hash_table_insert_impl(parsec_hash_table_t *ht, parsec_hash_table_it
     hash = parsec_hash_table_universal_rehash(ht->key_functions.key_hash(item->key, ht->hash_data), ht->rw_hash->nb_bits);
     assert( hash < (1ULL<<ht->rw_hash->nb_bits) );
     parsec_atomic_lock(&ht->rw_hash->buckets[hash].lock);
-    parsec_hash_table_nolock_insert(ht, item);
+    __parsec_hash_table_nolock_insert(ht, item);
     if( ht->rw_hash->buckets[hash].cur_len > ht->max_collisions_hint ) {
         if( (int)ht->rw_hash->nb_bits + 1 < ht->max_table_nb_bits )
             resize = 1;
@@ -647,7 +766,7 @@ void *parsec_hash_table_find(parsec_hash_table_t *ht, parsec_key_t key)
     hash = parsec_hash_table_universal_rehash(ht->key_functions.key_hash(key, ht->hash_data), ht->rw_hash->nb_bits);
     assert( hash < (1ULL<<ht->rw_hash->nb_bits) );
     parsec_atomic_lock(&ht->rw_hash->buckets[hash].lock);
-    ret = parsec_hash_table_nolock_find(ht, key);
+    ret = __parsec_hash_table_nolock_find(ht, key);
     parsec_atomic_unlock(&ht->rw_hash->buckets[hash].lock);
     parsec_atomic_rwlock_rdunlock(&ht->rw_lock);
     return ret;
@@ -661,12 +780,173 @@ void *parsec_hash_table_remove(parsec_hash_table_t *ht, parsec_key_t key)
     hash = parsec_hash_table_universal_rehash(ht->key_functions.key_hash(key, ht->hash_data), ht->rw_hash->nb_bits);
     assert( hash < (1ULL<<ht->rw_hash->nb_bits) );
     parsec_atomic_lock(&ht->rw_hash->buckets[hash].lock);
-    ret = parsec_hash_table_nolock_remove(ht, key);
+    ret = __parsec_hash_table_nolock_remove(ht, key);
     parsec_atomic_unlock(&ht->rw_hash->buckets[hash].lock);
     parsec_atomic_rwlock_rdunlock(&ht->rw_lock);
     return ret;
 }
 
+/**
+ * A key of a batch operation: the keys are sorted by bucket, keeping the
+ * order of the caller for the keys of a same bucket.
+ */
+typedef struct parsec_hash_table_batch_s {
+    uint64_t hash64;
+    uint64_t hash;
+    int      idx;
+} parsec_hash_table_batch_t;
+
+static int parsec_hash_table_batch_compare(const void *a, const void *b)
+{
+    const parsec_hash_table_batch_t *ba = (const parsec_hash_table_batch_t*)a;
+    const parsec_hash_table_batch_t *bb = (const parsec_hash_table_batch_t*)b;
+    if( ba->hash != bb->hash )
+        return ba->hash < bb->hash ? -1 : 1;
+    return ba->idx - bb->idx;
+}
+
+/* Hashes and sorts the keys. Called with the read lock held, as the
+ * buckets depend on the size of the current head */
+static parsec_hash_table_batch_t *
+parsec_hash_table_batch_sort(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys,
+                             parsec_hash_table_batch_t *on_stack)
+{
+    parsec_hash_table_batch_t *batch = on_stack, tmp;
+    int i, j;
+
+    if( nb > PARSEC_HASH_TABLE_BATCH_ON_STACK )
+        batch = (parsec_hash_table_batch_t*)malloc(nb * sizeof(parsec_hash_table_batch_t));
+    for( i = 0; i < nb; i++ ) {
+        batch[i].hash64 = ht->key_functions.key_hash(keys[i], ht->hash_data);
+        batch[i].hash = parsec_hash_table_universal_rehash(batch[i].hash64, ht->rw_hash->nb_bits);
+        batch[i].idx = i;
+    }
+    if( nb > PARSEC_HASH_TABLE_BATCH_ON_STACK ) {
+        qsort(batch, nb, sizeof(parsec_hash_table_batch_t), parsec_hash_table_batch_compare);
+        return batch;
+    }
+    /* The batches are mostly small (the flows of a task): insertion sort */
+    for( i = 1; i < nb; i++ ) {
+        tmp = batch[i];
+        for( j = i; (j > 0) && (batch[j-1].hash > tmp.hash); j-- )
+            batch[j] = batch[j-1];
+        batch[j] = tmp;
+    }
+    return batch;
+}
+
+/* Returns the index of the first key of the next bucket, after prefetching it */
+static int parsec_hash_table_batch_next(parsec_hash_table_t *ht, int nb,
+                                        const parsec_hash_table_batch_t *batch, int first)
+{
+    int next;
+
+    for( next = first + 1; (next < nb) && (batch[next].hash == batch[first].hash); next++ ) ;
+    if( next < nb )
+        PARSEC_PREFETCH(&ht->rw_hash->buckets[batch[next].hash]);
+    return next;
+}
+
+void parsec_hash_table_insert_many_impl(parsec_hash_table_t *ht, int nb, parsec_hash_table_item_t **items,
+                                        const char *file, int line)
+{
+    parsec_hash_table_batch_t on_stack[PARSEC_HASH_TABLE_BATCH_ON_STACK], *batch;
+    parsec_key_t keys_on_stack[PARSEC_HASH_TABLE_BATCH_ON_STACK], *keys = keys_on_stack;
+    parsec_hash_table_head_t *cur_head;
+    parsec_key_handle_t handle;
+    int i, first, next, resize = 0;
+    uint64_t hash;
+
+    if( nb <= 0 ) return;
+    if( nb > PARSEC_HASH_TABLE_BATCH_ON_STACK )
+        keys = (parsec_key_t*)malloc(nb * sizeof(parsec_key_t));
+    for( i = 0; i < nb; i++ )
+        keys[i] = items[i]->key;
+
+    parsec_atomic_rwlock_rdlock(&ht->rw_lock);
+    cur_head = ht->rw_hash;
+    batch = parsec_hash_table_batch_sort(ht, nb, keys, on_stack);
+    for( first = 0; first < nb; first = next ) {
+        next = parsec_hash_table_batch_next(ht, nb, batch, first);
+        hash = batch[first].hash;
+        parsec_atomic_lock(&ht->rw_hash->buckets[hash].lock);
+        for( i = first; i < next; i++ ) {
+            handle.key = keys[batch[i].idx];
+            handle.hash64 = batch[i].hash64;
+            handle.hash = hash;
+            __parsec_hash_table_nolock_insert_handle(ht, &handle, items[batch[i].idx]);
+        }
+        if( ht->rw_hash->buckets[hash].cur_len > ht->max_collisions_hint ) {
+            if( (int)ht->rw_hash->nb_bits + 1 < ht->max_table_nb_bits )
+                resize = 1;
+            else if( !ht->warning_issued ) {
+                parsec_warning("%s:%d -- Hash table has %d collisions in bucket %lu, but it already spans over %lu buckets. Performance might get very bad if more elements continue to stack in this bucket. Consider allowing larger resize with the MCA parameter parsec_hash_table_max_table_nb_bits",
+                               file, line, ht->rw_hash->buckets[hash].cur_len, hash, (1UL<<ht->rw_hash->nb_bits));
+                ht->warning_issued = 1;
+            }
+        }
+        parsec_atomic_unlock(&ht->rw_hash->buckets[hash].lock);
+    }
+    parsec_atomic_rwlock_rdunlock(&ht->rw_lock);
+
+    if( resize ) {
+        parsec_atomic_rwlock_wrlock(&ht->rw_lock);
+        if( cur_head == ht->rw_hash ) {
+            parsec_hash_table_resize(ht);
+        }
+        parsec_atomic_rwlock_wrunlock(&ht->rw_lock);
+    }
+    if( batch != on_stack ) free(batch);
+    if( keys != keys_on_stack ) free(keys);
+}
+
+static void parsec_hash_table_find_or_remove_many(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys,
+                                                  void **items, int remove,
+                                                  parsec_hash_elem_fct_t fct, void *cb_data)
+{
+    parsec_hash_table_batch_t on_stack[PARSEC_HASH_TABLE_BATCH_ON_STACK], *batch;
+    parsec_key_handle_t handle;
+    int i, first, next;
+    uint64_t hash;
+
+    if( nb <= 0 ) return;
+    parsec_atomic_rwlock_rdlock(&ht->rw_lock);
+    batch = parsec_hash_table_batch_sort(ht, nb, keys, on_stack);
+    for( first = 0; first < nb; first = next ) {
+        next = parsec_hash_table_batch_next(ht, nb, batch, first);
+        hash = batch[first].hash;
+        parsec_atomic_lock(&ht->rw_hash->buckets[hash].lock);
+        for( i = first; i < next; i++ ) {
+            handle.key = keys[batch[i].idx];
+            handle.hash64 = batch[i].hash64;
+            handle.hash = hash;
+            items[batch[i].idx] = remove ? __parsec_hash_table_nolock_remove_handle(ht, &handle)
+                                         : __parsec_hash_table_nolock_find_handle(ht, &handle);
+            if( (NULL != fct) && (NULL != items[batch[i].idx]) )
+                fct(items[batch[i].idx], cb_data);
+        }
+        parsec_atomic_unlock(&ht->rw_hash->buckets[hash].lock);
+    }
+    parsec_atomic_rwlock_rdunlock(&ht->rw_lock);
+    if( batch != on_stack ) free(batch);
+}
+
+void parsec_hash_table_find_many(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys, void **items)
+{
+    parsec_hash_table_find_or_remove_many(ht, nb, keys, items, 0, NULL, NULL);
+}
+
+void parsec_hash_table_find_many_apply(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys, void **items,
+                                       parsec_hash_elem_fct_t fct, void *cb_data)
+{
+    parsec_hash_table_find_or_remove_many(ht, nb, keys, items, 0, fct, cb_data);
+}
+
+void parsec_hash_table_remove_many(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys, void **items)
+{
+    parsec_hash_table_find_or_remove_many(ht, nb, keys, items, 1, NULL, NULL);
+}
+
 void parsec_hash_table_stat(parsec_hash_table_t *ht)
 {
     parsec_hash_table_head_t *head;
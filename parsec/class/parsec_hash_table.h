@@ -338,6 +338,60 @@ void *parsec_hash_table_find(parsec_hash_table_t *ht, parsec_key_t key);
  */
 void * parsec_hash_table_remove(parsec_hash_table_t *ht, parsec_key_t key);
 
+/**
+ * @brief Insert several elements in the hash table
+ *
+ * @details
+ *  Inserts the nb elements at once, assuming none of them is already in
+ *  the table. The elements are grouped by bucket, each bucket is locked
+ *  once for all its elements, and the next bucket is prefetched while
+ *  the current one is updated. The table is resized at most once, after
+ *  all the insertions. Use this through the parsec_hash_table_insert_many
+ *  macro.
+ *  @arg[inout] ht    the hash table
+ *  @arg[in]    nb    the number of elements
+ *  @arg[inout] items the elements to insert. Their keys must be initialized.
+ *  @arg[in]    file  the name of the file where the caller of this function is
+ *  @arg[in]    line  the line at which the caller is
+ *
+ * @remark this function is thread-safe.
+ */
+void parsec_hash_table_insert_many_impl(parsec_hash_table_t *ht, int nb, parsec_hash_table_item_t **items,
+                                        const char *file, int line);
+#define parsec_hash_table_insert_many(ht, nb, items) parsec_hash_table_insert_many_impl(ht, nb, items, __FILE__, __LINE__)
+
+/**
+ * @brief Find several elements in the hash table
+ *
+ * @details
+ *  Looks for the nb keys at once, locking each bucket once for all its
+ *  keys (see parsec_hash_table_insert_many).
+ *  @arg[in]  ht    the hash table
+ *  @arg[in]  nb    the number of keys
+ *  @arg[in]  keys  the keys of the elements to find
+ *  @arg[out] items items[i] is the element of key keys[i], NULL if it is
+ *                  not in the table
+ *
+ * @remark this function is thread-safe.
+ */
+void parsec_hash_table_find_many(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys, void **items);
+
+/**
+ * @brief Remove several elements from the hash table
+ *
+ * @details
+ *  Removes the elements of the nb keys at once, locking each bucket once
+ *  for all its keys (see parsec_hash_table_insert_many).
+ *  @arg[inout] ht    the hash table
+ *  @arg[in]    nb    the number of keys
+ *  @arg[in]    keys  the keys of the elements to remove
+ *  @arg[out]   items items[i] is the element of key keys[i] that was
+ *                    removed from the table, NULL if it was not in the table
+ *
+ * @remark this function is thread-safe.
+ */
+void parsec_hash_table_remove_many(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys, void **items);
+
 /**
  * @brief Converts a parsec_hash_table_item_t *pointer into its
  *  corresponding data pointer (void*).
@@ -379,6 +433,26 @@ typedef void (*parsec_hash_elem_fct_t)(void *item, void*cb_data);
  */
 void parsec_hash_table_for_all(parsec_hash_table_t* ht, parsec_hash_elem_fct_t fct, void* cb_data);
 
+/**
+ * @brief Find several elements in the hash table, and update them
+ *
+ * @details
+ *  As parsec_hash_table_find_many, but fct is called on each element
+ *  found while its bucket is still locked, so that it can update the
+ *  element safely.
+ *  @arg[in]  ht      the hash table
+ *  @arg[in]  nb      the number of keys
+ *  @arg[in]  keys    the keys of the elements to find
+ *  @arg[out] items   items[i] is the element of key keys[i], NULL if it is
+ *                    not in the table
+ *  @arg[in]  fct     function to apply to the elements found
+ *  @arg[in]  cb_data data to pass to each call of fct
+ *
+ * @remark this function is thread-safe.
+ */
+void parsec_hash_table_find_many_apply(parsec_hash_table_t *ht, int nb, const parsec_key_t *keys, void **items,
+                                       parsec_hash_elem_fct_t fct, void *cb_data);
+
 /**
  * @brief a generic key_equal function that can be used for 64 bits keys
  *
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/class/multiqueue.h"
+#include "parsec/sys/atomic.h"
+#include "parsec/constants.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <assert.h>
+
+#define PARSEC_MULTIQUEUE_INITIAL_CAPACITY 16
+
+/* Compare two entries (or two int priorities) with the convention of the sorted lists */
+#define MQ_HIGHER(a, b) A_HIGHER_PRIORITY_THAN_B((a), (b), offsetof(parsec_multiqueue_entry_t, priority))
+
+static void parsec_multiqueue_heaps_free(parsec_multiqueue_t *mq)
+{
+    int i;
+    if( NULL == mq->heaps ) return;
+    for( i = 0; i < mq->nb_heaps; i++ ) {
+        free(mq->heaps[i].entries);
+    }
+    free(mq->heaps);
+    mq->heaps = NULL;
+}
+
+static void parsec_multiqueue_heaps_alloc(parsec_multiqueue_t *mq, int nb_heaps)
+{
+    int i;
+    mq->nb_heaps = nb_heaps;
+    mq->heaps = (parsec_multiqueue_heap_t*)calloc(nb_heaps, sizeof(parsec_multiqueue_heap_t));
+    for( i = 0; i < nb_heaps; i++ ) {
+        parsec_atomic_lock_init(&mq->heaps[i].lock);
+        mq->heaps[i].size = 0;
+        mq->heaps[i].capacity = 0;
+        mq->heaps[i].entries = NULL;
+    }
+}
+
+static void parsec_multiqueue_construct(parsec_multiqueue_t *mq)
+{
+    mq->offset = 0;
+    mq->heaps = NULL;
+    parsec_multiqueue_heaps_alloc(mq, 1);
+}
+
+static void parsec_multiqueue_destruct(parsec_multiqueue_t *mq)
+{
+    parsec_multiqueue_heaps_free(mq);
+}
+
+PARSEC_OBJ_CLASS_INSTANCE(parsec_multiqueue_t, parsec_object_t,
+                          parsec_multiqueue_construct, parsec_multiqueue_destruct);
+
+void parsec_multiqueue_init(parsec_multiqueue_t *mq, int nb_heaps, size_t offset)
+{
+    if( nb_heaps < 1 ) nb_heaps = 1;
+    parsec_multiqueue_heaps_free(mq);
+    parsec_multiqueue_heaps_alloc(mq, nb_heaps);
+    mq->offset = offset;
+}
+
+/**
+ * Sequential heap operations: the lock of the heap must be held.
+ */
+static void heap_insert(parsec_multiqueue_heap_t *h, int priority, parsec_list_item_t *item)
+{
+    parsec_multiqueue_entry_t e;
+    int32_t i, parent;
+
+    if( h->size == h->capacity ) {
+        h->capacity = (0 == h->capacity) ? PARSEC_MULTIQUEUE_INITIAL_CAPACITY : 2 * h->capacity;
+        h->entries = (parsec_multiqueue_entry_t*)realloc(h->entries, h->capacity * sizeof(parsec_multiqueue_entry_t));
+    }
+    e.priority = priority;
+    e.item = item;
+    for( i = h->size; i > 0; i = parent ) {
+        parent = (i - 1) / 2;
+        if( !MQ_HIGHER(&e, &h->entries[parent]) ) break;
+        h->entries[i] = h->entries[parent];
+    }
+    h->entries[i] = e;
+    h->top = h->entries[0].priority;
+    parsec_atomic_wmb();
+    h->size = h->size + 1;
+}
+
+static parsec_list_item_t *heap_pop(parsec_multiqueue_heap_t *h)
+{
+    parsec_list_item_t *item = h->entries[0].item;
+    parsec_multiqueue_entry_t last;
+    int32_t i, child, size = h->size - 1;
+
+    last = h->entries[size];
+    for( i = 0; (child = 2 * i + 1) < size; i = child ) {
+        if( (child + 1 < size) && MQ_HIGHER(&h->entries[child + 1], &h->entries[child]) )
+            child++;
+        if( !MQ_HIGHER(&h->entries[child], &last) ) break;
+        h->entries[i] = h->entries[child];
+    }
+    h->entries[i] = last;
+    if( size > 0 )
+        h->top = h->entries[0].priority;
+    h->size = size;
+    return item;
+}
+
+/**
+ * Lock a random heap. Busy heaps are skipped, so that the caller only
+ * waits if all the heaps it tries are in use.
+ */
+static parsec_multiqueue_heap_t *
+parsec_multiqueue_lock_random(parsec_multiqueue_t *mq, parsec_multiqueue_thread_t *th)
+{
+    parsec_multiqueue_heap_t *h;
+    for(;;) {
+        h = &mq->heaps[parsec_multiqueue_rand(&th->seed) % mq->nb_heaps];
+        if( parsec_atomic_trylock(&h->lock) )
+            return h;
+        th->nb_busy++;
+    }
+}
+
+void parsec_multiqueue_push(parsec_multiqueue_t *mq, parsec_list_item_t *item, parsec_multiqueue_thread_t *th)
+{
+    parsec_multiqueue_heap_t *h = parsec_multiqueue_lock_random(mq, th);
+    heap_insert(h, COMPARISON_VAL(item, mq->offset), item);
+    parsec_atomic_unlock(&h->lock);
+}
+
+void parsec_multiqueue_push_ring(parsec_multiqueue_t *mq, parsec_list_item_t *ring, parsec_multiqueue_thread_t *th)
+{
+    parsec_multiqueue_heap_t *h = parsec_multiqueue_lock_random(mq, th);
+    parsec_list_item_t *item;
+
+    while( NULL != ring ) {
+        item = ring;
+        ring = parsec_list_item_ring_chop(item);
+        PARSEC_LIST_ITEM_SINGLETON(item);
+        heap_insert(h, COMPARISON_VAL(item, mq->offset), item);
+    }
+    parsec_atomic_unlock(&h->lock);
+}
+
+/** Number of consecutive pairs of empty heaps drawn before scanning all the heaps */
+#define PARSEC_MULTIQUEUE_EMPTY_TRIES 4
+
+parsec_list_item_t *
+parsec_multiqueue_pop(parsec_multiqueue_t *mq, parsec_multiqueue_thread_t *th)
+{
+    parsec_multiqueue_heap_t *h, *hi, *hj;
+    parsec_list_item_t *item;
+    int tries = 0, busy, k, start;
+
+    /* Two random choices: pop from the heap with the highest top */
+    while( tries < PARSEC_MULTIQUEUE_EMPTY_TRIES ) {
+        hi = &mq->heaps[parsec_multiqueue_rand(&th->seed) % mq->nb_heaps];
+        hj = &mq->heaps[parsec_multiqueue_rand(&th->seed) % mq->nb_heaps];
+        if( 0 == hi->size ) {
+            h = hj;
+        } else if( 0 == hj->size ) {
+            h = hi;
+        } else {
+            int ti = hi->top, tj = hj->top;
+            h = A_HIGHER_PRIORITY_THAN_B(&tj, &ti, 0) ? hj : hi;
+        }
+        if( 0 == h->size ) {
+            tries++;
+            continue;
+        }
+        if( !parsec_atomic_trylock(&h->lock) ) {
+            th->nb_busy++;
+            continue;
+        }
+        item = (h->size > 0) ? heap_pop(h) : NULL;
+        parsec_atomic_unlock(&h->lock);
+        if( NULL != item ) return item;
+        tries++;
+    }
+
+    /* The random choices only found empty heaps: look at all of them
+     * before reporting an empty queue. */
+    start = parsec_multiqueue_rand(&th->seed) % mq->nb_heaps;
+    do {
+        busy = 0;
+        for( k = 0; k < mq->nb_heaps; k++ ) {
+            h = &mq->heaps[(start + k) % mq->nb_heaps];
+            if( 0 == h->size ) continue;
+            if( !parsec_atomic_trylock(&h->lock) ) {
+                busy = 1;
+                continue;
+            }
+            item = (h->size > 0) ? heap_pop(h) : NULL;
+            parsec_atomic_unlock(&h->lock);
+            if( NULL != item ) return item;
+        }
+    } while( busy );
+    return NULL;
+}
+
+long long int parsec_multiqueue_approx_size(parsec_multiqueue_t *mq)
+{
+    long long int size = 0;
+    int i;
+    for( i = 0; i < mq->nb_heaps; i++ ) {
+        size += mq->heaps[i].size;
+    }
+    return size;
+}
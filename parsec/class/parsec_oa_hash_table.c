@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include <assert.h>
+#include "parsec/parsec_config.h"
+#include "parsec/class/parsec_oa_hash_table.h"
+#include "parsec/constants.h"
+#include "parsec/utils/debug.h"
+#include "parsec/utils/mem_footprint.h"
+#include "parsec/class/parsec_ebr.h"
+#include <stdlib.h>
+
+/**
+ * @brief Slot of an open addressing hash table. There is no need to have this
+ *        structure public, it should only be used in this file.
+ *
+ * @details hash64 is written by the thread that claimed the slot, before it
+ *          publishes the item, and is only a hint: a thread that reads the
+ *          item of a slot and then its hash64 can see the hash of a later
+ *          item, if the slot was reused in between.
+ */
+struct parsec_oa_hash_table_slot_s {
+    volatile uint64_t                   hash64; /**< Is a 64-bits hash of the key of the item */
+    parsec_hash_table_item_t * volatile item;   /**< The item, or one of the SLOT_ states below */
+};
+
+/* States of the slots, that are not items */
+#define SLOT_EMPTY     ((parsec_hash_table_item_t*)0x0)  /**< Never used: ends the probing */
+#define SLOT_RESERVED  ((parsec_hash_table_item_t*)0x1)  /**< Claimed by an insertion, the item is being written */
+#define SLOT_TOMBSTONE ((parsec_hash_table_item_t*)0x2)  /**< The item was removed, the slot can be reused */
+#define SLOT_MOVED     ((parsec_hash_table_item_t*)0x3)  /**< Migrated to the next array */
+#define SLOT_END       ((parsec_hash_table_item_t*)0x4)  /**< Was empty when migrated: ends the probing */
+/* An item that is being copied to the next array has this bit set */
+#define SLOT_COPYING   ((uintptr_t)0x1)
+
+#define SLOT_IS_ITEM(it)   ((uintptr_t)(it) > (uintptr_t)SLOT_END)
+#define SLOT_ITEM(it)      ((parsec_hash_table_item_t*)((uintptr_t)(it) & ~SLOT_COPYING))
+
+/* Number of slots migrated at once by a thread */
+#define PARSEC_OA_HASH_TABLE_COPY_CHUNK 64
+#define BASEADDROF(item, ht)  (void*)(  ( (char*)(item) ) - ( (ht)->elt_hashitem_offset ) )
+
+/* To create object of class parsec_oa_hash_table that inherits parsec_object_t class */
+PARSEC_OBJ_CLASS_INSTANCE(parsec_oa_hash_table_t, parsec_object_t, NULL, parsec_oa_hash_table_fini);
+
+/* Same test as the chained hash table: keys that fit in 64 bits are compared
+ * directly, the others only if the hashes are equal */
+#define OPTIMIZED_EQUAL_TEST(_ITEM, _KEY, _HASH64, _HT)                 \
+    ( (_ITEM)->key == (_KEY) ||                                         \
+      ((_ITEM)->hash64 == (_HASH64) &&                                  \
+       NULL != (_HT)->key_functions.key_equal &&                        \
+       (_HT)->key_functions.key_equal((_ITEM)->key,                     \
+                                      (_KEY), (_HT)->hash_data)) )
+
+/* Fibonacci hashing: the high bits of the product depend on all the bits of
+ * the hash, and consecutive keys are spread over the array */
+static inline uint32_t parsec_oa_hash_table_home(uint64_t hash64, uint32_t nb_bits)
+{
+    return (uint32_t)((hash64 * 0x9E3779B97F4A7C15ULL) >> (64 - nb_bits));
+}
+
+/* Memory of a head and its array of slots */
+#define PARSEC_OA_HASH_TABLE_HEAD_SIZE(nb_bits) \
+    (sizeof(parsec_oa_hash_table_head_t) + (1ULL<<(nb_bits)) * sizeof(parsec_oa_hash_table_slot_t))
+
+static parsec_oa_hash_table_head_t *parsec_oa_hash_table_head_new(uint32_t nb_bits)
+{
+    parsec_oa_hash_table_head_t *head = malloc(sizeof(parsec_oa_hash_table_head_t));
+    head->next         = NULL;
+    head->nb_bits      = nb_bits;
+    head->used_slots   = 0;
+    head->copy_next    = 0;
+    head->copy_done    = 0;
+    /* SLOT_EMPTY is 0 */
+    head->slots        = calloc(1ULL<<nb_bits, sizeof(parsec_oa_hash_table_slot_t));
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_HASH_TABLES, PARSEC_OA_HASH_TABLE_HEAD_SIZE(nb_bits));
+    return head;
+}
+
+static void parsec_oa_hash_table_head_free(void *ptr)
+{
+    parsec_oa_hash_table_head_t *head = (parsec_oa_hash_table_head_t*)ptr;
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_HASH_TABLES, -(int64_t)PARSEC_OA_HASH_TABLE_HEAD_SIZE(head->nb_bits));
+    free(head->slots);
+    free(head);
+}
+
+int parsec_oa_hash_table_init(parsec_oa_hash_table_t *ht, int64_t offset, int nb_bits,
+                              parsec_key_fn_t key_functions, void *data)
+{
+    if( nb_bits < 1 || nb_bits > PARSEC_OA_HASH_TABLE_MAX_NB_BITS ) {
+        parsec_warning("Open addressing hash table %p: %d bits requested, must be between 1 and %d",
+                       ht, nb_bits, PARSEC_OA_HASH_TABLE_MAX_NB_BITS);
+        return PARSEC_ERR_BAD_PARAM;
+    }
+    ht->key_functions = key_functions;
+    ht->hash_data = data;
+    ht->elt_hashitem_offset = offset;
+    ht->rw_hash = parsec_oa_hash_table_head_new(nb_bits);
+    return PARSEC_SUCCESS;
+}
+
+/**
+ * Allocates the array to which the items of head are migrated, unless
+ * another thread did it already. Only the current array can be migrated,
+ * so there are at most two arrays in use at any time.
+ */
+static void parsec_oa_hash_table_start_migration(parsec_oa_hash_table_t *ht, parsec_oa_hash_table_head_t *head)
+{
+    parsec_oa_hash_table_head_t *next;
+    uint32_t nb_bits = head->nb_bits;
+    size_t i, live = 0;
+
+    if( (NULL != head->next) || (head != ht->rw_hash) )
+        return;
+    /* Grow if more than a quarter of the slots hold items, otherwise the
+     * migration only gets rid of the tombstones */
+    for( i = 0; i < (1ULL<<head->nb_bits); i++ ) {
+        if( SLOT_IS_ITEM(head->slots[i].item) ) live++;
+    }
+    if( (4 * live > (1ULL<<nb_bits)) && (nb_bits < PARSEC_OA_HASH_TABLE_MAX_NB_BITS) )
+        nb_bits++;
+    next = parsec_oa_hash_table_head_new(nb_bits);
+    if( !parsec_atomic_cas_ptr(&head->next, NULL, next) ) {
+        parsec_oa_hash_table_head_free(next);
+        return;
+    }
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "Migrating open addressing hash table %p from %lu to %lu slots (%lu items)",
+                         ht, (unsigned long)(1ULL<<head->nb_bits), (unsigned long)(1ULL<<nb_bits), (unsigned long)live);
+}
+
+/**
+ * Inserts item in head. Returns 1 if the array should be migrated after
+ * this insertion, 0 if not, and -1 if the item could not be inserted
+ * because the array is being migrated or is full.
+ */
+static int parsec_oa_hash_table_insert_in(parsec_oa_hash_table_head_t *head,
+                                          parsec_hash_table_item_t *item, uint64_t hash64)
+{
+    uint32_t mask = (1U<<head->nb_bits) - 1, idx = parsec_oa_hash_table_home(hash64, head->nb_bits);
+    parsec_oa_hash_table_slot_t *slot;
+    parsec_hash_table_item_t *it;
+    int32_t used = 0;
+    uint32_t n;
+
+    for( n = 0; n <= mask; ) {
+        slot = &head->slots[idx];
+        it = slot->item;
+        if( (SLOT_MOVED == it) || (SLOT_END == it) )
+            return -1;
+        if( (SLOT_EMPTY == it) || (SLOT_TOMBSTONE == it) ) {
+            if( !parsec_atomic_cas_ptr(&slot->item, it, SLOT_RESERVED) )
+                continue;  /* look at the same slot again */
+            if( SLOT_EMPTY == it )
+                used = parsec_atomic_fetch_inc_int32(&head->used_slots) + 1;
+            slot->hash64 = hash64;
+            parsec_atomic_wmb();
+            slot->item = item;
+            return (4 * (int64_t)used > 3 * (int64_t)(mask + 1));
+        }
+        idx = (idx + 1) & mask;
+        n++;
+    }
+    return -1;
+}
+
+/**
+ * Inserts the copy of an item in the array to which it is migrated. The
+ * copies are the only insertions in this array until the migration ends,
+ * and are not visible before their slot in the old array is marked as
+ * moved, so the slot can be claimed directly with the item. Returns 1 if
+ * an empty slot was used.
+ */
+static int parsec_oa_hash_table_copy_in(parsec_oa_hash_table_head_t *next,
+                                        parsec_hash_table_item_t *item, uint64_t hash64)
+{
+    uint32_t mask = (1U<<next->nb_bits) - 1, idx = parsec_oa_hash_table_home(hash64, next->nb_bits);
+    parsec_oa_hash_table_slot_t *slot;
+    parsec_hash_table_item_t *it;
+
+    for(;;) {
+        slot = &next->slots[idx];
+        it = slot->item;
+        if( ((SLOT_EMPTY == it) || (SLOT_TOMBSTONE == it)) &&
+            parsec_atomic_cas_ptr(&slot->item, it, item) ) {
+            slot->hash64 = hash64;
+            return (SLOT_EMPTY == it);
+        }
+        if( (SLOT_EMPTY == it) || (SLOT_TOMBSTONE == it) )
+            continue;  /* another copy took this slot, look at it again */
+        idx = (idx + 1) & mask;
+    }
+}
+
+/**
+ * Copies one slot of head to head->next. The slot belongs to a chunk that
+ * only this thread migrates, but insertions and removals may still update
+ * it concurrently. Returns 1 if the copy used an empty slot of head->next.
+ */
+static int parsec_oa_hash_table_copy_slot(parsec_oa_hash_table_head_t *head, parsec_oa_hash_table_slot_t *slot)
+{
+    parsec_hash_table_item_t *it;
+    int used;
+
+    for(;;) {
+        it = slot->item;
+        if( SLOT_EMPTY == it ) {
+            if( parsec_atomic_cas_ptr(&slot->item, SLOT_EMPTY, SLOT_END) ) return 0;
+            continue;
+        }
+        if( SLOT_TOMBSTONE == it ) {
+            if( parsec_atomic_cas_ptr(&slot->item, SLOT_TOMBSTONE, SLOT_MOVED) ) return 0;
+            continue;
+        }
+        if( SLOT_RESERVED == it ) {
+            /* An insertion is writing the item */
+            continue;
+        }
+        assert( SLOT_IS_ITEM(it) && !((uintptr_t)it & SLOT_COPYING) );
+        /* Removals wait until the item is in the next array */
+        if( parsec_atomic_cas_ptr(&slot->item, it, (void*)((uintptr_t)it | SLOT_COPYING)) ) {
+            used = parsec_oa_hash_table_copy_in(head->next, it, it->hash64);
+            parsec_atomic_wmb();
+            slot->item = SLOT_MOVED;
+            return used;
+        }
+    }
+}
+
+/**
+ * Migrates one chunk of head, if there are chunks left. The thread that
+ * completes the migration replaces head by its next array.
+ */
+static void parsec_oa_hash_table_help_migration(parsec_oa_hash_table_t *ht, parsec_oa_hash_table_head_t *head)
+{
+    int32_t nb_slots = (int32_t)(1U<<head->nb_bits), start, end, i, used = 0;
+
+    if( head->copy_next >= nb_slots )
+        return;
+    start = parsec_atomic_fetch_add_int32(&head->copy_next, PARSEC_OA_HASH_TABLE_COPY_CHUNK);
+    if( start >= nb_slots )
+        return;
+    end = (start + PARSEC_OA_HASH_TABLE_COPY_CHUNK < nb_slots) ? start + PARSEC_OA_HASH_TABLE_COPY_CHUNK : nb_slots;
+    for( i = start; i < end; i++ ) {
+        used += parsec_oa_hash_table_copy_slot(head, &head->slots[i]);
+    }
+    parsec_atomic_fetch_add_int32(&head->next->used_slots, used);
+    if( parsec_atomic_fetch_add_int32(&head->copy_done, end - start) + (end - start) == nb_slots ) {
+        /* The threads that still read head are in a critical section */
+        if( parsec_atomic_cas_ptr(&ht->rw_hash, head, head->next) )
+            parsec_ebr_retire(head, parsec_oa_hash_table_head_free);
+    }
+}
+
+/* Completes the migrations in progress. Not thread safe. */
+static void parsec_oa_hash_table_finish_migration(parsec_oa_hash_table_t *ht)
+{
+    while( NULL != ht->rw_hash->next ) {
+        parsec_oa_hash_table_help_migration(ht, ht->rw_hash);
+    }
+}
+
+void parsec_oa_hash_table_fini(parsec_oa_hash_table_t *ht)
+{
+    parsec_oa_hash_table_head_t *head, *next;
+
+    if( NULL == ht->rw_hash )
+        return;
+    /* The arrays replaced by a migration were retired, only the current
+     * array and the one it is being migrated to remain */
+    for( head = ht->rw_hash; NULL != head; head = next ) {
+#if defined(PARSEC_DEBUG_PARANOID)
+        for( size_t i = 0; i < (1ULL<<head->nb_bits); i++ ) {
+            assert( !SLOT_IS_ITEM(head->slots[i].item) );
+        }
+#endif  /* defined(PARSEC_DEBUG_PARANOID) */
+        next = head->next;
+        parsec_oa_hash_table_head_free(head);
+    }
+    ht->rw_hash = NULL;
+}
+
+void parsec_oa_hash_table_insert(parsec_oa_hash_table_t *ht, parsec_hash_table_item_t *item)
+{
+    parsec_oa_hash_table_head_t *head;
+    uint64_t hash64 = ht->key_functions.key_hash(item->key, ht->hash_data);
+    int rc;
+
+    assert( 0 == ((uintptr_t)item & SLOT_COPYING) );
+    item->hash64 = hash64;
+    item->next_item = NULL;
+    parsec_ebr_enter();
+    for(;;) {
+        head = ht->rw_hash;
+        /* Help the migration in progress, and wait for its end: as only the
+         * copies go to the next array, they always find a free slot */
+        if( NULL != head->next ) {
+            parsec_oa_hash_table_help_migration(ht, head);
+            continue;
+        }
+        rc = parsec_oa_hash_table_insert_in(head, item, hash64);
+        if( rc >= 0 ) {
+            if( rc > 0 ) parsec_oa_hash_table_start_migration(ht, head);
+            break;
+        }
+        /* The array is full or being migrated */
+        parsec_oa_hash_table_start_migration(ht, head);
+    }
+    parsec_ebr_exit();
+#if defined(PARSEC_DEBUG_NOISIER)
+    {
+        char estr[64];
+        PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "Added item %p/%s into open addressing hash table %p",
+                             item, ht->key_functions.key_print(estr, 64, item->key, ht->hash_data), ht);
+    }
+#endif
+}
+
+/**
+ * Looks for key in head, and replaces the item by a tombstone if remove
+ * is set. Items that are being copied are still found by lookups, and
+ * removals wait until they are moved to look for them in the next array.
+ */
+static parsec_hash_table_item_t *parsec_oa_hash_table_lookup_in(parsec_oa_hash_table_t *ht,
+                                                                parsec_oa_hash_table_head_t *head,
+                                                                parsec_key_t key, uint64_t hash64,
+                                                                int remove)
+{
+    uint32_t mask = (1U<<head->nb_bits) - 1, idx = parsec_oa_hash_table_home(hash64, head->nb_bits);
+    parsec_oa_hash_table_slot_t *slot;
+    parsec_hash_table_item_t *it, *item;
+    uint32_t n;
+
+    for( n = 0; n <= mask; ) {
+        slot = &head->slots[idx];
+        it = slot->item;
+        parsec_atomic_rmb();
+        if( (SLOT_EMPTY == it) || (SLOT_END == it) )
+            return NULL;
+        if( SLOT_IS_ITEM(it) && (slot->hash64 == hash64) ) {
+            item = SLOT_ITEM(it);
+            if( OPTIMIZED_EQUAL_TEST(item, key, hash64, ht) ) {
+                if( !remove )
+                    return item;
+                if( (uintptr_t)it & SLOT_COPYING ) {
+                    while( it == slot->item ) /* wait for the copy */;
+                    continue;  /* and look at the same slot again */
+                }
+                if( parsec_atomic_cas_ptr(&slot->item, it, SLOT_TOMBSTONE) )
+                    return item;
+                continue;
+            }
+        }
+        idx = (idx + 1) & mask;
+        n++;
+    }
+    return NULL;
+}
+
+void *parsec_oa_hash_table_find(parsec_oa_hash_table_t *ht, parsec_key_t key)
+{
+    parsec_oa_hash_table_head_t *head;
+    parsec_hash_table_item_t *item = NULL;
+    uint64_t hash64 = ht->key_functions.key_hash(key, ht->hash_data);
+
+    /* The next array is read after the current one: an item that was moved
+     * while this thread was looking at the current array is in the next */
+    parsec_ebr_enter();
+    for( head = ht->rw_hash; NULL != head; head = head->next ) {
+        item = parsec_oa_hash_table_lookup_in(ht, head, key, hash64, 0);
+        if( NULL != item )
+            break;
+    }
+    parsec_ebr_exit();
+    return NULL != item ? BASEADDROF(item, ht) : NULL;
+}
+
+void *parsec_oa_hash_table_remove(parsec_oa_hash_table_t *ht, parsec_key_t key)
+{
+    parsec_oa_hash_table_head_t *head;
+    parsec_hash_table_item_t *item = NULL;
+    uint64_t hash64 = ht->key_functions.key_hash(key, ht->hash_data);
+
+    parsec_ebr_enter();
+    head = ht->rw_hash;
+    if( NULL != head->next )
+        parsec_oa_hash_table_help_migration(ht, head);
+    for( ; NULL != head; head = head->next ) {
+        item = parsec_oa_hash_table_lookup_in(ht, head, key, hash64, 1);
+        if( NULL != item )
+            break;
+    }
+    parsec_ebr_exit();
+    if( NULL == item )
+        return NULL;
+#if defined(PARSEC_DEBUG_NOISIER)
+    {
+        char estr[64];
+        PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "Removed item %p/%s from open addressing hash table %p",
+                             item, ht->key_functions.key_print(estr, 64, key, ht->hash_data), ht);
+    }
+#endif
+    return BASEADDROF(item, ht);
+}
+
+void parsec_oa_hash_table_for_all(parsec_oa_hash_table_t *ht, parsec_hash_elem_fct_t fct, void *cb_data)
+{
+    parsec_oa_hash_table_head_t *head;
+    parsec_hash_table_item_t *it;
+
+    parsec_oa_hash_table_finish_migration(ht);
+    head = ht->rw_hash;
+    for( size_t i = 0; i < (1ULL<<head->nb_bits); i++ ) {
+        it = head->slots[i].item;
+        if( SLOT_IS_ITEM(it) )
+            fct( BASEADDROF(it, ht), cb_data );
+    }
+}
+
+void parsec_oa_hash_table_stat(parsec_oa_hash_table_t *ht)
+{
+    parsec_oa_hash_table_head_t *head;
+    parsec_hash_table_item_t *it;
+    uint32_t mask, dist, max_dist;
+    size_t i, live, tombstones, sum_dist;
+    int j;
+
+    for( head = ht->rw_hash, j = 0; NULL != head; head = head->next, j++ ) {
+        mask = (1U<<head->nb_bits) - 1;
+        live = tombstones = sum_dist = 0;
+        max_dist = 0;
+        for( i = 0; i <= mask; i++ ) {
+            it = head->slots[i].item;
+            if( SLOT_TOMBSTONE == it ) tombstones++;
+            if( !SLOT_IS_ITEM(it) ) continue;
+            live++;
+            dist = ((uint32_t)i - parsec_oa_hash_table_home(head->slots[i].hash64, head->nb_bits)) & mask;
+            sum_dist += dist;
+            if( dist > max_dist ) max_dist = dist;
+        }
+        parsec_inform("table %p array %d: %u slots, %d used, %lu items, %lu tombstones, probe length average %g max %u",
+                      ht, j, mask + 1, head->used_slots, (unsigned long)live, (unsigned long)tombstones,
+                      live ? 1.0 + (double)sum_dist / live : 0.0, max_dist + 1);
+    }
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#ifndef _parsec_oa_hash_table_h
+#define _parsec_oa_hash_table_h
+
+#include "parsec/parsec_config.h"
+#include "parsec/sys/atomic.h"
+#include "parsec/class/parsec_object.h"
+#include "parsec/class/parsec_hash_table.h"
+
+/**
+ * @defgroup parsec_internal_classes_oahashtable Open Addressing Hash Tables
+ * @ingroup parsec_internal_classes
+ * @{
+ *
+ *  @brief Concurrent open addressing hash tables, with lock-free lookups
+ *
+ *  @details
+ *    This is an alternative to @ref parsec_hash_table_t for the tables
+ *    that are mostly read, or accessed by many threads at once. It uses
+ *    the same items (@ref parsec_hash_table_item_t, at a given offset in
+ *    the user structures) and the same key functions (@ref parsec_key_fn_t),
+ *    so that a user of parsec_hash_table_t can opt in by changing the calls.
+ *
+ *    The items are stored in a single array of slots, with linear probing.
+ *    Each slot holds the 64 bits hash of its key and a pointer to the item,
+ *    that is updated with compare-and-swap only:
+ *     - lookups do not write anything, and never wait;
+ *     - insertions claim an empty or deleted slot, and removals replace the
+ *       item by a tombstone, without locks;
+ *     - when too many slots have been used, a larger (or, if most of the
+ *       slots are tombstones, an equally sized) array is allocated and the
+ *       items are migrated incrementally, by chunks of slots: each thread
+ *       that removes an item first copies a chunk, and the threads that
+ *       insert items copy chunks until the new array replaces the old one.
+ *       Lookups and removals that run during the migration look in both
+ *       arrays.
+ *    Besides the insertions during a migration, the only waits are for a
+ *    slot that another thread is writing (an insertion between the claim
+ *    and the publication of the item, or the copy of this item to the new
+ *    array).
+ *
+ *    Compared to parsec_hash_table_t, there is no way to lock a bucket:
+ *    an insertion assumes that the key is not in the table, and the users
+ *    that need to atomically find or insert an item must provide their own
+ *    synchronization. An item that is removed can still be returned by a
+ *    concurrent lookup that started before the removal, so the user must
+ *    not release it while other threads may look it up. The operations run
+ *    in critical sections of the epoch-based reclamation
+ *    (@ref parsec_internal_classes_ebr), and the arrays replaced by a
+ *    migration are retired, to be released once no lookup can read them.
+ */
+
+BEGIN_C_DECLS
+
+/** log_2 of the number of slots of the largest array of a table */
+#define PARSEC_OA_HASH_TABLE_MAX_NB_BITS 30
+
+typedef struct parsec_oa_hash_table_s      parsec_oa_hash_table_t;      /**< An Open Addressing Hash Table */
+typedef struct parsec_oa_hash_table_slot_s parsec_oa_hash_table_slot_t; /**< Slots of an Open Addressing Hash Table */
+
+/**
+ * @brief The array of slots of an open addressing hash table
+ */
+typedef struct parsec_oa_hash_table_head_s {
+    struct parsec_oa_hash_table_head_s * volatile next; /**< Array to which the items are migrated, NULL if none */
+    uint32_t                            nb_bits;        /**< This array has 1<<nb_bits slots */
+    volatile int32_t                    used_slots;     /**< Number of slots that are not empty anymore */
+    volatile int32_t                    copy_next;      /**< First slot not yet taken by a migrating thread */
+    volatile int32_t                    copy_done;      /**< Number of slots already migrated */
+    parsec_oa_hash_table_slot_t        *slots;          /**< These are the slots of this array */
+} parsec_oa_hash_table_head_t;
+
+/**
+ * @brief A concurrent open addressing hash table
+ */
+struct parsec_oa_hash_table_s {
+    parsec_object_t                       super;               /**< An Open Addressing Hash Table is a PaRSEC object */
+    int64_t                               elt_hashitem_offset; /**< Elements belonging to this hash table have a
+                                                                *   parsec_hash_table_item_t at this offset */
+    parsec_key_fn_t                       key_functions;       /**< How to acccess and modify the keys */
+    void                                 *hash_data;           /**< This is the last parameter of the hashing function */
+    parsec_oa_hash_table_head_t * volatile rw_hash;            /**< Added elements go in this array (or in its next) */
+};
+PARSEC_DECLSPEC PARSEC_OBJ_CLASS_DECLARATION(parsec_oa_hash_table_t);
+
+/**
+ * @brief Create an open addressing hash table
+ *
+ * @details
+ *  @arg[inout] ht      the hash table to initialize
+ *  @arg[in]    offset  the number of bytes between an element pointer and its parsec_hash_table_item field
+ *  @arg[in]    nb_bits log_2 of the initial number of slots. The table holds
+ *                      up to 3/4 of its slots before growing.
+ *                      This field is a hint and must be between 1 and
+ *                      PARSEC_OA_HASH_TABLE_MAX_NB_BITS.
+ *  @arg[in]    key_fn  the functions to access and modify these keys
+ *  @arg[in]    data    the opaque pointer to pass to the hash function
+ *  @return PARSEC_SUCCESS, or PARSEC_ERR_BAD_PARAM if nb_bits is out of bounds
+ */
+int parsec_oa_hash_table_init(parsec_oa_hash_table_t *ht, int64_t offset, int nb_bits,
+                              parsec_key_fn_t key_functions, void *data);
+
+/**
+ * @brief Destroy an open addressing hash table
+ *
+ * @details
+ *   Releases the resources allocated by the hash table. The arrays that
+ *   were replaced during the migrations are released by the epoch-based
+ *   reclamation.
+ *   In debug mode, will assert if the hash table is not empty
+ * @arg[inout] ht the hash table to release
+ */
+void parsec_oa_hash_table_fini(parsec_oa_hash_table_t *ht);
+
+/**
+ * @brief Insert element in the hash table
+ *
+ * @details
+ *  Inserts an element in the table, assuming it is not already in the
+ *  table. This function is thread-safe and does not take any lock; it
+ *  may start, or help with, the migration of the table to a larger array.
+ *  @arg[inout] ht the hash table
+ *  @arg[inout] item the pointer to the structure with a parsec_hash_table_item_t
+ *              structure at the right offset (see parsec_oa_hash_table_init).
+ *              Its key must be initialized.
+ */
+void parsec_oa_hash_table_insert(parsec_oa_hash_table_t *ht, parsec_hash_table_item_t *item);
+
+/**
+ * @brief Find element in the hash table
+ *
+ * @details
+ *  This function is thread-safe and lock-free: it does not write in the
+ *  table, and never waits for other threads.
+ *  @arg[in] ht the hash table
+ *  @arg[in] key the key of the element to find
+ *  @return NULL if the element is not in the table, the element otherwise.
+ */
+void *parsec_oa_hash_table_find(parsec_oa_hash_table_t *ht, parsec_key_t key);
+
+/**
+ * @brief Remove element from the hash table.
+ *
+ * @details
+ *  @arg[inout] ht the hash table
+ *  @arg[inout] key the key of the item to remove
+ *  @return NULL if the element was not in the table, the element
+ *    that was removed from the table otherwise. If several threads remove
+ *    the same key concurrently, only one of them gets the element.
+ *
+ * @remark this function is thread-safe.
+ */
+void *parsec_oa_hash_table_remove(parsec_oa_hash_table_t *ht, parsec_key_t key);
+
+/**
+ * @brief Call the function passed as argument for all items in the
+ *         hash table.
+ *
+ * @details This function is safe for items removal, but is not thread
+ *          safe: no other thread can insert elements while it runs.
+ *
+ *  @arg[in] ht    the hash table
+ *  @arg[in] fct   function to apply to all items in the hash table
+ *  @arg[in] cb_data data to pass for each element as the first parameter of the fct.
+ */
+void parsec_oa_hash_table_for_all(parsec_oa_hash_table_t *ht, parsec_hash_elem_fct_t fct, void *cb_data);
+
+/**
+ * @brief displays statistics about the hash table
+ *
+ * @details displays the occupancy and probe lengths of the arrays of the
+ *          hash table with parsec_inform. Not thread safe.
+ *
+ *    @arg[in] ht the hash table
+ */
+void parsec_oa_hash_table_stat(parsec_oa_hash_table_t *ht);
+
+END_C_DECLS
+
+/** @} */
+
+#endif
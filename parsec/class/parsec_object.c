@@ -43,7 +43,8 @@ parsec_class_t parsec_object_t_class = {
     0,                    /* class hierarchy depth */
     NULL,                 /* array of constructors */
     NULL,                 /* array of destructors */
-    sizeof(parsec_object_t) /* size of the opal object */
+    sizeof(parsec_object_t), /* size of the opal object */
+    NULL                  /* free function */
 };
 
 /*
@@ -137,6 +137,7 @@ typedef struct parsec_object_t parsec_object_t;
 typedef struct parsec_class_t parsec_class_t;
 typedef void (*parsec_construct_t) (parsec_object_t *);
 typedef void (*parsec_destruct_t) (parsec_object_t *);
+typedef void (*parsec_free_t) (parsec_object_t *);
 
 
 /* types **************************************************************/
@@ -159,6 +160,8 @@ struct parsec_class_t {
     parsec_destruct_t *cls_destruct_array;
                                     /**< array of parent class destructors */
     size_t cls_sizeof;              /**< size of an object instance */
+    parsec_free_t cls_free;         /**< releases the storage of a destructed
+                                         instance, free() when NULL */
 };
 
 /**
@@ -220,7 +223,8 @@ struct parsec_object_t {
         (parsec_construct_t) CONSTRUCTOR,                                 \
         (parsec_destruct_t) DESTRUCTOR,                                   \
         0, 0, NULL, NULL,                                               \
-        sizeof(NAME)                                                    \
+        sizeof(NAME),                                                   \
+        NULL                                                            \
     }
 
 
@@ -314,7 +318,7 @@ static inline parsec_object_t *parsec_obj_new_debug(parsec_class_t* type, const
             parsec_obj_run_destructors((parsec_object_t *) (object));       \
             PARSEC_OBJ_SET_MAGIC_ID((object), 0);                      \
             PARSEC_OBJ_REMEMBER_FILE_AND_LINENO( object, __FILE__, __LINE__ ); \
-            free(object);                                       \
+            parsec_obj_free((parsec_object_t *) (object));      \
             object = NULL;                                      \
         }                                                       \
     } while (0)
@@ -323,7 +327,7 @@ static inline parsec_object_t *parsec_obj_new_debug(parsec_class_t* type, const
     do {                                                        \
         if (0 == parsec_obj_update((parsec_object_t *) (object), -1)) {     \
             parsec_obj_run_destructors((parsec_object_t *) (object));       \
-            free(object);                                       \
+            parsec_obj_free((parsec_object_t *) (object));      \
             object = NULL;                                      \
         }                                                       \
     } while (0)
@@ -475,6 +479,23 @@ static inline parsec_object_t *parsec_obj_new(parsec_class_t * cls)
     return object;
 }
 
+/**
+ * Release the storage of an object whose destructors have been run, with
+ * the free function of its class if it has one.
+ *
+ * Do not use this function directly: use PARSEC_OBJ_RELEASE() instead.
+ *
+ * @param object        Pointer to the object
+ */
+static inline void parsec_obj_free(parsec_object_t *object)
+{
+    if( NULL != object->obj_class->cls_free ) {
+        object->obj_class->cls_free(object);
+        return;
+    }
+    free(object);
+}
+
 #if defined(BUILDING_PARSEC)
 #include "parsec/sys/atomic.h"
 
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/class/wsdeque.h"
+#include "parsec/sys/atomic.h"
+#include "parsec/constants.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+struct parsec_wsdeque_array_s {
+    parsec_wsdeque_array_t *prev;           /**< Arrays previously used by the dequeue */
+    int64_t                 mask;           /**< Capacity of the array, minus one */
+    parsec_list_item_t     *volatile items[1];
+};
+
+static parsec_wsdeque_array_t *
+parsec_wsdeque_array_new(size_t size, parsec_wsdeque_array_t *prev)
+{
+    parsec_wsdeque_array_t *a;
+    assert( 0 == (size & (size-1)) );
+    a = (parsec_wsdeque_array_t*)malloc(sizeof(parsec_wsdeque_array_t) +
+                                        (size - 1) * sizeof(parsec_list_item_t*));
+    if( NULL == a ) return NULL;
+    a->prev = prev;
+    a->mask = (int64_t)size - 1;
+    return a;
+}
+
+static size_t parsec_wsdeque_pow2(size_t size)
+{
+    size_t s = 2;
+    while( s < size ) s <<= 1;
+    return s;
+}
+
+static void parsec_wsdeque_construct(parsec_wsdeque_t *deque)
+{
+    deque->top = 0;
+    deque->bottom = 0;
+    deque->max_size = PARSEC_WSDEQUE_DEFAULT_SIZE;
+    deque->array = parsec_wsdeque_array_new(PARSEC_WSDEQUE_DEFAULT_SIZE, NULL);
+}
+
+static void parsec_wsdeque_destruct(parsec_wsdeque_t *deque)
+{
+    parsec_wsdeque_array_t *a = deque->array, *prev;
+    while( NULL != a ) {
+        prev = a->prev;
+        free(a);
+        a = prev;
+    }
+    deque->array = NULL;
+}
+
+PARSEC_OBJ_CLASS_INSTANCE(parsec_wsdeque_t, parsec_object_t,
+                          parsec_wsdeque_construct, parsec_wsdeque_destruct);
+
+void parsec_wsdeque_init(parsec_wsdeque_t *deque, size_t initial_size, size_t max_size)
+{
+    assert( deque->top == deque->bottom );
+    initial_size = parsec_wsdeque_pow2(initial_size);
+    max_size = (0 == max_size) ? SIZE_MAX : parsec_wsdeque_pow2(max_size);
+    if( max_size < initial_size ) max_size = initial_size;
+    deque->max_size = max_size;
+    if( (size_t)(deque->array->mask + 1) != initial_size ) {
+        parsec_wsdeque_destruct(deque);
+        deque->array = parsec_wsdeque_array_new(initial_size, NULL);
+    }
+    deque->top = deque->bottom = 0;
+}
+
+/**
+ * Replace the current array by one twice as large. Only the owner
+ * calls this, and the elements between t and b are copied before the
+ * new array is published. The old array is kept alive, as thieves that
+ * read the array pointer before the switch might still access it.
+ */
+static parsec_wsdeque_array_t *
+parsec_wsdeque_grow(parsec_wsdeque_t *deque, parsec_wsdeque_array_t *a,
+                    int64_t t, int64_t b)
+{
+    parsec_wsdeque_array_t *na;
+    size_t size = (size_t)(a->mask + 1);
+    int64_t i;
+
+    if( size >= deque->max_size ) return NULL;
+    na = parsec_wsdeque_array_new(2 * size, a);
+    if( NULL == na ) return NULL;
+    for( i = t; i < b; i++ ) {
+        na->items[i & na->mask] = a->items[i & a->mask];
+    }
+    parsec_atomic_wmb();
+    deque->array = na;
+    return na;
+}
+
+int parsec_wsdeque_push(parsec_wsdeque_t *deque, parsec_list_item_t *item)
+{
+    int64_t b = deque->bottom;
+    int64_t t = deque->top;
+    parsec_wsdeque_array_t *a = deque->array;
+
+    if( b - t > a->mask ) {
+        a = parsec_wsdeque_grow(deque, a, t, b);
+        if( NULL == a ) return PARSEC_ERR_OUT_OF_RESOURCE;
+    }
+    a->items[b & a->mask] = item;
+    parsec_atomic_wmb();
+    deque->bottom = b + 1;
+    return PARSEC_SUCCESS;
+}
+
+parsec_list_item_t *
+parsec_wsdeque_push_ring(parsec_wsdeque_t *deque, parsec_list_item_t *ring)
+{
+    int64_t b = deque->bottom, b0 = b;
+    int64_t t = deque->top;
+    parsec_wsdeque_array_t *a = deque->array;
+    parsec_list_item_t *item;
+
+    while( NULL != ring ) {
+        if( b - t > a->mask ) {
+            /* Refresh top: thieves might have made room since we read it */
+            t = deque->top;
+            if( b - t > a->mask ) {
+                parsec_wsdeque_array_t *na = parsec_wsdeque_grow(deque, a, t, b);
+                if( NULL == na ) break;
+                a = na;
+            }
+        }
+        item = ring;
+        ring = parsec_list_item_ring_chop(item);
+        PARSEC_LIST_ITEM_SINGLETON(item);
+        a->items[b & a->mask] = item;
+        b++;
+    }
+    if( b != b0 ) {
+        parsec_atomic_wmb();
+        deque->bottom = b;
+    }
+    return ring;
+}
+
+parsec_list_item_t *
+parsec_wsdeque_pop(parsec_wsdeque_t *deque)
+{
+    int64_t b = deque->bottom - 1;
+    parsec_wsdeque_array_t *a = deque->array;
+    parsec_list_item_t *item;
+    int64_t t;
+
+    deque->bottom = b;
+    parsec_mfence();
+    t = deque->top;
+    if( t > b ) {
+        /* Empty dequeue */
+        deque->bottom = b + 1;
+        return NULL;
+    }
+    item = a->items[b & a->mask];
+    if( t == b ) {
+        /* Last element: race against the thieves */
+        if( !parsec_atomic_cas_int64(&deque->top, t, t + 1) ) {
+            item = NULL;
+        }
+        deque->bottom = b + 1;
+    }
+    return item;
+}
+
+parsec_list_item_t *
+parsec_wsdeque_steal(parsec_wsdeque_t *deque)
+{
+    int64_t t = deque->top;
+    parsec_wsdeque_array_t *a;
+    parsec_list_item_t *item;
+    int64_t b;
+
+    parsec_mfence();
+    b = deque->bottom;
+    if( t >= b ) return NULL;
+    parsec_atomic_rmb();
+    a = deque->array;
+    item = a->items[t & a->mask];
+    if( !parsec_atomic_cas_int64(&deque->top, t, t + 1) ) {
+        return NULL;
+    }
+    return item;
+}
+
+long long int parsec_wsdeque_approx_size(parsec_wsdeque_t *deque)
+{
+    int64_t t = deque->top;
+    int64_t b = deque->bottom;
+    return (b > t) ? (long long int)(b - t) : 0;
+}
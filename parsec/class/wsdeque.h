@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#ifndef WSDEQUE_H_HAS_BEEN_INCLUDED
+#define WSDEQUE_H_HAS_BEEN_INCLUDED
+
+#include "parsec/parsec_config.h"
+#include "parsec/class/list_item.h"
+#include <stdint.h>
+
+/**
+ * @defgroup parsec_internal_classes_wsdeque Work-Stealing Dequeue
+ * @ingroup parsec_internal_classes
+ * @{
+ *
+ *  @brief Chase-Lev work-stealing dequeue of parsec_list_item_t
+ *
+ *  @details A single owner pushes and pops elements at the bottom of
+ *  the dequeue without any atomic read-modify-write operation (a CAS
+ *  on the top index is only needed when the owner races with thieves
+ *  for the last element). Any other thread can steal elements from
+ *  the top of the dequeue, using one CAS on the top index.
+ *
+ *  The implementation follows "Correct and Efficient Work-Stealing for
+ *  Weak Memory Models" (N.M. Lê, A. Pop, A. Cohen, F. Zappa Nardelli,
+ *  PPoPP'13). The circular array grows (by powers of two) when the owner
+ *  pushes into a full dequeue, until it reaches the bound given at
+ *  initialization; past that bound, push operations fail and the caller
+ *  is expected to store the elements elsewhere. The arrays that are
+ *  replaced by a larger one are kept until the dequeue is destructed, as
+ *  a thief might still be reading from them.
+ *
+ *  Elements are not linked through their list_next / list_prev fields
+ *  while they are in the dequeue: these fields can be used by the caller.
+ */
+
+BEGIN_C_DECLS
+
+typedef struct parsec_wsdeque_array_s parsec_wsdeque_array_t;
+
+/** Size used to keep the indices modified by the owner and by the
+ *  thieves on separate cache lines */
+#define PARSEC_WSDEQUE_CACHE_LINE_SIZE 64
+
+/**
+ * @brief A work-stealing dequeue object
+ */
+typedef struct parsec_wsdeque_s parsec_wsdeque_t;
+PARSEC_DECLSPEC PARSEC_OBJ_CLASS_DECLARATION(parsec_wsdeque_t);
+
+struct parsec_wsdeque_s {
+    parsec_object_t                  super;
+    volatile int64_t                 top;       /**< Index of the oldest element, advanced by thieves */
+    char                             pad0[PARSEC_WSDEQUE_CACHE_LINE_SIZE - sizeof(int64_t)];
+    volatile int64_t                 bottom;    /**< Index of the next free slot, owned by the owner */
+    parsec_wsdeque_array_t *volatile array;     /**< Current circular array */
+    size_t                           max_size;  /**< Maximal number of elements */
+    char                             pad1[PARSEC_WSDEQUE_CACHE_LINE_SIZE - sizeof(int64_t) - sizeof(void*) - sizeof(size_t)];
+};
+
+#define PARSEC_WSDEQUE_DEFAULT_SIZE 256
+
+/**
+ * @brief Set the initial and maximal sizes of a dequeue
+ *
+ * @details Must be called after the dequeue has been constructed, and
+ *   before it is used. Both sizes are rounded up to the next power of 2.
+ *   A dequeue that is not initialized has an initial and a maximal size
+ *   of PARSEC_WSDEQUE_DEFAULT_SIZE.
+ *
+ * @param[inout] deque the dequeue to initialize
+ * @param[in] initial_size the initial capacity of the dequeue
+ * @param[in] max_size the maximal capacity of the dequeue, 0 for no bound
+ *
+ * @remark this function is not thread safe
+ */
+PARSEC_DECLSPEC void
+parsec_wsdeque_init(parsec_wsdeque_t *deque, size_t initial_size, size_t max_size);
+
+/**
+ * @brief Push an element at the bottom of the dequeue
+ *
+ * @param[inout] deque the dequeue
+ * @param[inout] item the element to push
+ * @return PARSEC_SUCCESS, or PARSEC_ERR_OUT_OF_RESOURCE if the dequeue
+ *   reached its maximal size
+ *
+ * @remark this function must only be called by the owner of the dequeue
+ */
+PARSEC_DECLSPEC int
+parsec_wsdeque_push(parsec_wsdeque_t *deque, parsec_list_item_t *item);
+
+/**
+ * @brief Push a ring of elements at the bottom of the dequeue
+ *
+ * @details the elements are pushed in the order of the ring, with a
+ *   single publication of the bottom index. The last element of the
+ *   ring is thus the first one that the owner will pop, and the first
+ *   element of the ring is the first one that a thief will steal.
+ *
+ * @param[inout] deque the dequeue
+ * @param[inout] ring the ring of elements to push
+ * @return NULL if all the elements were pushed, or the ring of elements
+ *   that did not fit in the dequeue because it reached its maximal size
+ *
+ * @remark this function must only be called by the owner of the dequeue
+ */
+PARSEC_DECLSPEC parsec_list_item_t*
+parsec_wsdeque_push_ring(parsec_wsdeque_t *deque, parsec_list_item_t *ring);
+
+/**
+ * @brief Pop the most recently pushed element
+ *
+ * @param[inout] deque the dequeue
+ * @return the element, or NULL if the dequeue is empty
+ *
+ * @remark this function must only be called by the owner of the dequeue
+ */
+PARSEC_DECLSPEC parsec_list_item_t*
+parsec_wsdeque_pop(parsec_wsdeque_t *deque);
+
+/**
+ * @brief Steal the oldest element of the dequeue
+ *
+ * @param[inout] deque the dequeue
+ * @return the element, or NULL if the dequeue is empty or if another
+ *   thread took the element concurrently
+ *
+ * @remark this function is thread safe
+ */
+PARSEC_DECLSPEC parsec_list_item_t*
+parsec_wsdeque_steal(parsec_wsdeque_t *deque);
+
+/**
+ * @brief Returns (approximately) how many elements are in the dequeue
+ *
+ * @param[in] deque the dequeue
+ * @return the number of elements at the time of the call
+ *
+ * @remark this function is thread safe, but the result may be outdated
+ *   when the function returns.
+ */
+PARSEC_DECLSPEC long long int
+parsec_wsdeque_approx_size(parsec_wsdeque_t *deque);
+
+/**
+ * @brief check if the dequeue is empty
+ *
+ * @param[in] deque the dequeue
+ * @return 1 if the dequeue is (approximately) empty, 0 otherwise
+ *
+ * @remark this function is thread safe, with the same limitations as
+ *   parsec_wsdeque_approx_size
+ */
+static inline int
+parsec_wsdeque_is_empty(parsec_wsdeque_t *deque)
+{
+    return parsec_wsdeque_approx_size(deque) <= 0;
+}
+
+END_C_DECLS
+
+/** @} */
+
+#endif  /* WSDEQUE_H_HAS_BEEN_INCLUDED */
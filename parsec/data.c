@@ -5,6 +5,7 @@
  */
 
 #include "parsec/parsec_config.h"
+#include <pthread.h>
 #include "parsec/class/lifo.h"
 #include "parsec/constants.h"
 #include "parsec/mca/device/device.h"
@@ -16,8 +17,177 @@
 #include "parsec/remote_dep.h"
 #include "parsec/parsec_internal.h"
 
-static parsec_lifo_t parsec_data_lifo;
-static parsec_lifo_t parsec_data_copies_lifo;
+/*
+ * The parsec_data_t and parsec_data_copy_t released by PARSEC_OBJ_RELEASE
+ * are recycled instead of being freed: each thread keeps some of them in a
+ * private cache, and shares the others with all the threads in a LIFO.
+ * The temporary copies (remote receptions, reshapes, DTD tiles) are then
+ * allocated without malloc, and without going through the class system.
+ */
+#define PARSEC_DATA_POOL_DATA       0
+#define PARSEC_DATA_POOL_COPIES     1
+#define PARSEC_DATA_POOL_NB         2
+
+/* Number of objects of each type a thread keeps for itself */
+#define PARSEC_DATA_POOL_CACHE_SIZE 64
+
+int parsec_data_pool_enabled = 1;
+
+/**
+ * The cache of a thread, chained through the list_next of the objects.
+ * These are chained when the thread first allocates or releases a data or
+ * a copy, and are flushed to the shared LIFO and freed when the thread
+ * exits (or by parsec_data_fini for the threads still alive).
+ */
+typedef struct parsec_data_pool_thread_s {
+    struct parsec_data_pool_thread_s *next;
+    parsec_list_item_t               *cache[PARSEC_DATA_POOL_NB];
+    int                               nb_cached[PARSEC_DATA_POOL_NB];
+    uint64_t                          nb_allocated[PARSEC_DATA_POOL_NB];
+    uint64_t                          nb_recycled[PARSEC_DATA_POOL_NB];
+    uint64_t                          nb_released[PARSEC_DATA_POOL_NB];
+} parsec_data_pool_thread_t;
+
+static parsec_lifo_t parsec_data_pool_lifo[PARSEC_DATA_POOL_NB];
+/* The caches of the threads alive, and the counters of those that exited */
+static parsec_data_pool_thread_t *parsec_data_pool_threads = NULL;
+static parsec_data_pool_thread_t parsec_data_pool_exited;
+static parsec_atomic_lock_t parsec_data_pool_threads_lock = PARSEC_ATOMIC_UNLOCKED;
+/* A pthread key rather than a PARSEC_TLS, for its destructor. It only lives
+ * between parsec_data_init and parsec_data_fini, so that the caches freed
+ * by parsec_data_fini cannot be reached by the threads that survive it. */
+static pthread_key_t parsec_data_pool_key;
+static int parsec_data_pool_key_ready = 0;
+
+/* Moves the objects of the cache of t to the shared LIFO */
+static void parsec_data_pool_flush(parsec_data_pool_thread_t *t)
+{
+    parsec_list_item_t *item;
+    int pool;
+
+    for( pool = 0; pool < PARSEC_DATA_POOL_NB; pool++ ) {
+        while( NULL != (item = t->cache[pool]) ) {
+            t->cache[pool] = (parsec_list_item_t*)item->list_next;
+            PARSEC_OBJ_CONSTRUCT(item, parsec_list_item_t);
+            parsec_lifo_push(&parsec_data_pool_lifo[pool], item);
+        }
+        t->nb_cached[pool] = 0;
+    }
+}
+
+/* Unchains t from the threads alive, and keeps its counters */
+static void parsec_data_pool_thread_retire(parsec_data_pool_thread_t *t)
+{
+    parsec_data_pool_thread_t **prev;
+    int pool;
+
+    parsec_atomic_lock(&parsec_data_pool_threads_lock);
+    for( prev = &parsec_data_pool_threads; *prev != t; prev = &(*prev)->next );
+    *prev = t->next;
+    for( pool = 0; pool < PARSEC_DATA_POOL_NB; pool++ ) {
+        parsec_data_pool_exited.nb_allocated[pool] += t->nb_allocated[pool];
+        parsec_data_pool_exited.nb_recycled[pool]  += t->nb_recycled[pool];
+        parsec_data_pool_exited.nb_released[pool]  += t->nb_released[pool];
+    }
+    parsec_atomic_unlock(&parsec_data_pool_threads_lock);
+}
+
+/* Destructor of the key, called when a thread with a cache exits */
+static void parsec_data_pool_thread_release(void *_t)
+{
+    parsec_data_pool_thread_t *t = (parsec_data_pool_thread_t*)_t;
+
+    parsec_data_pool_flush(t);
+    parsec_data_pool_thread_retire(t);
+    free(t);
+}
+
+static parsec_data_pool_thread_t *parsec_data_pool_thread(void)
+{
+    parsec_data_pool_thread_t *t;
+
+    t = (parsec_data_pool_thread_t*)pthread_getspecific(parsec_data_pool_key);
+    if( NULL != t ) return t;
+
+    t = (parsec_data_pool_thread_t*)calloc(1, sizeof(parsec_data_pool_thread_t));
+    parsec_atomic_lock(&parsec_data_pool_threads_lock);
+    t->next = parsec_data_pool_threads;
+    parsec_data_pool_threads = t;
+    parsec_atomic_unlock(&parsec_data_pool_threads_lock);
+    pthread_setspecific(parsec_data_pool_key, t);
+    return t;
+}
+
+/* Returns a constructed object of cls from the pool, or NULL if the pool
+ * is empty (or disabled) and the object must be allocated */
+static parsec_object_t *parsec_data_pool_get(int pool, parsec_class_t *cls)
+{
+    parsec_data_pool_thread_t *t;
+    parsec_list_item_t *item = NULL;
+
+    if( !parsec_data_pool_key_ready )  /* outside of parsec_data_init/fini */
+        return NULL;
+    t = parsec_data_pool_thread();
+    if( NULL != cls->cls_free ) {
+        if( NULL != (item = t->cache[pool]) ) {
+            t->cache[pool] = (parsec_list_item_t*)item->list_next;
+            t->nb_cached[pool]--;
+        } else {
+            item = parsec_lifo_pop(&parsec_data_pool_lifo[pool]);
+        }
+    }
+    if( NULL == item ) {
+        t->nb_allocated[pool]++;
+        return NULL;
+    }
+    t->nb_recycled[pool]++;
+    /* The class is initialized, and the destructors left the object in a
+     * known state: only the constructors are run on reuse */
+    PARSEC_OBJ_SET_MAGIC_ID(item, PARSEC_OBJ_MAGIC_ID);
+    ((parsec_object_t*)item)->obj_class = cls;
+    ((parsec_object_t*)item)->obj_reference_count = 1;
+    parsec_obj_run_constructors((parsec_object_t*)item);
+    PARSEC_OBJ_REMEMBER_FILE_AND_LINENO(item, __FILE__, __LINE__);
+    return (parsec_object_t*)item;
+}
+
+static void parsec_data_pool_put(int pool, parsec_object_t *obj)
+{
+    parsec_data_pool_thread_t *t = parsec_data_pool_thread();
+    parsec_list_item_t *item = (parsec_list_item_t*)obj;
+
+    t->nb_released[pool]++;
+    if( t->nb_cached[pool] < PARSEC_DATA_POOL_CACHE_SIZE ) {
+        item->list_next = t->cache[pool];
+        t->cache[pool] = item;
+        t->nb_cached[pool]++;
+        return;
+    }
+    /* The object is destructed: reuse its storage as a plain list item */
+    PARSEC_OBJ_CONSTRUCT(item, parsec_list_item_t);
+    parsec_lifo_push(&parsec_data_pool_lifo[pool], item);
+}
+
+static void parsec_data_pool_free(parsec_object_t *obj)
+{
+    parsec_data_pool_put(PARSEC_DATA_POOL_DATA, obj);
+}
+
+static void parsec_data_copy_pool_free(parsec_object_t *obj)
+{
+    parsec_data_pool_put(PARSEC_DATA_POOL_COPIES, obj);
+}
+
+static parsec_data_copy_t *parsec_data_copy_allocate(void)
+{
+    parsec_data_copy_t *copy;
+
+    copy = (parsec_data_copy_t*)parsec_data_pool_get(PARSEC_DATA_POOL_COPIES,
+                                                     PARSEC_OBJ_CLASS(parsec_data_copy_t));
+    if( NULL == copy )
+        copy = PARSEC_OBJ_NEW(parsec_data_copy_t);
+    return copy;
+}
 
 
 static void parsec_data_copy_construct(parsec_data_copy_t* obj)
@@ -114,8 +284,12 @@ PARSEC_OBJ_CLASS_INSTANCE(parsec_data_t, parsec_object_t,
 
 int parsec_data_init(parsec_context_t* context)
 {
-    PARSEC_OBJ_CONSTRUCT(&parsec_data_lifo, parsec_lifo_t);
-    PARSEC_OBJ_CONSTRUCT(&parsec_data_copies_lifo, parsec_lifo_t);
+    PARSEC_OBJ_CONSTRUCT(&parsec_data_pool_lifo[PARSEC_DATA_POOL_DATA], parsec_lifo_t);
+    PARSEC_OBJ_CONSTRUCT(&parsec_data_pool_lifo[PARSEC_DATA_POOL_COPIES], parsec_lifo_t);
+    if( !parsec_data_pool_key_ready ) {
+        pthread_key_create(&parsec_data_pool_key, parsec_data_pool_thread_release);
+        parsec_data_pool_key_ready = 1;
+    }
     /**
      * This is a trick. Now that we know the number of available devices
      * we can update the size of the parsec_data_t class to the correct value.
@@ -125,29 +299,76 @@ int parsec_data_init(parsec_context_t* context)
         return PARSEC_ERROR;
     }
     parsec_data_t_class.cls_sizeof += sizeof(parsec_data_copy_t*) * parsec_nb_devices;
+    if( parsec_data_pool_enabled ) {
+        /* The pools keep the released objects as list items */
+        assert(sizeof(parsec_data_t) >= sizeof(parsec_list_item_t));
+        parsec_data_t_class.cls_free = parsec_data_pool_free;
+        parsec_data_copy_t_class.cls_free = parsec_data_copy_pool_free;
+    }
     return PARSEC_SUCCESS;
 }
 
 int parsec_data_fini(parsec_context_t* context)
 {
-    PARSEC_OBJ_DESTRUCT(&parsec_data_lifo);
-    PARSEC_OBJ_DESTRUCT(&parsec_data_copies_lifo);
+    parsec_data_pool_thread_t *t;
+    parsec_list_item_t *item;
+    int pool;
+
+    /* From now on the released objects are freed */
+    parsec_data_t_class.cls_free = NULL;
+    parsec_data_copy_t_class.cls_free = NULL;
+    /* The threads still alive will not run the destructor of the key */
+    if( parsec_data_pool_key_ready ) {
+        pthread_key_delete(parsec_data_pool_key);
+        parsec_data_pool_key_ready = 0;
+    }
+    while( NULL != (t = parsec_data_pool_threads) ) {
+        parsec_data_pool_flush(t);
+        parsec_data_pool_thread_retire(t);
+        free(t);
+    }
+    for( pool = 0; pool < PARSEC_DATA_POOL_NB; pool++ ) {
+        while( NULL != (item = parsec_lifo_pop(&parsec_data_pool_lifo[pool])) )
+            free(item);
+        PARSEC_OBJ_DESTRUCT(&parsec_data_pool_lifo[pool]);
+    }
     (void)context;
     return PARSEC_SUCCESS;
 }
 
+void parsec_data_pool_stats(parsec_data_pool_stats_t *stats)
+{
+    parsec_data_pool_thread_t *t;
+
+    parsec_atomic_lock(&parsec_data_pool_threads_lock);
+    t = &parsec_data_pool_exited;
+    stats->data_allocated   = t->nb_allocated[PARSEC_DATA_POOL_DATA];
+    stats->data_recycled    = t->nb_recycled[PARSEC_DATA_POOL_DATA];
+    stats->copies_allocated = t->nb_allocated[PARSEC_DATA_POOL_COPIES];
+    stats->copies_recycled  = t->nb_recycled[PARSEC_DATA_POOL_COPIES];
+    stats->data_released    = t->nb_released[PARSEC_DATA_POOL_DATA];
+    stats->copies_released  = t->nb_released[PARSEC_DATA_POOL_COPIES];
+    for( t = parsec_data_pool_threads; NULL != t; t = t->next ) {
+        stats->data_allocated   += t->nb_allocated[PARSEC_DATA_POOL_DATA];
+        stats->data_recycled    += t->nb_recycled[PARSEC_DATA_POOL_DATA];
+        stats->copies_allocated += t->nb_allocated[PARSEC_DATA_POOL_COPIES];
+        stats->copies_recycled  += t->nb_recycled[PARSEC_DATA_POOL_COPIES];
+        stats->data_released    += t->nb_released[PARSEC_DATA_POOL_DATA];
+        stats->copies_released  += t->nb_released[PARSEC_DATA_POOL_COPIES];
+    }
+    parsec_atomic_unlock(&parsec_data_pool_threads_lock);
+}
+
 /**
  *
  */
 parsec_data_t* parsec_data_new(void)
 {
-    parsec_data_t* item = (parsec_data_t*)parsec_lifo_pop(&parsec_data_lifo);
-    if( NULL == item ) {
+    parsec_data_t* item;
+
+    item = (parsec_data_t*)parsec_data_pool_get(PARSEC_DATA_POOL_DATA, PARSEC_OBJ_CLASS(parsec_data_t));
+    if( NULL == item )
         item = PARSEC_OBJ_NEW(parsec_data_t);
-        if( NULL == item ) return NULL;
-    } else {
-        PARSEC_OBJ_CONSTRUCT(item, parsec_object_t);
-    }
     return item;
 }
 
@@ -156,8 +377,8 @@ parsec_data_t* parsec_data_new(void)
  */
 void parsec_data_delete(parsec_data_t* data)
 {
-    PARSEC_LIST_ITEM_SINGLETON((parsec_list_item_t*)data);
-    parsec_lifo_push(&parsec_data_lifo, (parsec_list_item_t*)data);
+    PARSEC_OBJ_DESTRUCT(data);
+    parsec_obj_free((parsec_object_t*)data);
 }
 
 inline int
@@ -211,14 +432,9 @@ parsec_data_copy_t* parsec_data_copy_new(parsec_data_t* data, uint8_t device,
 {
     parsec_data_copy_t* copy;
 
-    copy = (parsec_data_copy_t*)parsec_lifo_pop(&parsec_data_copies_lifo);
+    copy = parsec_data_copy_allocate();
     if( NULL == copy ) {
-        copy = PARSEC_OBJ_NEW(parsec_data_copy_t);
-        if( NULL == copy ) {
-            return NULL;
-        }
-    } else {
-        PARSEC_OBJ_CONSTRUCT(copy, parsec_data_copy_t);
+        return NULL;
     }
     copy->flags = flags;
     if( PARSEC_SUCCESS != parsec_data_copy_attach(data, copy, device) ) {
@@ -490,8 +706,8 @@ parsec_data_create( parsec_data_t **holder,
     parsec_data_t *data = *holder;
 
     if( NULL == data ) {
-        parsec_data_copy_t* data_copy = PARSEC_OBJ_NEW(parsec_data_copy_t);
-        data = PARSEC_OBJ_NEW(parsec_data_t);
+        parsec_data_copy_t* data_copy = parsec_data_copy_allocate();
+        data = parsec_data_new();
 
         data_copy->coherency_state = PARSEC_DATA_COHERENCY_OWNED;
         data_copy->device_private = ptr;
@@ -528,8 +744,8 @@ parsec_data_create_with_type( parsec_data_collection_t *desc,
 {
     parsec_data_t *clone;
 
-    parsec_data_copy_t* data_copy = PARSEC_OBJ_NEW(parsec_data_copy_t);
-    clone = PARSEC_OBJ_NEW(parsec_data_t);
+    parsec_data_copy_t* data_copy = parsec_data_copy_allocate();
+    clone = parsec_data_new();
 
     data_copy->coherency_state = PARSEC_DATA_COHERENCY_OWNED;
     data_copy->device_private = ptr;
@@ -98,6 +98,23 @@ PARSEC_DECLSPEC parsec_data_t* parsec_data_new(void);
  */
 PARSEC_DECLSPEC void parsec_data_delete(parsec_data_t* data);
 
+/**
+ * Number of data and data copies allocated with malloc, of those recycled
+ * from the pools of released objects (see the MCA parameter
+ * runtime_data_pool), and of those released to the pools, by all the
+ * threads since the first initialization.
+ */
+typedef struct parsec_data_pool_stats_s {
+    uint64_t data_allocated;
+    uint64_t data_recycled;
+    uint64_t data_released;
+    uint64_t copies_allocated;
+    uint64_t copies_recycled;
+    uint64_t copies_released;
+} parsec_data_pool_stats_t;
+
+PARSEC_DECLSPEC void parsec_data_pool_stats(parsec_data_pool_stats_t *stats);
+
 /**
  * Attach a new copy corresponding to the specified device to a data. If a copy
  * for the device is already attached, nothing will be done and an error code
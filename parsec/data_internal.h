@@ -27,6 +27,12 @@
  */
 extern uint32_t parsec_supported_number_of_devices;
 
+/**
+ * Recycle the released data and data copies instead of freeing them
+ * (MCA parameter runtime_data_pool).
+ */
+extern int parsec_data_pool_enabled;
+
 /**
  * This structure is the keeper of all the information regarding
  * each unique data that can be handled by the system. It contains
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2009-2018 The University of Tennessee and The University
+ * Copyright (c) 2009-2022 The University of Tennessee and The University
  *                         of Tennessee Research Foundation.  All rights
  *                         reserved.
  */
@@ -170,6 +170,28 @@ __data_repo_entry_addto_usage_limit(data_repo_t *repo, parsec_key_t key, uint32_
     }
 }
 
+void
+__data_repo_entry_addto_static_usage_limit(data_repo_t *repo, data_repo_entry_t *e, uint32_t usagelmt
+#if defined(PARSEC_DEBUG_NOISIER)
+                                           , const char *tablename, const char *file, int line
+#endif
+                                           )
+{
+    int32_t ov;
+#if defined(PARSEC_DEBUG_NOISIER)
+    char estr[64];
+#endif
+
+    (void)repo;
+    assert( e->usagecnt < e->usagelmt );
+    ov = parsec_atomic_fetch_add_int32(&e->usagelmt, (int32_t)usagelmt);
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output,
+                         "entry %p/%s of hash table %s has a usage count of %u/%u (static) and is %s retained at %s:%d",
+                         e, repo->table.key_functions.key_print(estr, 64, e->ht_item.key, repo->table.hash_data), tablename,
+                         e->usagecnt, ov + usagelmt, e->retained ? "still" : "not", file, line);
+    (void)ov;
+}
+
 #if defined(PARSEC_DEBUG_NOISIER)
 static void print_data_repo_entry(void *item, void *cb_data)
 {
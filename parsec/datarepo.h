@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2009-2019 The University of Tennessee and The University
+ * Copyright (c) 2009-2022 The University of Tennessee and The University
  *                         of Tennessee Research Foundation.  All rights
  *                         reserved.
  */
@@ -37,10 +37,13 @@ typedef struct data_repo_head_s  data_repo_head_t;
  *       threads use this element 3 times. The element is going to be removed while the
  *       pushing thread is still exploring, and SEGFAULT will occur.
  *
- *  An alternative solution consisted in having a function that will compute how many
- *  times the element will be used at creation time, and keep this for the whole life
- *  of the entry without changing it. But this requires to write a specialized function
- *  dumped by the precompiler, that will do a loop on the predicates. This was ruled out.
+ *  An alternative solution consists in having a function that computes how many
+ *  times the element will be used before any of its users can see it. The PTG
+ *  precompiler dumps such a function for the task classes whose successors can only
+ *  use the entry of the task itself (see jdf_function_has_static_usage): as the task
+ *  keeps a usage of its own entry until the end of its release_deps, the whole usage
+ *  limit of its successors is added at once with data_repo_entry_addto_static_usage_limit,
+ *  without retaining the entry, before the successors are released.
  *
  *  The element can still be inserted in the table, counted for some data (not all),
  *  used by some tasks (not all), removed from the table, then re-inserted when a
@@ -102,6 +105,9 @@ data_repo_lookup_entry(data_repo_t *repo, parsec_key_t key);
 /* If using lookup_and_create, don't forget to call add_to_usage_limit on the same entry when
  * you're done counting the number of references, otherwise the entry is non erasable.
  * See comment near the structure definition.
+ * addto_static_usage_limit can only be called on an entry that the caller has not used
+ * yet, after its own use was added to the usage limit: the entry cannot be released
+ * meanwhile, and it does not need to be retained.
  */
 #if defined(PARSEC_DEBUG_NOISIER)
 
@@ -123,6 +129,12 @@ void
 __data_repo_entry_addto_usage_limit(data_repo_t *repo, parsec_key_t key, uint32_t usagelmt,
                                     const char *tablename, const char *file, int line);
 
+# define data_repo_entry_addto_static_usage_limit(repo, entry, usagelmt)     \
+    __data_repo_entry_addto_static_usage_limit(repo, entry, usagelmt, #repo, __FILE__, __LINE__)
+void
+__data_repo_entry_addto_static_usage_limit(data_repo_t *repo, data_repo_entry_t *entry, uint32_t usagelmt,
+                                           const char *tablename, const char *file, int line);
+
 #else
 
 # define data_repo_lookup_entry_and_create(eu, repo, key)   \
@@ -139,6 +151,11 @@ __data_repo_entry_used_once(data_repo_t *repo, parsec_key_t key);
 void
 __data_repo_entry_addto_usage_limit(data_repo_t *repo, parsec_key_t key, uint32_t usagelmt);
 
+# define data_repo_entry_addto_static_usage_limit(repo, entry, usagelmt) \
+    __data_repo_entry_addto_static_usage_limit(repo, entry, usagelmt)
+void
+__data_repo_entry_addto_static_usage_limit(data_repo_t *repo, data_repo_entry_t *entry, uint32_t usagelmt);
+
 #endif
 
 void data_repo_destroy_nothreadsafe(data_repo_t *repo);
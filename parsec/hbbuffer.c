@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2009-2018 The University of Tennessee and The University
+ * Copyright (c) 2009-2022 The University of Tennessee and The University
  *                         of Tennessee Research Foundation.  All rights
  *                         reserved.
  */
@@ -10,26 +10,203 @@
 #include "parsec/sys/atomic.h"
 #include "parsec/hbbuffer.h"
 #include "parsec/maxheap.h"
+#include "parsec/mca/pins/pins.h"
+#include "parsec/utils/mca_param.h"
 
 #include <stdlib.h>
 
+static int parsec_hbbuffer_adaptive = 0;
+static int parsec_hbbuffer_min_size = 0;
+static int parsec_hbbuffer_max_size = 0;
+static int parsec_hbbuffer_adapt_window = 64;
+static int parsec_hbbuffer_grow_threshold = 25;
+
+int parsec_hbbuffers_init(void)
+{
+    parsec_mca_param_reg_int_name("parsec", "hbbuffer_adaptive",
+                                  "Let the bounded buffers of the schedulers that support it (lfq, ltq) resize "
+                                  "themselves based on their occupancy and on how often they overflow into their "
+                                  "parent store (1=true, 0=false).",
+                                  false, false, parsec_hbbuffer_adaptive, &parsec_hbbuffer_adaptive);
+    parsec_mca_param_reg_int_name("parsec", "hbbuffer_min_size",
+                                  "Minimal size of an adaptive bounded buffer (0 for the size chosen by the scheduler).",
+                                  false, false, parsec_hbbuffer_min_size, &parsec_hbbuffer_min_size);
+    parsec_mca_param_reg_int_name("parsec", "hbbuffer_max_size",
+                                  "Maximal size of an adaptive bounded buffer (0 for 8 times the size chosen by the scheduler).",
+                                  false, false, parsec_hbbuffer_max_size, &parsec_hbbuffer_max_size);
+    parsec_mca_param_reg_int_name("parsec", "hbbuffer_adapt_window",
+                                  "Number of push operations between two resize decisions of an adaptive bounded buffer.",
+                                  false, false, parsec_hbbuffer_adapt_window, &parsec_hbbuffer_adapt_window);
+    parsec_mca_param_reg_int_name("parsec", "hbbuffer_grow_threshold",
+                                  "Percentage of the push operations of a window that must overflow into the parent "
+                                  "store for an adaptive bounded buffer to double its size.",
+                                  false, false, parsec_hbbuffer_grow_threshold, &parsec_hbbuffer_grow_threshold);
+    if( parsec_hbbuffer_adapt_window < 1 ) parsec_hbbuffer_adapt_window = 1;
+    if( parsec_hbbuffer_grow_threshold < 0 ) parsec_hbbuffer_grow_threshold = 0;
+    return PARSEC_SUCCESS;
+}
+
 parsec_hbbuffer_t*
-parsec_hbbuffer_new(size_t size,  size_t ideal_fill,
-                    parsec_hbbuffer_parent_push_fct_t parent_push_fct,
-                    void *parent_store)
+parsec_hbbuffer_new_bounded(size_t size, size_t min_size, size_t max_size,
+                            size_t ideal_fill,
+                            parsec_hbbuffer_parent_push_fct_t parent_push_fct,
+                            void *parent_store)
 {
+    parsec_hbbuffer_t *n;
+
+    if( min_size < 1 ) min_size = 1;
+    if( max_size < min_size ) max_size = min_size;
+    if( size < min_size ) size = min_size;
+    if( size > max_size ) size = max_size;
     /** Must use calloc to ensure that all ites are set to NULL */
-    parsec_hbbuffer_t *n = (parsec_hbbuffer_t*)calloc(1, sizeof(parsec_hbbuffer_t) + (size-1)*sizeof(parsec_list_item_t*));
+    n = (parsec_hbbuffer_t*)calloc(1, sizeof(parsec_hbbuffer_t) + (max_size-1)*sizeof(parsec_list_item_t*));
     assert(NULL != parent_store);
     n->size = size;
+    n->min_size = min_size;
+    n->max_size = max_size;
+    n->used_size = (int64_t)size;
+    n->adapt_window = parsec_hbbuffer_adapt_window;
+    n->grow_threshold = parsec_hbbuffer_grow_threshold;
     n->ideal_fill = ideal_fill;
         /** n->nbelt = 0; <not needed because callc */
     n->parent_push_fct = parent_push_fct;
     n->parent_store = parent_store;
-    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HBB:\tCreated a new hierarchical buffer of %d elements", (int)size);
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HBB:\tCreated a new hierarchical buffer of %d elements (between %d and %d)",
+                         (int)size, (int)min_size, (int)max_size);
     return n;
 }
 
+parsec_hbbuffer_t*
+parsec_hbbuffer_new(size_t size,  size_t ideal_fill,
+                    parsec_hbbuffer_parent_push_fct_t parent_push_fct,
+                    void *parent_store)
+{
+    return parsec_hbbuffer_new_bounded(size, size, size, ideal_fill, parent_push_fct, parent_store);
+}
+
+parsec_hbbuffer_t*
+parsec_hbbuffer_new_adaptive(size_t size, size_t ideal_fill,
+                             parsec_hbbuffer_parent_push_fct_t parent_push_fct,
+                             void *parent_store)
+{
+    size_t min_size = size, max_size = size;
+
+    if( parsec_hbbuffer_adaptive ) {
+        if( parsec_hbbuffer_min_size > 0 ) min_size = (size_t)parsec_hbbuffer_min_size;
+        max_size = (parsec_hbbuffer_max_size > 0) ? (size_t)parsec_hbbuffer_max_size : 8 * size;
+    }
+    return parsec_hbbuffer_new_bounded(size, min_size, max_size, ideal_fill, parent_push_fct, parent_store);
+}
+
+static void
+parsec_hbbuffer_raise_used_size(parsec_hbbuffer_t *b, int64_t used)
+{
+    int64_t u;
+    do {
+        u = b->used_size;
+        if( u >= used ) return;
+    } while( !parsec_atomic_cas_int64(&b->used_size, u, used) );
+}
+
+/**
+ * An element was stored in slot i. If the buffer shrank since the slot was
+ * chosen, make sure that the pop operations still scan it: either we see
+ * the shrunk used_size here, or the shrinking thread sees the element when
+ * it checks the slots past the end of the buffer again.
+ */
+static inline void
+parsec_hbbuffer_slot_used(parsec_hbbuffer_t *b, size_t i)
+{
+    if( i < b->size ) return;
+    parsec_mfence();
+    parsec_hbbuffer_raise_used_size(b, (int64_t)i + 1);
+}
+
+static int
+parsec_hbbuffer_slots_empty(parsec_hbbuffer_t *b, int64_t from, int64_t to)
+{
+    for( ; from < to; from++ )
+        if( NULL != b->items[from] )
+            return 0;
+    return 1;
+}
+
+/**
+ * Take a resize decision based on the push operations of the last window
+ * and on the current occupancy of the buffer. Only the thread that completed
+ * the window calls this function, so there is a single resizer at a time.
+ */
+static void
+parsec_hbbuffer_resize(parsec_hbbuffer_t *b)
+{
+    parsec_hbbuffer_resize_event_t event;
+    size_t old_size = b->size, new_size = old_size;
+    int64_t used;
+
+    event.buffer = b;
+    event.nb_pushes = b->nb_pushes;
+    event.nb_overflows = b->nb_overflows;
+    event.occupancy = (int32_t)parsec_hbbuffer_approx_occupency(b);
+
+    if( (int64_t)event.nb_overflows * 100 > (int64_t)event.nb_pushes * b->grow_threshold ) {
+        new_size = (2 * old_size < b->max_size) ? 2 * old_size : b->max_size;
+    } else if( (0 == event.nb_overflows) && ((size_t)event.occupancy * 4 <= old_size) ) {
+        new_size = (old_size / 2 > b->min_size) ? old_size / 2 : b->min_size;
+    }
+
+    if( new_size > old_size ) {
+        /* The new slots must be scanned before anything is stored in them */
+        parsec_hbbuffer_raise_used_size(b, (int64_t)new_size);
+        parsec_atomic_wmb();
+        b->size = new_size;
+        b->nb_grows++;
+    } else if( new_size < old_size ) {
+        b->size = new_size;
+        b->nb_shrinks++;
+    }
+
+    /* Stop scanning the slots past the end of the buffer once they are empty */
+    used = b->used_size;
+    if( (used > (int64_t)b->size) &&
+        parsec_hbbuffer_slots_empty(b, (int64_t)b->size, used) &&
+        parsec_atomic_cas_int64(&b->used_size, used, (int64_t)b->size) ) {
+        parsec_mfence();
+        if( !parsec_hbbuffer_slots_empty(b, (int64_t)b->size, used) )
+            parsec_hbbuffer_raise_used_size(b, used);
+    }
+
+    b->nb_overflows = 0;
+    parsec_atomic_wmb();
+    b->nb_pushes = 0;
+
+    if( new_size != old_size ) {
+        PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HBB:\tResize buffer %p from %d to %d elements (%d/%d push operations overflowed, %d elements)",
+                             b, (int)old_size, (int)new_size, event.nb_overflows, event.nb_pushes, event.occupancy);
+#if defined(PARSEC_PROF_PINS)
+        {
+            parsec_execution_stream_t *es = parsec_my_execution_stream();
+            event.old_size = (int32_t)old_size;
+            event.new_size = (int32_t)new_size;
+            if( NULL != es )
+                PARSEC_PINS(es, HBBUFFER_RESIZE, (parsec_task_t*)&event);
+        }
+#endif  /* defined(PARSEC_PROF_PINS) */
+    }
+}
+
+/**
+ * Account for a push operation that stored elements in the buffer (distance
+ * 0), and resize the buffer at the end of each window.
+ */
+static inline void
+parsec_hbbuffer_adapt(parsec_hbbuffer_t *b, int overflowed)
+{
+    if( b->min_size == b->max_size ) return;
+    if( overflowed ) parsec_atomic_fetch_inc_int32(&b->nb_overflows);
+    if( (b->adapt_window - 1) == parsec_atomic_fetch_inc_int32(&b->nb_pushes) )
+        parsec_hbbuffer_resize(b);
+}
+
 void parsec_hbbuffer_destruct(parsec_hbbuffer_t *b)
 {
     free(b);
@@ -42,6 +219,7 @@ parsec_hbbuffer_push_all(parsec_hbbuffer_t *b,
 {
     parsec_list_item_t *next = elt;
     int i = 0, nbelt = 0;
+    size_t size = b->size;
 
     if( (0 != distance) && (NULL != b->parent_push_fct) )
         goto push_upstream;
@@ -53,16 +231,17 @@ parsec_hbbuffer_push_all(parsec_hbbuffer_t *b,
         next = parsec_list_item_ring_chop(elt);
         PARSEC_LIST_ITEM_SINGLETON(elt);
         /* Try to find a room for elt */
-        for(; (size_t)i < b->size; i++) {
+        for(; (size_t)i < size; i++) {
             if( NULL != b->items[i] || 0 == parsec_atomic_cas_ptr(&b->items[i], NULL, elt) )
                 continue;
+            parsec_hbbuffer_slot_used(b, (size_t)i);
             PARSEC_DEBUG_VERBOSE(20, parsec_debug_output,  "HBB:\tPush elem %p in local queue %p at position %d", elt, b, i );
             /* Found an empty space to push the first element. */
             nbelt++;
             break;
         }
 
-        if( (size_t)i == b->size ) {
+        if( (size_t)i == size ) {
             /* It was impossible to push elt */
             break;
         }
@@ -73,6 +252,7 @@ parsec_hbbuffer_push_all(parsec_hbbuffer_t *b,
     PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HBB:\tpushed %d elements. %s",
                          nbelt, NULL != elt ? "More to push, go to father" : "Everything pushed - done");
 
+    parsec_hbbuffer_adapt(b, NULL != elt);
     if( NULL == elt ) return;
 
     if( NULL != next ) {
@@ -84,16 +264,95 @@ parsec_hbbuffer_push_all(parsec_hbbuffer_t *b,
     b->parent_push_fct(b->parent_store, elt, distance - 1);
 }
 
+/**
+ * Split a ring of nb_elt elements after its first nb_keep elements. Returns
+ * the ring of the nb_elt - nb_keep last elements, and leaves the first ones
+ * in ring (nb_keep must be > 0 and < nb_elt).
+ */
+static parsec_list_item_t*
+parsec_hbbuffer_ring_split(parsec_list_item_t *ring, int32_t nb_keep)
+{
+    parsec_list_item_t *tail = ring, *last, *tail_last;
+    int32_t i;
+
+    for(i = 0; i < nb_keep; i++)
+        tail = (parsec_list_item_t*)tail->list_next;
+    last = (parsec_list_item_t*)tail->list_prev;
+    tail_last = (parsec_list_item_t*)ring->list_prev;
+    parsec_list_item_ring(ring, last);
+    parsec_list_item_ring(tail, tail_last);
+    return tail;
+}
+
 void
-parsec_hbbuffer_push_all_by_priority(parsec_hbbuffer_t *b,
-                                     parsec_list_item_t *list,
-                                     int32_t distance)
+parsec_hbbuffer_push_all_bulk(parsec_hbbuffer_t *b,
+                              parsec_list_item_t *ring,
+                              int32_t nb_elt,
+                              int32_t distance)
+{
+    parsec_list_item_t *elt, *overflow = NULL;
+    int32_t nb_free = 0;
+    size_t i, size = b->size;
+
+    if( (0 != distance) && (NULL != b->parent_push_fct) ) {
+        overflow = ring;
+        goto push_upstream;
+    }
+
+    /* Count the free slots, without any atomic operation, to decide at once
+     * which elements go in the buffer and which ones go to the parent */
+    for(i = 0; (i < size) && (nb_free < nb_elt); i++) {
+        if( NULL == b->items[i] ) nb_free++;
+    }
+    if( 0 == nb_free ) {
+        overflow = ring;
+        ring = NULL;
+    } else if( nb_free < nb_elt ) {
+        overflow = parsec_hbbuffer_ring_split(ring, nb_free);
+    }
+
+    for(i = 0; NULL != ring; i++) {
+        elt = ring;
+        ring = parsec_list_item_ring_chop(elt);
+        PARSEC_LIST_ITEM_SINGLETON(elt);
+        for(; i < size; i++) {
+            if( NULL == b->items[i] && parsec_atomic_cas_ptr(&b->items[i], NULL, elt) )
+                break;
+        }
+        if( i == size ) {
+            /* Some slots were taken concurrently: the remaining elements,
+             * that have a higher priority than the overflow, go first */
+            if( NULL != ring ) parsec_list_item_ring_merge(elt, ring);
+            if( NULL != overflow ) parsec_list_item_ring_merge(elt, overflow);
+            overflow = elt;
+            break;
+        }
+        parsec_hbbuffer_slot_used(b, i);
+        PARSEC_DEBUG_VERBOSE(20, parsec_debug_output,  "HBB:\tPush elem %p in local queue %p at position %d", elt, b, (int)i );
+    }
+
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HBB:\tbulk push of %d elements. %s",
+                         nb_elt, NULL != overflow ? "More to push, go to father" : "Everything pushed - done");
+    parsec_hbbuffer_adapt(b, NULL != overflow);
+    if( NULL == overflow ) return;
+
+  push_upstream:
+    assert(NULL != b->parent_push_fct);
+    b->parent_push_fct(b->parent_store, overflow, distance - 1);
+}
+
+static void
+parsec_hbbuffer_push_by_priority(parsec_hbbuffer_t *b,
+                                 parsec_list_item_t *list,
+                                 parsec_list_item_t *overflow,
+                                 int32_t distance)
 {
     int i = 0;
     parsec_task_t *candidate, *best_context;
     parsec_list_item_t *topush;
     int best_index;
     parsec_list_item_t *ejected = NULL;
+    size_t size = b->size;
 #define CTX(to) ((parsec_task_t*)(to))
 
     if( (0 != distance) && (NULL != b->parent_push_fct) ) {
@@ -115,7 +374,7 @@ parsec_hbbuffer_push_all_by_priority(parsec_hbbuffer_t *b,
         best_index = -1;
         /* We need to find something with a lower priority than topush anyway */
         best_context = CTX(topush);
-        for(i = 0; (size_t)i < b->size; i++) {
+        for(i = 0; (size_t)i < size; i++) {
             if( NULL == (candidate = CTX(b->items[i])) ) {
                 best_index = i;
                 best_context = CTX(topush);
@@ -145,6 +404,7 @@ parsec_hbbuffer_push_all_by_priority(parsec_hbbuffer_t *b,
 #if defined(PARSEC_DEBUG_NOISIER)
                 char tmp[MAX_TASK_STRLEN];
 #endif
+                parsec_hbbuffer_slot_used(b, (size_t)best_index);
                 PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HBB:\tPushed task %s in buffer %p.",
                         parsec_task_snprintf( tmp,  MAX_TASK_STRLEN, CTX(topush) ), b);
 
@@ -194,8 +454,14 @@ parsec_hbbuffer_push_all_by_priority(parsec_hbbuffer_t *b,
             break;
         }
     }
+    parsec_hbbuffer_adapt(b, (NULL != ejected) || (NULL != overflow));
 
   push_upstream:
+    /* The elements that were known not to fit follow the ejected ones */
+    if( NULL != overflow ) {
+        if( NULL != ejected ) parsec_list_item_ring_merge(ejected, overflow);
+        else ejected = overflow;
+    }
     PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HBB:\t  %s",
                          NULL != ejected ? "More to push, go to father" : "Everything pushed - done");
 
@@ -218,10 +484,35 @@ parsec_hbbuffer_push_all_by_priority(parsec_hbbuffer_t *b,
 #undef CTX
 }
 
+void
+parsec_hbbuffer_push_all_by_priority(parsec_hbbuffer_t *b,
+                                     parsec_list_item_t *list,
+                                     int32_t distance)
+{
+    parsec_hbbuffer_push_by_priority(b, list, NULL, distance);
+}
+
+void
+parsec_hbbuffer_push_all_by_priority_bulk(parsec_hbbuffer_t *b,
+                                          parsec_list_item_t *ring,
+                                          int32_t nb_elt,
+                                          int32_t distance)
+{
+    parsec_list_item_t *overflow = NULL;
+    size_t size = b->size;
+
+    /* The ring is sorted: at most b->size of its first elements can find a
+     * place in the buffer, the others go directly to the parent */
+    if( (0 == distance) && ((size_t)nb_elt > size) ) {
+        overflow = parsec_hbbuffer_ring_split(ring, (int32_t)size);
+    }
+    parsec_hbbuffer_push_by_priority(b, ring, overflow, distance);
+}
+
 parsec_list_item_t*
 parsec_hbbuffer_pop_best(parsec_hbbuffer_t *b, off_t priority_offset)
 {
-    unsigned int idx;
+    int64_t idx, used;
     parsec_list_item_t *best_elt = NULL;
     int best_idx = -1;
     parsec_list_item_t *candidate;
@@ -230,13 +521,14 @@ parsec_hbbuffer_pop_best(parsec_hbbuffer_t *b, off_t priority_offset)
         best_elt = NULL;
         best_idx = -1;
 
-        for(idx = 0; idx < b->size; idx++) {
+        used = b->used_size;
+        for(idx = 0; idx < used; idx++) {
             if( NULL == (candidate = (parsec_list_item_t *)b->items[idx]) )
                 continue;
 
             if( (NULL == best_elt) || A_HIGHER_PRIORITY_THAN_B(candidate, best_elt, priority_offset) ) {
                 best_elt  = candidate;
-                best_idx  = idx;
+                best_idx  = (int)idx;
             }
         }
 
@@ -266,9 +558,9 @@ parsec_hbbuffer_pop_best(parsec_hbbuffer_t *b, off_t priority_offset)
 
 long long int parsec_hbbuffer_approx_occupency(parsec_hbbuffer_t *b)
 {
-    unsigned int idx;
+    int64_t idx, used = b->used_size;
     long long int length = 0;
-    for(idx = 0; idx < b->size; idx++) {
+    for(idx = 0; idx < used; idx++) {
         if( NULL != b->items[idx]) {
             length++;
         }
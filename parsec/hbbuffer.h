@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2009-2017 The University of Tennessee and The University
+ * Copyright (c) 2009-2022 The University of Tennessee and The University
  *                         of Tennessee Research Foundation.  All rights
  *                         reserved.
  */
@@ -35,21 +35,97 @@ typedef void (*parsec_hbbuffer_parent_push_fct_t)(void *store,
                                                   parsec_list_item_t *elt,
                                                   int32_t distance);
 
+/**
+ * Adaptive buffers:
+ *
+ *   a buffer created with different minimal and maximal sizes changes the
+ *   number of slots it uses for new elements (size) between these bounds.
+ *   Every adapt_window push operations, the buffer doubles its size if more
+ *   than grow_threshold percent of these operations had to give elements to
+ *   the parent store, and halves it if none did and the buffer is less than
+ *   a quarter full. The slots are allocated for the maximal size at creation,
+ *   so resizing never moves the elements; the elements left past the end of
+ *   a shrunk buffer remain visible to the pop operations (up to used_size)
+ *   until they are consumed.
+ */
 struct parsec_hbbuffer_s {
-    size_t size;       /**< the size of the buffer, in number of void* */
+    volatile size_t size; /**< the size of the buffer, in number of void* */
     size_t ideal_fill; /**< hint on the number of elements that should be there to increase parallelism */
     unsigned int assoc_core_num; // only exists for scheduler instrumentation
     void    *parent_store; /**< pointer to this buffer parent store */
     /** function to push element to the parent store */
     parsec_hbbuffer_parent_push_fct_t parent_push_fct;
+    size_t min_size;   /**< lower bound of size */
+    size_t max_size;   /**< upper bound of size, and number of allocated slots */
+    volatile int64_t used_size;  /**< slots that may hold elements (>= size) */
+    int32_t adapt_window;        /**< number of push operations between two resize decisions */
+    int32_t grow_threshold;      /**< percentage of overflowing push operations that triggers a growth */
+    volatile int32_t nb_pushes;    /**< push operations since the last resize decision */
+    volatile int32_t nb_overflows; /**< push operations that overflowed since the last resize decision */
+    int32_t nb_grows;            /**< number of times the buffer grew */
+    int32_t nb_shrinks;          /**< number of times the buffer shrank */
     volatile parsec_list_item_t *items[1]; /**< array of elements */
 };
 
+/**
+ * Description of a resize of an adaptive buffer. A pointer to this structure
+ * is given, in place of the task, to the callbacks of the HBBUFFER_RESIZE
+ * PINS event, by the execution stream that took the decision.
+ */
+typedef struct parsec_hbbuffer_resize_event_s {
+    parsec_hbbuffer_t *buffer;  /**< the buffer that was resized */
+    int32_t old_size;           /**< size before the resize */
+    int32_t new_size;           /**< size after the resize */
+    int32_t nb_pushes;          /**< push operations observed to take the decision */
+    int32_t nb_overflows;       /**< push operations among them that overflowed */
+    int32_t occupancy;          /**< number of elements in the buffer at decision time */
+} parsec_hbbuffer_resize_event_t;
+
+/**
+ * @brief Register the MCA parameters of the adaptive buffers
+ *
+ * @details parsec_hbbuffer_adaptive enables the adaptive mode of the buffers
+ *   created with parsec_hbbuffer_new_adaptive; parsec_hbbuffer_min_size and
+ *   parsec_hbbuffer_max_size bound their size (0 selects the size requested
+ *   at creation, and 8 times this size, respectively);
+ *   parsec_hbbuffer_adapt_window and parsec_hbbuffer_grow_threshold control
+ *   the resize decisions.
+ */
+int parsec_hbbuffers_init(void);
+
 parsec_hbbuffer_t*
 parsec_hbbuffer_new(size_t size,  size_t ideal_fill,
                     parsec_hbbuffer_parent_push_fct_t parent_push_fct,
                     void *parent_store);
 
+/**
+ * @brief Create a buffer whose size varies between min_size and max_size,
+ *   starting at size
+ *
+ * @details The buffer is adaptive if min_size < max_size. size is clamped
+ *   between the bounds. The resize decisions use the current values of the
+ *   parsec_hbbuffer_adapt_window and parsec_hbbuffer_grow_threshold MCA
+ *   parameters.
+ */
+parsec_hbbuffer_t*
+parsec_hbbuffer_new_bounded(size_t size, size_t min_size, size_t max_size,
+                            size_t ideal_fill,
+                            parsec_hbbuffer_parent_push_fct_t parent_push_fct,
+                            void *parent_store);
+
+/**
+ * @brief Create a buffer of initial size size, that is adaptive if the
+ *   parsec_hbbuffer_adaptive MCA parameter is set
+ *
+ * @details The bounds of the buffer are given by the parsec_hbbuffer_min_size
+ *   and parsec_hbbuffer_max_size MCA parameters. If the adaptive mode is
+ *   disabled, this is equivalent to parsec_hbbuffer_new.
+ */
+parsec_hbbuffer_t*
+parsec_hbbuffer_new_adaptive(size_t size, size_t ideal_fill,
+                             parsec_hbbuffer_parent_push_fct_t parent_push_fct,
+                             void *parent_store);
+
 void parsec_hbbuffer_destruct(parsec_hbbuffer_t *b);
 
 void
@@ -62,14 +138,43 @@ parsec_hbbuffer_push_all_by_priority(parsec_hbbuffer_t *b,
                                      parsec_list_item_t *list,
                                      int32_t distance);
 
+/**
+ * @brief Push a sorted ring of nb_elt items in the buffer at once
+ *
+ * @details The ring must be sorted by decreasing priority. The free slots
+ *   of the buffer are counted first (without atomic operations), so that
+ *   the items that cannot fit are given to the parent store in a single
+ *   call, and only the items that are stored in the buffer cost an atomic
+ *   operation.
+ */
+void
+parsec_hbbuffer_push_all_bulk(parsec_hbbuffer_t *b,
+                              parsec_list_item_t *ring,
+                              int32_t nb_elt,
+                              int32_t distance);
+
+/**
+ * @brief Same as parsec_hbbuffer_push_all_by_priority, for a ring of nb_elt
+ *   items sorted by decreasing priority
+ *
+ * @details Only the first b->size items of the ring can take a slot in the
+ *   buffer; the others are given to the parent store directly, together with
+ *   the items ejected from the buffer.
+ */
+void
+parsec_hbbuffer_push_all_by_priority_bulk(parsec_hbbuffer_t *b,
+                                          parsec_list_item_t *ring,
+                                          int32_t nb_elt,
+                                          int32_t distance);
+
 /* This code is unsafe, since another thread may be inserting new elements.
  * Use is_empty in safe-checking only
  */
 static inline int
 parsec_hbbuffer_is_empty(parsec_hbbuffer_t *b)
 {
-    unsigned int i;
-    for(i = 0; i < b->size; i++)
+    int64_t i;
+    for(i = 0; i < b->used_size; i++)
         if( NULL != b->items[i] )
             return 0;
     return 1;
@@ -81,8 +186,8 @@ parsec_hbbuffer_pop_best(parsec_hbbuffer_t *b, off_t priority_offset);
 /**
  * @brief Returns (approximately) how many items are in the bounded buffer
  *
- * @details This iterates over the bounded buffer, and counts the number of
- *   items not null at the time of execution. This function is thread safe but
+ * @details This iterates over the slots of the bounded buffer that may hold
+ *   items, and counts the number of items not null at the time of execution. This function is thread safe but
  *   may return an incorrect number of items if other threads insert or remove
  *   concurrently. It is used by SDE counters to get an approximate number of
  *   pending tasks.
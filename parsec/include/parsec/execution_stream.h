@@ -37,6 +37,7 @@ struct parsec_execution_stream_s {
     int32_t   th_id;        /**< Internal thread identifier. A thread belongs to a vp */
     int core_id;            /**< Core on which the thread is bound (hwloc in order numbering) */
     int socket_id;          /**< Socket on which the thread is bound (hwloc in order numerotation) */
+    int numa_id;            /**< NUMA node on which the thread is bound (hwloc logical index, 0 if unknown) */
 
     pthread_t pthread_id;     /**< POSIX thread identifier. */
 
@@ -52,6 +53,12 @@ struct parsec_execution_stream_s {
      * the scheduler decision.
      */
     struct parsec_task_s* next_task;
+    int32_t  chain_depth;      /**< Number of tasks executed in a row from next_task */
+    uint32_t nb_chained;       /**< Number of tasks kept as next_task */
+    uint32_t nb_chain_cuts;    /**< Number of times a task was not kept because the chain was too long */
+    uint32_t nb_handoffs;      /**< Number of tasks this stream handed off to another virtual process */
+    struct parsec_task_s** gathered_rings; /**< When set, __parsec_schedule_vp sorts the tasks into these
+                                            *   rings (one per virtual process) instead of scheduling them */
 
 #if defined(PARSEC_SIM)
     int largest_simulation_date;
@@ -67,6 +74,14 @@ struct parsec_execution_stream_s {
 #endif /* PARSEC_HAVE_GETRUSAGE */
 #endif
 
+    /* Statistics of the idle periods, reported with the resource usage */
+    uint64_t idle_spin_ns;          /**< Time spent looking for a task without finding one (parked time excluded) */
+    uint64_t idle_park_ns;          /**< Time spent parked */
+    uint32_t nb_parks;              /**< Number of times the stream parked */
+    uint32_t nb_wakeups;            /**< Number of times the stream was woken up by a new task (not by the timeout) */
+    uint64_t wake_latency_ns;       /**< Cumulated time between a wake up and the stream running again */
+    uint64_t max_wake_latency_ns;   /**< Longest of these wake up latencies */
+
     struct parsec_vp_s      *virtual_process;   /**< Backlink to the virtual process that holds this thread */
     parsec_thread_mempool_t *context_mempool;   /**< When allocating new execution contexts, this mempool is used */
     parsec_thread_mempool_t *datarepo_mempools[MAX_PARAM_COUNT+1]; /**< When allocating new data repositories,
@@ -93,6 +108,19 @@ struct parsec_vp_s {
     parsec_mempool_t         dependencies_mempool; /**< If using hashtables to store dependencies
                                                     *   those are allocated using this mempool */
 
+    struct parsec_sched_module_s *scheduler;  /**< Scheduler of the execution streams of this VP */
+    volatile int32_t         handoff_next;  /**< Stream of this VP that receives the next ring of tasks handed off
+                                             *   by another VP (round-robin) */
+
+    /* Idle execution streams of this VP park on park_seq (see runtime_park_spin) */
+    volatile int32_t         park_seq;      /**< Changed each time parked streams are woken up */
+    volatile int32_t         nb_parked;     /**< Number of streams parked, or about to park */
+    volatile uint64_t        park_wake_ns;  /**< Date of the last wake up, to measure the wake up latency */
+#if !defined(PARSEC_HAVE_FUTEX)
+    pthread_mutex_t          park_lock;
+    pthread_cond_t           park_cond;
+#endif  /* !defined(PARSEC_HAVE_FUTEX) */
+
     /* This field should always be the last one in the structure. Even if the
      * declared number of execution units is 1, when we allocate the memory
      * we will allocate more (as many as we need), so everything after this
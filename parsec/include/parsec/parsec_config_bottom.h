@@ -56,6 +56,12 @@
 #define PARSEC_UNLIKELY(x)     (x)
 #endif
 
+#if defined(PARSEC_HAVE_BUILTIN_PREFETCH) && defined(BUILDING_PARSEC)
+#define PARSEC_PREFETCH(addr)  __builtin_prefetch((addr))
+#else
+#define PARSEC_PREFETCH(addr)  ((void)(addr))
+#endif
+
 #if defined(PARSEC_HAVE_ATTRIBUTE_DEPRECATED)
 #   define __parsec_attribute_deprecated__(msg) __attribute__((deprecated(msg)))
 #else // PARSEC_HAVE_ATTRIBUTE_DEPRECATED
@@ -77,8 +77,6 @@ int insert_task_trace_keyout = -1;
 int hashtable_trace_keyin = -1;
 int hashtable_trace_keyout = -1;
 
-extern parsec_sched_module_t *parsec_current_scheduler;
-
 /* Global mempool for all the parsec DTD taskpools that will be created for a run */
 parsec_mempool_t *parsec_dtd_taskpool_mempool = NULL;
 
@@ -370,6 +368,7 @@ void parsec_dtd_taskpool_constructor(parsec_dtd_taskpool_t *tp)
                              NULL, sizeof(dtd_hash_table_pointer_item_t),
                              offsetof(dtd_hash_table_pointer_item_t, mempool_owner),
                              1/* no. of threads*/ );
+    parsec_mempool_set_footprint(tp->hash_table_bucket_mempool, PARSEC_MEM_FOOTPRINT_HASH_TABLES);
 }
 
 /***************************************************************************//**
@@ -552,6 +551,7 @@ parsec_dtd_lazy_init(void)
                               PARSEC_OBJ_CLASS(parsec_dtd_tile_t), sizeof(parsec_dtd_tile_t),
                               offsetof(parsec_dtd_tile_t, mempool_owner),
                               1/* no. of threads*/ );
+    parsec_mempool_set_footprint(parsec_dtd_tile_mempool, PARSEC_MEM_FOOTPRINT_DTD_TILES);
 }
 
 /* **************************************************************************** */
@@ -636,9 +636,11 @@ parsec_execute_and_come_back(parsec_taskpool_t *tp,
         misses_in_a_row++;  /* assume we fail to extract a task */
 
         if( NULL == (task = es->next_task) ) {
-            task = parsec_current_scheduler->module.select(es, &distance);
+            task = es->virtual_process->scheduler->module.select(es, &distance);
+            es->chain_depth = 0;
         } else {
             es->next_task = NULL;
+            es->chain_depth++;
             distance = 1;
         }
 
@@ -1746,6 +1748,29 @@ parsec_dtd_iterate_successors(parsec_execution_stream_t *es,
                                   action_mask, ontask, ontask_arg);
 }
 
+/*
+ * Hands the data of a released flow of the remote task (cb_data) to the
+ * task tracking the flow, while its bucket is locked. The flow is the bit
+ * set in the lower half of the key.
+ */
+static void
+parsec_dtd_remote_flow_update(void *item, void *cb_data)
+{
+    dtd_hash_table_pointer_item_t *flow_item = (dtd_hash_table_pointer_item_t *)item;
+    parsec_task_t *this_task = (parsec_task_t *)cb_data;
+    parsec_dtd_task_t *dtd_task = (parsec_dtd_task_t *)flow_item->value;
+    uint32_t flow_mask = (uint32_t)(uint64_t)flow_item->ht_item.key;
+    int flow_index = 0;
+
+    while( !(flow_mask & (1U << flow_index)) ) flow_index++;
+
+    if( this_task->data[flow_index].data_out != NULL ) {
+        dtd_task->super.data[flow_index].data_in = this_task->data[flow_index].data_in;
+        dtd_task->super.data[flow_index].data_out = this_task->data[flow_index].data_out;
+        parsec_dtd_retain_data_copy(this_task->data[flow_index].data_out);
+    }
+}
+
 /* **************************************************************************** */
 /**
  * Release dependencies after a task is done
@@ -1792,29 +1817,30 @@ parsec_dtd_release_deps(parsec_execution_stream_t *es,
     const parsec_task_class_t *tc = this_task->task_class;
     parsec_dtd_taskpool_t *tp = (parsec_dtd_taskpool_t *)this_task->taskpool;
 
+    /* The remote tasks are tracked once for each of their flows: the keys
+     * of all the released flows are looked up together */
+    parsec_key_t flow_keys[MAX_PARAM_COUNT];
+    dtd_hash_table_pointer_item_t *flow_items[MAX_PARAM_COUNT];
+    int flow_index, nb_flow_keys = 0;
+
+    assert(tc->nb_flows <= MAX_PARAM_COUNT);
+    if( !(action_mask & PARSEC_ACTION_COMPLETE_LOCAL_TASK) ) {
+        for( flow_index = 0; flow_index < tc->nb_flows; flow_index++ ) {
+            if( action_mask & (1 << flow_index) )
+                flow_keys[nb_flow_keys++] = (parsec_key_t)(((uint64_t)this_task->locals[0].value << 32) | (1U << flow_index));
+        }
+    }
+
     if((action_mask & PARSEC_ACTION_COMPLETE_LOCAL_TASK)) {
         this_dtd_task = (parsec_dtd_task_t *)this_task;
     } else {
-        int flow_index, track_flow = 0;
-        for( flow_index = 0; flow_index < tc->nb_flows; flow_index++ ) {
-            if((action_mask & (1 << flow_index))) {
-                if( !(track_flow & (1U << flow_index))) {
-                    uint64_t key = (((uint64_t)this_task->locals[0].value << 32) | (1U << flow_index));
-                    parsec_hash_table_lock_bucket(tp->task_hash_table, (parsec_key_t)key);
-                    this_dtd_task = parsec_dtd_find_task(tp, key);
-                    assert(this_dtd_task != NULL);
-
-                    if( this_task->data[flow_index].data_out != NULL) {
-                        assert(this_task->data[flow_index].data_out != NULL);
-                        this_dtd_task->super.data[flow_index].data_in = this_task->data[flow_index].data_in;
-                        this_dtd_task->super.data[flow_index].data_out = this_task->data[flow_index].data_out;
-                        parsec_dtd_retain_data_copy(this_task->data[flow_index].data_out);
-
-                    }
-                    track_flow |= (1 << flow_index); /* to make sure we are retaining the data only once */
-                    parsec_hash_table_unlock_bucket(tp->task_hash_table, (parsec_key_t)key);
-                }
-            }
+        int k;
+        /* The data of the flows are updated under the locks of their buckets */
+        parsec_hash_table_find_many_apply(tp->task_hash_table, nb_flow_keys, flow_keys, (void**)flow_items,
+                                          parsec_dtd_remote_flow_update, this_task);
+        for( k = 0; k < nb_flow_keys; k++ ) {
+            assert(NULL != flow_items[k]);
+            this_dtd_task = (parsec_dtd_task_t *)flow_items[k]->value;  /* the same task for all the flows */
         }
     }
 
@@ -1827,19 +1853,13 @@ parsec_dtd_release_deps(parsec_execution_stream_t *es,
      * for each flow a rank is concerned about.
      */
     if( parsec_dtd_task_is_remote(this_dtd_task) && !(action_mask & PARSEC_ACTION_COMPLETE_LOCAL_TASK)) {
-        int flow_index, track_flow = 0;
-        for( flow_index = 0; flow_index < tc->nb_flows; flow_index++ ) {
-            if((action_mask & (1 << flow_index))) {
-                if( !(track_flow & (1U << flow_index))) {
-                    uint64_t key = (((uint64_t)this_task->locals[0].value << 32) | (1U << flow_index));
-                    parsec_hash_table_lock_bucket(tp->task_hash_table, (parsec_key_t)key);
-                    if( NULL != parsec_dtd_untrack_task(tp, key)) {
-                        /* also releasing task */
-                        parsec_dtd_remote_task_release(this_dtd_task);
-                    }
-                    track_flow |= (1 << flow_index); /* to make sure we are releasing the data only once */
-                    parsec_hash_table_unlock_bucket(tp->task_hash_table, (parsec_key_t)key);
-                }
+        int k;
+        parsec_hash_table_remove_many(tp->task_hash_table, nb_flow_keys, flow_keys, (void**)flow_items);
+        for( k = 0; k < nb_flow_keys; k++ ) {
+            if( NULL != flow_items[k] ) {
+                parsec_mempool_free(tp->hash_table_bucket_mempool, flow_items[k]);
+                /* also releasing task */
+                parsec_dtd_remote_task_release(this_dtd_task);
             }
         }
     }
@@ -2199,6 +2219,7 @@ parsec_dtd_create_task_classv(parsec_dtd_taskpool_t *dtd_tp,
                              PARSEC_OBJ_CLASS(parsec_dtd_task_t), total_size,
                              offsetof(parsec_dtd_task_t, mempool_owner),
                              parsec_my_execution_stream()->virtual_process->nb_cores);
+    parsec_mempool_set_footprint(&dtd_tc->context_mempool, PARSEC_MEM_FOOTPRINT_TASKS);
 
     int total_size_remote_task = (int)(sizeof(parsec_dtd_task_t) +
             (flow_count * sizeof(parsec_dtd_parent_info_t)) +
@@ -2209,6 +2230,7 @@ parsec_dtd_create_task_classv(parsec_dtd_taskpool_t *dtd_tp,
                              PARSEC_OBJ_CLASS(parsec_dtd_task_t), total_size_remote_task,
                              offsetof(parsec_dtd_task_t, mempool_owner),
                              parsec_my_execution_stream()->virtual_process->nb_cores);
+    parsec_mempool_set_footprint(&dtd_tc->remote_task_mempool, PARSEC_MEM_FOOTPRINT_TASKS);
 
     /*
      To bypass const in function structure.
@@ -45,6 +45,8 @@ static void jdf_generate_code_release_deps(const jdf_t *jdf, const jdf_function_
 static void jdf_generate_code_iterate_successors_or_predecessors(const jdf_t *jdf, const jdf_function_entry_t *f,
                                                                  const char *prefix, jdf_dep_flags_t flow_type);
 static void jdf_generate_code_datatype_lookup(const jdf_t *jdf,  const jdf_function_entry_t *f, const char *name);
+static int jdf_function_has_static_usage(const jdf_function_entry_t *f);
+static void jdf_generate_code_usage_limit(const jdf_t *jdf, const jdf_function_entry_t *f, const char *name);
 static void
 jdf_generate_code_find_deps(const jdf_t *jdf,
                             const jdf_function_entry_t *f,
@@ -1638,6 +1640,9 @@ static void jdf_generate_structure(jdf_t *jdf)
                 "  int _vmax = (vMAX);                                                         \\\n"
                 "  (DEPS) = (parsec_dependencies_t*)calloc(1, sizeof(parsec_dependencies_t) +  \\\n"
                 "                   (_vmax - _vmin) * sizeof(parsec_dependencies_union_t));    \\\n"
+                "  PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_DEPENDENCIES,                  \\\n"
+                "                           sizeof(parsec_dependencies_t) +                    \\\n"
+                "                           (_vmax - _vmin) * sizeof(parsec_dependencies_union_t)); \\\n"
                 "  PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, \"Allocate %%d spaces for loop %%s (min %%d max %%d) 0x%%p\",    \\\n"
                 "           (_vmax - _vmin + 1), (vNAME), _vmin, _vmax, (void*)(DEPS));        \\\n"
                 "  (DEPS)->flags = PARSEC_DEPENDENCIES_FLAG_ALLOCATED | (FLAG);                \\\n"
@@ -3171,11 +3176,15 @@ static void jdf_generate_startup_tasks(const jdf_t *jdf, const jdf_function_entr
             "%s  }\n"
             "#endif\n", indent(nesting), indent(nesting), indent(nesting), indent(nesting), indent(nesting));
 
-    coutput("%s  parsec_dependencies_mark_task_as_startup((parsec_task_t*)new_task, es);\n"
+    coutput("%s  if( PARSEC_SUCCESS != parsec_dependencies_mark_task_as_startup((parsec_task_t*)new_task, es) ) {\n"
+            "%s    parsec_thread_mempool_free(new_task->mempool_owner, new_task);\n"
+            "%s    return PARSEC_HOOK_RETURN_ERROR;\n"
+            "%s  }\n"
             "%s  pready_ring[vpid] = parsec_list_item_ring_push_sorted(pready_ring[vpid],\n"
             "%s                                                        (parsec_list_item_t*)new_task,\n"
             "%s                                                        parsec_execution_context_priority_comparator);\n"
-            "%s  nb_tasks++;\n", indent(nesting), indent(nesting), indent(nesting), indent(nesting), indent(nesting));
+            "%s  nb_tasks++;\n", indent(nesting), indent(nesting), indent(nesting), indent(nesting),
+            indent(nesting), indent(nesting), indent(nesting), indent(nesting));
     coutput("%s restore_context_%d:  /* we jump here just so that we have code after the label */\n", indent(nesting), ctx_level);
     coutput("%s  restore_context = 0;\n"
             "%s  (void)restore_context;\n"
@@ -3288,6 +3297,40 @@ static jdf_param_list_t *local_is_parameter(const jdf_function_entry_t *f, const
     return NULL;
 }
 
+/**
+ * The dependencies of a task class whose execution space is a dense box
+ * (every parameter spans a range that does not depend on the other locals)
+ * can be tracked in a flat array of counters instead of a hash table. The
+ * internal init then computes the bounding box of the local tasks, and lets
+ * the runtime decide if it is dense enough (it falls back to the hash table
+ * otherwise), so the number of local tasks must be known.
+ */
+static int jdf_function_has_flat_deps(const jdf_function_entry_t *f)
+{
+    const jdf_variable_list_t *vl, *ovl;
+
+    if( (JDF_COMPILER_GLOBAL_ARGS.dep_management != DEP_MANAGEMENT_DYNAMIC_HASH_TABLE) ||
+        (NULL == f->parameters) ||
+        (f->user_defines & (JDF_FUNCTION_HAS_UD_DEPENDENCIES_FUNS | JDF_HAS_UD_NB_LOCAL_TASKS |
+                            JDF_HAS_DYNAMIC_TERMDET | JDF_HAS_USER_TRIGGERED_TERMDET)) )
+        return 0;
+    for(vl = f->locals; NULL != vl; vl = vl->next) {
+        if( NULL == local_is_parameter(f, vl) ) continue;
+        if( NULL != vl->expr->local_variables ) return 0;
+        for(ovl = f->locals; NULL != ovl; ovl = ovl->next) {
+            if( ovl == vl ) continue;
+            if( JDF_RANGE == vl->expr->op ) {
+                if( jdf_expr_depends_on_symbol(ovl->name, vl->expr->jdf_ta1) ||
+                    jdf_expr_depends_on_symbol(ovl->name, vl->expr->jdf_ta2) )
+                    return 0;
+            } else if( jdf_expr_depends_on_symbol(ovl->name, vl->expr) ) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
 static  void jdf_generate_deps_key_functions(const jdf_t *jdf, const jdf_function_entry_t *f, const char *sname)
 {
     jdf_variable_list_t *vl;
@@ -3412,7 +3455,7 @@ static void jdf_generate_internal_init(const jdf_t *jdf, const jdf_function_entr
     const jdf_param_list_t *pl;
     expr_info_t info = EMPTY_EXPR_INFO;
     int need_to_iterate, need_min_max, need_to_count_tasks;
-    int nesting = 0, idx;
+    int nesting = 0, idx, flat_deps = jdf_function_has_flat_deps(f);
     jdf_l2p_t *l2p = build_l2p(f), *l2p_item;
     char *dep_key_fn_name = NULL;
     (void)jdf;
@@ -3454,6 +3497,13 @@ static void jdf_generate_internal_init(const jdf_t *jdf, const jdf_function_entr
         /* prepare the epilog output to prevent compiler from complaining about initialized but unused data */
         string_arena_add_string(sa_end, "(void)saved_nb_tasks;\n");
     }
+    if( flat_deps ) {
+        /* The bounding box of the local tasks */
+        for(pl = f->parameters; NULL != pl; pl = pl->next) {
+            coutput("  int32_t %s%s_lmin = 0x7fffffff, %s%s_lmax = -0x7fffffff - 1;\n",
+                    JDF2C_NAMESPACE, pl->name, JDF2C_NAMESPACE, pl->name);
+        }
+    }
     if( need_min_max ) {
         for(l2p_item = l2p; NULL != l2p_item; l2p_item = l2p_item->next) {
             vl = l2p_item->vl; assert(NULL != vl);
@@ -3612,6 +3662,14 @@ static void jdf_generate_internal_init(const jdf_t *jdf, const jdf_function_entr
             coutput("%s  nb_tasks++;\n",
                     indent(nesting));
         }
+        if( flat_deps ) {
+            for(pl = f->parameters; NULL != pl; pl = pl->next) {
+                coutput("%s  %s%s_lmin = parsec_imin(%s%s_lmin, %s);\n"
+                        "%s  %s%s_lmax = parsec_imax(%s%s_lmax, %s);\n",
+                        indent(nesting), JDF2C_NAMESPACE, pl->name, JDF2C_NAMESPACE, pl->name, pl->name,
+                        indent(nesting), JDF2C_NAMESPACE, pl->name, JDF2C_NAMESPACE, pl->name, pl->name);
+            }
+        }
 
         /* We close all non-range variables */
         while( NULL != inner_vl &&
@@ -3770,9 +3828,32 @@ static void jdf_generate_internal_init(const jdf_t *jdf, const jdf_function_entr
                     f->task_class_id);
         } else if( JDF_COMPILER_GLOBAL_ARGS.dep_management == DEP_MANAGEMENT_DYNAMIC_HASH_TABLE ||
                    0 != (f->user_defines & JDF_FUNCTION_HAS_UD_HASH_STRUCT)) {
-            coutput("  __parsec_tp->super.super.dependencies_array[%d] = PARSEC_OBJ_NEW(parsec_hash_table_t);\n"
-                    "  parsec_hash_table_init(__parsec_tp->super.super.dependencies_array[%d], offsetof(parsec_hashable_dependency_t, ht_item), 10, %s, this_task->taskpool);\n",
-                    f->task_class_id, f->task_class_id, dep_key_fn_name);
+            if( flat_deps ) {
+                string_arena_t *sa_min = string_arena_new(64), *sa_max = string_arena_new(64);
+                int nb_params = 0;
+                for(pl = f->parameters; NULL != pl; pl = pl->next, nb_params++) {
+                    string_arena_add_string(sa_min, "%s%s%s_lmin", (0 == nb_params) ? "" : ", ", JDF2C_NAMESPACE, pl->name);
+                    string_arena_add_string(sa_max, "%s%s%s_lmax", (0 == nb_params) ? "" : ", ", JDF2C_NAMESPACE, pl->name);
+                }
+                coutput("  {  /* Use a flat array if the local tasks are dense enough in their bounding box */\n"
+                        "    const int lmin[] = { %s }, lmax[] = { %s };\n"
+                        "    __parsec_tp->super.super.dependencies_array[%d] = parsec_flat_dependencies_new(%d, lmin, lmax, nb_tasks);\n"
+                        "  }\n"
+                        "  if( NULL != __parsec_tp->super.super.dependencies_array[%d] ) {\n"
+                        "    ((parsec_task_class_t*)__parsec_tp->super.super.task_classes_array[%d])->find_deps = parsec_flat_find_deps;\n"
+                        "  } else {\n",
+                        string_arena_get_string(sa_min), string_arena_get_string(sa_max),
+                        f->task_class_id, nb_params, f->task_class_id, f->task_class_id);
+                string_arena_free(sa_min);
+                string_arena_free(sa_max);
+            }
+            coutput("%s  __parsec_tp->super.super.dependencies_array[%d] = PARSEC_OBJ_NEW(parsec_hash_table_t);\n"
+                    "%s  parsec_hash_table_init(__parsec_tp->super.super.dependencies_array[%d], offsetof(parsec_hashable_dependency_t, ht_item), 10, %s, this_task->taskpool);\n",
+                    flat_deps ? "  " : "", f->task_class_id,
+                    flat_deps ? "  " : "", f->task_class_id, dep_key_fn_name);
+            if( flat_deps ) {
+                coutput("  }\n");
+            }
             free(dep_key_fn_name);
             dep_key_fn_name = NULL;
         }
@@ -3964,15 +4045,24 @@ static void jdf_generate_release_task_fct(const jdf_t *jdf, jdf_function_entry_t
             jdf_basename,
             jdf_basename);
     if( !(f->user_defines & JDF_FUNCTION_HAS_UD_DEPENDENCIES_FUNS) ) {
-        coutput("    parsec_hash_table_t *ht = (parsec_hash_table_t*)__parsec_tp->super.super.dependencies_array[%d];\n"
-                "    parsec_key_t key = this_task->task_class->make_key((const parsec_taskpool_t*)__parsec_tp, (const parsec_assignment_t*)&this_task->locals);\n"
-                "    parsec_hashable_dependency_t *hash_dep = (parsec_hashable_dependency_t *)parsec_hash_table_remove(ht, key);\n",
-                f->task_class_id);
+        const char *ind = "";
+        if( jdf_function_has_flat_deps(f) ) {
+            /* Nothing to release in the flat dependencies */
+            coutput("    if( parsec_flat_find_deps != this_task->task_class->find_deps ) {\n");
+            ind = "  ";
+        }
+        coutput("%s    parsec_hash_table_t *ht = (parsec_hash_table_t*)__parsec_tp->super.super.dependencies_array[%d];\n"
+                "%s    parsec_key_t key = this_task->task_class->make_key((const parsec_taskpool_t*)__parsec_tp, (const parsec_assignment_t*)&this_task->locals);\n"
+                "%s    parsec_hashable_dependency_t *hash_dep = (parsec_hashable_dependency_t *)parsec_hash_table_remove(ht, key);\n",
+                ind, f->task_class_id, ind, ind);
         if( f->user_defines & JDF_FUNCTION_HAS_UD_STARTUP_TASKS_FUN ) {
-            coutput("    /* Must test for NULL, as user-provided startup tasks may not have a dep in the hash table */\n"
-                    "    if(NULL != hash_dep) parsec_thread_mempool_free(hash_dep->mempool_owner, hash_dep);\n");
+            coutput("%s    /* Must test for NULL, as user-provided startup tasks may not have a dep in the hash table */\n"
+                    "%s    if(NULL != hash_dep) parsec_thread_mempool_free(hash_dep->mempool_owner, hash_dep);\n", ind, ind);
         } else {
-            coutput("    parsec_thread_mempool_free(hash_dep->mempool_owner, hash_dep);\n");
+            coutput("%s    parsec_thread_mempool_free(hash_dep->mempool_owner, hash_dep);\n", ind);
+        }
+        if( jdf_function_has_flat_deps(f) ) {
+            coutput("    }\n");
         }
     }
     if( f->user_defines & JDF_HAS_UD_NB_LOCAL_TASKS ) {
@@ -4040,7 +4130,7 @@ static void jdf_generate_one_function( const jdf_t *jdf, jdf_function_entry_t *f
     string_arena_t *sa, *sa2;
     int nbparameters, nbdefinitions;
     int inputmask, nb_input, nb_output, input_index;
-    int i, has_in_in_dep, has_control_gather, ret, use_mask;
+    int i, has_in_in_dep, has_control_gather, ret, use_mask, chain;
     jdf_dataflow_t *fl;
     jdf_dep_t *dl;
     char *prefix;
@@ -4220,21 +4310,26 @@ static void jdf_generate_one_function( const jdf_t *jdf, jdf_function_entry_t *f
     string_arena_add_string(sa, "  .out = { %s },\n",
                             string_arena_get_string(sa2));
 
+    /* chain = 1: run the task right after its predecessor when it is its only local successor,
+     * chain = 0: always go through the scheduler, unset: runtime_keep_highest_priority_task decides */
+    chain = jdf_property_get_int(f->properties, "chain", -1);
     if( use_mask ) {
         string_arena_add_string(sa,
-                                "  .flags = %s%s%s | PARSEC_USE_DEPS_MASK,\n"
+                                "  .flags = %s%s%s%s | PARSEC_USE_DEPS_MASK,\n"
                                 "  .dependencies_goal = 0x%x,\n",
                                 (f->flags & JDF_FUNCTION_FLAG_HIGH_PRIORITY) ? "PARSEC_HIGH_PRIORITY_TASK" : "0x0",
                                 has_in_in_dep ? " | PARSEC_HAS_IN_IN_DEPENDENCIES" : "",
                                 jdf_property_get_int(f->properties, "immediate", 0) ? " | PARSEC_IMMEDIATE_TASK" : "",
+                                (chain > 0) ? " | PARSEC_CHAIN_TASK" : ((0 == chain) ? " | PARSEC_NO_CHAIN_TASK" : ""),
                                 inputmask);
     } else {
         string_arena_add_string(sa,
-                                "  .flags = %s%s%s%s,\n"
+                                "  .flags = %s%s%s%s%s,\n"
                                 "  .dependencies_goal = %d,\n",
                                 (f->flags & JDF_FUNCTION_FLAG_HIGH_PRIORITY) ? "PARSEC_HIGH_PRIORITY_TASK" : "0x0",
                                 has_in_in_dep ? " | PARSEC_HAS_IN_IN_DEPENDENCIES" : "",
                                 jdf_property_get_int(f->properties, "immediate", 0) ? " | PARSEC_IMMEDIATE_TASK" : "",
+                                (chain > 0) ? " | PARSEC_CHAIN_TASK" : ((0 == chain) ? " | PARSEC_NO_CHAIN_TASK" : ""),
                                 has_control_gather ? "|PARSEC_HAS_CTL_GATHER" : "",
                                 nb_input);
     }
@@ -4282,6 +4377,11 @@ static void jdf_generate_one_function( const jdf_t *jdf, jdf_function_entry_t *f
         string_arena_add_string(sa, "  .iterate_predecessors = (parsec_traverse_function_t*)NULL,\n");
     }
 
+    if( jdf_function_has_static_usage(f) ) {
+        sprintf(prefix, "usage_limit_of_%s_%s", jdf_basename, f->fname);
+        jdf_generate_code_usage_limit(jdf, f, prefix);
+    }
+
     sprintf(prefix, "release_deps_of_%s_%s", jdf_basename, f->fname);
     jdf_generate_code_release_deps(jdf, f, prefix);
     string_arena_add_string(sa, "  .release_deps = (parsec_release_deps_t*)%s,\n", prefix);
@@ -4496,6 +4596,39 @@ static void jdf_generate_destructor( const jdf_t *jdf )
     coutput("  parsec_taskpool_unregister( &__parsec_tp->super.super );\n"
             "  if(NULL != __parsec_tp->super.super.tdm.module) __parsec_tp->super.super.tdm.module->unmonitor_taskpool(&__parsec_tp->super.super);\n");
 
+    /* Before the task classes, as their find_deps tells which dependencies are flat */
+    coutput("  /* Release the dependencies arrays for this object */\n");
+    for(f = jdf->functions; NULL != f; f = f->next) {
+        if( !( f->user_defines & JDF_FUNCTION_HAS_UD_DEPENDENCIES_FUNS ) ) {
+            if( JDF_COMPILER_GLOBAL_ARGS.dep_management == DEP_MANAGEMENT_INDEX_ARRAY ) {
+                coutput("  if(NULL != __parsec_tp->super.super.dependencies_array[%d])\n"
+                        "    dependencies_size += parsec_destruct_dependencies( __parsec_tp->super.super.dependencies_array[%d] );\n",
+                        f->task_class_id, f->task_class_id);
+            } else if( jdf_function_has_flat_deps(f) ) {
+                coutput("  if( parsec_flat_find_deps == __parsec_tp->super.super.task_classes_array[%d]->find_deps ) {\n"
+                        "    parsec_flat_dependencies_destruct( (parsec_flat_dependencies_t*)__parsec_tp->super.super.dependencies_array[%d] );\n"
+                        "  } else {\n"
+                        "    parsec_hash_table_fini( (parsec_hash_table_t*)__parsec_tp->super.super.dependencies_array[%d] );\n"
+                        "    PARSEC_OBJ_RELEASE(__parsec_tp->super.super.dependencies_array[%d]);\n"
+                        "  }\n",
+                        f->task_class_id, f->task_class_id, f->task_class_id, f->task_class_id);
+            } else if (JDF_COMPILER_GLOBAL_ARGS.dep_management == DEP_MANAGEMENT_DYNAMIC_HASH_TABLE ) {
+                coutput("  parsec_hash_table_fini( (parsec_hash_table_t*)__parsec_tp->super.super.dependencies_array[%d] );\n"
+                        "  PARSEC_OBJ_RELEASE(__parsec_tp->super.super.dependencies_array[%d]);\n",
+                        f->task_class_id, f->task_class_id);
+            } 
+        } else {
+            coutput("  %s(__parsec_tp, __parsec_tp->super.super.dependencies_array[%d]);\n",
+                    jdf_property_get_function(f->properties, JDF_PROP_UD_FREE_DEPS_FN_NAME, NULL),
+                    f->task_class_id);
+
+        }
+        coutput("  __parsec_tp->super.super.dependencies_array[%d] = NULL;\n",
+                f->task_class_id);
+    }
+    coutput("  free( __parsec_tp->super.super.dependencies_array );\n"
+            "  __parsec_tp->super.super.dependencies_array = NULL;\n");
+
     coutput("  for( i = 0; i < (uint32_t)(2 * __parsec_tp->super.super.nb_task_classes); i++ ) {  /* Extra startup function added at the end */\n"
             "    parsec_task_class_t* tc = (parsec_task_class_t*)__parsec_tp->super.super.task_classes_array[i];\n"
             "    free((void*)tc->incarnations);\n"
@@ -4521,30 +4654,6 @@ static void jdf_generate_destructor( const jdf_t *jdf )
                 f->task_class_id, f->fname);
     }
 
-    coutput("  /* Release the dependencies arrays for this object */\n");
-    for(f = jdf->functions; NULL != f; f = f->next) {
-        if( !( f->user_defines & JDF_FUNCTION_HAS_UD_DEPENDENCIES_FUNS ) ) {
-            if( JDF_COMPILER_GLOBAL_ARGS.dep_management == DEP_MANAGEMENT_INDEX_ARRAY ) {
-                coutput("  if(NULL != __parsec_tp->super.super.dependencies_array[%d])\n"
-                        "    dependencies_size += parsec_destruct_dependencies( __parsec_tp->super.super.dependencies_array[%d] );\n",
-                        f->task_class_id, f->task_class_id);
-            } else if (JDF_COMPILER_GLOBAL_ARGS.dep_management == DEP_MANAGEMENT_DYNAMIC_HASH_TABLE ) {
-                coutput("  parsec_hash_table_fini( (parsec_hash_table_t*)__parsec_tp->super.super.dependencies_array[%d] );\n"
-                        "  PARSEC_OBJ_RELEASE(__parsec_tp->super.super.dependencies_array[%d]);\n",
-                        f->task_class_id, f->task_class_id);
-            } 
-        } else {
-            coutput("  %s(__parsec_tp, __parsec_tp->super.super.dependencies_array[%d]);\n",
-                    jdf_property_get_function(f->properties, JDF_PROP_UD_FREE_DEPS_FN_NAME, NULL),
-                    f->task_class_id);
-
-        }
-        coutput("  __parsec_tp->super.super.dependencies_array[%d] = NULL;\n",
-                f->task_class_id);
-    }
-    coutput("  free( __parsec_tp->super.super.dependencies_array );\n"
-            "  __parsec_tp->super.super.dependencies_array = NULL;\n");
-
     if( JDF_COMPILER_GLOBAL_ARGS.dep_management == DEP_MANAGEMENT_INDEX_ARRAY ) {
         coutput("#if defined(PARSEC_PROF_TRACE)\n"
                 "  {\n"
@@ -7174,6 +7283,14 @@ static void jdf_generate_code_free_hash_table_entry(const jdf_t *jdf, const jdf_
 
 static void jdf_generate_code_release_deps(const jdf_t *jdf, const jdf_function_entry_t *f, const char *name)
 {
+    int static_usage = jdf_function_has_static_usage(f);
+    uint32_t complete_mask = 0;
+    jdf_dataflow_t *dl;
+
+    for( dl = f->dataflow; dl != NULL; dl = dl->next ) {
+        complete_mask |= dl->flow_dep_mask_out;
+    }
+
     coutput("static int %s(parsec_execution_stream_t *es, %s *this_task, uint32_t action_mask, parsec_remote_deps_t *deps)\n"
             "{\n"
             "PARSEC_PINS(es, RELEASE_DEPS_BEGIN, (parsec_task_t *)this_task);"
@@ -7182,6 +7299,7 @@ static void jdf_generate_code_release_deps(const jdf_t *jdf, const jdf_function_
             "  parsec_release_dep_fct_arg_t arg;\n"
             "  int __vp_id;\n"
             "  int consume_local_repo = 0;\n"
+            "  int32_t static_usage = -1; (void)static_usage;\n"
             "  arg.action_mask = action_mask;\n"
             "  arg.output_entry = NULL;\n"
             "  arg.output_repo = NULL;\n"
@@ -7205,6 +7323,21 @@ static void jdf_generate_code_release_deps(const jdf_t *jdf, const jdf_function_
         coutput("  arg.output_entry = this_task->repo_entry;\n");
         coutput("  arg.output_usage = 0;\n");
 
+        if( static_usage ) {
+            /* When all the successors of a task that ran are released, the
+             * usage limit of its entry is known in advance: the task still
+             * uses its own entry, so it does not need to be retained. */
+            coutput("  if( (NULL != this_task->repo_entry) &&\n"
+                    "      ((PARSEC_ACTION_RELEASE_LOCAL_DEPS | PARSEC_ACTION_RESHAPE_ON_RELEASE | 0x%x) ==\n"
+                    "       (action_mask & (PARSEC_ACTION_RELEASE_LOCAL_DEPS | PARSEC_ACTION_RESHAPE_ON_RELEASE |\n"
+                    "                       PARSEC_ACTION_RESHAPE_REMOTE_ON_RELEASE | 0x%x))) ) {\n"
+                    "    static_usage = usage_limit_of_%s_%s(es, this_task);\n"
+                    "  }\n"
+                    "  if( static_usage >= 0 ) {\n"
+                    "    data_repo_entry_addto_static_usage_limit(%s_repo, arg.output_entry, static_usage);\n"
+                    "  } else\n",
+                    complete_mask, complete_mask, jdf_basename, f->fname, f->fname);
+        }
         coutput("  if( action_mask & (PARSEC_ACTION_RELEASE_LOCAL_DEPS | PARSEC_ACTION_GET_REPO_ENTRY) ) {\n"
                  "    arg.output_entry = data_repo_lookup_entry_and_create( es, arg.output_repo, %s((const parsec_taskpool_t*)__parsec_tp, (const parsec_assignment_t*)&this_task->locals));\n"
                  "    arg.output_entry->generator = (void*)this_task;  /* for AYU */\n"
@@ -7234,9 +7367,19 @@ static void jdf_generate_code_release_deps(const jdf_t *jdf, const jdf_function_
                 "  }\n"
                 "#endif\n"
                 "\n");
-        coutput("  if(action_mask & PARSEC_ACTION_RELEASE_LOCAL_DEPS) {\n"
-                "    data_repo_entry_addto_usage_limit(%s_repo, arg.output_entry->ht_item.key, arg.output_usage);\n",
-                f->fname);
+        if( static_usage ) {
+            coutput("  if(action_mask & PARSEC_ACTION_RELEASE_LOCAL_DEPS) {\n"
+                    "    if( static_usage >= 0 ) {\n"
+                    "      assert( (uint32_t)static_usage == arg.output_usage );\n"
+                    "    } else {\n"
+                    "      data_repo_entry_addto_usage_limit(%s_repo, arg.output_entry->ht_item.key, arg.output_usage);\n"
+                    "    }\n",
+                    f->fname);
+        } else {
+            coutput("  if(action_mask & PARSEC_ACTION_RELEASE_LOCAL_DEPS) {\n"
+                    "    data_repo_entry_addto_usage_limit(%s_repo, arg.output_entry->ht_item.key, arg.output_usage);\n",
+                    f->fname);
+        }
         if(jdf_uses_dynamic_termdet(jdf)) {
             coutput("    {\n"
                     "      /* Using Dynamic Termination Detection, the DSL is reponsible of counting the number of tasks scheduled before scheduling them */\n"
@@ -7290,7 +7433,8 @@ static char *jdf_dump_context_assignment(string_arena_t *sa_open,
                                          const jdf_dep_t *dep,
                                          int lineno,
                                          const char *prefix,
-                                         const char *var)
+                                         const char *var,
+                                         int count_only)
 {
     expr_info_t local_info = EMPTY_EXPR_INFO, dest_info = EMPTY_EXPR_INFO;
     int nbparam_given, nbparam_required, i, nbopen;
@@ -7520,6 +7664,17 @@ static char *jdf_dump_context_assignment(string_arena_t *sa_open,
                             UTIL_DUMP_LIST(sa2, targetf->predicate->parameters, next,
                                            dump_expr, (void*)&dest_info,
                                            "", "", ", ", ""));
+    if( count_only ) {
+        /* Only the local successors are counted: skip everything that is
+         * needed to release the successor */
+        string_arena_add_string(sa_open,
+                                "%s%s  if( rank_dst == es->virtual_process->parsec_context->my_rank )\n"
+                                "#endif /* DISTRIBUTED */\n"
+                                "%s%s    %s",
+                                prefix, indent(nbopen),
+                                prefix, indent(nbopen), calltext);
+        goto close_and_return;
+    }
     string_arena_add_string(sa_open,
                             "%s%s  if( (NULL != es) && (rank_dst == es->virtual_process->parsec_context->my_rank) )\n"
                             "#endif /* DISTRIBUTED */\n"
@@ -7563,6 +7718,7 @@ static char *jdf_dump_context_assignment(string_arena_t *sa_open,
     string_arena_add_string(sa_open,
                             "%s%s%s", prefix, indent(nbopen), calltext);
 
+  close_and_return:
     for(i = nbopen; i > 0; i--) {
         string_arena_add_string(sa_close, "%s%s  }\n", prefix, indent(nbopen));
         nbopen--;
@@ -7902,7 +8058,7 @@ jdf_generate_code_iterate_successors_or_predecessors(const jdf_t *jdf,
                                             "%s",
                                             jdf_dump_context_assignment(sa1, jdf, f, fl, string_arena_get_string(sa_ontask),
                                                                         dl->guard->calltrue, dl, JDF_OBJECT_LINENO(dl),
-                                                                        "    ", "nc") );
+                                                                        "    ", "nc", 0) );
                 } else {
                     UTIL_DUMP_LIST(sa_temp, dl->guard->calltrue->parameters, next,
                                    dump_expr, (void*)&info, "", "", ", ", "");
@@ -7924,7 +8080,7 @@ jdf_generate_code_iterate_successors_or_predecessors(const jdf_t *jdf,
                                             dump_expr((void**)dl->guard->guard, &info),
                                             jdf_dump_context_assignment(sa1, jdf, f, fl, string_arena_get_string(sa_ontask),
                                                                         dl->guard->calltrue, dl, JDF_OBJECT_LINENO(dl),
-                                                                        "      ", "nc") );
+                                                                        "      ", "nc", 0) );
                 } else {
                     UTIL_DUMP_LIST(sa_temp, dl->guard->calltrue->parameters, next,
                                    dump_expr, (void*)&info, "", "", ", ", "");
@@ -7946,7 +8102,7 @@ jdf_generate_code_iterate_successors_or_predecessors(const jdf_t *jdf,
                                             dump_expr((void**)dl->guard->guard, &info),
                                             jdf_dump_context_assignment(sa1, jdf, f, fl, string_arena_get_string(sa_ontask),
                                                                         dl->guard->calltrue, dl, JDF_OBJECT_LINENO(dl),
-                                                                        "      ", "nc"));
+                                                                        "      ", "nc", 0));
                     depnb++;
 
                     string_arena_init(sa_ontask);
@@ -7963,7 +8119,7 @@ jdf_generate_code_iterate_successors_or_predecessors(const jdf_t *jdf,
                                                 "    }\n",
                                                 jdf_dump_context_assignment(sa1, jdf, f, fl, string_arena_get_string(sa_ontask),
                                                                             dl->guard->callfalse, dl, JDF_OBJECT_LINENO(dl),
-                                                                            "      ", "nc") );
+                                                                            "      ", "nc", 0) );
                     } else {
                         string_arena_add_string(sa_deps,
                                                 "\n");
@@ -7986,7 +8142,7 @@ jdf_generate_code_iterate_successors_or_predecessors(const jdf_t *jdf,
                                                 dump_expr((void**)dl->guard->guard, &info),
                                                 jdf_dump_context_assignment(sa1, jdf, f, fl, string_arena_get_string(sa_ontask),
                                                                             dl->guard->callfalse, dl, JDF_OBJECT_LINENO(dl),
-                                                                            "      ", "nc") );
+                                                                            "      ", "nc", 0) );
                     } else {
                         UTIL_DUMP_LIST(sa_temp, dl->guard->callfalse->parameters, next,
                                        dump_expr, (void*)&info, "", "", ", ", "");
@@ -8053,6 +8209,184 @@ jdf_generate_code_iterate_successors_or_predecessors(const jdf_t *jdf,
 
 }
 
+/**
+ * The number of times the repo entry of a task is used by its local
+ * successors can be computed before they are released (instead of being
+ * counted while they are released, with the entry retained in the
+ * meantime) when the dependencies cannot set up a reshape promise on the
+ * repo of a successor, that is when no output dependency of a data flow
+ * defines its own type. The property static_usage = 0 of a task class
+ * disables this.
+ */
+static int jdf_function_has_static_usage(const jdf_function_entry_t *f)
+{
+    jdf_dataflow_t *fl;
+    jdf_dep_t *dl;
+
+    if( (f->flags & JDF_FUNCTION_FLAG_NO_SUCCESSORS) ||
+        !jdf_property_get_int(f->properties, "static_usage", 1) )
+        return 0;
+    for(fl = f->dataflow; fl != NULL; fl = fl->next) {
+        if( JDF_FLOW_TYPE_CTL & fl->flow_flags ) continue;
+        for(dl = fl->deps; dl != NULL; dl = dl->next) {
+            if( !(dl->dep_flags & JDF_DEP_FLOW_OUT) ) continue;
+            if( JDF_IS_DEP_WRITE_ONLY_INPUT_TYPE(dl) ) continue;
+            if( (DEP_UNDEFINED_DATATYPE != jdf_dep_undefined_type(dl->datatype_local)) ||
+                (NULL != dl->datatype_local.layout) ||
+                (NULL == dl->datatype_local.count) ||
+                (JDF_CST != dl->datatype_local.count->op) ||
+                (0 == dl->datatype_local.count->jdf_cst) )
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Generates the function that returns the number of local successors
+ * that will use the repo entry of a task, when all its output dependencies
+ * are released: one per dependency of a data flow with a data, towards a
+ * task that exists and runs on this rank. This follows the same steps as
+ * iterate_successors, without computing the datatypes, the priorities or
+ * the keys of the successors. It returns -1 if the successors may use the
+ * entry otherwise.
+ */
+static void jdf_generate_code_usage_limit(const jdf_t *jdf, const jdf_function_entry_t *f, const char *name)
+{
+    jdf_dataflow_t *fl;
+    jdf_dep_t *dl;
+    jdf_expr_t *ld;
+    string_arena_t *sa1 = string_arena_new(64);
+    string_arena_t *sa2 = string_arena_new(64);
+    string_arena_t *sa_deps = string_arena_new(1024);
+    const char *count = "__nb_uses++;\n";
+    assignment_info_t ai;
+    expr_info_t info = EMPTY_EXPR_INFO;
+    int nb_open_ldef;
+
+    info.sa = sa2;
+    info.prefix = "";
+    info.suffix = "";
+    info.assignments = "&"JDF2C_NAMESPACE"_tmp_locals";
+
+    ai.sa = sa2;
+    ai.holder = JDF2C_NAMESPACE"_tmp_locals.";
+    ai.expr = NULL;
+    coutput("static int32_t\n"
+            "%s(parsec_execution_stream_t *es, const %s *this_task)\n"
+            "{\n"
+            "#if defined(PARSEC_RESHAPE_BEFORE_SEND_TO_REMOTE)\n"
+            "  /* The remote successors use the entry too */\n"
+            "  (void)es; (void)this_task;\n"
+            "  return -1;\n"
+            "#else\n"
+            "  const __parsec_%s_internal_taskpool_t *__parsec_tp = (const __parsec_%s_internal_taskpool_t*)this_task->taskpool;\n"
+            "  parsec_task_t nc = { 0 };  /* generic placeholder for locals */\n"
+            "  %s "JDF2C_NAMESPACE"_tmp_locals = *(%s*)&this_task->locals;   /* copy of this_task locals in R/W mode to manage local definitions */\n"
+            "  int32_t __nb_uses = 0;\n"
+            "  int rank_dst = 0;\n"
+            "%s"
+            "  (void)rank_dst; (void)__parsec_tp; (void)es;\n",
+            name, parsec_get_name(jdf, f, "task_t"),
+            jdf_basename, jdf_basename,
+            parsec_get_name(jdf, f, "parsec_assignment_t"), parsec_get_name(jdf, f, "parsec_assignment_t"),
+            UTIL_DUMP_LIST(sa1, f->locals, next,
+                           dump_local_assignments, &ai, "", "  ", "\n", "\n"));
+    coutput("%s",
+            UTIL_DUMP_LIST_FIELD(sa1, f->locals, next, name,
+                                 dump_string, NULL, "", "  (void)", ";", ";\n"));
+    coutput("  nc.taskpool  = this_task->taskpool;\n");
+
+    for(fl = f->dataflow; fl != NULL; fl = fl->next) {
+        if( JDF_FLOW_TYPE_CTL & fl->flow_flags ) continue;
+        string_arena_init(sa_deps);
+        for(dl = fl->deps; dl != NULL; dl = dl->next) {
+            if( !(dl->dep_flags & JDF_DEP_FLOW_OUT) ) continue;
+            if( JDF_IS_DEP_WRITE_ONLY_INPUT_TYPE(dl) ) continue;
+            if( (NULL == dl->guard->calltrue->var) &&
+                ((JDF_GUARD_TERNARY != dl->guard->guard_type) || (NULL == dl->guard->callfalse->var)) )
+                continue;  /* Only to memory */
+
+            nb_open_ldef = 0;
+            if( NULL != dl->local_defs ) {
+                for(ld = jdf_expr_lv_first(dl->local_defs); ld != NULL; ld = jdf_expr_lv_next(dl->local_defs, ld)) {
+                    assert(NULL != ld->alias);
+                    assert(-1 != ld->ldef_index);
+                    string_arena_add_string(sa_deps, "%s    int %s;\n", indent(nb_open_ldef), ld->alias);
+                    if(JDF_RANGE == ld->op) {
+                        string_arena_add_string(sa_deps,
+                                                "%s    for( %s = %s;",
+                                                indent(nb_open_ldef), ld->alias, dump_expr((void**)ld->jdf_ta1, &info));
+                        string_arena_add_string(sa_deps, "%s <= %s; %s+=",
+                                                ld->alias, dump_expr((void**)ld->jdf_ta2, &info), ld->alias);
+                        string_arena_add_string(sa_deps, "%s) {\n"
+                                                "%s    "JDF2C_NAMESPACE"_tmp_locals.ldef[%d].value = %s;\n",
+                                                dump_expr((void**)ld->jdf_ta3, &info),
+                                                indent(nb_open_ldef), ld->ldef_index, ld->alias);
+                        nb_open_ldef++;
+                    } else {
+                        string_arena_add_string(sa_deps,
+                                                "%s    "JDF2C_NAMESPACE"_tmp_locals.ldef[%d].value = %s = %s;\n",
+                                                indent(nb_open_ldef), ld->ldef_index, ld->alias, dump_expr((void**)ld, &info));
+                    }
+                }
+            }
+
+            switch( dl->guard->guard_type ) {
+            case JDF_GUARD_UNCONDITIONAL:
+                string_arena_add_string(sa_deps, "    {\n%s    }\n",
+                                        jdf_dump_context_assignment(sa1, jdf, f, fl, count,
+                                                                    dl->guard->calltrue, dl, JDF_OBJECT_LINENO(dl),
+                                                                    "      ", "nc", 1));
+                break;
+            case JDF_GUARD_BINARY:
+                string_arena_add_string(sa_deps, "    if( %s ) {\n%s    }\n",
+                                        dump_expr((void**)dl->guard->guard, &info),
+                                        jdf_dump_context_assignment(sa1, jdf, f, fl, count,
+                                                                    dl->guard->calltrue, dl, JDF_OBJECT_LINENO(dl),
+                                                                    "      ", "nc", 1));
+                break;
+            case JDF_GUARD_TERNARY:
+                if( NULL != dl->guard->calltrue->var ) {
+                    string_arena_add_string(sa_deps, "    if( %s ) {\n%s    }\n",
+                                            dump_expr((void**)dl->guard->guard, &info),
+                                            jdf_dump_context_assignment(sa1, jdf, f, fl, count,
+                                                                        dl->guard->calltrue, dl, JDF_OBJECT_LINENO(dl),
+                                                                        "      ", "nc", 1));
+                }
+                if( NULL != dl->guard->callfalse->var ) {
+                    string_arena_add_string(sa_deps, "    if( !(%s) ) {\n%s    }\n",
+                                            dump_expr((void**)dl->guard->guard, &info),
+                                            jdf_dump_context_assignment(sa1, jdf, f, fl, count,
+                                                                        dl->guard->callfalse, dl, JDF_OBJECT_LINENO(dl),
+                                                                        "      ", "nc", 1));
+                }
+                break;
+            }
+
+            while(nb_open_ldef > 0) {
+                string_arena_add_string(sa_deps, "%s    }\n", indent(nb_open_ldef));
+                nb_open_ldef--;
+            }
+        }
+        if( 0 != strlen(string_arena_get_string(sa_deps)) ) {
+            coutput("  if( NULL != this_task->data._f_%s.data_out ) {  /* Flow of data %s [%d] */\n"
+                    "%s"
+                    "  }\n",
+                    fl->varname, fl->varname, fl->flow_index,
+                    string_arena_get_string(sa_deps));
+        }
+    }
+    coutput("  (void)nc;\n"
+            "  return __nb_uses;\n"
+            "#endif  /* defined(PARSEC_RESHAPE_BEFORE_SEND_TO_REMOTE) */\n"
+            "}\n\n");
+
+    string_arena_free(sa1);
+    string_arena_free(sa2);
+    string_arena_free(sa_deps);
+}
+
 /**
  * Generates the code corresponding to inline_c expressions. If the inline_c was
  * defined in the context of a function, then it uses the function name and the
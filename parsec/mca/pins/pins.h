@@ -43,6 +43,7 @@ typedef enum PARSEC_PINS_FLAG {
      */
     THREAD_INIT,         // Provided as an option for modules to run work during thread init without using the MCA module registration system.
     THREAD_FINI,         // Similar to above, for thread finalization.
+    HBBUFFER_RESIZE,     // An adaptive bounded buffer changed size; task points to a parsec_hbbuffer_resize_event_t.
     /* inactive but tentatively planned (no current call in PaRSEC runtime)
      PARSEC_SCHEDULED,
      PARSEC_PROLOGUE,
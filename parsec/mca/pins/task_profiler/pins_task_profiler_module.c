@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2019 The University of Tennessee and The University
+ * Copyright (c) 2012-2022 The University of Tennessee and The University
  *                         of Tennessee Research Foundation.  All rights
  *                         reserved.
  */
@@ -11,6 +11,7 @@
 #include "pins_task_profiler.h"
 #include "parsec/profiling.h"
 #include "parsec/execution_stream.h"
+#include "parsec/hbbuffer.h"
 #include "parsec/interfaces/dtd/insert_function_internal.h"
 
 int release_deps_trace_keyin;
@@ -19,6 +20,8 @@ int activate_cb_trace_keyin;
 int activate_cb_trace_keyout;
 int data_flush_trace_keyin;
 int data_flush_trace_keyout;
+int hbbuffer_resize_trace_keyin;
+int hbbuffer_resize_trace_keyout;
 
 /* init functions */
 static void pins_init_task_profiler(parsec_context_t *master_context);
@@ -46,6 +49,10 @@ static void task_profiler_data_flush_end(struct parsec_execution_stream_s*     e
                                          struct parsec_task_s*                 task,
                                          struct parsec_pins_next_callback_s*   cb_data);
 
+static void task_profiler_hbbuffer_resize(struct parsec_execution_stream_s*    es,
+                                          struct parsec_task_s*                task,
+                                          struct parsec_pins_next_callback_s*  cb_data);
+
 static void task_profiler_exec_count_begin(struct parsec_execution_stream_s*   es,
                                            struct parsec_task_s*               task,
                                            struct parsec_pins_next_callback_s* cb_data);
@@ -86,6 +93,12 @@ static void pins_init_task_profiler(parsec_context_t *master_context)
                                            "",
                                            &data_flush_trace_keyin,
                                            &data_flush_trace_keyout);
+
+    parsec_profiling_add_dictionary_keyword("HBBUFFER_RESIZE", "fill:#00FF00",
+                                           5 * sizeof(int32_t),
+                                           "old_size{int32_t};new_size{int32_t};nb_pushes{int32_t};nb_overflows{int32_t};occupancy{int32_t}",
+                                           &hbbuffer_resize_trace_keyin,
+                                           &hbbuffer_resize_trace_keyout);
 }
 
 static void pins_fini_task_profiler(parsec_context_t *master_context)
@@ -115,6 +128,9 @@ static void pins_thread_init_task_profiler(struct parsec_execution_stream_s * es
     PARSEC_PINS_REGISTER(es, DATA_FLUSH_BEGIN, task_profiler_data_flush_begin, event_cb);
     event_cb = (parsec_pins_next_callback_t*)malloc(sizeof(parsec_pins_next_callback_t));
     PARSEC_PINS_REGISTER(es, DATA_FLUSH_END, task_profiler_data_flush_end, event_cb);
+
+    event_cb = (parsec_pins_next_callback_t*)malloc(sizeof(parsec_pins_next_callback_t));
+    PARSEC_PINS_REGISTER(es, HBBUFFER_RESIZE, task_profiler_hbbuffer_resize, event_cb);
 }
 
 static void pins_thread_fini_task_profiler(struct parsec_execution_stream_s * es)
@@ -139,6 +155,9 @@ static void pins_thread_fini_task_profiler(struct parsec_execution_stream_s * es
     free(event_cb);
     PARSEC_PINS_UNREGISTER(es, DATA_FLUSH_END, task_profiler_data_flush_end, &event_cb);
     free(event_cb);
+
+    PARSEC_PINS_UNREGISTER(es, HBBUFFER_RESIZE, task_profiler_hbbuffer_resize, &event_cb);
+    free(event_cb);
 }
 
 /*
@@ -230,6 +249,28 @@ task_profiler_data_flush_end(struct parsec_execution_stream_s*   es,
     (void)cb_data;(void)task;
 }
 
+/* The resize is instantaneous: trace it as an empty interval, with the
+ * description of the resize as the info of both events */
+static void
+task_profiler_hbbuffer_resize(struct parsec_execution_stream_s*   es,
+                              struct parsec_task_s*               task,
+                              struct parsec_pins_next_callback_s* cb_data)
+{
+    parsec_hbbuffer_resize_event_t *event = (parsec_hbbuffer_resize_event_t*)task;
+
+    PARSEC_PROFILING_TRACE(es->es_profile,
+                           hbbuffer_resize_trace_keyin,
+                           (uint64_t)(uintptr_t)event->buffer,
+                           -1,
+                           (void*)&event->old_size);
+    PARSEC_PROFILING_TRACE(es->es_profile,
+                           hbbuffer_resize_trace_keyout,
+                           (uint64_t)(uintptr_t)event->buffer,
+                           -1,
+                           (void*)&event->old_size);
+    (void)cb_data;
+}
+
 static void
 task_profiler_exec_count_begin(struct parsec_execution_stream_s*   es,
                                struct parsec_task_s*               task,
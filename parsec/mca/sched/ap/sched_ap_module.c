@@ -41,7 +41,9 @@ const parsec_sched_module_t parsec_sched_ap_module = {
         sched_ap_schedule,
         sched_ap_select,
         NULL,
-        sched_ap_remove
+        sched_ap_remove,
+        NULL,
+        NULL
     }
 };
 
@@ -122,6 +124,7 @@ static void sched_ap_remove( parsec_context_t *master )
     parsec_mca_sched_list_local_counter_t *sl;
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_ap_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             sl = LOCAL_SCHED_OBJECT(es);
@@ -40,7 +40,9 @@ const parsec_sched_module_t parsec_sched_gd_module = {
         sched_gd_schedule,
         sched_gd_select,
         NULL,
-        sched_gd_remove
+        sched_gd_remove,
+        NULL,
+        NULL
     }
 };
 
@@ -172,6 +174,7 @@ static void sched_gd_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_gd_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             sd = LOCAL_SCHED_OBJECT(es);
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ * Critical-Path (HEFT upward rank) Scheduler
+ *
+ */
+
+
+#ifndef MCA_SCHED_HEFT_H
+#define MCA_SCHED_HEFT_H
+
+#include "parsec/parsec_config.h"
+#include "parsec/mca/mca.h"
+#include "parsec/mca/sched/sched.h"
+
+
+BEGIN_C_DECLS
+
+/**
+ * Globally exported variable
+ */
+PARSEC_DECLSPEC extern const parsec_sched_base_component_t parsec_sched_heft_component;
+PARSEC_DECLSPEC extern const parsec_sched_module_t parsec_sched_heft_module;
+/* static accessor */
+mca_base_component_t *sched_heft_static_component(void);
+
+/**
+ * Weight (in percent) of a new measure in the moving average of the
+ * execution time of a task class.
+ */
+extern int sched_heft_ewma_weight;
+
+/**
+ * Number of execution time measures between two updates of the upward
+ * ranks of the task classes.
+ */
+extern int sched_heft_rank_period;
+
+END_C_DECLS
+#endif /* MCA_SCHED_HEFT_H */
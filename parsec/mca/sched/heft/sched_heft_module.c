@@ -0,0 +1,566 @@
+/**
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/parsec_internal.h"
+#include "parsec/utils/debug.h"
+#include "parsec/os-spec-timing.h"
+#include "parsec/sys/atomic.h"
+#include "parsec/class/parsec_oa_hash_table.h"
+#include "parsec/class/parsec_ebr.h"
+
+#include "parsec/mca/sched/sched.h"
+#include "parsec/mca/sched/heft/sched_heft.h"
+#include "parsec/mca/pins/pins.h"
+#include "parsec/papi_sde.h"
+
+#include <string.h>
+
+/**
+ * @brief Execution time statistics of a task class
+ *
+ * @details Task classes are identified by their name and the name of their
+ *   taskpool, so that the statistics carry over from one taskpool to the
+ *   next instance of the same algorithm. The successors are the task
+ *   classes that the output flows of the class can activate; the upward
+ *   rank of a class is its average duration plus the largest upward rank of
+ *   its successors (back edges of cycles in the graph of task classes are
+ *   ignored). This is the rank HEFT uses to order tasks, at the granularity
+ *   of task classes. The measures are accounted with atomic operations, as
+ *   all the execution streams running tasks of a class update its statistics.
+ */
+
+/** A double updated with compare-and-swap on its bits */
+typedef union {
+    double  d;
+    int64_t bits;
+} sched_heft_double_t;
+
+typedef struct sched_heft_class_s {
+    char                        *tp_name;     /**< Name of the taskpool */
+    char                        *name;        /**< Name of the task class */
+    volatile sched_heft_double_t duration;    /**< Moving average of the execution time */
+    volatile int64_t             nb_samples;  /**< Number of measures of the execution time */
+    volatile double              rank;        /**< Upward rank */
+    int                          nb_succ;
+    struct sched_heft_class_s  **succ;        /**< Successor classes */
+    int                          mark;        /**< Depth-first search state during the rank updates */
+} sched_heft_class_t;
+
+#define SCHED_HEFT_UNVISITED 0
+#define SCHED_HEFT_VISITING  1
+#define SCHED_HEFT_VISITED   2
+
+/** A ready task, and the rank it had when it was scheduled */
+typedef struct {
+    double              rank;
+    parsec_task_t      *task;
+    sched_heft_class_t *cls;
+} sched_heft_entry_t;
+
+/** Binary max-heap of the ready tasks of a virtual process */
+typedef struct {
+    parsec_atomic_lock_t lock;
+    int32_t              size;
+    int32_t              capacity;
+    sched_heft_entry_t  *heap;
+} sched_heft_queue_t;
+
+/** Tasks scheduled together are ranked in a buffer of that size on the stack */
+#define SCHED_HEFT_BATCH 32
+
+/**
+ * @brief Class of the tasks of a task class of a taskpool
+ *
+ * @details These entries are keyed by the taskpool id and the task class
+ *   id, and found without lock. They are inserted, and removed once their
+ *   taskpool is unregistered, with sched_heft_classes_lock held.
+ */
+typedef struct {
+    parsec_hash_table_item_t   ht_item;
+    const parsec_task_class_t *tc;
+    sched_heft_class_t        *cls;
+} sched_heft_tc_t;
+
+#define SCHED_HEFT_TC_KEY(tp, tc) \
+    ((parsec_key_t)(((uint64_t)(tp)->taskpool_id << 8) | (uint64_t)(tc)->task_class_id))
+
+/**
+ * @brief Scheduling object of the critical-path scheduler
+ *
+ * @details The execution time of each task is reported by the runtime once
+ *   its body returned (see sched_heft_executed), and accounted to its own
+ *   class, whether it was selected here or chained by the execution stream.
+ */
+typedef struct {
+    sched_heft_queue_t *queue;    /**< Queue of the virtual process */
+} sched_heft_object_t;
+
+#define SCHED_HEFT_OBJECT(es) ((sched_heft_object_t*)(es)->scheduler_object)
+
+/* All the task classes seen since the scheduler was installed */
+static parsec_atomic_lock_t  sched_heft_classes_lock = PARSEC_ATOMIC_UNLOCKED;
+static int                   sched_heft_nb_classes = 0;
+static int                   sched_heft_classes_size = 0;
+static sched_heft_class_t  **sched_heft_classes = NULL;
+static volatile int32_t      sched_heft_nb_samples = 0;
+
+/* The class of each task class of the live taskpools */
+static parsec_oa_hash_table_t sched_heft_tcs;
+static int                    sched_heft_tcs_ready = 0;
+static int                    sched_heft_nb_tcs = 0;
+static int                    sched_heft_tcs_purge = 64;  /**< Purge the table when it has that many entries */
+
+/**
+ * Module functions
+ */
+static int sched_heft_install(parsec_context_t* master);
+static int sched_heft_schedule(parsec_execution_stream_t* es,
+                               parsec_task_t* new_context,
+                               int32_t distance);
+static parsec_task_t*
+sched_heft_select(parsec_execution_stream_t *es,
+                  int32_t* distance);
+static void sched_heft_executed(parsec_execution_stream_t* es,
+                                const parsec_task_t* task,
+                                uint64_t duration);
+static void sched_heft_display_stats(parsec_execution_stream_t* es);
+static void sched_heft_remove(parsec_context_t* master);
+static int flow_heft_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier);
+
+const parsec_sched_module_t parsec_sched_heft_module = {
+    &parsec_sched_heft_component,
+    {
+        sched_heft_install,
+        flow_heft_init,
+        sched_heft_schedule,
+        sched_heft_select,
+        sched_heft_display_stats,
+        sched_heft_remove,
+        NULL,
+        sched_heft_executed
+    }
+};
+
+static double sched_heft_rank_dfs(sched_heft_class_t *cls)
+{
+    double best = 0.0, r;
+    int i;
+
+    if( SCHED_HEFT_VISITED == cls->mark ) return cls->rank;
+    if( SCHED_HEFT_VISITING == cls->mark ) return 0.0;  /* back edge */
+    cls->mark = SCHED_HEFT_VISITING;
+    for( i = 0; i < cls->nb_succ; i++ ) {
+        r = sched_heft_rank_dfs(cls->succ[i]);
+        if( r > best ) best = r;
+    }
+    cls->rank = cls->duration.d + best;
+    cls->mark = SCHED_HEFT_VISITED;
+    return cls->rank;
+}
+
+/* Must be called with sched_heft_classes_lock held */
+static void sched_heft_update_ranks_nolock(void)
+{
+    int i;
+    for( i = 0; i < sched_heft_nb_classes; i++ )
+        sched_heft_classes[i]->mark = SCHED_HEFT_UNVISITED;
+    for( i = 0; i < sched_heft_nb_classes; i++ )
+        sched_heft_rank_dfs(sched_heft_classes[i]);
+}
+
+/* Must be called with sched_heft_classes_lock held */
+static sched_heft_class_t *
+sched_heft_get_class_nolock(const parsec_taskpool_t *tp, const parsec_task_class_t *tc)
+{
+    const char *tp_name = (NULL == tp->taskpool_name) ? "" : tp->taskpool_name;
+    sched_heft_class_t *cls, *succ;
+    const parsec_flow_t *flow;
+    const parsec_dep_t *dep;
+    int i, j, k;
+
+    for( i = 0; i < sched_heft_nb_classes; i++ ) {
+        cls = sched_heft_classes[i];
+        if( (0 == strcmp(cls->name, tc->name)) && (0 == strcmp(cls->tp_name, tp_name)) )
+            return cls;
+    }
+
+    cls = (sched_heft_class_t*)calloc(1, sizeof(sched_heft_class_t));
+    cls->tp_name = strdup(tp_name);
+    cls->name = strdup(tc->name);
+    if( sched_heft_nb_classes == sched_heft_classes_size ) {
+        sched_heft_classes_size = (0 == sched_heft_classes_size) ? 16 : 2 * sched_heft_classes_size;
+        sched_heft_classes = (sched_heft_class_t**)realloc(sched_heft_classes,
+                                                           sched_heft_classes_size * sizeof(sched_heft_class_t*));
+    }
+    /* Register the class before its successors, to stop on cycles */
+    sched_heft_classes[sched_heft_nb_classes++] = cls;
+
+    for( i = 0; (i < MAX_PARAM_COUNT) && (NULL != (flow = tc->out[i])); i++ ) {
+        for( j = 0; (j < MAX_DEP_OUT_COUNT) && (NULL != (dep = flow->dep_out[j])); j++ ) {
+            if( (dep->task_class_id >= tp->nb_task_classes) ||
+                (NULL == tp->task_classes_array[dep->task_class_id]) )
+                continue;  /* the data goes back to memory */
+            succ = sched_heft_get_class_nolock(tp, tp->task_classes_array[dep->task_class_id]);
+            for( k = 0; (k < cls->nb_succ) && (cls->succ[k] != succ); k++ );
+            if( k < cls->nb_succ ) continue;
+            cls->succ = (sched_heft_class_t**)realloc(cls->succ, (cls->nb_succ + 1) * sizeof(sched_heft_class_t*));
+            cls->succ[cls->nb_succ++] = succ;
+        }
+    }
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HEFT:\tnew task class %s:%s with %d successor classes",
+                         cls->tp_name, cls->name, cls->nb_succ);
+    return cls;
+}
+
+/* Must be called with sched_heft_classes_lock held */
+static void sched_heft_purge_tc(void *item, void *cb_data)
+{
+    sched_heft_tc_t *entry = (sched_heft_tc_t*)item;
+    (void)cb_data;
+    if( NULL != parsec_taskpool_lookup((uint32_t)((uint64_t)entry->ht_item.key >> 8)) )
+        return;
+    parsec_oa_hash_table_remove(&sched_heft_tcs, entry->ht_item.key);
+    parsec_ebr_retire(entry, free);
+    sched_heft_nb_tcs--;
+}
+
+/**
+ * Find the statistics of the class of a task. The table of the task classes
+ * is read without lock; the first task of a task class takes
+ * sched_heft_classes_lock to find or create its class by name.
+ */
+static sched_heft_class_t *
+sched_heft_get_class(const parsec_task_t *task)
+{
+    const parsec_task_class_t *tc = task->task_class;
+    parsec_key_t key = SCHED_HEFT_TC_KEY(task->taskpool, tc);
+    sched_heft_class_t *cls = NULL;
+    sched_heft_tc_t *entry;
+
+    parsec_ebr_enter();
+    entry = (sched_heft_tc_t*)parsec_oa_hash_table_find(&sched_heft_tcs, key);
+    if( (NULL != entry) && (entry->tc == tc) )
+        cls = entry->cls;
+    parsec_ebr_exit();
+    if( NULL != cls )
+        return cls;
+
+    parsec_atomic_lock(&sched_heft_classes_lock);
+    entry = (sched_heft_tc_t*)parsec_oa_hash_table_find(&sched_heft_tcs, key);
+    if( (NULL != entry) && (entry->tc == tc) ) {
+        cls = entry->cls;
+        parsec_atomic_unlock(&sched_heft_classes_lock);
+        return cls;
+    }
+    if( NULL != entry ) {  /* a former task class with the same ids */
+        parsec_oa_hash_table_remove(&sched_heft_tcs, key);
+        parsec_ebr_retire(entry, free);
+        sched_heft_nb_tcs--;
+    }
+    if( sched_heft_nb_tcs >= sched_heft_tcs_purge ) {
+        /* Forget the task classes of the taskpools that are gone */
+        parsec_oa_hash_table_for_all(&sched_heft_tcs, sched_heft_purge_tc, NULL);
+        sched_heft_tcs_purge = (2 * sched_heft_nb_tcs > 64) ? 2 * sched_heft_nb_tcs : 64;
+    }
+    cls = sched_heft_get_class_nolock(task->taskpool, tc);
+    if( 0 == cls->nb_samples )
+        sched_heft_update_ranks_nolock();
+    entry = (sched_heft_tc_t*)malloc(sizeof(sched_heft_tc_t));
+    entry->ht_item.key = key;
+    entry->tc = tc;
+    entry->cls = cls;
+    parsec_oa_hash_table_insert(&sched_heft_tcs, &entry->ht_item);
+    sched_heft_nb_tcs++;
+    parsec_atomic_unlock(&sched_heft_classes_lock);
+    return cls;
+}
+
+/**
+ * Account for a new measure of the execution time of a class, and update
+ * the ranks of all classes every sched_heft_rank_period measures.
+ */
+static void sched_heft_account(sched_heft_class_t *cls, uint64_t duration)
+{
+    sched_heft_double_t old_avg, new_avg;
+    int32_t nb;
+    int update;
+
+    /* The first measure of a class changes the ranks the most */
+    update = (0 == parsec_atomic_fetch_inc_int64(&cls->nb_samples));
+    do {
+        old_avg.bits = cls->duration.bits;
+        if( update )
+            new_avg.d = (double)duration;
+        else
+            new_avg.d = old_avg.d + ((double)duration - old_avg.d) * sched_heft_ewma_weight / 100.0;
+    } while( !parsec_atomic_cas_int64(&cls->duration.bits, old_avg.bits, new_avg.bits) );
+
+    /* The stream that completes a period resets the counter, unless other
+     * measures were counted meanwhile: the last of them does it */
+    nb = parsec_atomic_fetch_inc_int32(&sched_heft_nb_samples) + 1;
+    if( (nb >= sched_heft_rank_period) &&
+        parsec_atomic_cas_int32(&sched_heft_nb_samples, nb, 0) ) {
+        update = 1;
+    }
+    if( update ) {
+        if( parsec_atomic_trylock(&sched_heft_classes_lock) ) {
+            sched_heft_update_ranks_nolock();
+            parsec_atomic_unlock(&sched_heft_classes_lock);
+        }
+    }
+}
+
+/* Returns true if the entry a must be selected before the entry b */
+static inline int
+sched_heft_before(const sched_heft_entry_t *a, const sched_heft_entry_t *b)
+{
+    if( a->rank != b->rank )
+        return a->rank > b->rank;
+    return A_HIGHER_PRIORITY_THAN_B(a->task, b->task, parsec_execution_context_priority_comparator);
+}
+
+/* Must be called with queue->lock held, and enough room in the heap */
+static void sched_heft_heap_push(sched_heft_queue_t *queue, sched_heft_entry_t *e)
+{
+    int32_t i = queue->size++, parent;
+
+    while( i > 0 ) {
+        parent = (i - 1) / 2;
+        if( !sched_heft_before(e, &queue->heap[parent]) )
+            break;
+        queue->heap[i] = queue->heap[parent];
+        i = parent;
+    }
+    queue->heap[i] = *e;
+}
+
+/* Must be called with queue->lock held, on a non empty heap */
+static void sched_heft_heap_pop(sched_heft_queue_t *queue, sched_heft_entry_t *top)
+{
+    sched_heft_entry_t last;
+    int32_t i = 0, child;
+
+    *top = queue->heap[0];
+    last = queue->heap[--queue->size];
+    while( (child = 2 * i + 1) < queue->size ) {
+        if( (child + 1 < queue->size) && sched_heft_before(&queue->heap[child + 1], &queue->heap[child]) )
+            child++;
+        if( !sched_heft_before(&queue->heap[child], &last) )
+            break;
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    queue->heap[i] = last;
+}
+
+static int sched_heft_install( parsec_context_t *master )
+{
+    (void)master;
+    /* The module can be installed for the context and for virtual processes */
+    if( !sched_heft_tcs_ready ) {
+        int rc = parsec_oa_hash_table_init(&sched_heft_tcs, offsetof(sched_heft_tc_t, ht_item), 6,
+                                           parsec_hash_table_generic_key_fn, NULL);
+        if( PARSEC_SUCCESS != rc )
+            return rc;
+        sched_heft_tcs_ready = 1;
+    }
+    return PARSEC_SUCCESS;
+}
+
+static int flow_heft_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier)
+{
+    sched_heft_object_t *sched_obj;
+    sched_heft_queue_t *queue;
+    parsec_vp_t *vp = es->virtual_process;
+
+    sched_obj = (sched_heft_object_t*)calloc(1, sizeof(sched_heft_object_t));
+    es->scheduler_object = sched_obj;
+    if( 0 == es->th_id ) {  /* flow 0 creates the queue of the virtual process */
+        queue = (sched_heft_queue_t*)calloc(1, sizeof(sched_heft_queue_t));
+        parsec_atomic_lock_init(&queue->lock);
+        queue->capacity = 256;
+        queue->heap = (sched_heft_entry_t*)malloc(queue->capacity * sizeof(sched_heft_entry_t));
+        sched_obj->queue = queue;
+    }
+
+    parsec_barrier_wait(barrier);
+
+    sched_obj->queue = SCHED_HEFT_OBJECT(vp->execution_streams[0])->queue;
+
+#if defined(PARSEC_PAPI_SDE)
+    if( 0 == es->th_id ) {
+        char event_name[PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN];
+        snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                 "SCHEDULER::PENDING_TASKS::QUEUE=%d::SCHED=HEFT", vp->vp_id);
+        parsec_papi_sde_register_counter(event_name, PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                         PAPI_SDE_int, (void*)&sched_obj->queue->size);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS", PAPI_SDE_SUM);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS::SCHED=HEFT", PAPI_SDE_SUM);
+    }
+#endif
+
+    return PARSEC_SUCCESS;
+}
+
+/**
+ * @brief
+ *   Selects the ready task with the highest upward rank
+ *
+ * @details
+ *   Ties between tasks of the same rank (e.g. of the same class) are broken
+ *   by their priority. The rescheduled tasks come after all the others.
+ */
+static parsec_task_t*
+sched_heft_select(parsec_execution_stream_t *es,
+                  int32_t* distance)
+{
+    sched_heft_object_t *sched_obj = SCHED_HEFT_OBJECT(es);
+    sched_heft_queue_t *queue = sched_obj->queue;
+    sched_heft_entry_t e;
+
+    if( 0 == queue->size )
+        return NULL;
+
+    parsec_atomic_lock(&queue->lock);
+    if( 0 == queue->size ) {
+        parsec_atomic_unlock(&queue->lock);
+        return NULL;
+    }
+    sched_heft_heap_pop(queue, &e);
+    parsec_atomic_unlock(&queue->lock);
+
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "HEFT\t: %d:%d selected task %p of class %s (rank %g)",
+                         es->virtual_process->vp_id, es->th_id, e.task, e.cls->name, e.rank);
+    *distance = 0;
+    return e.task;
+}
+
+static int sched_heft_schedule(parsec_execution_stream_t* es,
+                               parsec_task_t* new_context,
+                               int32_t distance)
+{
+    sched_heft_queue_t *queue = SCHED_HEFT_OBJECT(es)->queue;
+    parsec_list_item_t *item = (parsec_list_item_t*)new_context, *next;
+    sched_heft_entry_t batch[SCHED_HEFT_BATCH], *entries = batch;
+    int32_t nb_tasks = 0, i;
+
+    _LIST_ITEM_ITERATOR(item, item, it, { (void)it; nb_tasks++; });
+    if( nb_tasks > SCHED_HEFT_BATCH )
+        entries = (sched_heft_entry_t*)malloc(nb_tasks * sizeof(sched_heft_entry_t));
+
+    /* Rank the tasks before taking the lock of the queue */
+    for( i = 0; i < nb_tasks; i++ ) {
+        next = PARSEC_LIST_ITEM_NEXT(item);
+        PARSEC_LIST_ITEM_SINGLETON(item);
+        entries[i].task = (parsec_task_t*)item;
+        entries[i].cls = sched_heft_get_class(entries[i].task);
+        /* Tasks that could not run yet (e.g. returned AGAIN) go behind the
+         * others, otherwise they would be selected again right away */
+        entries[i].rank = (distance > 0) ? -(double)distance : entries[i].cls->rank;
+        item = next;
+    }
+
+    parsec_atomic_lock(&queue->lock);
+    if( queue->size + nb_tasks > queue->capacity ) {
+        while( queue->size + nb_tasks > queue->capacity )
+            queue->capacity *= 2;
+        queue->heap = (sched_heft_entry_t*)realloc(queue->heap, queue->capacity * sizeof(sched_heft_entry_t));
+    }
+    for( i = 0; i < nb_tasks; i++ )
+        sched_heft_heap_push(queue, &entries[i]);
+    parsec_atomic_unlock(&queue->lock);
+
+    if( entries != batch )
+        free(entries);
+    return PARSEC_SUCCESS;
+}
+
+/* Accounts the execution time of a task to its class */
+static void sched_heft_executed(parsec_execution_stream_t* es,
+                                const parsec_task_t* task,
+                                uint64_t duration)
+{
+    (void)es;
+    sched_heft_account(sched_heft_get_class(task), duration);
+}
+
+static void sched_heft_display_stats(parsec_execution_stream_t* es)
+{
+    sched_heft_class_t *cls;
+    int i;
+
+    if( (0 != es->th_id) || (0 != es->virtual_process->vp_id) )
+        return;
+    parsec_atomic_lock(&sched_heft_classes_lock);
+    for( i = 0; i < sched_heft_nb_classes; i++ ) {
+        cls = sched_heft_classes[i];
+        parsec_inform("HEFT scheduler: task class %s:%s: %lld measures, average duration %g %s, upward rank %g %s",
+                      cls->tp_name, cls->name, (long long int)cls->nb_samples,
+                      cls->duration.d, TIMER_UNIT, cls->rank, TIMER_UNIT);
+    }
+    parsec_atomic_unlock(&sched_heft_classes_lock);
+}
+
+static void sched_heft_free_tc(void *item, void *cb_data)
+{
+    sched_heft_tc_t *entry = (sched_heft_tc_t*)item;
+    (void)cb_data;
+    parsec_oa_hash_table_remove(&sched_heft_tcs, entry->ht_item.key);
+    free(entry);
+}
+
+static void sched_heft_remove( parsec_context_t *master )
+{
+    int p, t, i;
+    parsec_execution_stream_t *es;
+    parsec_vp_t *vp;
+    sched_heft_object_t *sched_obj;
+
+    for(p = 0; p < master->nb_vp; p++) {
+        vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_heft_module) ) continue;
+        for(t = 0; t < vp->nb_cores; t++) {
+            es = vp->execution_streams[t];
+            if (es != NULL) {
+                sched_obj = SCHED_HEFT_OBJECT(es);
+                if( es->th_id == 0 ) {
+                    free(sched_obj->queue->heap);
+                    free(sched_obj->queue);
+                }
+                free(es->scheduler_object);
+                es->scheduler_object = NULL;
+            }
+        }
+        PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=%d::SCHED=HEFT", p);
+    }
+    PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::SCHED=HEFT");
+
+    if( sched_heft_tcs_ready ) {
+        parsec_oa_hash_table_for_all(&sched_heft_tcs, sched_heft_free_tc, NULL);
+        parsec_oa_hash_table_fini(&sched_heft_tcs);
+        sched_heft_nb_tcs = 0;
+        sched_heft_tcs_purge = 64;
+        sched_heft_tcs_ready = 0;
+    }
+
+    for( i = 0; i < sched_heft_nb_classes; i++ ) {
+        free(sched_heft_classes[i]->tp_name);
+        free(sched_heft_classes[i]->name);
+        free(sched_heft_classes[i]->succ);
+        free(sched_heft_classes[i]);
+    }
+    free(sched_heft_classes);
+    sched_heft_classes = NULL;
+    sched_heft_nb_classes = sched_heft_classes_size = 0;
+    sched_heft_nb_samples = 0;
+}
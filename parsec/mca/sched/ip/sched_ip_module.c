@@ -40,7 +40,9 @@ const parsec_sched_module_t parsec_sched_ip_module = {
         sched_ip_schedule,
         sched_ip_select,
         NULL,
-        sched_ip_remove
+        sched_ip_remove,
+        NULL,
+        NULL
     }
 };
 
@@ -121,6 +123,7 @@ static void sched_ip_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_ip_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             sl = LOCAL_SCHED_OBJECT(es);
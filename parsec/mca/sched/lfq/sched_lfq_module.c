@@ -30,9 +30,14 @@ static int sched_lfq_install(parsec_context_t* master);
 static int sched_lfq_schedule(parsec_execution_stream_t* es,
                               parsec_task_t* new_context,
                               int32_t distance);
+static int sched_lfq_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance);
 static parsec_task_t*
 sched_lfq_select(parsec_execution_stream_t *es,
                  int32_t* distance);
+static void sched_lfq_display_stats(parsec_execution_stream_t* es);
 static void sched_lfq_remove(parsec_context_t* master);
 static int flow_lfq_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier);
 
@@ -43,8 +48,10 @@ const parsec_sched_module_t parsec_sched_lfq_module = {
         flow_lfq_init,
         sched_lfq_schedule,
         sched_lfq_select,
-        NULL,
-        sched_lfq_remove
+        sched_lfq_display_stats,
+        sched_lfq_remove,
+        sched_lfq_schedule_bulk,
+        NULL
     }
 };
 
@@ -82,8 +89,8 @@ static int flow_lfq_init(parsec_execution_stream_t* es, struct parsec_barrier_t*
     sched_obj->system_queue = PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(vp->execution_streams[0])->system_queue;
 
     /* Each thread creates its own "local" queue, connected to the shared dequeue */
-    sched_obj->task_queue = parsec_hbbuffer_new( queue_size, 1, parsec_mca_sched_push_in_system_queue_wrapper,
-                                                (void*)sched_obj );
+    sched_obj->task_queue = parsec_hbbuffer_new_adaptive( queue_size, 1, parsec_mca_sched_push_in_system_queue_wrapper,
+                                                         (void*)sched_obj );
     sched_obj->hierarch_queues[0] = sched_obj->task_queue;
 
     /* All local allocations are now completed. Synchronize with the other
@@ -202,6 +209,25 @@ static int sched_lfq_schedule(parsec_execution_stream_t* es,
     return PARSEC_SUCCESS;
 }
 
+static int sched_lfq_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance)
+{
+    parsec_hbbuffer_push_all_bulk(PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es)->task_queue,
+                                  (parsec_list_item_t*)new_context,
+                                  nb_tasks, distance);
+    return PARSEC_SUCCESS;
+}
+
+static void sched_lfq_display_stats(parsec_execution_stream_t* es)
+{
+    parsec_hbbuffer_t *b = PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es)->task_queue;
+    parsec_inform("LFQ scheduler VP: %i Thread: %i (Core %i): local queue of %d elements (between %d and %d), grew %d times, shrank %d times",
+                  es->virtual_process->vp_id, es->th_id, es->core_id,
+                  (int)b->size, (int)b->min_size, (int)b->max_size, b->nb_grows, b->nb_shrinks);
+}
+
 static void sched_lfq_remove( parsec_context_t *master )
 {
     int p, t;
@@ -211,6 +237,7 @@ static void sched_lfq_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_lfq_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             if (es != NULL) {
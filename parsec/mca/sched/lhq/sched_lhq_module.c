@@ -44,7 +44,9 @@ const parsec_sched_module_t parsec_sched_lhq_module = {
         sched_lhq_schedule,
         sched_lhq_select,
         NULL,
-        sched_lhq_remove
+        sched_lhq_remove,
+        NULL,
+        NULL
     }
 };
 
@@ -232,6 +234,7 @@ static void sched_lhq_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_lhq_module) ) continue;
 
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
@@ -43,7 +43,9 @@ const parsec_sched_module_t parsec_sched_ll_module = {
         sched_ll_schedule,
         sched_ll_select,
         NULL,
-        sched_ll_remove
+        sched_ll_remove,
+        NULL,
+        NULL
     }
 };
 
@@ -268,6 +270,7 @@ static void sched_ll_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_ll_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             if (es != NULL) {
@@ -33,6 +33,10 @@ static int sched_llp_install(parsec_context_t* master);
 static int sched_llp_schedule(parsec_execution_stream_t* es,
                               parsec_task_t* new_context,
                               int32_t distance);
+static int sched_llp_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance);
 static parsec_task_t*
 sched_llp_select(parsec_execution_stream_t *es,
                  int32_t* distance);
@@ -75,7 +79,9 @@ const parsec_sched_module_t parsec_sched_llp_module = {
         sched_llp_schedule,
         sched_llp_select,
         NULL,
-        sched_llp_remove
+        sched_llp_remove,
+        sched_llp_schedule_bulk,
+        NULL
     }
 };
 
@@ -268,6 +274,44 @@ static int sched_llp_schedule(parsec_execution_stream_t* es,
     return PARSEC_SUCCESS;
 }
 
+/**
+ * @brief
+ *  Schedule a sorted set of ready tasks on the calling execution stream
+ *
+ * @details
+ *  The ring is known to be sorted and its length is known: it is
+ *  chained into the local LIFO at once (a single CAS when the tasks
+ *  have a higher priority than the head of the LIFO), and the
+ *  counter is updated without walking the ring.
+ *
+ *   @param[INOUT] es          the calling execution stream
+ *   @param[INOUT] new_context the ring of ready tasks to schedule, sorted
+ *                             by decreasing priority
+ *   @param[IN] nb_tasks       the number of tasks in new_context
+ *   @param[IN] distance       the distance hint
+ *   @return PARSEC_SUCCESS in case of success, a negative number
+ *                          otherwise.
+ */
+static int sched_llp_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance)
+{
+    parsec_lifo_with_prio_t *es_sched_obj = (parsec_lifo_with_prio_t*)es->scheduler_object;
+#if defined(PARSEC_PAPI_SDE)
+    es_sched_obj->local_counter += nb_tasks;
+#else
+    (void)nb_tasks;
+#endif
+
+    lifo_chain_sorted(&es_sched_obj->lifo, &new_context->super, distance,
+                      parsec_execution_context_priority_comparator,
+                      /* the comm thread might write into thread 0' s queue */
+                      (es->th_id != 0));
+
+    return PARSEC_SUCCESS;
+}
+
 /**
  * @brief
  *  Removes the scheduler from the parsec_context_t
@@ -287,6 +331,7 @@ static void sched_llp_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_llp_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             if (es != NULL) {
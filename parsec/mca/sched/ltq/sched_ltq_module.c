@@ -33,9 +33,14 @@ static int sched_ltq_install(parsec_context_t* master);
 static int sched_ltq_schedule(parsec_execution_stream_t* es,
                               parsec_task_t* new_context,
                               int32_t distance);
+static int sched_ltq_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance);
 static parsec_task_t *sched_ltq_select(parsec_execution_stream_t *es,
                                        int32_t* distance);
 static int flow_ltq_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier);
+static void sched_ltq_display_stats(parsec_execution_stream_t* es);
 static void sched_ltq_remove(parsec_context_t* master);
 
 const parsec_sched_module_t parsec_sched_ltq_module = {
@@ -45,8 +50,10 @@ const parsec_sched_module_t parsec_sched_ltq_module = {
         flow_ltq_init,
         sched_ltq_schedule,
         sched_ltq_select,
-        NULL,
-        sched_ltq_remove
+        sched_ltq_display_stats,
+        sched_ltq_remove,
+        sched_ltq_schedule_bulk,
+        NULL
     }
 };
 
@@ -83,8 +90,8 @@ static int flow_ltq_init(parsec_execution_stream_t* es, struct parsec_barrier_t*
     sched_obj->system_queue = PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(vp->execution_streams[0])->system_queue;
 
     /* Each thread creates its own "local" queue, connected to the shared dequeue */
-    sched_obj->task_queue = parsec_hbbuffer_new( queue_size, 1, parsec_mca_sched_push_in_system_queue_wrapper,
-                                                (void*)sched_obj);
+    sched_obj->task_queue = parsec_hbbuffer_new_adaptive( queue_size, 1, parsec_mca_sched_push_in_system_queue_wrapper,
+                                                         (void*)sched_obj);
     sched_obj->task_queue->assoc_core_num = -1; // broken since flow added
     sched_obj->hierarch_queues[0] = sched_obj->task_queue;
 
@@ -233,9 +240,13 @@ sched_ltq_select(parsec_execution_stream_t *es,
     return task;
 }
 
-static int sched_ltq_schedule(parsec_execution_stream_t* es,
-                              parsec_task_t* new_context,
-                              int32_t distance)
+/**
+ * Group the ring of tasks into a ring of heaps, two consecutive tasks of
+ * the ring sharing at least one input being in the same heap. Returns the
+ * ring of heaps, and the number of heaps in nb_heaps.
+ */
+static parsec_heap_t* sched_ltq_build_heaps(parsec_task_t* new_context,
+                                            int32_t* nb_heaps)
 {
     parsec_task_t * cur = new_context;
     parsec_task_t * next;
@@ -278,8 +289,18 @@ static int sched_ltq_schedule(parsec_execution_stream_t* es,
             new_heap->list_item.list_next = (parsec_list_item_t*)heap->list_item.list_next;
             heap->list_item.list_next = (parsec_list_item_t*)new_heap;
             heap = new_heap;
+            (*nb_heaps)++;
         }
     }
+    return first_h;
+}
+
+static int sched_ltq_schedule(parsec_execution_stream_t* es,
+                              parsec_task_t* new_context,
+                              int32_t distance)
+{
+    int32_t nb_heaps = 1;
+    parsec_heap_t* first_h = sched_ltq_build_heaps(new_context, &nb_heaps);
 
     /* Insert the prepared heap elements starting from the correct distance */
     parsec_hbbuffer_push_all(PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es)->task_queue,
@@ -288,6 +309,34 @@ static int sched_ltq_schedule(parsec_execution_stream_t* es,
     return PARSEC_SUCCESS;
 }
 
+/**
+ * The tasks are sorted by decreasing priority, and so are the heaps built
+ * from them: the heaps that do not fit in the local buffer are given to the
+ * system queue in a single operation.
+ */
+static int sched_ltq_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance)
+{
+    int32_t nb_heaps = 1;
+    parsec_heap_t* first_h = sched_ltq_build_heaps(new_context, &nb_heaps);
+
+    (void)nb_tasks;
+    parsec_hbbuffer_push_all_bulk(PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es)->task_queue,
+                                  (parsec_list_item_t*)first_h, nb_heaps, distance);
+
+    return PARSEC_SUCCESS;
+}
+
+static void sched_ltq_display_stats(parsec_execution_stream_t* es)
+{
+    parsec_hbbuffer_t *b = PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es)->task_queue;
+    parsec_inform("LTQ scheduler VP: %i Thread: %i (Core %i): local queue of %d elements (between %d and %d), grew %d times, shrank %d times",
+                  es->virtual_process->vp_id, es->th_id, es->core_id,
+                  (int)b->size, (int)b->min_size, (int)b->max_size, b->nb_grows, b->nb_shrinks);
+}
+
 static void sched_ltq_remove( parsec_context_t *master )
 {
     int t, p;
@@ -297,6 +346,7 @@ static void sched_ltq_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_ltq_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             sched_obj = PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es);
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ * Lock-free Work-Stealing Scheduler
+ *
+ */
+
+
+#ifndef MCA_SCHED_LWS_H
+#define MCA_SCHED_LWS_H
+
+#include "parsec/parsec_config.h"
+#include "parsec/mca/mca.h"
+#include "parsec/mca/sched/sched.h"
+
+
+BEGIN_C_DECLS
+
+/**
+ * Globally exported variable
+ */
+PARSEC_DECLSPEC extern const parsec_sched_base_component_t parsec_sched_lws_component;
+PARSEC_DECLSPEC extern const parsec_sched_module_t parsec_sched_lws_module;
+/* static accessor */
+mca_base_component_t *sched_lws_static_component(void);
+
+/**
+ * Maximal number of tasks held by the work-stealing dequeue of each
+ * execution stream. Tasks that do not fit are stored in the shared
+ * overflow queue of the virtual process.
+ */
+extern int sched_lws_deque_size;
+
+END_C_DECLS
+#endif /* MCA_SCHED_LWS_H */
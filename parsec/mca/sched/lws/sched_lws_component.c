@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ * These symbols are in a file by themselves to provide nice linker
+ * semantics.  Since linkers generally pull in symbols by object
+ * files, keeping these symbols as the only symbols in this file
+ * prevents utility programs such as "ompi_info" from having to import
+ * entire components just to query their version and parameters.
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/runtime.h"
+
+#include "parsec/mca/sched/sched.h"
+#include "parsec/mca/sched/lws/sched_lws.h"
+#include "parsec/utils/mca_param.h"
+#include "parsec/papi_sde.h"
+
+/*
+ * Local function
+ */
+static int sched_lws_component_query(mca_base_module_t **module, int *priority);
+static int sched_lws_component_register(void);
+
+int sched_lws_deque_size = 4096;
+
+/*
+ * Instantiate the public struct with all of our public information
+ * and pointers to our public functions in it
+ */
+const parsec_sched_base_component_t parsec_sched_lws_component = {
+
+    /* First, the mca_component_t struct containing meta information
+       about the component itself */
+
+    {
+        PARSEC_SCHED_BASE_VERSION_2_0_0,
+
+        /* Component name and version */
+        "lws",
+        "", /* options */
+        PARSEC_VERSION_MAJOR,
+        PARSEC_VERSION_MINOR,
+
+        /* Component open and close functions */
+        NULL, /*< No open: sched_lws is always available, no need to check at runtime */
+        NULL, /*< No close: open did not allocate any resource, no need to release them */
+        sched_lws_component_query,
+        /*< specific query to return the module and add it to the list of available modules */
+        sched_lws_component_register,
+        "", /*< no reserve */
+    },
+    {
+        /* The component has no metada */
+        MCA_BASE_METADATA_PARAM_NONE,
+        "", /*< no reserve */
+    }
+};
+
+mca_base_component_t *sched_lws_static_component(void)
+{
+    return (mca_base_component_t *)&parsec_sched_lws_component;
+}
+
+static int sched_lws_component_query(mca_base_module_t **module, int *priority)
+{
+    /* module type should be: const mca_base_module_t ** */
+    void *ptr = (void*)&parsec_sched_lws_module;
+    *priority = 4;
+    *module = (mca_base_module_t *)ptr;
+    return MCA_SUCCESS;
+}
+
+static int sched_lws_component_register(void)
+{
+    parsec_mca_param_reg_int_name("sched_lws", "deque_size",
+                                  "Maximal number of tasks in the work-stealing dequeue of each execution stream "
+                                  "(rounded up to a power of 2); tasks that do not fit are stored in a shared "
+                                  "overflow queue",
+                                  false, false,
+                                  sched_lws_deque_size, &sched_lws_deque_size);
+    if( sched_lws_deque_size < 2 )
+        sched_lws_deque_size = 2;
+
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::PENDING_TASKS::SCHED=LWS",
+                              "the number of pending tasks for the LWS scheduler");
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=<VPID>/<QID>::SCHED=LWS",
+                              "the number of pending tasks that end up in the virtual process <VPID> queue of queue identifier <QID> for the LWS scheduler");
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::STEALS::SCHED=LWS",
+                              "the number of tasks the LWS scheduler stole from the dequeue of another execution stream");
+    return MCA_SUCCESS;
+}
@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/parsec_internal.h"
+#include "parsec/utils/debug.h"
+#include "parsec/class/dequeue.h"
+#include "parsec/class/wsdeque.h"
+
+#include "parsec/mca/sched/sched.h"
+#include "parsec/mca/sched/sched_local_queues_utils.h"
+#include "parsec/mca/sched/lws/sched_lws.h"
+#include "parsec/mca/pins/pins.h"
+#include "parsec/papi_sde.h"
+
+/**
+ * @brief Scheduling object of the lock-free work stealing scheduler
+ *
+ * @details Each execution stream owns a Chase-Lev dequeue: it pushes and
+ *   pops tasks at the bottom without atomic operations, while the other
+ *   streams of the virtual process steal from the top. Tasks scheduled by
+ *   a thread that does not own the target stream (e.g. the communication
+ *   thread), tasks scheduled at a non-zero distance, and tasks that do not
+ *   fit in the dequeue go to the overflow queue of the virtual process
+ *   (super.system_queue). The bounded buffers of the super object are not
+ *   used.
+ */
+typedef struct {
+    parsec_mca_sched_local_queues_scheduler_object_t super;
+    parsec_wsdeque_t   *deque;       /**< Dequeue owned by this stream */
+    int                 nb_victims;  /**< Number of other streams in the virtual process */
+    parsec_wsdeque_t  **victims;     /**< Dequeues of the other streams, round-robin from ours */
+    int                 last_victim; /**< Victim of the last successful steal, tried first */
+    long long int       steals;      /**< Tasks stolen from the dequeue of another stream */
+} sched_lws_object_t;
+
+#define SCHED_LWS_OBJECT(es) ((sched_lws_object_t*)(es)->scheduler_object)
+
+/**
+ * Module functions
+ */
+static int sched_lws_install(parsec_context_t* master);
+static int sched_lws_schedule(parsec_execution_stream_t* es,
+                              parsec_task_t* new_context,
+                              int32_t distance);
+static parsec_task_t*
+sched_lws_select(parsec_execution_stream_t *es,
+                 int32_t* distance);
+static void sched_lws_display_stats(parsec_execution_stream_t* es);
+static void sched_lws_remove(parsec_context_t* master);
+static int flow_lws_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier);
+
+const parsec_sched_module_t parsec_sched_lws_module = {
+    &parsec_sched_lws_component,
+    {
+        sched_lws_install,
+        flow_lws_init,
+        sched_lws_schedule,
+        sched_lws_select,
+        sched_lws_display_stats,
+        sched_lws_remove,
+        NULL,
+        NULL
+    }
+};
+
+static int sched_lws_install( parsec_context_t *master )
+{
+    (void)master;
+    return PARSEC_SUCCESS;
+}
+
+static int flow_lws_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier)
+{
+    sched_lws_object_t *sched_obj = NULL;
+    parsec_vp_t* vp = es->virtual_process;
+    int i;
+
+    /* Every flow creates its own local object */
+    sched_obj = (sched_lws_object_t*)calloc(1, sizeof(sched_lws_object_t));
+    es->scheduler_object = sched_obj;
+    if( 0 == es->th_id ) {  /* And flow 0 creates the system_queue */
+        sched_obj->super.system_queue = PARSEC_OBJ_NEW(parsec_dequeue_t);
+    }
+    sched_obj->deque = PARSEC_OBJ_NEW(parsec_wsdeque_t);
+    parsec_wsdeque_init(sched_obj->deque, PARSEC_WSDEQUE_DEFAULT_SIZE, sched_lws_deque_size);
+
+    /* All local allocations are now completed. Synchronize with the other
+     threads before setting up the victims. */
+    parsec_barrier_wait(barrier);
+
+    /* Get the flow 0 system queue and store it locally */
+    sched_obj->super.system_queue = SCHED_LWS_OBJECT(vp->execution_streams[0])->super.system_queue;
+
+    sched_obj->nb_victims = vp->nb_cores - 1;
+    sched_obj->victims = (parsec_wsdeque_t**)malloc(vp->nb_cores * sizeof(parsec_wsdeque_t*));
+    for( i = 0; i < sched_obj->nb_victims; i++ ) {
+        sched_obj->victims[i] = SCHED_LWS_OBJECT(vp->execution_streams[(es->th_id + i + 1) % vp->nb_cores])->deque;
+    }
+
+#if defined(PARSEC_PAPI_SDE)
+    {
+        char event_name[PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN];
+        if( 0 == es->th_id ) {
+            snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                     "SCHEDULER::PENDING_TASKS::QUEUE=%d/overflow::SCHED=LWS", vp->vp_id);
+            parsec_papi_sde_register_fp_counter(event_name, PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                                PAPI_SDE_int, (papi_sde_fptr_t)parsec_mca_sched_system_queue_length, vp);
+            parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS", PAPI_SDE_SUM);
+            parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS::SCHED=LWS", PAPI_SDE_SUM);
+        }
+        snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                 "SCHEDULER::PENDING_TASKS::QUEUE=%d/%d::SCHED=LWS", vp->vp_id, es->th_id);
+        parsec_papi_sde_register_fp_counter(event_name, PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                            PAPI_SDE_long_long, (papi_sde_fptr_t)parsec_wsdeque_approx_size,
+                                            sched_obj->deque);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS", PAPI_SDE_SUM);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS::SCHED=LWS", PAPI_SDE_SUM);
+
+        snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                 "SCHEDULER::STEALS::QUEUE=%d/%d::SCHED=LWS", vp->vp_id, es->th_id);
+        parsec_papi_sde_register_counter(event_name, PAPI_SDE_RO|PAPI_SDE_DELTA,
+                                         PAPI_SDE_long_long, &sched_obj->steals);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::STEALS::SCHED=LWS", PAPI_SDE_SUM);
+    }
+#endif
+
+    return PARSEC_SUCCESS;
+}
+
+/**
+ * @brief
+ *   Selects a task to run
+ *
+ * @details
+ *   Pop the most recent task from our own dequeue (depth-first, the data
+ *   it uses are likely still in cache), otherwise steal the oldest task of
+ *   the other streams, starting with the last successful victim, and
+ *   finally look in the overflow queue of the virtual process.
+ */
+static parsec_task_t*
+sched_lws_select(parsec_execution_stream_t *es,
+                 int32_t* distance)
+{
+    sched_lws_object_t *sched_obj = SCHED_LWS_OBJECT(es);
+    parsec_task_t *task = NULL;
+    int i, v;
+
+    task = (parsec_task_t*)parsec_wsdeque_pop(sched_obj->deque);
+    if( NULL != task ) {
+        *distance = 0;
+        return task;
+    }
+    for( i = 0; i < sched_obj->nb_victims; i++ ) {
+        v = (sched_obj->last_victim + i) % sched_obj->nb_victims;
+        task = (parsec_task_t*)parsec_wsdeque_steal(sched_obj->victims[v]);
+        if( NULL != task ) {
+            PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "LWS\t: %d:%d stole task %p from dequeue %p",
+                                 es->virtual_process->vp_id, es->th_id, task, sched_obj->victims[v]);
+            sched_obj->last_victim = v;
+            sched_obj->steals++;
+            *distance = v + 1;
+            return task;
+        }
+    }
+    task = parsec_mca_sched_pop_from_system_queue_wrapper(&sched_obj->super);
+    if( NULL != task ) {
+        PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "LWS\t: %d:%d found task %p in its system queue %p",
+                             es->virtual_process->vp_id, es->th_id, task, sched_obj->super.system_queue);
+        *distance = 1 + sched_obj->nb_victims;
+    }
+    return task;
+}
+
+static int sched_lws_schedule(parsec_execution_stream_t* es,
+                              parsec_task_t* new_context,
+                              int32_t distance)
+{
+    sched_lws_object_t *sched_obj = SCHED_LWS_OBJECT(es);
+    parsec_list_item_t *ring = (parsec_list_item_t*)new_context, *item, *next;
+
+    /* Only the owner can push in the dequeue */
+    if( (0 == distance) && (parsec_my_execution_stream() == es) ) {
+        /* Reverse the ring, so that the first task of the ring (the one with
+         * the highest priority when the ring is sorted) is the first one the
+         * owner pops, and the last one to be stolen. */
+        item = ring;
+        do {
+            next = (parsec_list_item_t*)item->list_next;
+            item->list_next = item->list_prev;
+            item->list_prev = next;
+            item = next;
+        } while( item != ring );
+        ring = parsec_wsdeque_push_ring(sched_obj->deque, (parsec_list_item_t*)ring->list_next);
+        if( NULL == ring )
+            return PARSEC_SUCCESS;
+    }
+    parsec_mca_sched_push_in_system_queue_wrapper(&sched_obj->super, ring, distance);
+    return PARSEC_SUCCESS;
+}
+
+static void sched_lws_display_stats(parsec_execution_stream_t* es)
+{
+    sched_lws_object_t *sched_obj = SCHED_LWS_OBJECT(es);
+    parsec_inform("LWS scheduler VP: %i Thread: %i (Core %i): %lld steals",
+                  es->virtual_process->vp_id, es->th_id, es->core_id, sched_obj->steals);
+}
+
+static void sched_lws_remove( parsec_context_t *master )
+{
+    int p, t;
+    parsec_execution_stream_t *es;
+    parsec_vp_t *vp;
+    sched_lws_object_t *sched_obj;
+
+    for(p = 0; p < master->nb_vp; p++) {
+        vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_lws_module) ) continue;
+        for(t = 0; t < vp->nb_cores; t++) {
+            es = vp->execution_streams[t];
+            if (es != NULL) {
+                sched_obj = SCHED_LWS_OBJECT(es);
+
+                if( es->th_id == 0 ) {
+                    PARSEC_OBJ_RELEASE( sched_obj->super.system_queue );
+                }
+                sched_obj->super.system_queue = NULL;
+
+                PARSEC_OBJ_RELEASE( sched_obj->deque );
+                free(sched_obj->victims);
+                sched_obj->victims = NULL;
+
+                free(es->scheduler_object);
+                es->scheduler_object = NULL;
+            }
+            PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=%d/%d::SCHED=LWS", vp->vp_id, t);
+            PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::STEALS::QUEUE=%d/%d::SCHED=LWS", vp->vp_id, t);
+        }
+        PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=%d/overflow::SCHED=LWS", p);
+    }
+    PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::SCHED=LWS");
+    PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::STEALS::SCHED=LWS");
+}
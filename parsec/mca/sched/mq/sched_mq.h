@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ * Relaxed Priority MultiQueue Scheduler
+ *
+ */
+
+
+#ifndef MCA_SCHED_MQ_H
+#define MCA_SCHED_MQ_H
+
+#include "parsec/parsec_config.h"
+#include "parsec/mca/mca.h"
+#include "parsec/mca/sched/sched.h"
+
+
+BEGIN_C_DECLS
+
+/**
+ * Globally exported variable
+ */
+PARSEC_DECLSPEC extern const parsec_sched_base_component_t parsec_sched_mq_component;
+PARSEC_DECLSPEC extern const parsec_sched_module_t parsec_sched_mq_module;
+/* static accessor */
+mca_base_component_t *sched_mq_static_component(void);
+
+/**
+ * Number of heaps per execution stream in the MultiQueue of each virtual
+ * process. The total number of heaps bounds the expected rank error of
+ * the selected tasks.
+ */
+extern int sched_mq_relaxation;
+
+END_C_DECLS
+#endif /* MCA_SCHED_MQ_H */
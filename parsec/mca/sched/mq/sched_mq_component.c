@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ * These symbols are in a file by themselves to provide nice linker
+ * semantics.  Since linkers generally pull in symbols by object
+ * files, keeping these symbols as the only symbols in this file
+ * prevents utility programs such as "ompi_info" from having to import
+ * entire components just to query their version and parameters.
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/runtime.h"
+
+#include "parsec/mca/sched/sched.h"
+#include "parsec/mca/sched/mq/sched_mq.h"
+#include "parsec/utils/mca_param.h"
+#include "parsec/papi_sde.h"
+
+/*
+ * Local function
+ */
+static int sched_mq_component_query(mca_base_module_t **module, int *priority);
+static int sched_mq_component_register(void);
+
+int sched_mq_relaxation = 2;
+
+/*
+ * Instantiate the public struct with all of our public information
+ * and pointers to our public functions in it
+ */
+const parsec_sched_base_component_t parsec_sched_mq_component = {
+
+    /* First, the mca_component_t struct containing meta information
+       about the component itself */
+
+    {
+        PARSEC_SCHED_BASE_VERSION_2_0_0,
+
+        /* Component name and version */
+        "mq",
+        "", /* options */
+        PARSEC_VERSION_MAJOR,
+        PARSEC_VERSION_MINOR,
+
+        /* Component open and close functions */
+        NULL, /*< No open: sched_mq is always available, no need to check at runtime */
+        NULL, /*< No close: open did not allocate any resource, no need to release them */
+        sched_mq_component_query,
+        /*< specific query to return the module and add it to the list of available modules */
+        sched_mq_component_register,
+        "", /*< no reserve */
+    },
+    {
+        /* The component has no metada */
+        MCA_BASE_METADATA_PARAM_NONE,
+        "", /*< no reserve */
+    }
+};
+
+mca_base_component_t *sched_mq_static_component(void)
+{
+    return (mca_base_component_t *)&parsec_sched_mq_component;
+}
+
+static int sched_mq_component_query(mca_base_module_t **module, int *priority)
+{
+    /* module type should be: const mca_base_module_t ** */
+    void *ptr = (void*)&parsec_sched_mq_module;
+    *priority = 6;
+    *module = (mca_base_module_t *)ptr;
+    return MCA_SUCCESS;
+}
+
+static int sched_mq_component_register(void)
+{
+    parsec_mca_param_reg_int_name("sched_mq", "relaxation",
+                                  "Number of priority heaps per execution stream in the MultiQueue of each "
+                                  "virtual process; more heaps lower the contention but relax the priority "
+                                  "order (the expected rank error of a selected task grows linearly with "
+                                  "the total number of heaps)",
+                                  false, false,
+                                  sched_mq_relaxation, &sched_mq_relaxation);
+    if( sched_mq_relaxation < 1 )
+        sched_mq_relaxation = 1;
+
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::PENDING_TASKS::SCHED=MQ",
+                              "the number of pending tasks for the MQ scheduler");
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=<VPID>::SCHED=MQ",
+                              "the number of pending tasks that end up in the MultiQueue of the virtual process <VPID> for the MQ scheduler");
+    return MCA_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/parsec_internal.h"
+#include "parsec/utils/debug.h"
+#include "parsec/class/multiqueue.h"
+
+#include "parsec/mca/sched/sched.h"
+#include "parsec/mca/sched/mq/sched_mq.h"
+#include "parsec/mca/pins/pins.h"
+#include "parsec/papi_sde.h"
+
+/**
+ * @brief Scheduling object of the MultiQueue scheduler
+ *
+ * @details All the execution streams of a virtual process share one
+ *   relaxed priority queue (parsec_multiqueue_t) made of
+ *   sched_mq_relaxation heaps per stream; flow 0 owns it. Each stream
+ *   keeps its own random state and contention counter, so that the
+ *   choice of the heaps does not need any shared variable.
+ */
+typedef struct {
+    parsec_multiqueue_t *queue;    /**< Shared queue of the virtual process */
+    parsec_multiqueue_thread_t th; /**< Random state and failed trylocks of this stream */
+    long long int        pushes;   /**< Tasks scheduled by this stream */
+    long long int        pops;     /**< Tasks selected by this stream */
+} sched_mq_object_t;
+
+#define SCHED_MQ_OBJECT(es) ((sched_mq_object_t*)(es)->scheduler_object)
+
+/**
+ * Module functions
+ */
+static int sched_mq_install(parsec_context_t* master);
+static int sched_mq_schedule(parsec_execution_stream_t* es,
+                             parsec_task_t* new_context,
+                             int32_t distance);
+static parsec_task_t*
+sched_mq_select(parsec_execution_stream_t *es,
+                int32_t* distance);
+static void sched_mq_display_stats(parsec_execution_stream_t* es);
+static void sched_mq_remove(parsec_context_t* master);
+static int flow_mq_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier);
+
+const parsec_sched_module_t parsec_sched_mq_module = {
+    &parsec_sched_mq_component,
+    {
+        sched_mq_install,
+        flow_mq_init,
+        sched_mq_schedule,
+        sched_mq_select,
+        sched_mq_display_stats,
+        sched_mq_remove,
+        NULL,
+        NULL
+    }
+};
+
+static int sched_mq_install( parsec_context_t *master )
+{
+    (void)master;
+    return PARSEC_SUCCESS;
+}
+
+static int flow_mq_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier)
+{
+    sched_mq_object_t *sched_obj = NULL;
+    parsec_vp_t* vp = es->virtual_process;
+
+    /* Every flow creates its own local object */
+    sched_obj = (sched_mq_object_t*)calloc(1, sizeof(sched_mq_object_t));
+    es->scheduler_object = sched_obj;
+    /* xorshift needs a non-zero state */
+    sched_obj->th.seed = 0x9e3779b9u * (uint32_t)(vp->vp_id * vp->nb_cores + es->th_id + 1);
+    sched_obj->th.nb_busy = 0;
+    if( 0 == es->th_id ) {  /* And flow 0 creates the shared queue */
+        sched_obj->queue = PARSEC_OBJ_NEW(parsec_multiqueue_t);
+        parsec_multiqueue_init(sched_obj->queue, sched_mq_relaxation * vp->nb_cores,
+                               parsec_execution_context_priority_comparator);
+    }
+
+    parsec_barrier_wait(barrier);
+
+    /* Get the flow 0 queue and store it locally */
+    sched_obj->queue = SCHED_MQ_OBJECT(vp->execution_streams[0])->queue;
+
+#if defined(PARSEC_PAPI_SDE)
+    if( 0 == es->th_id ) {
+        char event_name[PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN];
+        snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                 "SCHEDULER::PENDING_TASKS::QUEUE=%d::SCHED=MQ", vp->vp_id);
+        parsec_papi_sde_register_fp_counter(event_name, PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                            PAPI_SDE_long_long, (papi_sde_fptr_t)parsec_multiqueue_approx_size,
+                                            sched_obj->queue);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS", PAPI_SDE_SUM);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS::SCHED=MQ", PAPI_SDE_SUM);
+    }
+#endif
+
+    return PARSEC_SUCCESS;
+}
+
+static parsec_task_t*
+sched_mq_select(parsec_execution_stream_t *es,
+                int32_t* distance)
+{
+    sched_mq_object_t *sched_obj = SCHED_MQ_OBJECT(es);
+    parsec_task_t *task;
+
+    task = (parsec_task_t*)parsec_multiqueue_pop(sched_obj->queue, &sched_obj->th);
+    if( NULL != task ) {
+        sched_obj->pops++;
+        *distance = 0;
+    }
+    return task;
+}
+
+/**
+ * @details Each task of the ring goes to its own random heap: pushing
+ *   the whole ring in a single heap would keep the other threads from
+ *   seeing its high priority tasks, and increase the rank error. The
+ *   distance is ignored, all the streams share the same queue.
+ */
+static int sched_mq_schedule(parsec_execution_stream_t* es,
+                             parsec_task_t* new_context,
+                             int32_t distance)
+{
+    sched_mq_object_t *sched_obj = SCHED_MQ_OBJECT(es);
+    parsec_list_item_t *ring = (parsec_list_item_t*)new_context, *item;
+    parsec_multiqueue_thread_t local_th, *th = &sched_obj->th;
+
+    (void)distance;
+    /* Another thread (e.g. the communication thread) must not update the
+     * state of the stream: its failed trylocks are not counted */
+    if( parsec_my_execution_stream() != es ) {
+        local_th.seed = (uint32_t)((uintptr_t)new_context >> 4) | 1;
+        local_th.nb_busy = 0;
+        th = &local_th;
+    } else {
+        sched_obj->pushes++;
+    }
+    while( NULL != ring ) {
+        item = ring;
+        ring = parsec_list_item_ring_chop(item);
+        PARSEC_LIST_ITEM_SINGLETON(item);
+        parsec_multiqueue_push(sched_obj->queue, item, th);
+    }
+    return PARSEC_SUCCESS;
+}
+
+static void sched_mq_display_stats(parsec_execution_stream_t* es)
+{
+    sched_mq_object_t *sched_obj = SCHED_MQ_OBJECT(es);
+    parsec_vp_t *vp = es->virtual_process;
+    long long int nb_busy = 0;
+    int t;
+
+    parsec_inform("MQ scheduler VP: %i Thread: %i (Core %i): %lld schedule calls, %lld tasks selected, %u failed trylocks",
+                  vp->vp_id, es->th_id, es->core_id, sched_obj->pushes, sched_obj->pops, sched_obj->th.nb_busy);
+    if( 0 == es->th_id ) {
+        for( t = 0; t < vp->nb_cores; t++ )
+            nb_busy += SCHED_MQ_OBJECT(vp->execution_streams[t])->th.nb_busy;
+        parsec_inform("MQ scheduler VP: %i: %d heaps, %lld failed trylocks",
+                      vp->vp_id, sched_obj->queue->nb_heaps, nb_busy);
+    }
+}
+
+static void sched_mq_remove( parsec_context_t *master )
+{
+    int p, t;
+    parsec_execution_stream_t *es;
+    parsec_vp_t *vp;
+    sched_mq_object_t *sched_obj;
+
+    for(p = 0; p < master->nb_vp; p++) {
+        vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_mq_module) ) continue;
+        for(t = 0; t < vp->nb_cores; t++) {
+            es = vp->execution_streams[t];
+            if (es != NULL) {
+                sched_obj = SCHED_MQ_OBJECT(es);
+
+                if( es->th_id == 0 ) {
+                    PARSEC_OBJ_RELEASE( sched_obj->queue );
+                }
+                sched_obj->queue = NULL;
+
+                free(es->scheduler_object);
+                es->scheduler_object = NULL;
+            }
+        }
+        PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=%d::SCHED=MQ", p);
+    }
+    PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::SCHED=MQ");
+}
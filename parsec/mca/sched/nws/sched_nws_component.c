@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ * These symbols are in a file by themselves to provide nice linker
+ * semantics.  Since linkers generally pull in symbols by object
+ * files, keeping these symbols as the only symbols in this file
+ * prevents utility programs such as "ompi_info" from having to import
+ * entire components just to query their version and parameters.
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/runtime.h"
+
+#include "parsec/mca/sched/sched.h"
+#include "parsec/mca/sched/nws/sched_nws.h"
+#include "parsec/utils/mca_param.h"
+#include "parsec/papi_sde.h"
+
+/*
+ * Local function
+ */
+static int sched_nws_component_query(mca_base_module_t **module, int *priority);
+static int sched_nws_component_register(void);
+
+int sched_nws_remote_steal_threshold = 4;
+
+/*
+ * Instantiate the public struct with all of our public information
+ * and pointers to our public functions in it
+ */
+const parsec_sched_base_component_t parsec_sched_nws_component = {
+
+    /* First, the mca_component_t struct containing meta information
+       about the component itself */
+
+    {
+        PARSEC_SCHED_BASE_VERSION_2_0_0,
+
+        /* Component name and version */
+        "nws",
+        "", /* options */
+        PARSEC_VERSION_MAJOR,
+        PARSEC_VERSION_MINOR,
+
+        /* Component open and close functions */
+        NULL, /*< No open: sched_nws is always available, no need to check at runtime */
+        NULL, /*< No close: open did not allocate any resource, no need to release them */
+        sched_nws_component_query,
+        /*< specific query to return the module and add it to the list of available modules */
+        sched_nws_component_register,
+        "", /*< no reserve */
+    },
+    {
+        /* The component has no metada */
+        MCA_BASE_METADATA_PARAM_NONE,
+        "", /*< no reserve */
+    }
+};
+
+mca_base_component_t *sched_nws_static_component(void)
+{
+    return (mca_base_component_t *)&parsec_sched_nws_component;
+}
+
+static int sched_nws_component_query(mca_base_module_t **module, int *priority)
+{
+    /* module type should be: const mca_base_module_t ** */
+    void *ptr = (void*)&parsec_sched_nws_module;
+    *priority = 5;
+    *module = (mca_base_module_t *)ptr;
+    return MCA_SUCCESS;
+}
+
+static int sched_nws_component_register(void)
+{
+    parsec_mca_param_reg_int_name("sched_nws", "remote_steal_threshold",
+                                  "Number of consecutive failed attempts to find a task in the NUMA domain "
+                                  "of an execution stream before it starts stealing from other NUMA domains "
+                                  "(0 to steal across NUMA domains as soon as the local domain is empty)",
+                                  false, false,
+                                  sched_nws_remote_steal_threshold, &sched_nws_remote_steal_threshold);
+    if( sched_nws_remote_steal_threshold < 0 )
+        sched_nws_remote_steal_threshold = 0;
+
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::PENDING_TASKS::SCHED=NWS",
+                              "the number of pending tasks for the NWS scheduler");
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=<VPID>/<QID>::SCHED=NWS",
+                              "the number of pending tasks that end up in the virtual process <VPID> queue of queue identifier <QID> for the NWS scheduler");
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::STEALS::LOCAL::SCHED=NWS",
+                              "the number of tasks the NWS scheduler stole from a queue in the NUMA domain of the thief");
+    PARSEC_PAPI_SDE_DESCRIBE_COUNTER("SCHEDULER::STEALS::REMOTE::SCHED=NWS",
+                              "the number of tasks the NWS scheduler stole from a queue in another NUMA domain than the one of the thief");
+    return MCA_SUCCESS;
+}
@@ -0,0 +1,399 @@
+/**
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ */
+
+#include "parsec/parsec_config.h"
+#include "parsec/parsec_internal.h"
+#include "parsec/utils/debug.h"
+#include "parsec/class/dequeue.h"
+
+#include "parsec/mca/sched/sched.h"
+#include "parsec/mca/sched/sched_local_queues_utils.h"
+#include "parsec/mca/sched/nws/sched_nws.h"
+#include "parsec/mca/pins/pins.h"
+#include "parsec/parsec_hwloc.h"
+#include "parsec/papi_sde.h"
+
+/**
+ * @brief Scheduling object of the NUMA-aware work stealing scheduler
+ *
+ * @details Each execution stream owns a bounded buffer (super.task_queue),
+ *   and the streams sharing a NUMA domain share an overflow dequeue
+ *   (super.system_queue). The hierarch_queues array of the super object
+ *   is ordered from the closest to the farthest queue in the hwloc
+ *   topology, with all the queues of the local NUMA domain first. The
+ *   domain_queues array holds the overflow queue of each NUMA domain of
+ *   the virtual process, the local one first and the others by increasing
+ *   distance.
+ */
+typedef struct {
+    parsec_mca_sched_local_queues_scheduler_object_t super;
+    int                 numa_id;             /**< NUMA node of the core this stream is bound to */
+    int                 owns_domain_queue;   /**< This stream allocated super.system_queue */
+    int                 nb_local_queues;     /**< hierarch_queues[0 .. nb_local_queues[ are in our NUMA domain */
+    int                 nb_domain_queues;    /**< number of NUMA domains in the virtual process */
+    parsec_dequeue_t  **domain_queues;       /**< overflow queues, ours first */
+    int                 failed_local_rounds; /**< consecutive selections that failed in our NUMA domain */
+    long long int       local_steals;        /**< tasks taken from a shared queue of our NUMA domain */
+    long long int       remote_steals;       /**< tasks taken from a queue of another NUMA domain */
+} sched_nws_object_t;
+
+#define SCHED_NWS_OBJECT(es) ((sched_nws_object_t*)(es)->scheduler_object)
+
+/**
+ * Module functions
+ */
+static int sched_nws_install(parsec_context_t* master);
+static int sched_nws_schedule(parsec_execution_stream_t* es,
+                              parsec_task_t* new_context,
+                              int32_t distance);
+static parsec_task_t*
+sched_nws_select(parsec_execution_stream_t *es,
+                 int32_t* distance);
+static void sched_nws_display_stats(parsec_execution_stream_t* es);
+static void sched_nws_remove(parsec_context_t* master);
+static int flow_nws_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier);
+
+const parsec_sched_module_t parsec_sched_nws_module = {
+    &parsec_sched_nws_component,
+    {
+        sched_nws_install,
+        flow_nws_init,
+        sched_nws_schedule,
+        sched_nws_select,
+        sched_nws_display_stats,
+        sched_nws_remove,
+        NULL,
+        NULL
+    }
+};
+
+static int sched_nws_install( parsec_context_t *master )
+{
+    (void)master;
+    return PARSEC_SUCCESS;
+}
+
+/**
+ * Returns the NUMA node of the core on which es is bound, falling back
+ * to the socket when hwloc does not expose NUMA nodes, and to a single
+ * domain when no topology information is available.
+ */
+static int sched_nws_numa_id(parsec_execution_stream_t *es)
+{
+    int id = -1;
+#if defined(PARSEC_HAVE_HWLOC)
+    if( es->core_id >= 0 ) {
+        id = parsec_hwloc_numa_id(es->core_id);
+        if( id < 0 )
+            id = parsec_hwloc_socket_id(es->core_id);
+    }
+#else
+    (void)es;
+#endif
+    return (id < 0) ? 0 : id;
+}
+
+/**
+ * Topological distance between two execution streams, as reported by
+ * hwloc. Streams that are not bound, or without hwloc, are considered
+ * at the same distance from each other.
+ */
+static int sched_nws_distance(parsec_execution_stream_t *es1, parsec_execution_stream_t *es2)
+{
+#if defined(PARSEC_HAVE_HWLOC)
+    if( (es1->core_id >= 0) && (es2->core_id >= 0) )
+        return parsec_hwloc_distance(es1->core_id, es2->core_id);
+#else
+    (void)es1; (void)es2;
+#endif
+    return 0;
+}
+
+/* Steal order comparison: streams of our NUMA domain first, then by hwloc
+ * distance, then round-robin starting after the calling stream to spread
+ * the thieves over the victims. */
+static int sched_nws_closer(parsec_execution_stream_t *es, int a, int b)
+{
+    parsec_vp_t *vp = es->virtual_process;
+    parsec_execution_stream_t *ea = vp->execution_streams[a], *eb = vp->execution_streams[b];
+    int la = (SCHED_NWS_OBJECT(ea)->numa_id != SCHED_NWS_OBJECT(es)->numa_id);
+    int lb = (SCHED_NWS_OBJECT(eb)->numa_id != SCHED_NWS_OBJECT(es)->numa_id);
+    if( la != lb ) return la < lb;
+    int da = sched_nws_distance(es, ea), db = sched_nws_distance(es, eb);
+    if( da != db ) return da < db;
+    return ((a - es->th_id + vp->nb_cores) % vp->nb_cores) <
+           ((b - es->th_id + vp->nb_cores) % vp->nb_cores);
+}
+
+static int flow_nws_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier)
+{
+    sched_nws_object_t *sched_obj = NULL;
+    parsec_vp_t* vp = es->virtual_process;
+    int *order, i, j, t, nq;
+    uint32_t queue_size;
+
+    /* Every flow creates its own local object */
+    sched_obj = (sched_nws_object_t*)calloc(1, sizeof(sched_nws_object_t));
+    es->scheduler_object = sched_obj;
+    sched_obj->numa_id = sched_nws_numa_id(es);
+
+    /* All scheduling objects must exist before we can look at the numa_id of the others */
+    parsec_barrier_wait(barrier);
+
+    /* The first stream of each NUMA domain allocates the overflow queue of that domain */
+    for( t = 0; t < es->th_id; t++ )
+        if( SCHED_NWS_OBJECT(vp->execution_streams[t])->numa_id == sched_obj->numa_id )
+            break;
+    if( t == es->th_id ) {
+        sched_obj->super.system_queue = PARSEC_OBJ_NEW(parsec_dequeue_t);
+        sched_obj->owns_domain_queue = 1;
+    }
+
+    sched_obj->super.nb_hierarch_queues = vp->nb_cores;
+    sched_obj->super.hierarch_queues = (parsec_hbbuffer_t **)malloc(vp->nb_cores * sizeof(parsec_hbbuffer_t*));
+    sched_obj->domain_queues = (parsec_dequeue_t **)malloc(vp->nb_cores * sizeof(parsec_dequeue_t*));
+    queue_size = vp->nb_cores * 4;
+
+    parsec_barrier_wait(barrier);
+
+    /* Get the overflow queue of our NUMA domain, and store it locally */
+    for( t = 0; !SCHED_NWS_OBJECT(vp->execution_streams[t])->owns_domain_queue ||
+                SCHED_NWS_OBJECT(vp->execution_streams[t])->numa_id != sched_obj->numa_id; t++ );
+    sched_obj->super.system_queue = SCHED_NWS_OBJECT(vp->execution_streams[t])->super.system_queue;
+
+    /* Each thread creates its own "local" queue, connected to the domain dequeue */
+    sched_obj->super.task_queue = parsec_hbbuffer_new( queue_size, 1, parsec_mca_sched_push_in_system_queue_wrapper,
+                                                       (void*)sched_obj );
+    sched_obj->super.task_queue->assoc_core_num = es->core_id;
+    sched_obj->super.hierarch_queues[0] = sched_obj->super.task_queue;
+
+    /* All local allocations are now completed. Synchronize with the other
+     threads before setting up the entire queues hierarchy. */
+    parsec_barrier_wait(barrier);
+
+    /* Sort the other streams from the closest to the farthest (insertion sort,
+     * there are only a few tens of them and this is done once) */
+    order = (int*)malloc(vp->nb_cores * sizeof(int));
+    for( nq = 0, t = 0; t < vp->nb_cores; t++ ) {
+        if( t == es->th_id ) continue;
+        for( j = nq; j > 0 && sched_nws_closer(es, t, order[j-1]); j-- )
+            order[j] = order[j-1];
+        order[j] = t;
+        nq++;
+    }
+    sched_obj->nb_local_queues = 1;
+    for( i = 0; i < nq; i++ ) {
+        parsec_execution_stream_t *victim = vp->execution_streams[order[i]];
+        sched_obj->super.hierarch_queues[i+1] = SCHED_NWS_OBJECT(victim)->super.task_queue;
+        if( SCHED_NWS_OBJECT(victim)->numa_id == sched_obj->numa_id )
+            sched_obj->nb_local_queues++;
+        PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "NWS %d of %d: my %d preferred queue is the task queue of %d (%p, %s NUMA domain)",
+                             es->th_id, vp->vp_id, i+1, order[i], sched_obj->super.hierarch_queues[i+1],
+                             SCHED_NWS_OBJECT(victim)->numa_id == sched_obj->numa_id ? "same" : "remote");
+    }
+
+    /* The overflow queues follow the same order, starting with ours */
+    sched_obj->domain_queues[0] = sched_obj->super.system_queue;
+    sched_obj->nb_domain_queues = 1;
+    for( i = 0; i < nq; i++ ) {
+        sched_nws_object_t *victim = SCHED_NWS_OBJECT(vp->execution_streams[order[i]]);
+        if( victim->owns_domain_queue && victim->super.system_queue != sched_obj->super.system_queue )
+            sched_obj->domain_queues[sched_obj->nb_domain_queues++] = victim->super.system_queue;
+    }
+    free(order);
+
+#if defined(PARSEC_PAPI_SDE)
+    {
+        char event_name[PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN];
+        if( 0 == es->th_id ) {
+            snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                     "SCHEDULER::PENDING_TASKS::QUEUE=%d/overflow::SCHED=NWS", vp->vp_id);
+            parsec_papi_sde_register_fp_counter(event_name, PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                                PAPI_SDE_int, (papi_sde_fptr_t)parsec_mca_sched_system_queue_length, vp);
+            parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS", PAPI_SDE_SUM);
+            parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS::SCHED=NWS", PAPI_SDE_SUM);
+        }
+        snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                 "SCHEDULER::PENDING_TASKS::QUEUE=%d/%d::SCHED=NWS", vp->vp_id, es->th_id);
+        parsec_papi_sde_register_fp_counter(event_name, PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                            PAPI_SDE_int, (papi_sde_fptr_t)parsec_hbbuffer_approx_occupency,
+                                            sched_obj->super.task_queue);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS", PAPI_SDE_SUM);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::PENDING_TASKS::SCHED=NWS", PAPI_SDE_SUM);
+
+        snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                 "SCHEDULER::STEALS::LOCAL::QUEUE=%d/%d::SCHED=NWS", vp->vp_id, es->th_id);
+        parsec_papi_sde_register_counter(event_name, PAPI_SDE_RO|PAPI_SDE_DELTA,
+                                         PAPI_SDE_long_long, &sched_obj->local_steals);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::STEALS::LOCAL::SCHED=NWS", PAPI_SDE_SUM);
+        snprintf(event_name, PARSEC_PAPI_SDE_MAX_COUNTER_NAME_LEN,
+                 "SCHEDULER::STEALS::REMOTE::QUEUE=%d/%d::SCHED=NWS", vp->vp_id, es->th_id);
+        parsec_papi_sde_register_counter(event_name, PAPI_SDE_RO|PAPI_SDE_DELTA,
+                                         PAPI_SDE_long_long, &sched_obj->remote_steals);
+        parsec_papi_sde_add_counter_to_group(event_name, "SCHEDULER::STEALS::REMOTE::SCHED=NWS", PAPI_SDE_SUM);
+    }
+#endif
+
+    return PARSEC_SUCCESS;
+}
+
+static inline parsec_task_t*
+sched_nws_pop_domain_queue(sched_nws_object_t *sched_obj, int d)
+{
+    parsec_task_t *task = (parsec_task_t*)parsec_dequeue_try_pop_front(sched_obj->domain_queues[d]);
+#if defined(PARSEC_PAPI_SDE)
+    if( NULL != task )
+        sched_obj->super.local_system_queue_balance--;
+#endif
+    return task;
+}
+
+/**
+ * @brief
+ *   Selects a task to run
+ *
+ * @details
+ *   Look in the local bounded buffer, then in the buffers of the other
+ *   streams of the same NUMA domain from the closest to the farthest, and
+ *   in the overflow queue of the domain. Only after sched_nws_remote_steal_threshold
+ *   consecutive failures to find a task in the local NUMA domain, the other
+ *   domains (bounded buffers then overflow queues) are considered.
+ */
+static parsec_task_t*
+sched_nws_select(parsec_execution_stream_t *es,
+                 int32_t* distance)
+{
+    sched_nws_object_t *sched_obj = SCHED_NWS_OBJECT(es);
+    parsec_task_t *task = NULL;
+    int i, d;
+
+    task = (parsec_task_t*)parsec_hbbuffer_pop_best(sched_obj->super.task_queue,
+                                                    parsec_execution_context_priority_comparator);
+    if( NULL != task ) {
+        sched_obj->failed_local_rounds = 0;
+        *distance = 0;
+        return task;
+    }
+    for( i = 1; i < sched_obj->nb_local_queues; i++ ) {
+        task = (parsec_task_t*)parsec_hbbuffer_pop_best(sched_obj->super.hierarch_queues[i],
+                                                        parsec_execution_context_priority_comparator);
+        if( NULL != task ) {
+            PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "NWS\t: %d:%d found task %p in its %d-preferred (local) queue %p",
+                                 es->virtual_process->vp_id, es->th_id, task, i, sched_obj->super.hierarch_queues[i]);
+            sched_obj->failed_local_rounds = 0;
+            sched_obj->local_steals++;
+            *distance = i;
+            return task;
+        }
+    }
+    task = sched_nws_pop_domain_queue(sched_obj, 0);
+    if( NULL != task ) {
+        PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "NWS\t: %d:%d found task %p in its NUMA domain queue %p",
+                             es->virtual_process->vp_id, es->th_id, task, sched_obj->domain_queues[0]);
+        sched_obj->failed_local_rounds = 0;
+        sched_obj->local_steals++;
+        *distance = sched_obj->nb_local_queues;
+        return task;
+    }
+
+    /* Nothing in our NUMA domain. Do not drag data across the NUMA boundary
+     * until the local domain has been found empty several times in a row. */
+    if( sched_obj->nb_local_queues == sched_obj->super.nb_hierarch_queues )
+        return NULL;
+    if( sched_obj->failed_local_rounds < sched_nws_remote_steal_threshold ) {
+        sched_obj->failed_local_rounds++;
+        return NULL;
+    }
+
+    for( i = sched_obj->nb_local_queues; i < sched_obj->super.nb_hierarch_queues; i++ ) {
+        task = (parsec_task_t*)parsec_hbbuffer_pop_best(sched_obj->super.hierarch_queues[i],
+                                                        parsec_execution_context_priority_comparator);
+        if( NULL != task ) {
+            PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "NWS\t: %d:%d found task %p in its %d-preferred (remote) queue %p",
+                                 es->virtual_process->vp_id, es->th_id, task, i, sched_obj->super.hierarch_queues[i]);
+            sched_obj->remote_steals++;
+            *distance = i + 1;
+            return task;
+        }
+    }
+    for( d = 1; d < sched_obj->nb_domain_queues; d++ ) {
+        task = sched_nws_pop_domain_queue(sched_obj, d);
+        if( NULL != task ) {
+            PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "NWS\t: %d:%d found task %p in the remote NUMA domain queue %p",
+                                 es->virtual_process->vp_id, es->th_id, task, sched_obj->domain_queues[d]);
+            sched_obj->remote_steals++;
+            *distance = sched_obj->super.nb_hierarch_queues + d;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static int sched_nws_schedule(parsec_execution_stream_t* es,
+                              parsec_task_t* new_context,
+                              int32_t distance)
+{
+    parsec_hbbuffer_push_all(SCHED_NWS_OBJECT(es)->super.task_queue,
+                             (parsec_list_item_t*)new_context,
+                             distance);
+    return PARSEC_SUCCESS;
+}
+
+static void sched_nws_display_stats(parsec_execution_stream_t* es)
+{
+    sched_nws_object_t *sched_obj = SCHED_NWS_OBJECT(es);
+    parsec_inform("NWS scheduler VP: %i Thread: %i (Core %i, NUMA %i): %lld local steals, %lld remote steals",
+                  es->virtual_process->vp_id, es->th_id, es->core_id, sched_obj->numa_id,
+                  sched_obj->local_steals, sched_obj->remote_steals);
+}
+
+static void sched_nws_remove( parsec_context_t *master )
+{
+    int p, t;
+    parsec_execution_stream_t *es;
+    parsec_vp_t *vp;
+    sched_nws_object_t *sched_obj;
+
+    for(p = 0; p < master->nb_vp; p++) {
+        vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_nws_module) ) continue;
+        for(t = 0; t < vp->nb_cores; t++) {
+            es = vp->execution_streams[t];
+            if (es != NULL) {
+                sched_obj = SCHED_NWS_OBJECT(es);
+
+                if( sched_obj->owns_domain_queue ) {
+                    PARSEC_OBJ_RELEASE( sched_obj->super.system_queue );
+                }
+                sched_obj->super.system_queue = NULL;
+
+                parsec_hbbuffer_destruct( sched_obj->super.task_queue );
+                sched_obj->super.task_queue = NULL;
+
+                free(sched_obj->super.hierarch_queues);
+                sched_obj->super.hierarch_queues = NULL;
+                free(sched_obj->domain_queues);
+                sched_obj->domain_queues = NULL;
+
+                free(es->scheduler_object);
+                es->scheduler_object = NULL;
+            }
+            PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=%d/%d::SCHED=NWS", vp->vp_id, t);
+            PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::STEALS::LOCAL::QUEUE=%d/%d::SCHED=NWS", vp->vp_id, t);
+            PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::STEALS::REMOTE::QUEUE=%d/%d::SCHED=NWS", vp->vp_id, t);
+        }
+        PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::QUEUE=%d/overflow::SCHED=NWS", p);
+    }
+    PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::PENDING_TASKS::SCHED=NWS");
+    PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::STEALS::LOCAL::SCHED=NWS");
+    PARSEC_PAPI_SDE_UNREGISTER_COUNTER("SCHEDULER::STEALS::REMOTE::SCHED=NWS");
+}
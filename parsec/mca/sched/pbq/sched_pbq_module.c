@@ -30,6 +30,10 @@ static int sched_pbq_install(parsec_context_t* master);
 static int sched_pbq_schedule(parsec_execution_stream_t* es,
                               parsec_task_t* new_context,
                               int32_t distance);
+static int sched_pbq_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance);
 static parsec_task_t *sched_pbq_select(parsec_execution_stream_t *es,
                                                     int32_t* distance);
 static int flow_pbq_init(parsec_execution_stream_t* es, struct parsec_barrier_t* barrier);
@@ -43,7 +47,9 @@ const parsec_sched_module_t parsec_sched_pbq_module = {
         sched_pbq_schedule,
         sched_pbq_select,
         NULL,
-        sched_pbq_remove
+        sched_pbq_remove,
+        sched_pbq_schedule_bulk,
+        NULL
     }
 };
 
@@ -196,6 +202,17 @@ static int sched_pbq_schedule(parsec_execution_stream_t* es,
     return PARSEC_SUCCESS;
 }
 
+static int sched_pbq_schedule_bulk(parsec_execution_stream_t* es,
+                                   parsec_task_t* new_context,
+                                   int32_t nb_tasks,
+                                   int32_t distance)
+{
+    parsec_hbbuffer_push_all_by_priority_bulk( PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es)->task_queue,
+                                               (parsec_list_item_t*)new_context,
+                                               nb_tasks, distance);
+    return PARSEC_SUCCESS;
+}
+
 static void sched_pbq_remove( parsec_context_t *master )
 {
     int p, t;
@@ -205,6 +222,7 @@ static void sched_pbq_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_pbq_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             sched_obj = PARSEC_MCA_SCHED_LOCAL_QUEUES_OBJECT(es);
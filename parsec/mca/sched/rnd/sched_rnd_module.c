@@ -40,7 +40,9 @@ const parsec_sched_module_t parsec_sched_rnd_module = {
         sched_rnd_schedule,
         sched_rnd_select,
         NULL,
-        sched_rnd_remove
+        sched_rnd_remove,
+        NULL,
+        NULL
     }
 };
 
@@ -133,6 +135,7 @@ static void sched_rnd_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_rnd_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             es = vp->execution_streams[t];
             sl = LOCAL_SCHED_OBJECT(es);
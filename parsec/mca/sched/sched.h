@@ -53,7 +53,25 @@
  * pointer that is available for this use in each parsec_execution_unit_t.
  * To help with the synchronization and sharing of structures, a
  * parsec_barrier_t is passed to the flow_init function, and all
- * execution streams call the flow_init function together.
+ * execution streams of a virtual process call the flow_init function
+ * together.
+ *
+ * @section SchedPerVP Schedulers of the Virtual Processes
+ *
+ * Each virtual process may use a different scheduler (see the
+ * runtime_vp_sched MCA parameter), pointed to by vp->scheduler. The
+ * install and remove functions of each scheduler in use are called once
+ * on the whole parsec_context_t, but flow_init, schedule and select are
+ * only called on the execution streams of the virtual processes that use
+ * the scheduler. The remove function must thus only release the objects of
+ * these virtual processes (see PARSEC_SCHED_VP_USES), and a scheduler
+ * cannot share any structure between virtual processes.
+ *
+ * Tasks released for another virtual process are handed off to the
+ * scheduler of that virtual process, as a whole ring, on one of its
+ * execution streams (chosen round-robin), with the distance given by the
+ * runtime. The schedule function may then be called by a thread that does
+ * not belong to the virtual process of the target execution stream.
  *
  * @section SchedFairness Fairness and Distance
  *
@@ -219,14 +237,14 @@ typedef int  (*parsec_sched_base_module_install_fn_t)(parsec_context_t* master);
  * based on the locality information available in the parsec_context_t.
  * eu_context->scheduler_object is a pointer to an opaque structure that
  * the scheduler can define and use to store scheduling information.
- * The barrier provided is global for all execution streams in the
- * parsec_context_t to which eu_context belongs, and may be used to force
+ * The barrier provided is common to all execution streams of the virtual
+ * process to which eu_context belongs, and may be used to force
  * synchronizations and setup structures sharing between the different
- * execution streams.
+ * execution streams of this virtual process.
  * @param[inout] eu_context the execution unit that is calling the flow_init
  *               function
  * @param[inout] barrier a barrier common to all execution units in the same
- *               parsec_context_t
+ *               virtual process
  * @return PARSEC_SUCCESS if the scheduler can be used; an error code otherwise
  */
 typedef int  (*parsec_sched_base_module_flow_init_fn_t)(parsec_execution_stream_t* es,
@@ -266,6 +284,35 @@ typedef int  (*parsec_sched_base_module_schedule_fn_t)
                  (parsec_execution_stream_t* es,
                   parsec_task_t* new_context,
                   int32_t distance);
+/**
+ * @brief Bulk Scheduling function
+ *
+ * @details
+ * Same as the scheduling function, but the caller guarantees that the ring of
+ * tasks is sorted by decreasing priority, and provides the number of tasks
+ * in the ring. This allows a scheduler to publish the whole set of tasks
+ * at once, with a constant number of atomic operations, instead of
+ * inserting them one by one. This is the path taken by the tasks released
+ * by the completion of another task (see __parsec_schedule_vp), where large
+ * sets of successors are common.
+ *
+ * This function is optional: when it is NULL, the scheduling function is
+ * used instead.
+ *
+ * @param[inout] eu_context the current execution stream
+ * @param[inout] new_context a double-linked ring of ready tasks, sorted by
+ *               decreasing priority
+ * @param[in]    nb_tasks the number of tasks in new_context
+ * @param[in]    distance a (mandatory) hint for the scheduler that enables
+ *               fairness (see parsec_sched_base_module_schedule_fn_t)
+ * @return PARSEC_SUCCESS on success; an error code in case of error (which is fatal).
+ */
+typedef int  (*parsec_sched_base_module_schedule_bulk_fn_t)
+                 (parsec_execution_stream_t* es,
+                  parsec_task_t* new_context,
+                  int32_t nb_tasks,
+                  int32_t distance);
+
 /**
  * @brief Selecting Function
  *
@@ -292,12 +339,36 @@ typedef parsec_task_t *(*parsec_sched_base_module_select_fn_t)
  * @details
  *   Prints some scheduler-specific runtime statistics on stdout.
  *
- *   This function is called for each execution stream.
+ *   This function is called for each execution stream, at the end of
+ *   each parsec_context_wait when per thread resource usage reports
+ *   are requested (profile_rusage >= 2). It may be NULL.
  *
  *  @param[in] eu_context the calling execution stream
  */
 typedef void (*parsec_sched_base_module_stats_fn_t)(parsec_execution_stream_t* es);
 
+/**
+ * @brief Execution notification.
+ *
+ * @details
+ *   Called by the execution stream that ran the body of a task, when the
+ *   body returned PARSEC_HOOK_RETURN_DONE and before the completion of the
+ *   task (its successors are not released yet), with the time the body
+ *   took. This is the case of every task, whether it came from the select
+ *   function or was chained by the execution stream as its next task. The
+ *   tasks that complete asynchronously are not notified.
+ *
+ *   This function is optional: when it is NULL, the execution of the tasks
+ *   is not timed.
+ *
+ * @param[in] es the execution stream that ran the task
+ * @param[in] task the task, not completed yet
+ * @param[in] duration the execution time of the body of the task, in TIMER_UNIT
+ */
+typedef void (*parsec_sched_base_module_executed_fn_t)(parsec_execution_stream_t* es,
+                                                       const parsec_task_t* task,
+                                                       uint64_t duration);
+
 /**
  * @brief Finalization.
  *
@@ -318,7 +389,8 @@ typedef void (*parsec_sched_base_module_stats_fn_t)(parsec_execution_stream_t* e
  * @endcode
  * points to an opaque structure, that is scheduler-specific, and that should
  * be released by this function if the installation / flow_init functions set
- * them.
+ * them. Only the virtual processes that use this scheduler must be
+ * considered (see PARSEC_SCHED_VP_USES).
  */
 typedef void (*parsec_sched_base_module_remove_fn_t)(parsec_context_t* master);
 
@@ -329,6 +401,8 @@ struct parsec_sched_base_module_1_0_0_t {
     parsec_sched_base_module_select_fn_t       select;
     parsec_sched_base_module_stats_fn_t        display_stats;
     parsec_sched_base_module_remove_fn_t       remove;
+    parsec_sched_base_module_schedule_bulk_fn_t schedule_bulk;
+    parsec_sched_base_module_executed_fn_t     executed;
 };
 
 typedef struct parsec_sched_base_module_1_0_0_t parsec_sched_base_module_1_0_0_t;
@@ -339,6 +413,12 @@ typedef struct parsec_sched_module_s {
     parsec_sched_base_module_t           module;
 } parsec_sched_module_t;
 
+/**
+ * True if the virtual process vp uses the scheduler module
+ */
+#define PARSEC_SCHED_VP_USES(vp, module) \
+    ((const parsec_sched_module_t*)(vp)->scheduler == &(module))
+
 /**
  * Macro for use in components that are of type sched
  */
@@ -91,7 +91,9 @@ const parsec_sched_module_t parsec_sched_spq_module = {
         sched_spq_schedule,
         sched_spq_select,
         NULL,
-        sched_spq_remove
+        sched_spq_remove,
+        NULL,
+        NULL
     }
 };
 
@@ -206,6 +208,7 @@ static void sched_spq_remove( parsec_context_t *master )
 
     for(p = 0; p < master->nb_vp; p++) {
         vp = master->virtual_processes[p];
+        if( !PARSEC_SCHED_VP_USES(vp, parsec_sched_spq_module) ) continue;
         for(t = 0; t < vp->nb_cores; t++) {
             eu = vp->execution_streams[t];
             if( eu->th_id == 0 ) {
@@ -6,10 +6,55 @@
 
 #include "parsec/runtime.h"
 #include "mempool.h"
+#include "parsec/sys/tls.h"
+#include "parsec/utils/mem_footprint.h"
+#include <stdlib.h>
 #ifdef PARSEC_HAVE_STRING_H
 #include <string.h>
 #endif
 
+/**
+ * In slab mode, the elements are carved, when first allocated, from
+ * slabs of slab_size bytes aligned on slab_size, so that the slab of an
+ * element is found by masking its address. A slab has a free list that
+ * only its owner uses; the slabs that have free (or not yet carved)
+ * elements are chained in the avail list of their thread mempool.
+ */
+typedef struct parsec_mempool_slab_s {
+    struct parsec_mempool_slab_s *prev;       /**< In the list of all the slabs of the thread mempool */
+    struct parsec_mempool_slab_s *next;
+    struct parsec_mempool_slab_s *avail_prev; /**< In the avail list of the thread mempool */
+    struct parsec_mempool_slab_s *avail_next;
+    parsec_list_item_t           *free;       /**< Elements freed in this slab */
+    uint32_t                      nb_used;    /**< Elements allocated, including those not yet returned by other threads */
+    uint32_t                      nb_carved;  /**< Elements carved from the slab so far */
+} parsec_mempool_slab_t;
+
+/** Elements freed by a thread for the owner of another thread mempool */
+typedef struct parsec_mempool_batch_s {
+    parsec_list_item_t *first;
+    parsec_list_item_t *last;
+    uint32_t            nb;
+} parsec_mempool_batch_t;
+
+#define PARSEC_MEMPOOL_SLAB_MIN_SIZE  (64*1024)
+#define PARSEC_MEMPOOL_SLAB_MIN_ELT   32
+#define PARSEC_MEMPOOL_SLAB_BATCH     32
+/** owner_thread of a thread mempool in slab mode that no thread has bound yet */
+#define PARSEC_MEMPOOL_UNBOUND        ((uintptr_t)-1)
+
+#define PARSEC_MEMPOOL_FOOTPRINT(mempool, bytes) do {                     \
+        if( (mempool)->footprint >= 0 )                                   \
+            PARSEC_MEM_FOOTPRINT_ADD((mempool)->footprint, (bytes));      \
+    } while(0)
+
+/** Identifier of the calling thread, 0 if it did not bind any thread mempool */
+static PARSEC_TLS_DECLARE(parsec_mempool_tls_thread);
+/** Index (plus one) of the thread mempools bound by the calling thread */
+static PARSEC_TLS_DECLARE(parsec_mempool_tls_index);
+static volatile int32_t parsec_mempool_tls_ready = 0;
+static int32_t parsec_mempool_nb_bound_threads = 0;
+
 /** parsec_thread_mempool_construct
  *    constructs the thread-specific memory pool.
  */
@@ -23,8 +68,18 @@ static void parsec_thread_mempool_construct( parsec_thread_mempool_t *thread_mem
 
 static void parsec_thread_mempool_destruct( parsec_thread_mempool_t *thread_mempool )
 {
+    parsec_mempool_slab_t *slab;
     void *elt;
+
+    while(NULL != (slab = thread_mempool->slabs)) {
+        thread_mempool->slabs = slab->next;
+        PARSEC_MEMPOOL_FOOTPRINT(thread_mempool->parent, -(int64_t)thread_mempool->parent->slab_size);
+        free(slab);
+    }
+    free(thread_mempool->batches);
+    thread_mempool->batches = NULL;
     while(NULL != (elt = parsec_lifo_pop(&thread_mempool->mempool))) {
+        PARSEC_MEMPOOL_FOOTPRINT(thread_mempool->parent, -(int64_t)thread_mempool->parent->elt_size);
         if(NULL != thread_mempool->parent->obj_class) {
             parsec_lifo_item_free(elt);
         } else {
@@ -51,6 +106,288 @@ void parsec_mempool_construct( parsec_mempool_t *mempool,
 
     for(tid = 0; tid < mempool->nb_thread_mempools; tid++)
         parsec_thread_mempool_construct(&mempool->thread_mempools[tid], mempool);
+
+    mempool->slab_size = 0;
+    mempool->shared = NULL;
+    mempool->footprint = -1;
+}
+
+void parsec_mempool_set_footprint( parsec_mempool_t *mempool, int subsystem )
+{
+    mempool->footprint = subsystem;
+}
+
+void parsec_mempool_slab_enable( parsec_mempool_t *mempool, unsigned int max_idle_slabs )
+{
+    size_t align = PARSEC_LIFO_ALIGNMENT(&mempool->thread_mempools[0].mempool);
+    uint32_t tid;
+
+    /* The keys must exist before any thread looks at its identifier */
+    if( parsec_atomic_cas_int32(&parsec_mempool_tls_ready, 0, 1) ) {
+        PARSEC_TLS_KEY_CREATE(parsec_mempool_tls_thread);
+        PARSEC_TLS_KEY_CREATE(parsec_mempool_tls_index);
+        parsec_atomic_wmb();
+        parsec_mempool_tls_ready = 2;
+    }
+    while( 2 != parsec_mempool_tls_ready ) ;
+
+    /* Keep the elements aligned as if they were allocated for the LIFO */
+    mempool->slab_stride = (mempool->elt_size + align - 1) & ~(align - 1);
+    mempool->slab_header = (sizeof(parsec_mempool_slab_t) + align - 1) & ~(align - 1);
+    mempool->slab_size = PARSEC_MEMPOOL_SLAB_MIN_SIZE;
+    while( mempool->slab_size < mempool->slab_header + PARSEC_MEMPOOL_SLAB_MIN_ELT * mempool->slab_stride )
+        mempool->slab_size <<= 1;
+    mempool->slab_capacity = (mempool->slab_size - mempool->slab_header) / mempool->slab_stride;
+    mempool->slab_max_idle = max_idle_slabs;
+
+    mempool->shared = (parsec_thread_mempool_t*)calloc(1, sizeof(parsec_thread_mempool_t));
+    parsec_thread_mempool_construct(mempool->shared, mempool);
+    for(tid = 0; tid < mempool->nb_thread_mempools; tid++)
+        mempool->thread_mempools[tid].owner_thread = PARSEC_MEMPOOL_UNBOUND;
+}
+
+void parsec_thread_mempool_bind( parsec_thread_mempool_t *thread_mempool )
+{
+    parsec_mempool_t *mempool = thread_mempool->parent;
+    uintptr_t me;
+
+    if( 0 == thread_mempool->owner_thread )
+        return;
+    me = (uintptr_t)PARSEC_TLS_GET_SPECIFIC(parsec_mempool_tls_thread);
+    if( 0 == me ) {
+        me = (uintptr_t)parsec_atomic_fetch_inc_int32(&parsec_mempool_nb_bound_threads) + 1;
+        PARSEC_TLS_SET_SPECIFIC(parsec_mempool_tls_thread, (void*)me);
+    }
+    PARSEC_TLS_SET_SPECIFIC(parsec_mempool_tls_index,
+                            (void*)(uintptr_t)(thread_mempool - mempool->thread_mempools + 1));
+    if( NULL == thread_mempool->batches )
+        thread_mempool->batches = (parsec_mempool_batch_t*)calloc(mempool->nb_thread_mempools,
+                                                                   sizeof(parsec_mempool_batch_t));
+    parsec_atomic_wmb();
+    thread_mempool->owner_thread = me;
+}
+
+/* The thread mempool of this mempool owned by the calling thread, NULL if none */
+static inline parsec_thread_mempool_t *parsec_mempool_bound( parsec_mempool_t *mempool, uintptr_t me )
+{
+    uintptr_t index;
+
+    if( 0 == me )
+        return NULL;
+    index = (uintptr_t)PARSEC_TLS_GET_SPECIFIC(parsec_mempool_tls_index);
+    if( (0 == index) || (index > mempool->nb_thread_mempools) )
+        return NULL;
+    if( me != mempool->thread_mempools[index-1].owner_thread )
+        return NULL;
+    return &mempool->thread_mempools[index-1];
+}
+
+static inline parsec_mempool_slab_t *parsec_mempool_slab_of( parsec_mempool_t *mempool, void *elt )
+{
+    return (parsec_mempool_slab_t*)((uintptr_t)elt & ~(uintptr_t)(mempool->slab_size - 1));
+}
+
+static inline void parsec_mempool_avail_push( parsec_thread_mempool_t *thread_mempool, parsec_mempool_slab_t *slab )
+{
+    slab->avail_prev = NULL;
+    slab->avail_next = thread_mempool->avail;
+    if( NULL != thread_mempool->avail )
+        thread_mempool->avail->avail_prev = slab;
+    thread_mempool->avail = slab;
+}
+
+static inline void parsec_mempool_avail_remove( parsec_thread_mempool_t *thread_mempool, parsec_mempool_slab_t *slab )
+{
+    if( NULL != slab->avail_prev )
+        slab->avail_prev->avail_next = slab->avail_next;
+    else
+        thread_mempool->avail = slab->avail_next;
+    if( NULL != slab->avail_next )
+        slab->avail_next->avail_prev = slab->avail_prev;
+}
+
+static parsec_mempool_slab_t *parsec_mempool_slab_new( parsec_thread_mempool_t *thread_mempool )
+{
+    parsec_mempool_slab_t *slab;
+    void *mem;
+
+    if( 0 != posix_memalign(&mem, thread_mempool->parent->slab_size, thread_mempool->parent->slab_size) )
+        return NULL;
+    PARSEC_MEMPOOL_FOOTPRINT(thread_mempool->parent, thread_mempool->parent->slab_size);
+    slab = (parsec_mempool_slab_t*)mem;
+    slab->free = NULL;
+    slab->nb_used = 0;
+    slab->nb_carved = 0;
+    slab->prev = NULL;
+    slab->next = thread_mempool->slabs;
+    if( NULL != thread_mempool->slabs )
+        thread_mempool->slabs->prev = slab;
+    thread_mempool->slabs = slab;
+    parsec_mempool_avail_push(thread_mempool, slab);
+    thread_mempool->nb_slabs++;
+    thread_mempool->nb_idle_slabs++;
+    return slab;
+}
+
+static void parsec_mempool_slab_release( parsec_thread_mempool_t *thread_mempool, parsec_mempool_slab_t *slab )
+{
+    parsec_mempool_avail_remove(thread_mempool, slab);
+    if( NULL != slab->prev )
+        slab->prev->next = slab->next;
+    else
+        thread_mempool->slabs = slab->next;
+    if( NULL != slab->next )
+        slab->next->prev = slab->prev;
+    thread_mempool->nb_slabs--;
+    thread_mempool->nb_elt -= slab->nb_carved;
+    thread_mempool->nb_released_slabs++;
+    PARSEC_MEMPOOL_FOOTPRINT(thread_mempool->parent, -(int64_t)thread_mempool->parent->slab_size);
+    free(slab);
+}
+
+/* Put back an element in its slab. Called by the owner only. */
+static inline void parsec_mempool_slab_put( parsec_thread_mempool_t *thread_mempool, parsec_list_item_t *elt )
+{
+    parsec_mempool_t *mempool = thread_mempool->parent;
+    parsec_mempool_slab_t *slab = parsec_mempool_slab_of(mempool, elt);
+
+    elt->list_next = slab->free;
+    slab->free = elt;
+    if( slab->nb_used-- == mempool->slab_capacity )
+        parsec_mempool_avail_push(thread_mempool, slab);
+    if( 0 != slab->nb_used )
+        return;
+    /* The slab is idle: keep it for the next allocations, unless there
+     * are already enough idle slabs. The last avail slab is always kept. */
+    if( (thread_mempool->nb_idle_slabs >= mempool->slab_max_idle) &&
+        ((thread_mempool->avail != slab) || (NULL != slab->avail_next)) ) {
+        parsec_mempool_slab_release(thread_mempool, slab);
+    } else {
+        thread_mempool->nb_idle_slabs++;
+    }
+}
+
+/* Take back all the elements returned by the other threads. Called by the owner only. */
+static void parsec_mempool_reclaim( parsec_thread_mempool_t *thread_mempool )
+{
+    parsec_list_item_t *items, *next;
+
+    do {
+        items = thread_mempool->returned;
+        if( NULL == items )
+            return;
+    } while( !parsec_atomic_cas_ptr(&thread_mempool->returned, items, NULL) );
+
+    for( ; NULL != items; items = next ) {
+        next = (parsec_list_item_t*)items->list_next;
+        parsec_mempool_slab_put(thread_mempool, items);
+    }
+}
+
+/* Push the chain of elements first..last to the returned elements of their owner */
+static inline void parsec_mempool_return( parsec_thread_mempool_t *owner,
+                                          parsec_list_item_t *first, parsec_list_item_t *last )
+{
+    parsec_list_item_t *head;
+
+    do {
+        head = owner->returned;
+        last->list_next = head;
+    } while( !parsec_atomic_cas_ptr(&owner->returned, head, first) );
+}
+
+static inline void parsec_mempool_batch_flush( parsec_thread_mempool_t *thread_mempool,
+                                               parsec_thread_mempool_t *owner,
+                                               parsec_mempool_batch_t *batch )
+{
+    parsec_mempool_return(owner, batch->first, batch->last);
+    batch->first = batch->last = NULL;
+    batch->nb = 0;
+    thread_mempool->nb_returned_batches++;
+}
+
+void parsec_thread_mempool_flush( parsec_thread_mempool_t *thread_mempool )
+{
+    parsec_mempool_t *mempool = thread_mempool->parent;
+    uint32_t tid;
+
+    if( (0 == thread_mempool->owner_thread) || (NULL == thread_mempool->batches) )
+        return;
+    assert( thread_mempool->owner_thread == (uintptr_t)PARSEC_TLS_GET_SPECIFIC(parsec_mempool_tls_thread) );
+    for(tid = 0; tid < mempool->nb_thread_mempools; tid++) {
+        if( 0 != thread_mempool->batches[tid].nb )
+            parsec_mempool_batch_flush(thread_mempool, &mempool->thread_mempools[tid],
+                                       &thread_mempool->batches[tid]);
+    }
+}
+
+void *parsec_thread_mempool_slab_allocate( parsec_thread_mempool_t *thread_mempool )
+{
+    parsec_mempool_t *mempool = thread_mempool->parent;
+    uintptr_t me = (uintptr_t)PARSEC_TLS_GET_SPECIFIC(parsec_mempool_tls_thread);
+    parsec_mempool_slab_t *slab;
+    parsec_list_item_t *elt;
+
+    if( me != thread_mempool->owner_thread ) {
+        /* Allocate from the thread mempool of the calling thread, or from the shared LIFO */
+        thread_mempool = parsec_mempool_bound(mempool, me);
+        if( NULL == thread_mempool ) {
+            elt = parsec_lifo_pop(&mempool->shared->mempool);
+            if( NULL == elt )
+                elt = parsec_thread_mempool_allocate_when_empty(mempool->shared);
+            return elt;
+        }
+    }
+
+    if( NULL == (slab = thread_mempool->avail) ) {
+        parsec_mempool_reclaim(thread_mempool);
+        if( (NULL == (slab = thread_mempool->avail)) &&
+            (NULL == (slab = parsec_mempool_slab_new(thread_mempool))) )
+            return NULL;
+    }
+    if( NULL != (elt = slab->free) ) {
+        slab->free = (parsec_list_item_t*)elt->list_next;
+    } else {
+        elt = (parsec_list_item_t*)((char*)slab + mempool->slab_header + slab->nb_carved * mempool->slab_stride);
+        slab->nb_carved++;
+        *(parsec_thread_mempool_t **)((char*)elt + mempool->pool_owner_offset) = thread_mempool;
+        if( NULL != mempool->obj_class ) {
+            PARSEC_OBJ_CONSTRUCT_INTERNAL(elt, mempool->obj_class);
+        }
+        thread_mempool->nb_elt++;
+    }
+    if( 0 == slab->nb_used++ )
+        thread_mempool->nb_idle_slabs--;
+    if( slab->nb_used == mempool->slab_capacity )
+        parsec_mempool_avail_remove(thread_mempool, slab);
+    return elt;
+}
+
+void parsec_thread_mempool_slab_free( parsec_thread_mempool_t *thread_mempool, void *elt )
+{
+    parsec_mempool_t *mempool = thread_mempool->parent;
+    uintptr_t me = (uintptr_t)PARSEC_TLS_GET_SPECIFIC(parsec_mempool_tls_thread);
+    parsec_thread_mempool_t *mine;
+    parsec_mempool_batch_t *batch;
+    parsec_list_item_t *item = (parsec_list_item_t*)elt;
+
+    if( me == thread_mempool->owner_thread ) {
+        parsec_mempool_slab_put(thread_mempool, item);
+        return;
+    }
+    mine = parsec_mempool_bound(mempool, me);
+    if( NULL == mine ) {
+        parsec_mempool_return(thread_mempool, item, item);
+        return;
+    }
+    batch = &mine->batches[thread_mempool - mempool->thread_mempools];
+    item->list_next = batch->first;
+    batch->first = item;
+    if( 0 == batch->nb++ )
+        batch->last = item;
+    mine->nb_remote_frees++;
+    if( PARSEC_MEMPOOL_SLAB_BATCH == batch->nb )
+        parsec_mempool_batch_flush(mine, thread_mempool, batch);
 }
 
 uint64_t parsec_mempool_destruct( parsec_mempool_t *mempool )
@@ -63,6 +400,13 @@ uint64_t parsec_mempool_destruct( parsec_mempool_t *mempool )
         parsec_thread_mempool_destruct(&mempool->thread_mempools[tid]);
     }
 
+    if( NULL != mempool->shared ) {
+        usage_counter += mempool->shared->nb_elt;
+        parsec_thread_mempool_destruct(mempool->shared);
+        free(mempool->shared);
+        mempool->shared = NULL;
+    }
+
     free(mempool->thread_mempools);
     mempool->thread_mempools = NULL;
     mempool->nb_thread_mempools = 0;
@@ -80,6 +424,7 @@ void *parsec_thread_mempool_allocate_when_empty( parsec_thread_mempool_t *thread
     parsec_thread_mempool_t **owner;
 
     elt = parsec_lifo_item_alloc(&thread_mempool->mempool, thread_mempool->parent->elt_size );
+    PARSEC_MEMPOOL_FOOTPRINT(thread_mempool->parent, thread_mempool->parent->elt_size);
     owner = (parsec_thread_mempool_t **)((char*)elt + thread_mempool->parent->pool_owner_offset);
     *owner = thread_mempool;
     if( NULL != thread_mempool->parent->obj_class ) {
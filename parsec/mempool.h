@@ -31,6 +31,24 @@ typedef struct parsec_mempool_s parsec_mempool_t;
  *
  * Memory Pool memory must also be a parsec_list_item_t, to
  * be chained using LIFOs.
+ *
+ * By default, each thread mempool keeps the free elements in a LIFO,
+ * and an element is pushed back to its owner LIFO with an atomic
+ * operation, whatever the thread that frees it. In slab mode (see
+ * parsec_mempool_slab_enable), the elements are carved from slabs
+ * that belong to a thread, that must bind its thread mempool
+ * (see parsec_thread_mempool_bind):
+ *  - the owner allocates and frees its elements without atomic
+ *    operations, in the free lists of its slabs;
+ *  - another thread that frees an element gathers it with the other
+ *    elements it freed for the same owner, and pushes the whole batch
+ *    to the owner with a single atomic operation. The owner takes back
+ *    all the returned elements at once, when its slabs are full;
+ *  - a slab in which all the elements are free is idle, and the slabs
+ *    that are idle beyond a threshold are released to the system.
+ * A thread that allocates from a thread mempool it does not own
+ * allocates from its own thread mempool in the same mempool if it has
+ * one, and from a LIFO shared by all the other threads otherwise.
  */
 struct parsec_mempool_s {
     unsigned int            nb_thread_mempools; /**< Number of thread mempools that share this mempool */
@@ -40,13 +58,35 @@ struct parsec_mempool_s {
     volatile uint32_t       nb_max_elt;         /**< this reflects the maximum of the nb_elt of the other threads */
     parsec_class_t          *obj_class;         /**< the base class of the objects inside the mempool */
     parsec_thread_mempool_t *thread_mempools;   /**< Array of thread mempools (of size nb_thread_mempools) */
+    /* Slab mode only */
+    size_t                   slab_size;         /**< Size (and alignment) of the slabs, 0 if the slab mode is not enabled */
+    size_t                   slab_header;       /**< Offset of the first element in a slab */
+    size_t                   slab_stride;       /**< Distance between two elements of a slab */
+    uint32_t                 slab_capacity;     /**< Number of elements in a slab */
+    uint32_t                 slab_max_idle;     /**< Number of idle slabs a thread mempool keeps before releasing them */
+    parsec_thread_mempool_t *shared;            /**< LIFO mempool of the threads that do not own a thread mempool */
+    int                      footprint;         /**< Subsystem charged with the memory of this mempool, -1 if none */
 };
 
+struct parsec_mempool_slab_s;
+struct parsec_mempool_batch_s;
+
 struct parsec_thread_mempool_s {
     parsec_mempool_t  *parent;   /**<  back pointer to the mempool */
     uint32_t nb_elt;             /**< this is the number of elements this thread
                                   *   has allocated since the creation of the pool */
     parsec_lifo_t mempool;       /**< Elements are stored in a LIFO */
+    /* Slab mode only */
+    uintptr_t owner_thread;      /**< Thread that owns the slabs, 0 if the elements are stored in the LIFO */
+    struct parsec_mempool_slab_s *slabs;       /**< All the slabs of this thread mempool */
+    struct parsec_mempool_slab_s *avail;       /**< Slabs with free elements, the first one is used first */
+    uint32_t nb_slabs;           /**< Number of slabs in this thread mempool */
+    uint32_t nb_idle_slabs;      /**< Number of slabs without any element in use */
+    parsec_list_item_t * volatile returned;    /**< Elements freed by other threads, not yet taken back */
+    struct parsec_mempool_batch_s *batches;    /**< Elements freed by the owner, to return to each other thread mempool */
+    uint64_t nb_remote_frees;    /**< Number of elements of other thread mempools freed by the owner */
+    uint64_t nb_returned_batches;/**< Number of batches the owner returned to other thread mempools */
+    uint64_t nb_released_slabs;  /**< Number of idle slabs released to the system */
 };
 
 /**
@@ -94,6 +134,83 @@ void parsec_mempool_construct( parsec_mempool_t *mempool,
                               size_t pool_offset,
                               unsigned int nbthreads );
 
+/**
+ * @brief switch a mempool to the slab mode
+ *
+ * @details
+ *    Must be called after parsec_mempool_construct, before any element
+ *    is allocated from the mempool. Each thread then binds the thread
+ *    mempool it owns with parsec_thread_mempool_bind.
+ *
+ * @param[inout] mempool the mempool to switch to the slab mode
+ * @param[in] max_idle_slabs number of idle slabs each thread mempool keeps
+ *            for later allocations; the slabs that become idle beyond
+ *            this number are released
+ */
+void parsec_mempool_slab_enable( parsec_mempool_t *mempool, unsigned int max_idle_slabs );
+
+/**
+ * @brief charge the memory of a mempool to a subsystem
+ *
+ * @details
+ *    The memory a mempool allocates from, and releases to, the system
+ *    (elements in LIFO mode, slabs in slab mode) is accounted to this
+ *    subsystem of the memory footprint (see parsec/utils/mem_footprint.h).
+ *    Must be called before any element is allocated from the mempool.
+ *
+ * @param[inout] mempool the mempool
+ * @param[in] subsystem a parsec_mem_footprint_subsystem_t
+ */
+void parsec_mempool_set_footprint( parsec_mempool_t *mempool, int subsystem );
+
+/**
+ * @brief make the calling thread the owner of a thread-mempool
+ *
+ * @details
+ *    Only the owner allocates from, and frees to, the slabs of a thread
+ *    mempool without atomic operations. A thread should own at most one
+ *    thread mempool of each mempool, at the same index in all the
+ *    mempools it uses. Does nothing if the mempool is not in slab mode.
+ *
+ * @param[inout] thread_mempool the thread-mempool owned by the calling thread
+ */
+void parsec_thread_mempool_bind( parsec_thread_mempool_t *thread_mempool );
+
+/**
+ * @brief return to their owners the elements freed by the owner of a thread-mempool
+ *
+ * @details
+ *    In slab mode, the elements a thread frees for the other threads
+ *    are returned by batches. This pushes the partial batches of the
+ *    calling thread, that must own thread_mempool. Does nothing if the
+ *    mempool is not in slab mode.
+ *
+ * @param[inout] thread_mempool the thread-mempool owned by the calling thread
+ */
+void parsec_thread_mempool_flush( parsec_thread_mempool_t *thread_mempool );
+
+/**
+ * @brief allocate an element from a thread-mempool in slab mode
+ *
+ * @details
+ *    Internal function, called by parsec_thread_mempool_allocate.
+ *
+ * @param[inout] thread_mempool the thread mempool from which an element should be allocated
+ * @return an object of class obj_class
+ */
+void *parsec_thread_mempool_slab_allocate( parsec_thread_mempool_t *thread_mempool );
+
+/**
+ * @brief return an element to its thread-mempool in slab mode
+ *
+ * @details
+ *    Internal function, called by parsec_thread_mempool_free.
+ *
+ * @param[inout] thread_mempool the owner of elt
+ * @param[inout] elt the element to free
+ */
+void parsec_thread_mempool_slab_free( parsec_thread_mempool_t *thread_mempool, void *elt );
+
 /**
  * @brief extends a thread-mempool when it is empty
  *
@@ -123,6 +240,9 @@ void *parsec_thread_mempool_allocate_when_empty( parsec_thread_mempool_t *thread
 static inline void *parsec_thread_mempool_allocate( parsec_thread_mempool_t *thread_mempool )
 {
     void* ret;
+    if( 0 != thread_mempool->owner_thread ) {
+        return parsec_thread_mempool_slab_allocate( thread_mempool );
+    }
     ret = (void*)parsec_lifo_pop( &thread_mempool->mempool );
     if( ret == NULL ) {
         ret = parsec_thread_mempool_allocate_when_empty( thread_mempool );
@@ -147,6 +267,10 @@ static inline void  parsec_thread_mempool_free( parsec_thread_mempool_t *thread_
     assert(owner == thread_mempool);
 #endif // PARSEC_DEBUG_ENABLE
 
+    if( 0 != thread_mempool->owner_thread ) {
+        parsec_thread_mempool_slab_free( thread_mempool, elt );
+        return;
+    }
     parsec_lifo_push( &(thread_mempool->mempool), (parsec_list_item_t*)elt );
 }
 
@@ -12,6 +12,7 @@
 #include "parsec/sys/tls.h"
 #include "parsec/sys/atomic.h"
 #include "parsec/utils/debug.h"
+#include "parsec/utils/mem_footprint.h"
 #include "parsec/class/list.h"
 #include "parsec/class/parsec_rwlock.h"
 
@@ -67,8 +68,25 @@ hl_counter_type_t hl_counters[PARSEC_PAPI_SDE_NB_HL_COUNTERS] = {
       0, 1 }
 };
 
+/* One counter per subsystem of the memory footprint, in the order of
+ * parsec_mem_footprint_subsystem_t */
+static const char *mem_footprint_counters[PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS][2] = {
+    { "MEMORY_FOOTPRINT::TASKS",        "the amount of memory allocated by PaRSEC for the tasks" },
+    { "MEMORY_FOOTPRINT::DATAREPO",     "the amount of memory allocated by PaRSEC for the data repository entries" },
+    { "MEMORY_FOOTPRINT::HASH_TABLES",  "the amount of memory allocated by PaRSEC for the heads and buckets of its hash tables" },
+    { "MEMORY_FOOTPRINT::ARENAS",       "the amount of memory allocated by PaRSEC in the arenas" },
+    { "MEMORY_FOOTPRINT::DEPENDENCIES", "the amount of memory allocated by PaRSEC to track the dependencies of the tasks" },
+    { "MEMORY_FOOTPRINT::DTD_TILES",    "the amount of memory allocated by PaRSEC for the tiles of the DTD interface" },
+    { "MEMORY_FOOTPRINT::REMOTE_DEPS",  "the amount of memory allocated by PaRSEC for the remote dependencies and their buffers" }
+};
+
 static long long int parsec_papi_sde_base_counter_cb(void *arg);
 
+static long long int parsec_papi_sde_mem_footprint_cb(void *arg)
+{
+    return (long long int)parsec_mem_footprint_current((parsec_mem_footprint_subsystem_t)(uintptr_t)arg);
+}
+
 void parsec_papi_sde_init(void)
 {
     parsec_papi_sde_hl_counters_t cnt;
@@ -91,6 +109,11 @@ void parsec_papi_sde_init(void)
             papi_sde_describe_counter(parsec_papi_sde_handle, hl_counters[cnt].name, hl_counters[cnt].description);
         }
     }
+    for(int s = 0; s < PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS; s++) {
+        papi_sde_register_fp_counter(parsec_papi_sde_handle, mem_footprint_counters[s][0], PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                     PAPI_SDE_int, (papi_sde_fptr_t)parsec_papi_sde_mem_footprint_cb, (void*)(uintptr_t)s);
+        papi_sde_describe_counter(parsec_papi_sde_handle, mem_footprint_counters[s][0], mem_footprint_counters[s][1]);
+    }
 }
 
 static papi_sde_fptr_struct_t *parsec_papi_sde_fptr = NULL;
@@ -111,6 +134,11 @@ papi_handle_t papi_sde_hook_list_events(papi_sde_fptr_struct_t *fptr_struct){
             fptr_struct->describe_counter(parsec_papi_sde_handle, hl_counters[cnt].name, hl_counters[cnt].description);
         }
     }
+    for(int s = 0; s < PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS; s++) {
+        fptr_struct->register_fp_counter(parsec_papi_sde_handle, mem_footprint_counters[s][0], PAPI_SDE_RO|PAPI_SDE_INSTANT,
+                                         PAPI_SDE_int, (papi_sde_fptr_t)parsec_papi_sde_mem_footprint_cb, (void*)(uintptr_t)s);
+        fptr_struct->describe_counter(parsec_papi_sde_handle, mem_footprint_counters[s][0], mem_footprint_counters[s][1]);
+    }
     parsec_papi_sde_fptr = fptr_struct;
     parsec_mca_param_init();
     mca_components_repository_init();
@@ -137,6 +165,9 @@ void parsec_papi_sde_fini(void)
     for(cnt = PARSEC_PAPI_SDE_FIRST_BASIC_COUNTER; cnt <= PARSEC_PAPI_SDE_LAST_BASIC_COUNTER; cnt++) {
         papi_sde_unregister_counter(parsec_papi_sde_handle, hl_counters[cnt].name);
     }
+    for(int s = 0; s < PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS; s++) {
+        papi_sde_unregister_counter(parsec_papi_sde_handle, mem_footprint_counters[s][0]);
+    }
     
     parsec_atomic_rwlock_wrlock( &sde_threads_lock );
     while(NULL != (it = parsec_list_nolock_pop_front(&sde_threads)) ) {
@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <limits.h>
+#include <inttypes.h>
 #if defined(PARSEC_HAVE_GEN_H)
 #include <libgen.h>
 #endif  /* defined(PARSEC_HAVE_GEN_H) */
@@ -32,6 +33,7 @@
 #include "parsec/class/list.h"
 #include "parsec/scheduling.h"
 #include "parsec/class/barrier.h"
+#include "parsec/class/parsec_ebr.h"
 #include "parsec/remote_dep.h"
 #include "parsec/datarepo.h"
 #include "parsec/bindthread.h"
@@ -39,6 +41,7 @@
 #include "parsec/vpmap.h"
 #include "parsec/class/info.h"
 #include "parsec/utils/mca_param.h"
+#include "parsec/utils/mem_footprint.h"
 #include "parsec/utils/installdirs.h"
 #include "parsec/utils/cmd_line.h"
 #include "parsec/utils/debug.h"
@@ -152,6 +155,14 @@ static int parsec_runtime_bind_main_thread = 1;
 static int parsec_runtime_bind_threads     = 1;
 
 int parsec_runtime_keep_highest_priority_task = 1;
+int parsec_runtime_chain_max_depth = 64;
+int parsec_runtime_park_spin = -1;
+int parsec_runtime_park_timeout = 10000;
+char *parsec_runtime_vp_sched = NULL;
+static int parsec_runtime_mempool_slab = 0;
+static int parsec_runtime_mempool_slab_idle = 4;
+static int parsec_runtime_dep_flat_ratio = 4;
+static int parsec_runtime_mem_footprint_report = 0;
 
 static PARSEC_TLS_DECLARE(parsec_tls_execution_stream);
 
@@ -256,12 +267,26 @@ static void* __parsec_thread_init( __parsec_temporary_thread_initialization_t* s
     es->rand_seed        = tv_now.tv_usec + startup->th_id;
     es->scheduler_object = NULL;
     es->next_task        = NULL;
+    es->chain_depth      = 0;
+    es->nb_chained       = 0;
+    es->nb_chain_cuts    = 0;
+    es->nb_handoffs      = 0;
+    es->gathered_rings   = NULL;
+    es->idle_spin_ns     = 0;
+    es->idle_park_ns     = 0;
+    es->nb_parks         = 0;
+    es->nb_wakeups       = 0;
+    es->wake_latency_ns  = 0;
+    es->max_wake_latency_ns = 0;
     startup->virtual_process->execution_streams[startup->th_id] = es;
     es->core_id          = startup->bindto;
 #if defined(PARSEC_HAVE_HWLOC)
     es->socket_id        = parsec_hwloc_socket_id(startup->bindto);
+    es->numa_id          = parsec_hwloc_numa_id(startup->bindto);
+    if( es->numa_id < 0 ) es->numa_id = 0;
 #else
     es->socket_id        = 0;
+    es->numa_id          = 0;
 #endif  /* defined(PARSEC_HAVE_HWLOC) */
 
     /*
@@ -286,18 +311,36 @@ static void* __parsec_thread_init( __parsec_temporary_thread_initialization_t* s
                                   NULL, sizeof(parsec_hashable_dependency_t),
                                   offsetof(parsec_hashable_dependency_t, mempool_owner),
                                   vp->nb_cores);
+        parsec_mempool_set_footprint( &vp->context_mempool, PARSEC_MEM_FOOTPRINT_TASKS );
+        for(pi = 0; pi <= MAX_PARAM_COUNT; pi++) {
+            parsec_mempool_set_footprint( &vp->datarepo_mempools[pi], PARSEC_MEM_FOOTPRINT_DATAREPO );
+        }
+        parsec_mempool_set_footprint( &vp->dependencies_mempool, PARSEC_MEM_FOOTPRINT_DEPENDENCIES );
+        if( parsec_runtime_mempool_slab ) {
+            parsec_mempool_slab_enable( &vp->context_mempool, parsec_runtime_mempool_slab_idle );
+            for(pi = 0; pi <= MAX_PARAM_COUNT; pi++) {
+                parsec_mempool_slab_enable( &vp->datarepo_mempools[pi], parsec_runtime_mempool_slab_idle );
+            }
+            parsec_mempool_slab_enable( &vp->dependencies_mempool, parsec_runtime_mempool_slab_idle );
+        }
     }
     /* Synchronize with the other threads */
     parsec_barrier_wait(startup->barrier);
 
-    if( NULL != parsec_current_scheduler->module.flow_init )
-        parsec_current_scheduler->module.flow_init(es, startup->barrier);
+    /* The barrier is shared by the streams of the VP, that all use the same scheduler */
+    if( NULL != es->virtual_process->scheduler->module.flow_init )
+        es->virtual_process->scheduler->module.flow_init(es, startup->barrier);
 
     es->context_mempool = &(es->virtual_process->context_mempool.thread_mempools[es->th_id]);
     for(pi = 0; pi <= MAX_PARAM_COUNT; pi++) {
         es->datarepo_mempools[pi] = &(es->virtual_process->datarepo_mempools[pi].thread_mempools[es->th_id]);
     }
     es->dependencies_mempool = &(es->virtual_process->dependencies_mempool.thread_mempools[es->th_id]);
+    parsec_thread_mempool_bind(es->context_mempool);
+    for(pi = 0; pi <= MAX_PARAM_COUNT; pi++) {
+        parsec_thread_mempool_bind(es->datarepo_mempools[pi]);
+    }
+    parsec_thread_mempool_bind(es->dependencies_mempool);
 
 #ifdef PARSEC_PROF_TRACE
     {
@@ -525,6 +568,46 @@ parsec_context_t* parsec_init( int nb_cores, int* pargc, char** pargv[] )
      */
     parsec_mca_param_reg_int_name("runtime", "keep_highest_priority_task", "Allow a compute thread to retain the highest priority task to be executed locally. This change makes the scheduling decision non-deterministic because some tasks will never be handled to the scheduler.", false, false,
                                   parsec_runtime_keep_highest_priority_task, &parsec_runtime_keep_highest_priority_task);
+    parsec_mca_param_reg_int_name("runtime", "chain_max_depth", "Maximal number of consecutive tasks a compute thread "
+                                  "executes as successors of the task it just completed, without going through the scheduler "
+                                  "(0 for no limit)",
+                                  false, false, parsec_runtime_chain_max_depth, &parsec_runtime_chain_max_depth);
+    parsec_mca_param_reg_int_name("runtime", "park_spin", "Time (in microseconds) an idle compute thread keeps looking for "
+                                  "tasks before it parks until new tasks are scheduled on its virtual process (-1 to never park)",
+                                  false, false, parsec_runtime_park_spin, &parsec_runtime_park_spin);
+    parsec_mca_param_reg_int_name("runtime", "park_timeout", "Maximal time (in microseconds) a parked compute thread sleeps "
+                                  "before it looks for tasks again",
+                                  false, false, parsec_runtime_park_timeout, &parsec_runtime_park_timeout);
+    if( parsec_runtime_park_timeout <= 0 )
+        parsec_runtime_park_timeout = 1;
+    parsec_mca_param_reg_string_name("runtime", "vp_sched", "Comma-separated list of the schedulers of the virtual processes: "
+                                     "the i-th scheduler is used by the virtual process i, the last one by all the remaining "
+                                     "virtual processes, and an empty name selects the default scheduler (see mca_sched)",
+                                     false, false, "", &parsec_runtime_vp_sched);
+    parsec_mca_param_reg_int_name("runtime", "mempool_slab", "Allocate the tasks, data repository entries and dependencies "
+                                  "from per-thread slabs, and return the elements freed by other threads by batches",
+                                  false, false, parsec_runtime_mempool_slab, &parsec_runtime_mempool_slab);
+    parsec_mca_param_reg_int_name("runtime", "mempool_slab_idle", "Number of idle slabs each thread keeps in each memory pool "
+                                  "before releasing them to the system (when runtime_mempool_slab is set)",
+                                  false, false, parsec_runtime_mempool_slab_idle, &parsec_runtime_mempool_slab_idle);
+    if( parsec_runtime_mempool_slab_idle < 0 )
+        parsec_runtime_mempool_slab_idle = 0;
+    parsec_mca_param_reg_int_name("runtime", "dep_flat_ratio", "Track the dependencies of the PTG task classes with a dense "
+                                  "execution space in a flat array of counters, when the bounding box of their local tasks "
+                                  "holds at most this many times their number of local tasks (0 to always use hash tables)",
+                                  false, false, parsec_runtime_dep_flat_ratio, &parsec_runtime_dep_flat_ratio);
+    parsec_mca_param_reg_int_name("runtime", "mem_footprint", "Account the memory allocated by the runtime for its tasks, "
+                                  "data repositories, hash tables, arenas, dependencies, DTD tiles and remote dependencies",
+                                  false, false, parsec_mem_footprint_enabled, &parsec_mem_footprint_enabled);
+    parsec_mca_param_reg_int_name("runtime", "mem_footprint_dump", "Period (in seconds) of the report of the memory footprint "
+                                  "of the runtime, 0 for none (when runtime_mem_footprint is set)",
+                                  false, false, parsec_mem_footprint_dump_period, &parsec_mem_footprint_dump_period);
+    parsec_mca_param_reg_int_name("runtime", "mem_footprint_report", "Report the memory footprint of the runtime, and its "
+                                  "high-water marks, at parsec_fini (when runtime_mem_footprint is set)",
+                                  false, false, parsec_runtime_mem_footprint_report, &parsec_runtime_mem_footprint_report);
+    parsec_mca_param_reg_int_name("runtime", "data_pool", "Recycle the released data and data copies in per-thread "
+                                  "pools, instead of freeing them",
+                                  false, false, parsec_data_pool_enabled, &parsec_data_pool_enabled);
 
     if( parsec_cmd_line_is_taken(cmd_line, "gpus") ) {
         parsec_warning("Option g (for accelerators) is deprecated as an argument. Use the MCA parameter instead.");
@@ -585,6 +668,7 @@ parsec_context_t* parsec_init( int nb_cores, int* pargc, char** pargv[] )
     }
 
     parsec_hash_tables_init();
+    parsec_hbbuffers_init();
 
 #if defined(PARSEC_PROF_GRAPHER)
     char *parsec_mca_enable_dot = parsec_enable_dot;
@@ -655,6 +739,15 @@ parsec_context_t* parsec_init( int nb_cores, int* pargc, char** pargv[] )
         vp = (parsec_vp_t *)malloc(sizeof(parsec_vp_t) + (vpmap_get_nb_threads_in_vp(p)-1) * sizeof(parsec_execution_stream_t*));
         vp->parsec_context = context;
         vp->vp_id = p;
+        vp->park_seq = 0;
+        vp->nb_parked = 0;
+        vp->park_wake_ns = 0;
+        vp->scheduler = NULL;
+        vp->handoff_next = 0;
+#if !defined(PARSEC_HAVE_FUTEX)
+        pthread_mutex_init(&vp->park_lock, NULL);
+        pthread_cond_init(&vp->park_cond, NULL);
+#endif  /* !defined(PARSEC_HAVE_FUTEX) */
         context->virtual_processes[p] = vp;
         /*
          * Set the threads local variables from startup[t] -> startup[t+nb_cores].
@@ -677,6 +770,9 @@ parsec_context_t* parsec_init( int nb_cores, int* pargc, char** pargv[] )
     parsec_mca_param_reg_sizet_name("arena", "max_cached", "The maxmimum amount of memory each arena can"
                                    " cache in a freelist (0=no caching)",
                                    false, false, parsec_arena_max_cached_memory, &parsec_arena_max_cached_memory);
+    parsec_mca_param_reg_int_name("arena", "size_classes", "Allocate the chunks of all the arenas from a pool of size"
+                                  " classes, backed by huge pages bound to the NUMA node of the requesting thread",
+                                  false, false, parsec_arena_size_classes, &parsec_arena_size_classes);
 
     parsec_mca_param_reg_sizet_name("task", "startup_iter", "The number of ready tasks to be generated during the startup "
                                    "before allowing the scheduler to distribute them across the entire execution context.",
@@ -892,7 +988,8 @@ parsec_context_t* parsec_init( int nb_cores, int* pargc, char** pargv[] )
         vpmap_display_map();
 
     parsec_mca_param_reg_int_name("profile", "rusage", "Report 'getrusage' satistics.\n"
-            "0: no report, 1: per process report, 2: per thread report (if available).\n",
+            "0: no report, 1: per process report, 2: per thread report (if available), including\n"
+            "the scheduler statistics (if the scheduler provides them).\n",
             false, false, parsec_want_rusage, &parsec_want_rusage);
     parsec_rusage(false);
 
@@ -1077,6 +1174,17 @@ void parsec_abort(parsec_context_t* ctx, int status)
 }
 
 #if defined(PARSEC_PROF_TRACE)
+/* Adds the remote frees, returned batches and released slabs of the thread mempools of mp */
+static void parsec_mempool_slab_counters(parsec_mempool_t *mp, uint64_t counters[3])
+{
+    unsigned int t;
+    for(t = 0; t < mp->nb_thread_mempools; t++) {
+        counters[0] += mp->thread_mempools[t].nb_remote_frees;
+        counters[1] += mp->thread_mempools[t].nb_returned_batches;
+        counters[2] += mp->thread_mempools[t].nb_released_slabs;
+    }
+}
+
 static void parsec_mempool_stats(parsec_context_t *context)
 {
     int i, p;
@@ -1117,6 +1225,20 @@ static void parsec_mempool_stats(parsec_context_t *context)
     }
     snprintf(meminfo, 128, "MEMPOOL - Dependencies - %zu bytes", m_usage);
     parsec_profiling_add_information("MEMORY_USAGE", meminfo);
+
+    if( parsec_runtime_mempool_slab ) {
+        uint64_t counters[3] = {0, 0, 0};
+        for(p = 0; p < context->nb_vp; p++) {
+            vp = context->virtual_processes[p];
+            parsec_mempool_slab_counters(&vp->context_mempool, counters);
+            for(i = 0; i <= MAX_PARAM_COUNT; i++)
+                parsec_mempool_slab_counters(&vp->datarepo_mempools[i], counters);
+            parsec_mempool_slab_counters(&vp->dependencies_mempool, counters);
+        }
+        snprintf(meminfo, 128, "MEMPOOL - Slabs - %"PRIu64" remote frees in %"PRIu64" batches, %"PRIu64" slabs released",
+                 counters[0], counters[1], counters[2]);
+        parsec_profiling_add_information("MEMORY_USAGE", meminfo);
+    }
 }
 #endif
 
@@ -1134,6 +1256,10 @@ static void parsec_vp_fini( parsec_vp_t *vp )
         free(vp->execution_streams[i]);
         vp->execution_streams[i] = NULL;
     }
+#if !defined(PARSEC_HAVE_FUTEX)
+    pthread_mutex_destroy(&vp->park_lock);
+    pthread_cond_destroy(&vp->park_cond);
+#endif  /* !defined(PARSEC_HAVE_FUTEX) */
 }
 
 void parsec_context_at_fini(parsec_external_fini_cb_t cb, void *data)
@@ -1256,6 +1382,23 @@ int parsec_fini( parsec_context_t** pcontext )
     }
 
     PARSEC_AYU_FINI();
+
+    if( parsec_mem_footprint_enabled ) {
+#ifdef PARSEC_PROF_TRACE
+        char name[64], value[64];
+        for(p = 0; p < PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS; p++) {
+            snprintf(name, sizeof(name), "MEMORY_FOOTPRINT::%s",
+                     parsec_mem_footprint_name((parsec_mem_footprint_subsystem_t)p));
+            snprintf(value, sizeof(value), "%"PRId64"/%"PRId64,
+                     parsec_mem_footprint_current((parsec_mem_footprint_subsystem_t)p),
+                     parsec_mem_footprint_high_water_mark((parsec_mem_footprint_subsystem_t)p));
+            parsec_profiling_add_information(name, value);
+        }
+#endif  /* PARSEC_PROF_TRACE */
+        if( parsec_runtime_mem_footprint_report )
+            parsec_mem_footprint_dump("at parsec_fini");
+    }
+
 #ifdef PARSEC_PROF_TRACE
     (void)parsec_profiling_fini( );  /* we're leaving, ignore errors */
 #endif  /* PARSEC_PROF_TRACE */
@@ -1270,6 +1413,8 @@ int parsec_fini( parsec_context_t** pcontext )
     /* Destroy all resources allocated for the barrier */
     parsec_barrier_destroy( &(context->barrier) );
 
+    parsec_arena_size_classes_fini();
+
 #if defined(PARSEC_HAVE_HWLOC_BITMAP)
     /* Release thread binding masks */
     hwloc_bitmap_free(context->cpuset_allowed_mask);
@@ -1295,6 +1440,7 @@ int parsec_fini( parsec_context_t** pcontext )
     free(context);
     *pcontext = NULL;
 
+    parsec_ebr_fini();
     parsec_class_finalize();
     parsec_debug_fini();  /* Always last */
     return PARSEC_SUCCESS;
@@ -1550,6 +1696,34 @@ parsec_hash_find_deps(const parsec_taskpool_t *tp,
     return &hd->dependency;
 }
 
+parsec_dependency_t*
+parsec_flat_find_deps(const parsec_taskpool_t *tp,
+                      parsec_execution_stream_t *es,
+                      const parsec_task_t* restrict task)
+{
+    const parsec_task_class_t *tc = task->task_class;
+    parsec_flat_dependencies_t *deps = (parsec_flat_dependencies_t*)tp->dependencies_array[tc->task_class_id];
+    size_t idx = 0;
+    int p, v;
+
+    assert(NULL != deps);
+    for(p = 0; p < deps->nb_params; p++) {
+        v = task->locals[tc->params[p]->context_index].value;
+        if( (v < deps->min[p]) || (v > deps->max[p]) ) {
+            /* Only the debugging calls (without execution stream) look for remote tasks,
+             * a local task outside of the box has no counter */
+            if( NULL != es ) {
+                char tmp[MAX_TASK_STRLEN];
+                parsec_warning("Task %s is outside of the bounding box of the dependencies of its task class",
+                               parsec_task_snprintf(tmp, MAX_TASK_STRLEN, task));
+            }
+            return NULL;
+        }
+        idx += (size_t)(v - deps->min[p]) * deps->stride[p];
+    }
+    return &deps->deps[idx];
+}
+
 int
 parsec_update_deps_with_counter(parsec_taskpool_t *tp,
                                 const parsec_task_t* restrict task,
@@ -1670,25 +1844,30 @@ parsec_update_deps_with_mask(parsec_taskpool_t *tp,
  * tasks and later tasks).
  * Since data -> task grapher logging is detected during dependency resolving,
  * and startup tasks don't have an input dependency, we also resolve this here.
+ * Returns PARSEC_ERR_OUT_OF_RESOURCE if the task has no dependencies to mark.
  */
-void parsec_dependencies_mark_task_as_startup(parsec_task_t* restrict task,
-                                              parsec_execution_stream_t *es)
+int parsec_dependencies_mark_task_as_startup(parsec_task_t* restrict task,
+                                             parsec_execution_stream_t *es)
 {
     const parsec_task_class_t* tc = task->task_class;
     parsec_taskpool_t *tp = task->taskpool;
     parsec_dependency_t *deps = tc->find_deps(tp, es, task);
 
+    if( NULL == deps )
+        return PARSEC_ERR_OUT_OF_RESOURCE;
     if( tc->flags & PARSEC_USE_DEPS_MASK ) {
         *deps = PARSEC_DEPENDENCIES_STARTUP_TASK | tc->dependencies_goal;
     } else {
         *deps = 0;
     }
+    return PARSEC_SUCCESS;
 }
 
 /*
  * Release the OUT dependencies for a single instance of a task. No ranges are
  * supported and the task is supposed to be valid (no input/output tasks) and
- * local.
+ * local. Returns PARSEC_ERR_OUT_OF_RESOURCE if the dependencies of the task
+ * cannot be found.
  */
 int
 parsec_release_local_OUT_dependencies(parsec_execution_stream_t* es,
@@ -1712,6 +1891,8 @@ parsec_release_local_OUT_dependencies(parsec_execution_stream_t* es,
 
     PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Activate dependencies for %s flags = 0x%04x", tmp1, tc->flags);
     deps = tc->find_deps(origin->taskpool, es, task);
+    if( NULL == deps )
+        return PARSEC_ERR_OUT_OF_RESOURCE;
 
     completed = tc->update_deps(origin->taskpool, task, deps, origin, origin_flow, dest_flow);
 
@@ -1907,14 +2088,15 @@ parsec_release_dep_fct(parsec_execution_stream_t *es,
          * We are doing this in order for dtd to be able to track control dependences.
          * Usage count of the repo is dealt with when setting up reshape promises.
          */
-        parsec_release_local_OUT_dependencies(es,
-                                              oldcontext,
-                                              src_flow,
-                                              newcontext,
-                                              dep->flow,
-                                              data,
-                                              &arg->ready_lists[dst_vpid],
-                                              target_repo, target_dc, target_repo_entry);
+        if( PARSEC_SUCCESS != parsec_release_local_OUT_dependencies(es,
+                                                                    oldcontext,
+                                                                    src_flow,
+                                                                    newcontext,
+                                                                    dep->flow,
+                                                                    data,
+                                                                    &arg->ready_lists[dst_vpid],
+                                                                    target_repo, target_dc, target_repo_entry) )
+            return PARSEC_ITERATE_STOP;
     }
 
     return PARSEC_ITERATE_CONTINUE;
@@ -1990,6 +2172,7 @@ size_t parsec_destruct_dependencies(parsec_dependencies_t* d)
     int i;
     if( NULL == d ) return 0;
     size_t ret = sizeof(parsec_dependencies_t) + (d->max-d->min) * sizeof(parsec_dependencies_union_t);
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_DEPENDENCIES, -(int64_t)ret);
     if( (d != NULL) && (d->flags & PARSEC_DEPENDENCIES_FLAG_NEXT) ) {
         for(i = d->min; i <= d->max; i++) {
             if( NULL != d->u.next[i - d->min] ) {
@@ -2001,6 +2184,57 @@ size_t parsec_destruct_dependencies(parsec_dependencies_t* d)
     return ret;
 }
 
+#define PARSEC_FLAT_DEPS_ALIGNMENT 64
+
+parsec_flat_dependencies_t *parsec_flat_dependencies_new(int nb_params, const int *min, const int *max,
+                                                         int32_t nb_tasks)
+{
+    parsec_flat_dependencies_t *d;
+    size_t size = 1, range, limit, bytes;
+    int p;
+
+    if( (parsec_runtime_dep_flat_ratio <= 0) || (nb_tasks <= 0) ||
+        (nb_params <= 0) || (nb_params > MAX_PARAM_COUNT) )
+        return NULL;
+    limit = (size_t)parsec_runtime_dep_flat_ratio * (size_t)nb_tasks;
+    for(p = 0; p < nb_params; p++) {
+        if( max[p] < min[p] ) return NULL;
+        range = (size_t)((int64_t)max[p] - (int64_t)min[p] + 1);
+        if( range > limit / size ) return NULL;  /* too sparse */
+        size *= range;
+    }
+    /* Pad the counters to full cache lines, and keep room to align them. Use calloc
+     * so that large arrays get zeroed pages from the system, only touched on use. */
+    bytes = (size * sizeof(parsec_dependency_t) + PARSEC_FLAT_DEPS_ALIGNMENT - 1) & ~((size_t)PARSEC_FLAT_DEPS_ALIGNMENT - 1);
+    d = (parsec_flat_dependencies_t*)calloc(1, sizeof(parsec_flat_dependencies_t) + PARSEC_FLAT_DEPS_ALIGNMENT + bytes);
+    if( NULL == d ) return NULL;
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_DEPENDENCIES, sizeof(parsec_flat_dependencies_t) + PARSEC_FLAT_DEPS_ALIGNMENT + bytes);
+    d->deps = (parsec_dependency_t*)(((uintptr_t)(d + 1) + PARSEC_FLAT_DEPS_ALIGNMENT - 1) &
+                                     ~((uintptr_t)PARSEC_FLAT_DEPS_ALIGNMENT - 1));
+    d->nb_params = nb_params;
+    d->size = size;
+    for(p = nb_params - 1, size = 1; p >= 0; p--) {
+        d->min[p] = min[p];
+        d->max[p] = max[p];
+        d->stride[p] = size;
+        size *= (size_t)(max[p] - min[p]) + 1;
+    }
+    PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "Allocate %zu flat dependencies for %d local tasks 0x%p",
+                         d->size, nb_tasks, (void*)d);
+    return d;
+}
+
+size_t parsec_flat_dependencies_destruct(parsec_flat_dependencies_t *d)
+{
+    size_t ret;
+    if( NULL == d ) return 0;
+    ret = sizeof(parsec_flat_dependencies_t) + PARSEC_FLAT_DEPS_ALIGNMENT +
+        ((d->size * sizeof(parsec_dependency_t) + PARSEC_FLAT_DEPS_ALIGNMENT - 1) & ~((size_t)PARSEC_FLAT_DEPS_ALIGNMENT - 1));
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_DEPENDENCIES, -(int64_t)ret);
+    free(d);
+    return ret;
+}
+
 int
 parsec_taskpool_set_complete_callback( parsec_taskpool_t* tp,
                                        parsec_event_cb_t complete_cb,
@@ -6,8 +6,12 @@
 
 #include <assert.h>
 #include "parsec/parsec_mpi_funnelled.h"
+#if defined(PARSEC_DIST_WITH_SHM)
+#include "parsec/parsec_shm_engine.h"
+#endif  /* defined(PARSEC_DIST_WITH_SHM) */
 
 parsec_comm_engine_t parsec_ce;
+parsec_comm_engine_t *parsec_ce_local = NULL;
 
 /* This function will be called by the runtime */
 parsec_comm_engine_t *
@@ -17,12 +21,31 @@ parsec_comm_engine_init(parsec_context_t *parsec_context)
     parsec_comm_engine_t *ce = mpi_funnelled_init(parsec_context);
 
     assert(ce->capabilites.sided > 0 && ce->capabilites.sided < 3);
+#if defined(PARSEC_DIST_WITH_SHM)
+    /* the processes of the same node communicate through shared memory */
+    parsec_ce_local = shm_engine_init(parsec_context);
+#endif  /* defined(PARSEC_DIST_WITH_SHM) */
     return ce;
 }
 
 int
 parsec_comm_engine_fini(parsec_comm_engine_t *comm_engine)
 {
+#if defined(PARSEC_DIST_WITH_SHM)
+    shm_engine_fini(parsec_ce_local);
+    parsec_ce_local = NULL;
+#endif  /* defined(PARSEC_DIST_WITH_SHM) */
     /* call the selected module fini */
     return mpi_funnelled_fini(comm_engine);
 }
+
+parsec_comm_engine_t *
+parsec_comm_engine_peer(int peer)
+{
+#if defined(PARSEC_DIST_WITH_SHM)
+    if( (NULL != parsec_ce_local) && shm_engine_is_local(peer) )
+        return parsec_ce_local;
+#endif  /* defined(PARSEC_DIST_WITH_SHM) */
+    (void)peer;
+    return &parsec_ce;
+}
@@ -115,6 +115,16 @@ typedef int (*parsec_ce_send_active_message_fn_t)(parsec_comm_engine_t *comm_eng
                                              int remote,
                                              void *addr, size_t size);
 
+/**
+ * From the callback of an active message, takes the ownership of the buffer
+ * holding the message @p msg, to keep its content without copying it. The
+ * buffer is released with free(). Returns NULL if the engine cannot give it
+ * away: the callback must then copy what it keeps. Engines that never can
+ * leave this function NULL.
+ */
+typedef void* (*parsec_ce_am_adopt_fn_t)(parsec_comm_engine_t *comm_engine,
+                                         void *msg);
+
 typedef int (*parsec_ce_progress_fn_t)(parsec_comm_engine_t *comm_engine);
 
 typedef int (*parsec_ce_enable_fn_t)(parsec_comm_engine_t *comm_engine);
@@ -179,12 +189,18 @@ struct parsec_comm_engine_s {
     parsec_ce_sync_fn_t                    sync;
     parsec_ce_can_serve_fn_t               can_serve;
     parsec_ce_send_active_message_fn_t     send_am;
+    parsec_ce_am_adopt_fn_t                am_adopt;
 };
 
 /* global comm_engine */
 PARSEC_DECLSPEC extern parsec_comm_engine_t parsec_ce;
+/* comm_engine for the processes of the same node, NULL if there is none */
+PARSEC_DECLSPEC extern parsec_comm_engine_t *parsec_ce_local;
 
 parsec_comm_engine_t * parsec_comm_engine_init(parsec_context_t *parsec_context);
 int parsec_comm_engine_fini(parsec_comm_engine_t *comm_engine);
 
+/* Returns the comm_engine serving the communications with the peer */
+parsec_comm_engine_t * parsec_comm_engine_peer(int peer);
+
 #endif /* __USE_PARSEC_COMM_ENGINE_H__ */
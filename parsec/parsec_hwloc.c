@@ -307,6 +307,35 @@ int parsec_hwloc_numa_id(int core_id )
     return PARSEC_ERR_NOT_IMPLEMENTED;
 }
 
+int parsec_hwloc_nb_numa_nodes(void)
+{
+#if defined(PARSEC_HAVE_HWLOC)
+    int nb = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_NODE);
+    if( nb > 0 ) return nb;
+#endif  /* defined(PARSEC_HAVE_HWLOC) */
+    return 1;
+}
+
+int parsec_hwloc_membind_numa(void *addr, size_t len, int numa_id)
+{
+#if defined(PARSEC_HAVE_HWLOC)
+    hwloc_obj_t node = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NODE, numa_id);
+    if( NULL == node ) return PARSEC_ERR_NOT_FOUND;
+#if HWLOC_API_VERSION >= 0x00020000
+    if( 0 != hwloc_set_area_membind(topology, addr, len, node->nodeset,
+                                     HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_BYNODESET) )
+#else
+    if( 0 != hwloc_set_area_membind_nodeset(topology, addr, len, node->nodeset,
+                                            HWLOC_MEMBIND_BIND, 0) )
+#endif  /* HWLOC_API_VERSION >= 0x00020000 */
+        return PARSEC_ERROR;
+    return PARSEC_SUCCESS;
+#else
+    (void)addr; (void)len; (void)numa_id;
+    return PARSEC_ERR_NOT_IMPLEMENTED;
+#endif  /* defined(PARSEC_HAVE_HWLOC) */
+}
+
 unsigned int parsec_hwloc_nb_cores_per_obj( int level, int index )
 {
 #if defined(PARSEC_HAVE_HWLOC)
@@ -93,6 +93,17 @@ int parsec_hwloc_socket_id(int core_id);
  */
 int parsec_hwloc_numa_id(int core_id);
 
+/**
+ * Return the number of NUMA nodes (1 if the topology is not available).
+ */
+int parsec_hwloc_nb_numa_nodes(void);
+
+/**
+ * Bind the memory pages of [addr, addr+len) to a NUMA node (logical index),
+ * so that they are allocated on this node when first touched.
+ */
+int parsec_hwloc_membind_numa(void *addr, size_t len, int numa_id);
+
 /**
  * Return the depth of the first core hardware ancestor: NUMA node or socket.
  */
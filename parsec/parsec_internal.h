@@ -23,6 +23,7 @@
 #include "parsec/data.h"
 #include "parsec/utils/debug.h"
 #include "parsec/utils/output.h"
+#include "parsec/utils/mem_footprint.h"
 #include "parsec/class/info.h"
 #include "parsec/mca/pins/pins.h"
 
@@ -217,6 +218,32 @@ struct parsec_dependencies_s {
 
 size_t parsec_destruct_dependencies(parsec_dependencies_t* d);
 
+/**
+ * This structure is used when the dependencies of a task class are resolved
+ * as a single flat array of counters, indexed by the tasks parameters
+ * linearized over the bounding box of the local tasks (the last parameter
+ * varies the fastest). The counters start on a cache line, right after this
+ * structure, in the same allocation.
+ */
+typedef struct parsec_flat_dependencies_s {
+    int                  nb_params;
+    int                  min[MAX_PARAM_COUNT];
+    int                  max[MAX_PARAM_COUNT];
+    size_t               stride[MAX_PARAM_COUNT];
+    size_t               size;   /**< Number of counters */
+    parsec_dependency_t *deps;
+} parsec_flat_dependencies_t;
+
+/**
+ * Allocate the flat dependencies of a task class with nb_tasks local tasks,
+ * whose parameters span [min[p], max[p]]. Returns NULL if the bounding box is
+ * too sparse for a flat array (see the runtime_dep_flat_ratio MCA parameter),
+ * in which case the caller should use another dependency tracking mechanism.
+ */
+parsec_flat_dependencies_t *parsec_flat_dependencies_new(int nb_params, const int *min, const int *max,
+                                                         int32_t nb_tasks);
+size_t parsec_flat_dependencies_destruct(parsec_flat_dependencies_t *d);
+
 /**
  * This structure is used when dependencies are resolved using a dynamic
  * hash table
@@ -330,6 +357,8 @@ typedef int (parsec_data_ref_fn_t)(parsec_task_t *task,
 #define PARSEC_IMMEDIATE_TASK             0x0010
 #define PARSEC_USE_DEPS_MASK              0x0020
 #define PARSEC_HAS_CTL_GATHER             0X0040
+#define PARSEC_CHAIN_TASK                 0x0080  /**< Run as the next task of the stream when it is the only local successor */
+#define PARSEC_NO_CHAIN_TASK              0x0100  /**< Never run as the next task of the stream, always go through the scheduler */
 
 #define PARSEC_TASK_CLASS_TYPE_PTG        0x01
 #define PARSEC_TASK_CLASS_TYPE_DTD        0x02
@@ -346,6 +375,9 @@ parsec_dependency_t *parsec_default_find_deps(const parsec_taskpool_t *tp,
 parsec_dependency_t *parsec_hash_find_deps(const parsec_taskpool_t *tp,
                                            parsec_execution_stream_t *es,
                                            const parsec_task_t* task);
+parsec_dependency_t *parsec_flat_find_deps(const parsec_taskpool_t *tp,
+                                           parsec_execution_stream_t *es,
+                                           const parsec_task_t* task);
 typedef int (parsec_update_dependency_fn_t)(parsec_taskpool_t *tp,
                                             const parsec_task_t* restrict task,
                                             parsec_dependency_t *deps,
@@ -457,6 +489,31 @@ PARSEC_DECLSPEC extern int parsec_want_rusage;
  */
 PARSEC_DECLSPEC extern int parsec_runtime_keep_highest_priority_task;
 
+/**
+ * Global configuration variable bounding the number of consecutive tasks an
+ * execution stream runs as its next task (see parsec_execution_stream_t::next_task),
+ * without going through the scheduler. 0 means no bound.
+ */
+PARSEC_DECLSPEC extern int parsec_runtime_chain_max_depth;
+
+/**
+ * Global configuration variables controlling the parking of idle execution
+ * streams. A stream that did not find any task for parsec_runtime_park_spin
+ * microseconds sleeps until new tasks are scheduled on its virtual process,
+ * or for at most parsec_runtime_park_timeout microseconds. A negative spin
+ * budget disables the parking.
+ */
+PARSEC_DECLSPEC extern int parsec_runtime_park_spin;
+PARSEC_DECLSPEC extern int parsec_runtime_park_timeout;
+
+/**
+ * Global configuration variable selecting a scheduler per virtual process
+ * (see parsec_set_scheduler): a comma-separated list of scheduler names, the
+ * last one applying to all the remaining virtual processes. Empty names, or
+ * an empty list, select the default scheduler.
+ */
+PARSEC_DECLSPEC extern char *parsec_runtime_vp_sched;
+
 /**
  * Description of the state of the task. It indicates what will be the next
  * next stage in the life-time of a task to be executed.
@@ -642,7 +699,7 @@ int parsec_task_deps_with_final_output(const parsec_task_t *task,
 
 int32_t parsec_add_fetch_runtime_task( parsec_taskpool_t *tp, int32_t nb_tasks );
 
-void parsec_dependencies_mark_task_as_startup(parsec_task_t* task, parsec_execution_stream_t *es);
+int parsec_dependencies_mark_task_as_startup(parsec_task_t* task, parsec_execution_stream_t *es);
 
 int
 parsec_release_local_OUT_dependencies(parsec_execution_stream_t* es,
@@ -8,6 +8,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "parsec/parsec_mpi_funnelled.h"
 #include "parsec/remote_dep.h"
 #include "parsec/class/parsec_hash_table.h"
@@ -65,44 +66,66 @@ PARSEC_OBJ_CLASS_INSTANCE(mpi_funnelled_mem_reg_handle_t, parsec_list_item_t,
  */
 #define MIN_MPI_TAG (PARSEC_CE_REMOTE_DEP_MAX_CTRL_TAG+1)
 static int MAX_MPI_TAG = -1, mca_tag_ub = -1;
-static volatile int __VAL_NEXT_TAG = MIN_MPI_TAG;
-#if INT_MAX == INT32_MAX
-#define next_tag_cas(t, o, n) parsec_atomic_cas_int32(t, o, n)
-#elif INT_MAX == INT64_MAX
-#define next_tag_cas(t, o, n) parsec_atomic_cas_int64(t, o, n)
-#else
-#error "next_tag_cas written to support sizeof(int) of 4 or 8"
-#endif
-static inline int next_tag(int k) {
-    int __tag, __tag_o, __next_tag;
-reread:
-    __tag = __tag_o = __VAL_NEXT_TAG;
-    if( __tag > (MAX_MPI_TAG-k) ) {
-        PARSEC_DEBUG_VERBOSE(20, parsec_comm_output_stream, "rank %d tag rollover: min %d < %d (+%d) < max %d", parsec_debug_rank,
-                MIN_MPI_TAG, __tag, k, MAX_MPI_TAG);
-        __tag = MIN_MPI_TAG;
-    }
-    __next_tag = __tag+k;
 
-    if( parsec_comm_es.virtual_process->parsec_context->flags & PARSEC_CONTEXT_FLAG_COMM_MT ) {
-        if(!next_tag_cas(&__VAL_NEXT_TAG, __tag_o, __next_tag)) {
-            goto reread;
+/* A tag is released once the transfer it was allocated for has been matched
+ * on both sides, and the released tags are reused before new ones are taken
+ * from [MIN_MPI_TAG, MAX_MPI_TAG]. The range only rolls over if all of its
+ * tags are in flight, or were used by the small PUTs, which do not release
+ * their tags (see mpi_no_thread_put).
+ */
+static parsec_atomic_lock_t mpi_funnelled_tag_lock = PARSEC_ATOMIC_UNLOCKED;
+static int  mpi_funnelled_next_tag = MIN_MPI_TAG;
+static int *mpi_funnelled_free_tags = NULL;
+static int  mpi_funnelled_nb_free_tags = 0;
+static int  mpi_funnelled_size_free_tags = 0;
+
+static int mpi_funnelled_tag_alloc(void)
+{
+    int tag;
+
+    parsec_atomic_lock(&mpi_funnelled_tag_lock);
+    if( mpi_funnelled_nb_free_tags > 0 ) {
+        tag = mpi_funnelled_free_tags[--mpi_funnelled_nb_free_tags];
+    } else {
+        tag = mpi_funnelled_next_tag;
+        if( tag >= MAX_MPI_TAG ) {
+            PARSEC_DEBUG_VERBOSE(20, parsec_comm_output_stream, "rank %d tag rollover: min %d < %d < max %d", parsec_debug_rank,
+                                 MIN_MPI_TAG, tag, MAX_MPI_TAG);
+            mpi_funnelled_next_tag = MIN_MPI_TAG;
+        } else {
+            mpi_funnelled_next_tag = tag + 1;
         }
     }
-    else {
-        __VAL_NEXT_TAG = __next_tag;
+    parsec_atomic_unlock(&mpi_funnelled_tag_lock);
+    assert(tag >= MIN_MPI_TAG);
+    return tag;
+}
+
+static void mpi_funnelled_tag_release(int tag)
+{
+    parsec_atomic_lock(&mpi_funnelled_tag_lock);
+    if( mpi_funnelled_nb_free_tags == mpi_funnelled_size_free_tags ) {
+        mpi_funnelled_size_free_tags = (0 == mpi_funnelled_size_free_tags) ? 64 : 2 * mpi_funnelled_size_free_tags;
+        mpi_funnelled_free_tags = (int*)realloc(mpi_funnelled_free_tags,
+                                                mpi_funnelled_size_free_tags * sizeof(int));
     }
-    return __tag;
+    mpi_funnelled_free_tags[mpi_funnelled_nb_free_tags++] = tag;
+    parsec_atomic_unlock(&mpi_funnelled_tag_lock);
 }
 
 /* Range of index allowed for each type of request.
  * For registered tags, each will get 5 spots in the array of requests.
- * For dynamic tags, there will be a total of MAX_DYNAMIC_REQ_RANGE
- * spots in the same array.
+ * For dynamic tags, the spots at the end of the same array start at
+ * mpi_dynamic_reqs (or at the size reached during the previous use of the
+ * engine, if larger), and grow on demand up to mpi_dynamic_reqs_max.
  */
-#define MAX_DYNAMIC_REQ_RANGE 30 /* according to current implementation */
+#define MAX_DYNAMIC_REQ_RANGE 30 /* default initial number of dynamic spots */
 #define EACH_STATIC_REQ_RANGE 5 /* for each registered tag */
 
+static int mpi_funnelled_dynamic_req_init = MAX_DYNAMIC_REQ_RANGE;
+static int mpi_funnelled_dynamic_req_max  = 1024;
+static int mpi_funnelled_dynamic_req_used = 0;  /* survives the fini, to size the next init */
+
 typedef struct mpi_funnelled_tag_s {
     parsec_ce_tag_t tag; /* tag user wants to register */
     int start_idx; /* Records the starting index for every TAG
@@ -119,6 +142,22 @@ typedef struct mpi_funnelled_tag_s {
 
 static struct mpi_funnelled_tag_s parsec_mpi_funnelled_array_of_registered_tags[PARSEC_MAX_REGISTERED_TAGS];
 
+/* The buffers of the persistent receives are aligned on a cache line, so
+ * that the content of the messages can be aligned too */
+#define MPI_FUNNELLED_AM_ALIGNMENT 64
+
+/* The active message being delivered: its callback can adopt the buffer.
+ * The persistent receive it came from then needs a replacement of renew
+ * bytes (0 if it was set aside, with a buffer of its own). */
+typedef struct mpi_funnelled_am_delivery_s {
+    void   *buf;
+    size_t  renew;
+    void   *replacement;
+    int     adopted;
+} mpi_funnelled_am_delivery_t;
+
+static mpi_funnelled_am_delivery_t *mpi_funnelled_am_delivery = NULL;
+
 typedef enum {
     MPI_FUNNELLED_TYPE_AM       = 0, /* indicating active message */
     MPI_FUNNELLED_TYPE_ONESIDED = 1,  /* indicating one sided */
@@ -135,6 +174,7 @@ typedef struct mpi_funnelled_callback_s {
     void *cb_data; /* callback data */
     mpi_funnelled_callback_type type;
     mpi_funnelled_tag_t *tag;
+    int mpi_tag; /* tag of the data transfer to release on completion, or -1 */
 
     union {
         struct {
@@ -180,8 +220,34 @@ static int count_internal_tag = 0;
 static int parsec_param_enable_mpi_overtake;
 #endif
 
+/* The data of the PUTs larger than that (in bytes) are sent with MPI_Issend
+ * (see mpi_no_thread_put) */
+static int mpi_funnelled_put_sync_limit = 65536;
+
 /* List to hold pending requests */
 parsec_list_t mpi_funnelled_dynamic_req_fifo; /* ordered non threaded fifo */
+
+/* An active message received while the progress thread was waiting for one
+ * of its sends to be matched. It keeps the buffer, the receive was posted
+ * again in a new one, and the message is delivered by the next progress,
+ * before the newer ones.
+ */
+typedef struct mpi_funnelled_deferred_am_s {
+    parsec_list_item_t super;
+    parsec_ce_am_callback_t fct;
+    void *cb_data;
+    int tag;
+    int src;
+    int length;
+    char *msg;
+} mpi_funnelled_deferred_am_t;
+
+static parsec_list_t mpi_funnelled_deferred_am_fifo; /* ordered non threaded fifo */
+
+/* The thread progressing the engine, the only one allowed to touch the
+ * persistent receives */
+static pthread_t mpi_funnelled_progress_thread;
+static int mpi_funnelled_progress_thread_known = 0;
 parsec_mempool_t *mpi_funnelled_dynamic_req_mempool = NULL;
 
 /* This structure is used to save all the information necessary to
@@ -190,7 +256,14 @@ parsec_mempool_t *mpi_funnelled_dynamic_req_mempool = NULL;
 typedef struct mpi_funnelled_dynamic_req_s {
     parsec_list_item_t super;
     parsec_thread_mempool_t *mempool_owner;
-    int post_isend;
+    int post_isend; /* 0: nothing to post, 1: MPI_Isend, 2: MPI_Issend */
+    struct {
+        void *mem;
+        int count;
+        MPI_Datatype datatype;
+        int remote;
+        int tag;
+    } isend;
     MPI_Request request;
     mpi_funnelled_callback_t cb;
 } mpi_funnelled_dynamic_req_t;
@@ -223,6 +296,37 @@ typedef struct mpi_funnelled_handshake_info_s {
 
 } mpi_funnelled_handshake_info_t;
 
+/* Returns 1 if a request can be posted at mpi_funnelled_last_active_req,
+ * after growing the dynamic part of the arrays of requests if it is full,
+ * or 0 if the request has to wait in the dynamic fifo. Beware, growing
+ * moves the arrays.
+ */
+static int mpi_funnelled_reserve_req(void)
+{
+    int i, range, old_size = size_of_total_reqs;
+
+    if( mpi_funnelled_last_active_req < size_of_total_reqs )
+        return 1;
+    range = size_of_total_reqs - mpi_funnelled_static_req_idx;
+    if( range >= mpi_funnelled_dynamic_req_max )
+        return 0;
+    range = (2 * range > mpi_funnelled_dynamic_req_max) ? mpi_funnelled_dynamic_req_max : 2 * range;
+    size_of_total_reqs = mpi_funnelled_static_req_idx + range;
+
+    array_of_callbacks = (mpi_funnelled_callback_t *) realloc(array_of_callbacks, size_of_total_reqs * sizeof(mpi_funnelled_callback_t));
+    array_of_requests  = (MPI_Request *) realloc(array_of_requests, size_of_total_reqs * sizeof(MPI_Request));
+    array_of_indices   = (int *) realloc(array_of_indices, size_of_total_reqs * sizeof(int));
+    array_of_statuses  = (MPI_Status *) realloc(array_of_statuses, size_of_total_reqs * sizeof(MPI_Status));
+    for(i = old_size; i < size_of_total_reqs; i++) {
+        array_of_requests[i] = MPI_REQUEST_NULL;
+    }
+    if( range > mpi_funnelled_dynamic_req_used )
+        mpi_funnelled_dynamic_req_used = range;
+    PARSEC_DEBUG_VERBOSE(10, parsec_comm_output_stream, "rank %d MPI: all the dynamic requests are in flight, growing their range to %d",
+                         parsec_debug_rank, range);
+    return 1;
+}
+
 /* This is the callback that is triggered on the sender side for a
  * GET. In this function we get the TAG on which the receiver has
  * posted an Irecv and using which the sender should post an Isend
@@ -236,7 +340,6 @@ mpi_funnelled_internal_get_am_callback(parsec_comm_engine_t *ce,
                                        void *cb_data)
 {
     (void) ce; (void) tag; (void) msg_size; (void) cb_data;
-    assert(mpi_funnelled_last_active_req < size_of_total_reqs);
 
     mpi_funnelled_callback_t *cb;
     MPI_Request *request;
@@ -250,7 +353,7 @@ mpi_funnelled_internal_get_am_callback(parsec_comm_engine_t *ce,
 
     assert(mpi_funnelled_last_active_req >= mpi_funnelled_static_req_idx);
 
-    int post_in_static_array = mpi_funnelled_last_active_req < size_of_total_reqs;
+    int post_in_static_array = mpi_funnelled_reserve_req();
     mpi_funnelled_dynamic_req_t *item;
 
     if(post_in_static_array) {
@@ -262,6 +365,11 @@ mpi_funnelled_internal_get_am_callback(parsec_comm_engine_t *ce,
     } else {
         item = (mpi_funnelled_dynamic_req_t *)parsec_thread_mempool_allocate(mpi_funnelled_dynamic_req_mempool->thread_mempools);
         item->post_isend = 1;
+        item->isend.mem = remote_memory_handle->mem;
+        item->isend.count = remote_memory_handle->count;
+        item->isend.datatype = remote_memory_handle->datatype;
+        item->isend.remote = src;
+        item->isend.tag = handshake_info->tag;
         request = &item->request;
         cb = &item->cb;
     }
@@ -281,6 +389,7 @@ mpi_funnelled_internal_get_am_callback(parsec_comm_engine_t *ce,
     cb->storage2 = src;
     cb->cb_data  = cb->cb_data;
     cb->tag      = NULL;
+    cb->mpi_tag  = -1;
     cb->type     = MPI_FUNNELLED_TYPE_ONESIDED_MIMIC_AM;
 
     if(post_in_static_array) {
@@ -323,11 +432,8 @@ mpi_funnelled_internal_put_am_callback(parsec_comm_engine_t *ce,
     int _size;
     MPI_Type_size(remote_memory_handle->datatype, &_size);
 
-    int post_in_static_array = 1;
+    int post_in_static_array = mpi_funnelled_reserve_req();
     mpi_funnelled_dynamic_req_t *item;
-    if(!(mpi_funnelled_last_active_req < size_of_total_reqs)) {
-        post_in_static_array = 0;
-    }
 
     if(post_in_static_array) {
         request = &array_of_requests[mpi_funnelled_last_active_req];
@@ -365,6 +471,7 @@ mpi_funnelled_internal_put_am_callback(parsec_comm_engine_t *ce,
     cb->storage2 = src;
     cb->cb_data  = cb->cb_data;
     cb->tag      = NULL;
+    cb->mpi_tag  = -1;
     cb->type     = MPI_FUNNELLED_TYPE_ONESIDED_MIMIC_AM;
 
     if(post_in_static_array) {
@@ -434,6 +541,22 @@ static int mpi_funneled_init_once(parsec_context_t* context)
     parsec_mca_param_reg_int_name("mpi", "tag_ub",
                                   "The upper bound of the TAG used by the MPI communication engine. Bounded by the MPI_TAG_UB attribute on the MPI implementation MPI_COMM_WORLD. (-1 for MPI default)",
                                   false, false, -1, &mca_tag_ub);
+    parsec_mca_param_reg_int_name("mpi", "dynamic_reqs",
+                                  "The initial number of requests for the data transfers in flight. The range grows on demand, "
+                                  "and the next initialization of the communication engine starts with the size it reached.",
+                                  false, false, mpi_funnelled_dynamic_req_init, &mpi_funnelled_dynamic_req_init);
+    parsec_mca_param_reg_int_name("mpi", "dynamic_reqs_max",
+                                  "The maximum number of requests for the data transfers in flight. Additional transfers wait until one completes.",
+                                  false, false, mpi_funnelled_dynamic_req_max, &mpi_funnelled_dynamic_req_max);
+    parsec_mca_param_reg_int_name("mpi", "put_sync_limit",
+                                  "The size in bytes above which the data of a PUT are sent with MPI_Issend, so that their tag "
+                                  "can be reused once the send completes. The smaller PUTs are sent with MPI_Isend, and do not "
+                                  "reuse their tag; this should be the eager limit of the MPI implementation.",
+                                  false, false, mpi_funnelled_put_sync_limit, &mpi_funnelled_put_sync_limit);
+    if( mpi_funnelled_dynamic_req_init < 1 )
+        mpi_funnelled_dynamic_req_init = 1;
+    if( mpi_funnelled_dynamic_req_max < mpi_funnelled_dynamic_req_init )
+        mpi_funnelled_dynamic_req_max = mpi_funnelled_dynamic_req_init;
 
     if( !mpi_tag_ub_exists ) {
         MAX_MPI_TAG = (-1 == mca_tag_ub) ? INT_MAX : mca_tag_ub;
@@ -494,20 +617,25 @@ mpi_funnelled_init(parsec_context_t *context)
         parsec_mpi_funnelled_array_of_registered_tags[i].buf = NULL;
     }
 
-    /* Initialize the arrays */
-    array_of_callbacks = (mpi_funnelled_callback_t *) calloc(MAX_DYNAMIC_REQ_RANGE,
+    /* Initialize the arrays, with the number of dynamic requests observed in
+     * flight during the previous use of the engine */
+    if( mpi_funnelled_dynamic_req_used < mpi_funnelled_dynamic_req_init )
+        mpi_funnelled_dynamic_req_used = mpi_funnelled_dynamic_req_init;
+    if( mpi_funnelled_dynamic_req_used > mpi_funnelled_dynamic_req_max )
+        mpi_funnelled_dynamic_req_used = mpi_funnelled_dynamic_req_max;
+    array_of_callbacks = (mpi_funnelled_callback_t *) calloc(mpi_funnelled_dynamic_req_used,
                             sizeof(mpi_funnelled_callback_t));
-    array_of_requests  = (MPI_Request *) calloc(MAX_DYNAMIC_REQ_RANGE,
+    array_of_requests  = (MPI_Request *) calloc(mpi_funnelled_dynamic_req_used,
                             sizeof(MPI_Request));
-    array_of_indices   = (int *) calloc(MAX_DYNAMIC_REQ_RANGE, sizeof(int));
-    array_of_statuses  = (MPI_Status *) calloc(MAX_DYNAMIC_REQ_RANGE,
+    array_of_indices   = (int *) calloc(mpi_funnelled_dynamic_req_used, sizeof(int));
+    array_of_statuses  = (MPI_Status *) calloc(mpi_funnelled_dynamic_req_used,
                             sizeof(MPI_Status));
 
-    for(i = 0; i < MAX_DYNAMIC_REQ_RANGE; i++) {
+    for(i = 0; i < mpi_funnelled_dynamic_req_used; i++) {
         array_of_requests[i] = MPI_REQUEST_NULL;
     }
 
-    size_of_total_reqs += MAX_DYNAMIC_REQ_RANGE;
+    size_of_total_reqs += mpi_funnelled_dynamic_req_used;
 
     nb_internal_tag = 2;
 
@@ -530,6 +658,7 @@ mpi_funnelled_init(parsec_context_t *context)
     parsec_ce.reshape             = parsec_mpi_sendrecv;
     parsec_ce.can_serve           = mpi_no_thread_can_push_more;
     parsec_ce.send_am             = mpi_no_thread_send_active_message;
+    parsec_ce.am_adopt            = mpi_no_thread_am_adopt;
 
     parsec_ce.parsec_context      = context;
     parsec_ce.capabilites.sided   = 2;
@@ -549,6 +678,7 @@ mpi_funnelled_init(parsec_context_t *context)
     count_internal_tag++;
 
     PARSEC_OBJ_CONSTRUCT(&mpi_funnelled_dynamic_req_fifo, parsec_list_t);
+    PARSEC_OBJ_CONSTRUCT(&mpi_funnelled_deferred_am_fifo, parsec_list_t);
 
     mpi_funnelled_mem_reg_handle_mempool = (parsec_mempool_t*) malloc (sizeof(parsec_mempool_t));
     parsec_mempool_construct(mpi_funnelled_mem_reg_handle_mempool,
@@ -584,7 +714,14 @@ mpi_funnelled_fini(parsec_comm_engine_t *ce)
     free(array_of_indices);   array_of_indices   = NULL;
     free(array_of_statuses);  array_of_statuses  = NULL;
 
+    free(mpi_funnelled_free_tags); mpi_funnelled_free_tags = NULL;
+    mpi_funnelled_nb_free_tags = mpi_funnelled_size_free_tags = 0;
+    mpi_funnelled_next_tag = MIN_MPI_TAG;
+
     PARSEC_OBJ_DESTRUCT(&mpi_funnelled_dynamic_req_fifo);
+    assert(parsec_list_nolock_is_empty(&mpi_funnelled_deferred_am_fifo));
+    PARSEC_OBJ_DESTRUCT(&mpi_funnelled_deferred_am_fifo);
+    mpi_funnelled_progress_thread_known = 0;
 
     parsec_mempool_destruct(mpi_funnelled_mem_reg_handle_mempool);
     free(mpi_funnelled_mem_reg_handle_mempool); mpi_funnelled_mem_reg_handle_mempool = NULL;
@@ -638,6 +775,7 @@ mpi_no_thread_tag_register(parsec_ce_tag_t tag,
         return PARSEC_ERR_EXISTS;
     }
 
+    int dynamic_req_range = size_of_total_reqs - mpi_funnelled_static_req_idx;
     size_of_total_reqs += EACH_STATIC_REQ_RANGE;
 
     array_of_indices = realloc(array_of_indices, size_of_total_reqs * sizeof(int));
@@ -653,19 +791,18 @@ mpi_no_thread_tag_register(parsec_ce_tag_t tag,
     /* Leaving "EACH_STATIC_REQ_RANGE" number elements in the middle and copying
      * the rest for the dynamic tag messages.
      */
-    memcpy(tmp_array_cb + mpi_funnelled_static_req_idx + EACH_STATIC_REQ_RANGE, array_of_callbacks + mpi_funnelled_static_req_idx, sizeof(mpi_funnelled_callback_t) * MAX_DYNAMIC_REQ_RANGE);
+    memcpy(tmp_array_cb + mpi_funnelled_static_req_idx + EACH_STATIC_REQ_RANGE, array_of_callbacks + mpi_funnelled_static_req_idx, sizeof(mpi_funnelled_callback_t) * dynamic_req_range);
     free(array_of_callbacks);
     array_of_callbacks = tmp_array_cb;
 
     /* Same procedure followed as array_of_callbacks. */
     MPI_Request *tmp_array_req = malloc(sizeof(MPI_Request) * size_of_total_reqs);
     memcpy(tmp_array_req, array_of_requests, sizeof(MPI_Request) * mpi_funnelled_static_req_idx);
-    memcpy(tmp_array_req + mpi_funnelled_static_req_idx +  EACH_STATIC_REQ_RANGE, array_of_requests + mpi_funnelled_static_req_idx, sizeof(MPI_Request) * MAX_DYNAMIC_REQ_RANGE);
+    memcpy(tmp_array_req + mpi_funnelled_static_req_idx +  EACH_STATIC_REQ_RANGE, array_of_requests + mpi_funnelled_static_req_idx, sizeof(MPI_Request) * dynamic_req_range);
     free(array_of_requests);
     array_of_requests = tmp_array_req;
 
     char **buf = (char **) calloc(EACH_STATIC_REQ_RANGE, sizeof(char *));
-    buf[0] = (char*)calloc(EACH_STATIC_REQ_RANGE, msg_length * sizeof(char));
 
     tag_struct->tag = tag;
     tag_struct->buf = buf;
@@ -673,7 +810,10 @@ mpi_no_thread_tag_register(parsec_ce_tag_t tag,
     tag_struct->msg_length = msg_length;
 
     for(int i = 0; i < EACH_STATIC_REQ_RANGE; i++) {
-        buf[i] = buf[0] + i * msg_length * sizeof(char);
+        /* Each buffer on its own, they can be adopted by the callbacks */
+        if( 0 != posix_memalign((void**)&buf[i], MPI_FUNNELLED_AM_ALIGNMENT, msg_length) ) {
+            parsec_fatal("Failed to allocate the buffers of the tag %d", (int)tag);
+        }
 
         /* Even though the address of array_of_requests changes after every
          * new registration of tags, the initialization of the requests will
@@ -689,13 +829,14 @@ mpi_no_thread_tag_register(parsec_ce_tag_t tag,
         cb->storage2 = i;
         cb->cb_data  = cb_data;
         cb->tag      = tag_struct;
+        cb->mpi_tag  = -1;
         cb->type     = MPI_FUNNELLED_TYPE_AM;
         mpi_funnelled_static_req_idx++;
     }
     /* Tag ready to receive data, start all persistent receives */
     MPI_Startall(EACH_STATIC_REQ_RANGE, &array_of_requests[mpi_funnelled_static_req_idx - EACH_STATIC_REQ_RANGE]);
 
-    assert((mpi_funnelled_static_req_idx + MAX_DYNAMIC_REQ_RANGE) == size_of_total_reqs);
+    assert((mpi_funnelled_static_req_idx + dynamic_req_range) == size_of_total_reqs);
 
     mpi_funnelled_last_active_req += EACH_STATIC_REQ_RANGE;
 
@@ -725,7 +866,9 @@ mpi_no_thread_tag_unregister(parsec_ce_tag_t tag)
         assert( MPI_REQUEST_NULL == array_of_requests[i] );
     }
 
-    free(tag_struct->buf[0]);
+    for(i = 0; i < EACH_STATIC_REQ_RANGE; i++) {
+        free(tag_struct->buf[i]);
+    }
     free(tag_struct->buf);
 
     return 1;
@@ -800,15 +943,12 @@ mpi_no_thread_put(parsec_comm_engine_t *ce,
                   parsec_ce_onesided_callback_t l_cb, void *l_cb_data,
                   parsec_ce_tag_t r_tag, void *r_cb_data, size_t r_cb_data_size)
 {
-    assert(mpi_funnelled_last_active_req < size_of_total_reqs);
-
     (void)r_cb_data; (void) size;
 
     mpi_funnelled_callback_t *cb;
     MPI_Request *request;
 
-    int tag = next_tag(1);
-    assert(tag >= MIN_MPI_TAG);
+    int tag = mpi_funnelled_tag_alloc();
 
     mpi_funnelled_mem_reg_handle_t *source_memory_handle = (mpi_funnelled_mem_reg_handle_t *) lreg;
     mpi_funnelled_mem_reg_handle_t *remote_memory_handle = (mpi_funnelled_mem_reg_handle_t *) rreg;
@@ -846,21 +986,38 @@ mpi_no_thread_put(parsec_comm_engine_t *ce,
     /*MPI_Isend((char *)ldata->mem + ldispl, ldata->size, MPI_BYTE, remote, tag, comm,
               &array_of_requests[mpi_funnelled_last_active_req]);*/
 
-    int post_in_static_array = 1;
+    int post_in_static_array = mpi_funnelled_reserve_req();
     mpi_funnelled_dynamic_req_t *item;
-    if(!(mpi_funnelled_last_active_req < size_of_total_reqs)) {
-        post_in_static_array = 0;
-    }
-
+    int type_size, sync;
+
+    /* The completion of a send tells that the receiver matched it, and the
+     * tag can be reused, only if the send is synchronous: the receiver can
+     * handle the handshakes of two PUTs out of order, and post their receives
+     * on the same tag in the wrong order. Below the eager limit of MPI,
+     * MPI_Issend costs an acknowledgement that MPI_Isend does not, so the
+     * small PUTs are sent with MPI_Isend and their tag is not reused. */
+    MPI_Type_size(source_memory_handle->datatype, &type_size);
+    sync = ((int64_t)source_memory_handle->count * type_size > mpi_funnelled_put_sync_limit);
     if(post_in_static_array) {
         request = &array_of_requests[mpi_funnelled_last_active_req];
         cb = &array_of_callbacks[mpi_funnelled_last_active_req];
-        MPI_Isend((char *)source_memory_handle->mem + ldispl, source_memory_handle->count,
-                  source_memory_handle->datatype, remote, tag, dep_comm,
-                  request);
+        if( sync ) {
+            MPI_Issend((char *)source_memory_handle->mem + ldispl, source_memory_handle->count,
+                       source_memory_handle->datatype, remote, tag, dep_comm,
+                       request);
+        } else {
+            MPI_Isend((char *)source_memory_handle->mem + ldispl, source_memory_handle->count,
+                      source_memory_handle->datatype, remote, tag, dep_comm,
+                      request);
+        }
     } else {
         item = (mpi_funnelled_dynamic_req_t *)parsec_thread_mempool_allocate(mpi_funnelled_dynamic_req_mempool->thread_mempools);
-        item->post_isend = 1;
+        item->post_isend = sync ? 2 : 1;
+        item->isend.mem = (char *)source_memory_handle->mem + ldispl;
+        item->isend.count = source_memory_handle->count;
+        item->isend.datatype = source_memory_handle->datatype;
+        item->isend.remote = remote;
+        item->isend.tag = tag;
         request = &item->request;
         cb = &item->cb;
     }
@@ -876,6 +1033,7 @@ mpi_no_thread_put(parsec_comm_engine_t *ce,
     cb->cb_type.onesided.size = tag; /* This should be taken care of */
     cb->cb_type.onesided.remote = remote;
     cb->tag  = NULL;
+    cb->mpi_tag = sync ? tag : -1;
     cb->type = MPI_FUNNELLED_TYPE_ONESIDED;
 
     if(post_in_static_array) {
@@ -908,7 +1066,9 @@ mpi_no_thread_get(parsec_comm_engine_t *ce,
     mpi_funnelled_callback_t *cb;
     MPI_Request *request;
 
-    int tag = next_tag(1);
+    /* The tag is released when the receive completes, the sender can only
+     * reuse it after we send it again */
+    int tag = mpi_funnelled_tag_alloc();
 
     mpi_funnelled_mem_reg_handle_t *source_memory_handle = (mpi_funnelled_mem_reg_handle_t *) lreg;
     mpi_funnelled_mem_reg_handle_t *remote_memory_handle = (mpi_funnelled_mem_reg_handle_t *) rreg;
@@ -943,11 +1103,8 @@ mpi_no_thread_get(parsec_comm_engine_t *ce,
 
     assert(mpi_funnelled_last_active_req >= mpi_funnelled_static_req_idx);
 
-    int post_in_static_array = 1;
+    int post_in_static_array = mpi_funnelled_reserve_req();
     mpi_funnelled_dynamic_req_t *item;
-    if(!(mpi_funnelled_last_active_req < size_of_total_reqs)) {
-        post_in_static_array = 0;
-    }
 
     if(post_in_static_array) {
         request = &array_of_requests[mpi_funnelled_last_active_req];
@@ -974,6 +1131,7 @@ mpi_no_thread_get(parsec_comm_engine_t *ce,
     cb->cb_type.onesided.size = size;
     cb->cb_type.onesided.remote = remote;
     cb->tag      = NULL;
+    cb->mpi_tag  = tag;
     cb->type     = MPI_FUNNELLED_TYPE_ONESIDED;
 
     if(post_in_static_array) {
@@ -990,6 +1148,89 @@ mpi_no_thread_get(parsec_comm_engine_t *ce,
     return 1;
 }
 
+/* Post the persistent receive req of the tag again, in a new buffer */
+static void
+mpi_funnelled_am_renew(long req, mpi_funnelled_tag_t *tag_struct, long i, void *buf)
+{
+    tag_struct->buf[i] = buf;
+    MPI_Request_free(&array_of_requests[req]);
+    MPI_Recv_init(buf, tag_struct->msg_length, MPI_BYTE,
+                  MPI_ANY_SOURCE, tag_struct->tag, dep_comm,
+                  &array_of_requests[req]);
+}
+
+/* Call the callback of an active message, that can adopt its buffer */
+static int
+mpi_funnelled_am_deliver(parsec_comm_engine_t *ce, parsec_ce_am_callback_t fct, void *cb_data,
+                         int tag, int src, int length, mpi_funnelled_am_delivery_t *delivery)
+{
+    /* the callbacks could progress the engine, and deliver others */
+    mpi_funnelled_am_delivery_t *outer = mpi_funnelled_am_delivery;
+    int ret;
+
+    mpi_funnelled_am_delivery = delivery;
+    ret = fct(ce, tag, delivery->buf, length, src, cb_data);
+    mpi_funnelled_am_delivery = outer;
+    return ret;
+}
+
+/* Set aside the active messages received on the persistent requests, and
+ * post the receives again. Only the progress thread can call it. */
+static void
+mpi_funnelled_defer_am(int *indices, MPI_Status *statuses)
+{
+    mpi_funnelled_deferred_am_t *am;
+    mpi_funnelled_callback_t *cb;
+    int idx, outcount, length;
+    void *buf = NULL;
+
+    MPI_Testsome(mpi_funnelled_static_req_idx, array_of_requests,
+                 &outcount, indices, statuses);
+    if( MPI_UNDEFINED == outcount ) return;
+    for( idx = 0; idx < outcount; idx++ ) {
+        cb = &array_of_callbacks[indices[idx]];
+        assert(MPI_FUNNELLED_TYPE_AM == cb->type);
+        MPI_Get_count(&statuses[idx], MPI_PACKED, &length);
+
+        am = (mpi_funnelled_deferred_am_t*)malloc(sizeof(mpi_funnelled_deferred_am_t));
+        if( 0 != posix_memalign(&buf, MPI_FUNNELLED_AM_ALIGNMENT, cb->tag->msg_length) ) {
+            parsec_fatal("Failed to allocate a buffer for the tag %d", (int)cb->tag->tag);
+        }
+        PARSEC_OBJ_CONSTRUCT(&am->super, parsec_list_item_t);
+        am->fct     = cb->cb_type.am.fct;
+        am->cb_data = cb->cb_data;
+        am->tag     = statuses[idx].MPI_TAG;
+        am->src     = statuses[idx].MPI_SOURCE;
+        am->length  = length;
+        am->msg     = cb->tag->buf[cb->storage2];
+        parsec_list_nolock_push_back(&mpi_funnelled_deferred_am_fifo, &am->super);
+
+        mpi_funnelled_am_renew(indices[idx], cb->tag, cb->storage2, buf);
+        MPI_Start(&array_of_requests[indices[idx]]);
+    }
+}
+
+/* Deliver the active messages set aside while the progress thread was
+ * sending */
+static int
+mpi_funnelled_serve_deferred_am(parsec_comm_engine_t *ce)
+{
+    mpi_funnelled_deferred_am_t *am;
+    int ret = 0;
+
+    while( NULL != (am = (mpi_funnelled_deferred_am_t*)parsec_list_nolock_pop_front(&mpi_funnelled_deferred_am_fifo)) ) {
+        mpi_funnelled_am_delivery_t delivery = { .buf = am->msg, .renew = 0, .replacement = NULL, .adopted = 0 };
+        if( NULL != am->fct )
+            mpi_funnelled_am_deliver(ce, am->fct, am->cb_data, am->tag, am->src, am->length, &delivery);
+        if( !delivery.adopted )
+            free(am->msg);
+        PARSEC_OBJ_DESTRUCT(&am->super);
+        free(am);
+        ret++;
+    }
+    return ret;
+}
+
 int
 mpi_no_thread_send_active_message(parsec_comm_engine_t *ce,
                                   parsec_ce_tag_t tag,
@@ -998,14 +1239,55 @@ mpi_no_thread_send_active_message(parsec_comm_engine_t *ce,
 {
     (void) ce;
     mpi_funnelled_tag_t *tag_struct = &parsec_mpi_funnelled_array_of_registered_tags[tag];
+    MPI_Request request;
+    MPI_Status *statuses;
+    int *indices, flag;
     assert(tag_struct->msg_length >= size);
     (void) tag_struct;
 
-    MPI_Send(addr, size, MPI_BYTE, remote, tag, dep_comm);
+    if( !mpi_funnelled_progress_thread_known ||
+        !pthread_equal(mpi_funnelled_progress_thread, pthread_self()) ) {
+        /* the progress thread keeps receiving meanwhile */
+        MPI_Send(addr, size, MPI_BYTE, remote, tag, dep_comm);
+        return 1;
+    }
+
+    /* A message too large to be buffered by MPI is only sent once the peer
+     * matches it. The peer could be sending to us at the same time, so keep
+     * receiving to avoid both of us waiting for the other. */
+    MPI_Isend(addr, size, MPI_BYTE, remote, tag, dep_comm, &request);
+    MPI_Test(&request, &flag, MPI_STATUS_IGNORE);
+    if( flag ) return 1;
+
+    indices  = (int*)malloc(mpi_funnelled_static_req_idx * sizeof(int));
+    statuses = (MPI_Status*)malloc(mpi_funnelled_static_req_idx * sizeof(MPI_Status));
+    do {
+        mpi_funnelled_defer_am(indices, statuses);
+        MPI_Test(&request, &flag, MPI_STATUS_IGNORE);
+    } while( !flag );
+    free(indices);
+    free(statuses);
 
     return 1;
 }
 
+/* The buffer of an active message can be adopted during its callback. The
+ * persistent receive it came from is posted again in a new buffer. */
+void *
+mpi_no_thread_am_adopt(parsec_comm_engine_t *ce, void *msg)
+{
+    mpi_funnelled_am_delivery_t *delivery = mpi_funnelled_am_delivery;
+    (void) ce;
+
+    if( (NULL == delivery) || delivery->adopted || (msg != delivery->buf) )
+        return NULL;
+    if( (0 != delivery->renew) &&
+        (0 != posix_memalign(&delivery->replacement, MPI_FUNNELLED_AM_ALIGNMENT, delivery->renew)) )
+        return NULL;
+    delivery->adopted = 1;
+    return msg;
+}
+
 /* Common function to serve callbacks of completed request */
 int
 mpi_no_thread_serve_cb(parsec_comm_engine_t *ce, mpi_funnelled_callback_t *cb,
@@ -1013,17 +1295,30 @@ mpi_no_thread_serve_cb(parsec_comm_engine_t *ce, mpi_funnelled_callback_t *cb,
                        int reset)
 {
     int ret = 0;
+    /* The callbacks can post new requests, and grow (thus move) the arrays
+     * holding cb: nothing can be read from it after the callback. */
     if(cb->type == MPI_FUNNELLED_TYPE_AM) {
+        long storage1 = cb->storage1, storage2 = cb->storage2;
+        mpi_funnelled_tag_t *tag_struct = cb->tag;
+        mpi_funnelled_am_delivery_t delivery = { .buf = buf, .renew = tag_struct->msg_length,
+                                                 .replacement = NULL, .adopted = 0 };
         if(cb->cb_type.am.fct != NULL) {
-            ret = cb->cb_type.am.fct(ce, mpi_tag, buf, length,
-                                     mpi_source, cb->cb_data);
+            ret = mpi_funnelled_am_deliver(ce, cb->cb_type.am.fct, cb->cb_data,
+                                           mpi_tag, mpi_source, length, &delivery);
+        }
+        if(delivery.adopted) {
+            /* The callback kept the buffer, receive in the new one */
+            mpi_funnelled_am_renew(storage1, tag_struct, storage2, delivery.replacement);
         }
         /* this is a persistent request, let's reset it if reset variable is ON */
         if(reset) {
             /* Let's re-enable the pending request in the same position */
-            MPI_Start(&array_of_requests[cb->storage1]);
+            MPI_Start(&array_of_requests[storage1]);
         }
     } else if(cb->type == MPI_FUNNELLED_TYPE_ONESIDED) {
+        if(-1 != cb->mpi_tag) {
+            mpi_funnelled_tag_release(cb->mpi_tag);
+        }
         if(cb->cb_type.onesided.fct != NULL) {
             ret = cb->cb_type.onesided.fct(ce, cb->cb_type.onesided.lreg,
                                            cb->cb_type.onesided.ldispl,
@@ -1035,9 +1330,10 @@ mpi_no_thread_serve_cb(parsec_comm_engine_t *ce, mpi_funnelled_callback_t *cb,
         }
     } else if (cb->type == MPI_FUNNELLED_TYPE_ONESIDED_MIMIC_AM) {
         if(cb->cb_type.onesided_mimic_am.fct != NULL) {
-            ret = cb->cb_type.onesided_mimic_am.fct(ce, mpi_tag, cb->cb_type.onesided_mimic_am.msg,
+            void *msg = cb->cb_type.onesided_mimic_am.msg;
+            ret = cb->cb_type.onesided_mimic_am.fct(ce, mpi_tag, msg,
                                      length, mpi_source, cb->cb_data);
-            free(cb->cb_type.onesided_mimic_am.msg);
+            free(msg);
         }
     } else {
         /* We only have three types */
@@ -1066,6 +1362,7 @@ mpi_no_thread_push_posted_req(parsec_comm_engine_t *ce)
     array_of_callbacks[mpi_funnelled_last_active_req].cb_data = item->cb.cb_data;
     array_of_callbacks[mpi_funnelled_last_active_req].type = item->cb.type;
     array_of_callbacks[mpi_funnelled_last_active_req].tag = item->cb.tag;
+    array_of_callbacks[mpi_funnelled_last_active_req].mpi_tag = item->cb.mpi_tag;
 
     if(item->cb.type == MPI_FUNNELLED_TYPE_ONESIDED) {
         array_of_callbacks[mpi_funnelled_last_active_req].cb_type.onesided.fct    = item->cb.cb_type.onesided.fct;
@@ -1085,11 +1382,14 @@ mpi_no_thread_push_posted_req(parsec_comm_engine_t *ce)
         assert(0);
     }
 
-    if(item->post_isend) {
-        mpi_funnelled_mem_reg_handle_t *ldata = (mpi_funnelled_mem_reg_handle_t *) item->cb.cb_type.onesided.lreg;
-        MPI_Isend((char *)ldata->mem + item->cb.cb_type.onesided.ldispl, ldata->count,
-                  ldata->datatype, item->cb.cb_type.onesided.remote, item->cb.cb_type.onesided.size, dep_comm,
+    if(1 == item->post_isend) {
+        MPI_Isend(item->isend.mem, item->isend.count, item->isend.datatype,
+                  item->isend.remote, item->isend.tag, dep_comm,
                   &array_of_requests[mpi_funnelled_last_active_req]);
+    } else if(2 == item->post_isend) {
+        MPI_Issend(item->isend.mem, item->isend.count, item->isend.datatype,
+                   item->isend.remote, item->isend.tag, dep_comm,
+                   &array_of_requests[mpi_funnelled_last_active_req]);
     }
 
     mpi_funnelled_last_active_req++;
@@ -1107,7 +1407,12 @@ mpi_no_thread_progress(parsec_comm_engine_t *ce)
     mpi_funnelled_callback_t *cb;
     int length;
 
+    mpi_funnelled_progress_thread = pthread_self();
+    mpi_funnelled_progress_thread_known = 1;
     do {
+        /* The messages received while sending are older than the next ones */
+        ret += mpi_funnelled_serve_deferred_am(ce);
+
         MPI_Testsome(mpi_funnelled_last_active_req, array_of_requests,
                      &outcount, array_of_indices, array_of_statuses);
 
@@ -1223,6 +1528,7 @@ mpi_no_thread_can_push_more(parsec_comm_engine_t *ce)
     }
 #endif
 
-    /* Do we have room to post more requests? */
-    return mpi_funnelled_last_active_req < size_of_total_reqs;
+    /* Do we have room to post more requests, or can we make some? */
+    return (mpi_funnelled_last_active_req < size_of_total_reqs) ||
+           (size_of_total_reqs - mpi_funnelled_static_req_idx < mpi_funnelled_dynamic_req_max);
 }
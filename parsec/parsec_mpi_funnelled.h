@@ -57,6 +57,8 @@ int mpi_no_thread_send_active_message(parsec_comm_engine_t *comm_engine,
                                       int remote,
                                       void *addr, size_t size);
 
+void *mpi_no_thread_am_adopt(parsec_comm_engine_t *comm_engine, void *msg);
+
 int mpi_no_thread_progress(parsec_comm_engine_t *comm_engine);
 
 int mpi_no_thread_enable(parsec_comm_engine_t *comm_engine);
@@ -0,0 +1,906 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/parsec_config.h"
+
+#include <mpi.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/prctl.h>
+#include "parsec/parsec_shm_engine.h"
+#include "parsec/remote_dep.h"
+#include "parsec/mempool.h"
+#include "parsec/class/list.h"
+#include "parsec/execution_stream.h"
+#include "parsec/sys/atomic.h"
+#include "parsec/utils/debug.h"
+#include "parsec/utils/mca_param.h"
+
+/*
+ * The processes of a node exchange their active messages through a shared
+ * segment holding one ring for each ordered pair of processes. Each ring has
+ * a single consumer, the communication thread of the receiver, and a single
+ * producer at a time: the sends are serialized by a lock, as the threads
+ * computing the tasks send the activations themselves when the communication
+ * engine is multithreaded. The producer publishes its records by moving the
+ * head, and the consumer gives their room back by moving the tail.
+ *
+ * The data are not copied through the segment: the sender exposes the
+ * address of the data in an active message, and the receiver reads them
+ * directly from the address space of the sender (Cross Memory Attach). The
+ * receiver then acknowledges the transfer, so that the sender can release
+ * the data.
+ */
+
+/* Tags above the range of the registered tags are internal to the engine */
+#define SHM_ENGINE_TAG_SKIP     (PARSEC_MAX_REGISTERED_TAGS + 0)  /* padding up to the end of a ring */
+#define SHM_ENGINE_TAG_PUT      (PARSEC_MAX_REGISTERED_TAGS + 1)  /* data exposed to the receiver */
+#define SHM_ENGINE_TAG_PUT_ACK  (PARSEC_MAX_REGISTERED_TAGS + 2)  /* data read by the receiver */
+#define SHM_ENGINE_TAG_GET      (PARSEC_MAX_REGISTERED_TAGS + 3)  /* data requested by the receiver */
+
+#define SHM_ENGINE_CACHE_LINE        64
+#define SHM_ENGINE_MIN_RING_SIZE     4096
+#define SHM_ENGINE_DEFAULT_RING_SIZE (64 * 1024)
+
+/* Header of each record of a ring. The records are aligned on the size of
+ * the header, so that the payloads are suitably aligned for any type. */
+typedef struct shm_engine_msg_hdr_s {
+    uint64_t tag;
+    uint64_t size;  /* of the payload, or of the padding for SKIP */
+} shm_engine_msg_hdr_t;
+
+#define SHM_ENGINE_RECORD_SIZE(s) \
+    ((sizeof(shm_engine_msg_hdr_t) + (s) + sizeof(shm_engine_msg_hdr_t) - 1) & ~(sizeof(shm_engine_msg_hdr_t) - 1))
+
+/* Both counters count the bytes since the creation of the ring, the head is
+ * only written by the producer and the tail by the consumer. They are kept
+ * on separate cache lines. */
+typedef struct shm_engine_ring_ctrl_s {
+    volatile uint64_t head;
+    char              pad0[SHM_ENGINE_CACHE_LINE - sizeof(uint64_t)];
+    volatile uint64_t tail;
+    char              pad1[SHM_ENGINE_CACHE_LINE - sizeof(uint64_t)];
+} shm_engine_ring_ctrl_t;
+
+typedef struct shm_engine_ring_s {
+    shm_engine_ring_ctrl_t *ctrl;
+    char                   *data;
+} shm_engine_ring_t;
+
+/* A message that found no room in its ring, waiting for the consumer */
+typedef struct shm_engine_pending_msg_s {
+    parsec_list_item_t super;
+    uint64_t           tag;
+    size_t             size;
+    char               data[];
+} shm_engine_pending_msg_t;
+
+typedef struct shm_engine_peer_s {
+    int               rank;     /* in the communicator of the context */
+    pid_t             pid;
+    parsec_atomic_lock_t out_lock;  /* serializes the producers of out and pending */
+    shm_engine_ring_t out;      /* messages to this peer */
+    shm_engine_ring_t in;       /* messages from this peer */
+    parsec_list_t     pending;  /* messages to this peer waiting for room in out */
+} shm_engine_peer_t;
+
+/* Memory handles, opaque to upper layers. Same layout as the handles of the
+ * MPI engine: the upper layer exchanges them as is. */
+typedef struct shm_engine_mem_reg_handle_s {
+    parsec_list_item_t        super;
+    parsec_thread_mempool_t *mempool_owner;
+    void *self;
+    void *mem;
+    parsec_datatype_t datatype;
+    int count;
+} shm_engine_mem_reg_handle_t;
+
+PARSEC_OBJ_CLASS_INSTANCE(shm_engine_mem_reg_handle_t, parsec_list_item_t,
+                          NULL, NULL);
+
+/* A transfer in flight, on the process that exposes the data (completed by
+ * the PUT_ACK) or on the process that reads them for a GET (completed once
+ * read).
+ */
+typedef struct shm_engine_req_s {
+    void                         *staging;  /* packed copy of a non dense layout */
+    parsec_ce_onesided_callback_t l_cb;
+    void                         *l_cb_data;
+    parsec_ce_mem_reg_handle_t    lreg;
+    ptrdiff_t                     ldispl;
+    parsec_ce_mem_reg_handle_t    rreg;
+    ptrdiff_t                     rdispl;
+    size_t                        size;
+    int                           remote;
+    parsec_ce_am_callback_t       r_cb;     /* owner of the data of a GET */
+    size_t                        r_cb_data_size;
+    char                          r_cb_data[];
+} shm_engine_req_t;
+
+/* Wire format of the internal messages. The callbacks and requests are
+ * pointers in the process that created them, and only used there. */
+typedef struct shm_engine_put_msg_s {
+    uint64_t addr;          /* of the data, in the sender */
+    uint64_t bytes;
+    uint64_t sender_req;    /* returned with the PUT_ACK */
+    uint64_t rreg;          /* memory handle of the receiver, for a PUT */
+    int64_t  rdispl;
+    uint64_t r_cb;          /* callback of the receiver, for a PUT */
+    uint64_t receiver_req;  /* request of the receiver for a GET, 0 for a PUT */
+} shm_engine_put_msg_t;     /* followed by the callback data of a PUT */
+
+typedef struct shm_engine_get_msg_s {
+    uint64_t owner_reg;     /* memory handle of the owner of the data */
+    int64_t  owner_displ;
+    uint64_t receiver_req;
+    uint64_t r_cb;          /* callback of the owner, once the data are read */
+} shm_engine_get_msg_t;     /* followed by the callback data of the owner */
+
+typedef struct shm_engine_tag_s {
+    parsec_ce_am_callback_t cb;
+    void                   *cb_data;
+    size_t                  msg_length;
+} shm_engine_tag_t;
+
+static parsec_comm_engine_t shm_engine;
+static shm_engine_tag_t shm_engine_tags[PARSEC_MAX_REGISTERED_TAGS];
+static parsec_mempool_t *shm_engine_mem_reg_handle_mempool = NULL;
+
+static int shm_engine_up = -1;  /* -1: not initialized, 0: disabled, 1: enabled */
+static int shm_engine_instance = 0;
+static MPI_Comm shm_node_comm = MPI_COMM_NULL;
+static int shm_nb_local = 0, shm_local_rank = -1;
+static int *shm_peer_of_rank = NULL;  /* index in shm_peers, or -1 if not on this node */
+static shm_engine_peer_t *shm_peers = NULL;
+static void *shm_segment = NULL;
+static size_t shm_segment_size = 0, shm_ring_size = 0;
+static volatile int32_t shm_nb_pending = 0;  /* messages waiting for room in a ring */
+static int shm_in_progress = 0;
+
+/* Read by the other processes of the node, to check they can */
+static const uint64_t shm_engine_probe = 0x7061727365637368ULL;
+
+static int shm_engine_tag_register(parsec_ce_tag_t tag, parsec_ce_am_callback_t cb,
+                                   void *cb_data, size_t msg_length);
+static int shm_engine_tag_unregister(parsec_ce_tag_t tag);
+static int shm_engine_mem_register(void *mem, parsec_mem_type_t mem_type,
+                                   size_t count, parsec_datatype_t datatype,
+                                   size_t mem_size,
+                                   parsec_ce_mem_reg_handle_t *lreg,
+                                   size_t *lreg_size);
+static int shm_engine_mem_unregister(parsec_ce_mem_reg_handle_t *lreg);
+static int shm_engine_get_mem_reg_handle_size(void);
+static int shm_engine_mem_retrieve(parsec_ce_mem_reg_handle_t lreg, void **mem,
+                                   parsec_datatype_t *datatype, int *count);
+static int shm_engine_put(parsec_comm_engine_t *ce,
+                          parsec_ce_mem_reg_handle_t lreg, ptrdiff_t ldispl,
+                          parsec_ce_mem_reg_handle_t rreg, ptrdiff_t rdispl,
+                          size_t size, int remote,
+                          parsec_ce_onesided_callback_t l_cb, void *l_cb_data,
+                          parsec_ce_tag_t r_tag, void *r_cb_data, size_t r_cb_data_size);
+static int shm_engine_get(parsec_comm_engine_t *ce,
+                          parsec_ce_mem_reg_handle_t lreg, ptrdiff_t ldispl,
+                          parsec_ce_mem_reg_handle_t rreg, ptrdiff_t rdispl,
+                          size_t size, int remote,
+                          parsec_ce_onesided_callback_t l_cb, void *l_cb_data,
+                          parsec_ce_tag_t r_tag, void *r_cb_data, size_t r_cb_data_size);
+static int shm_engine_send_active_message(parsec_comm_engine_t *ce, parsec_ce_tag_t tag,
+                                          int remote, void *addr, size_t size);
+static int shm_engine_progress(parsec_comm_engine_t *ce);
+static int shm_engine_enable(parsec_comm_engine_t *ce);
+static int shm_engine_disable(parsec_comm_engine_t *ce);
+static int shm_engine_can_serve(parsec_comm_engine_t *ce);
+
+/* Writes a record made of two parts in the ring, if there is room for it */
+static int
+shm_engine_ring_write(shm_engine_ring_t *ring, uint64_t tag,
+                      const void *p1, size_t s1, const void *p2, size_t s2)
+{
+    size_t rec = SHM_ENGINE_RECORD_SIZE(s1 + s2), off, contig;
+    uint64_t head = ring->ctrl->head, tail = ring->ctrl->tail;
+    shm_engine_msg_hdr_t *hdr;
+
+    /* The consumer is done with the records before the tail we read */
+    parsec_mfence();
+    off = head & (shm_ring_size - 1);
+    contig = shm_ring_size - off;
+    if( ((contig < rec) ? (contig + rec) : rec) > (shm_ring_size - (head - tail)) )
+        return 0;
+    if( contig < rec ) {
+        /* No room before the end of the ring, skip to its beginning */
+        hdr = (shm_engine_msg_hdr_t*)(ring->data + off);
+        hdr->tag  = SHM_ENGINE_TAG_SKIP;
+        hdr->size = contig;
+        head += contig;
+        off = 0;
+    }
+    hdr = (shm_engine_msg_hdr_t*)(ring->data + off);
+    hdr->tag  = tag;
+    hdr->size = s1 + s2;
+    memcpy(hdr + 1, p1, s1);
+    if( 0 != s2 )
+        memcpy((char*)(hdr + 1) + s1, p2, s2);
+    /* The record is complete before it is published */
+    parsec_atomic_wmb();
+    ring->ctrl->head = head + rec;
+    return 1;
+}
+
+/* Sends a message made of two parts to a peer, in order with the previous
+ * messages to the same peer. Never blocks: the messages that find no room
+ * in the ring are kept until the progress finds some. */
+static void
+shm_engine_send(shm_engine_peer_t *peer, uint64_t tag,
+                const void *p1, size_t s1, const void *p2, size_t s2)
+{
+    shm_engine_pending_msg_t *msg;
+
+    parsec_atomic_lock(&peer->out_lock);
+    if( parsec_list_nolock_is_empty(&peer->pending) &&
+        shm_engine_ring_write(&peer->out, tag, p1, s1, p2, s2) ) {
+        parsec_atomic_unlock(&peer->out_lock);
+        return;
+    }
+    msg = (shm_engine_pending_msg_t*)malloc(sizeof(shm_engine_pending_msg_t) + s1 + s2);
+    PARSEC_OBJ_CONSTRUCT(&msg->super, parsec_list_item_t);
+    msg->tag  = tag;
+    msg->size = s1 + s2;
+    memcpy(msg->data, p1, s1);
+    if( 0 != s2 )
+        memcpy(msg->data + s1, p2, s2);
+    parsec_list_nolock_push_back(&peer->pending, &msg->super);
+    parsec_atomic_unlock(&peer->out_lock);
+    (void)parsec_atomic_fetch_inc_int32(&shm_nb_pending);
+}
+
+static int
+shm_engine_flush_pending(shm_engine_peer_t *peer)
+{
+    shm_engine_pending_msg_t *msg;
+    int nb = 0;
+
+    parsec_atomic_lock(&peer->out_lock);
+    while( NULL != (msg = (shm_engine_pending_msg_t*)parsec_list_nolock_pop_front(&peer->pending)) ) {
+        if( !shm_engine_ring_write(&peer->out, msg->tag, msg->data, msg->size, NULL, 0) ) {
+            parsec_list_nolock_push_front(&peer->pending, &msg->super);
+            break;
+        }
+        PARSEC_OBJ_DESTRUCT(&msg->super);
+        free(msg);
+        nb++;
+    }
+    parsec_atomic_unlock(&peer->out_lock);
+    if( 0 != nb )
+        (void)parsec_atomic_fetch_sub_int32(&shm_nb_pending, nb);
+    return nb;
+}
+
+/* Returns 1 if count elements of the datatype are a single block of memory
+ * starting at their address, and its size */
+static int
+shm_engine_dense(parsec_datatype_t datatype, int count, size_t *bytes)
+{
+    MPI_Aint lb, extent, true_lb, true_extent;
+    int size;
+
+    MPI_Type_size(datatype, &size);
+    MPI_Type_get_extent(datatype, &lb, &extent);
+    MPI_Type_get_true_extent(datatype, &true_lb, &true_extent);
+    *bytes = (size_t)size * count;
+    return (0 == lb) && (0 == true_lb) && (size == extent) && (size == true_extent);
+}
+
+/* Returns the address of a block of memory holding the data of the handle,
+ * packing them in a staging buffer if their layout is not dense */
+static void *
+shm_engine_expose(shm_engine_mem_reg_handle_t *handle, ptrdiff_t displ,
+                  size_t *bytes, void **staging)
+{
+    char *mem = (char*)handle->mem + displ;
+    int packed_size, position = 0;
+
+    *staging = NULL;
+    if( shm_engine_dense(handle->datatype, handle->count, bytes) )
+        return mem;
+    MPI_Pack_size(handle->count, handle->datatype, shm_node_comm, &packed_size);
+    *staging = malloc(packed_size);
+    MPI_Pack(mem, handle->count, handle->datatype, *staging, packed_size, &position, shm_node_comm);
+    *bytes = position;
+    return *staging;
+}
+
+static void
+shm_engine_read(shm_engine_peer_t *peer, void *dst, uint64_t src, size_t bytes)
+{
+    struct iovec local, remote;
+    ssize_t rc;
+
+    while( bytes > 0 ) {
+        local.iov_base  = dst;
+        local.iov_len   = bytes;
+        remote.iov_base = (void*)(uintptr_t)src;
+        remote.iov_len  = bytes;
+        rc = process_vm_readv(peer->pid, &local, 1, &remote, 1, 0);
+        if( rc <= 0 ) {
+            if( (rc < 0) && (EINTR == errno) ) continue;
+            parsec_fatal("SHM: failed to read %zu bytes from process %d (rank %d): %s",
+                         bytes, (int)peer->pid, peer->rank, strerror(errno));
+        }
+        dst = (char*)dst + rc;
+        src += rc;
+        bytes -= rc;
+    }
+}
+
+/* Reads the data exposed by the peer into the memory of the handle */
+static void
+shm_engine_fetch(shm_engine_peer_t *peer, shm_engine_mem_reg_handle_t *handle,
+                 ptrdiff_t displ, uint64_t addr, size_t bytes)
+{
+    char *mem = (char*)handle->mem + displ;
+    size_t dense_bytes;
+    int position = 0;
+    void *tmp;
+
+    /* The processes of a node share the same data representation, so the
+     * packed form of the data is their image in a dense layout. */
+    if( shm_engine_dense(handle->datatype, handle->count, &dense_bytes) ) {
+        assert(bytes <= dense_bytes);
+        shm_engine_read(peer, mem, addr, bytes);
+        return;
+    }
+    tmp = malloc(bytes);
+    shm_engine_read(peer, tmp, addr, bytes);
+    MPI_Unpack(tmp, bytes, &position, mem, handle->count, handle->datatype, shm_node_comm);
+    free(tmp);
+}
+
+static void
+shm_engine_put_cb(shm_engine_peer_t *peer, void *payload, size_t size)
+{
+    shm_engine_put_msg_t *put = (shm_engine_put_msg_t*)payload;
+    shm_engine_req_t *req = (shm_engine_req_t*)(uintptr_t)put->receiver_req;
+    uint64_t ack = put->sender_req;
+
+    if( NULL == req ) {
+        shm_engine_fetch(peer, (shm_engine_mem_reg_handle_t*)(uintptr_t)put->rreg, put->rdispl,
+                         put->addr, put->bytes);
+        shm_engine_send(peer, SHM_ENGINE_TAG_PUT_ACK, &ack, sizeof(uint64_t), NULL, 0);
+        ((parsec_ce_am_callback_t)(uintptr_t)put->r_cb)(&shm_engine, SHM_ENGINE_TAG_PUT,
+                                                         put + 1, size - sizeof(shm_engine_put_msg_t),
+                                                         peer->rank, NULL);
+        return;
+    }
+    /* The answer to one of our GET */
+    shm_engine_fetch(peer, (shm_engine_mem_reg_handle_t*)req->lreg, req->ldispl,
+                     put->addr, put->bytes);
+    shm_engine_send(peer, SHM_ENGINE_TAG_PUT_ACK, &ack, sizeof(uint64_t), NULL, 0);
+    if( NULL != req->l_cb )
+        req->l_cb(&shm_engine, req->lreg, req->ldispl, req->rreg, req->rdispl,
+                  req->size, req->remote, req->l_cb_data);
+    free(req);
+}
+
+static void
+shm_engine_put_ack_cb(shm_engine_peer_t *peer, void *payload)
+{
+    shm_engine_req_t *req = (shm_engine_req_t*)(uintptr_t)(*(uint64_t*)payload);
+
+    free(req->staging);
+    if( NULL != req->r_cb ) {
+        /* We answered a GET of the peer */
+        req->r_cb(&shm_engine, SHM_ENGINE_TAG_GET, req->r_cb_data, req->r_cb_data_size,
+                  peer->rank, NULL);
+    } else if( NULL != req->l_cb ) {
+        req->l_cb(&shm_engine, req->lreg, req->ldispl, req->rreg, req->rdispl,
+                  req->size, req->remote, req->l_cb_data);
+    }
+    free(req);
+}
+
+static void
+shm_engine_get_cb(shm_engine_peer_t *peer, void *payload, size_t size)
+{
+    shm_engine_get_msg_t *get = (shm_engine_get_msg_t*)payload;
+    size_t r_cb_data_size = size - sizeof(shm_engine_get_msg_t);
+    shm_engine_req_t *req = (shm_engine_req_t*)malloc(sizeof(shm_engine_req_t) + r_cb_data_size);
+    shm_engine_put_msg_t put;
+    void *addr;
+    size_t bytes;
+
+    memset(req, 0, sizeof(shm_engine_req_t));
+    req->r_cb = (parsec_ce_am_callback_t)(uintptr_t)get->r_cb;
+    req->r_cb_data_size = r_cb_data_size;
+    memcpy(req->r_cb_data, get + 1, r_cb_data_size);
+    addr = shm_engine_expose((shm_engine_mem_reg_handle_t*)(uintptr_t)get->owner_reg,
+                             get->owner_displ, &bytes, &req->staging);
+
+    put.addr         = (uint64_t)(uintptr_t)addr;
+    put.bytes        = bytes;
+    put.sender_req   = (uint64_t)(uintptr_t)req;
+    put.rreg         = 0;
+    put.rdispl       = 0;
+    put.r_cb         = 0;
+    put.receiver_req = get->receiver_req;
+    shm_engine_send(peer, SHM_ENGINE_TAG_PUT, &put, sizeof(put), NULL, 0);
+}
+
+static void
+shm_engine_dispatch(shm_engine_peer_t *peer, uint64_t tag, void *payload, size_t size)
+{
+    switch(tag) {
+    case SHM_ENGINE_TAG_PUT:
+        shm_engine_put_cb(peer, payload, size);
+        break;
+    case SHM_ENGINE_TAG_PUT_ACK:
+        shm_engine_put_ack_cb(peer, payload);
+        break;
+    case SHM_ENGINE_TAG_GET:
+        shm_engine_get_cb(peer, payload, size);
+        break;
+    default:
+        assert(tag < PARSEC_MAX_REGISTERED_TAGS && NULL != shm_engine_tags[tag].cb);
+        shm_engine_tags[tag].cb(&shm_engine, tag, payload, size,
+                                peer->rank, shm_engine_tags[tag].cb_data);
+    }
+}
+
+/* Delivers all the messages published in the ring from the peer. The
+ * callbacks get the messages in place, and their room is given back once
+ * they all returned. */
+static int
+shm_engine_drain(shm_engine_peer_t *peer)
+{
+    shm_engine_ring_t *ring = &peer->in;
+    uint64_t tail = ring->ctrl->tail, head = ring->ctrl->head;
+    shm_engine_msg_hdr_t *hdr;
+    int nb = 0;
+
+    if( head == tail ) return 0;
+    /* The records are read after their publication */
+    parsec_atomic_rmb();
+    while( tail != head ) {
+        hdr = (shm_engine_msg_hdr_t*)(ring->data + (tail & (shm_ring_size - 1)));
+        if( SHM_ENGINE_TAG_SKIP == hdr->tag ) {
+            tail += hdr->size;
+            continue;
+        }
+        shm_engine_dispatch(peer, hdr->tag, hdr + 1, hdr->size);
+        tail += SHM_ENGINE_RECORD_SIZE(hdr->size);
+        nb++;
+    }
+    /* Done with the records before their room is given back */
+    parsec_mfence();
+    ring->ctrl->tail = tail;
+    return nb;
+}
+
+parsec_comm_engine_t *
+shm_engine_init(parsec_context_t *context)
+{
+    int enabled = 1, ring_size = SHM_ENGINE_DEFAULT_RING_SIZE, ok = 0, fd = -1, i;
+    MPI_Comm comm = (MPI_Comm)context->comm_ctx;
+    char name[64] = {0}, *ring;
+    int64_t me[3], *info = NULL;
+    size_t ring_stride;
+    uint64_t probe;
+    void *segment = MAP_FAILED;
+
+    if( -1 != shm_engine_up )
+        return (1 == shm_engine_up) ? &shm_engine : NULL;
+
+    parsec_mca_param_reg_int_name("runtime", "comm_shm", "Use shared memory and single copy transfers between the processes of the same node (1=true,0=false).",
+                                  false, false, enabled, &enabled);
+    parsec_mca_param_reg_int_name("runtime", "comm_shm_ring_size", "The size in bytes of the ring of messages from each process of a node to each other (rounded up to a power of 2).",
+                                  false, false, ring_size, &ring_size);
+
+    /* All the processes of a node take the same decisions */
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &shm_node_comm);
+    MPI_Comm_size(shm_node_comm, &shm_nb_local);
+    MPI_Comm_rank(shm_node_comm, &shm_local_rank);
+    MPI_Allreduce(MPI_IN_PLACE, &enabled, 1, MPI_INT, MPI_MIN, shm_node_comm);
+    MPI_Allreduce(MPI_IN_PLACE, &ring_size, 1, MPI_INT, MPI_MAX, shm_node_comm);
+    if( !enabled || (1 == shm_nb_local) )
+        goto disable;
+
+    for( shm_ring_size = SHM_ENGINE_MIN_RING_SIZE; shm_ring_size < (size_t)ring_size; shm_ring_size <<= 1 );
+    ring_stride = sizeof(shm_engine_ring_ctrl_t) + shm_ring_size;
+    shm_segment_size = (size_t)shm_nb_local * shm_nb_local * ring_stride;
+
+    /* The first process of the node creates the segment, the others map it,
+     * and it is unlinked as soon as all of them did */
+    if( 0 == shm_local_rank ) {
+        snprintf(name, sizeof(name), "/parsec_shm_%d_%d", (int)getpid(), shm_engine_instance++);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        ok = (-1 != fd) && (0 == ftruncate(fd, shm_segment_size));
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, shm_node_comm);
+    if( !ok ) {
+        if( -1 != fd ) {
+            close(fd);
+            shm_unlink(name);
+        }
+        parsec_debug_verbose(3, parsec_comm_output_stream, "SHM: could not create a segment of %zu bytes, shared memory engine disabled",
+                             shm_segment_size);
+        goto disable;
+    }
+    MPI_Bcast(name, sizeof(name), MPI_CHAR, 0, shm_node_comm);
+    if( 0 != shm_local_rank )
+        fd = shm_open(name, O_RDWR, 0);
+    if( -1 != fd ) {
+        segment = mmap(NULL, shm_segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    ok = (MAP_FAILED != segment);
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, shm_node_comm);
+    if( 0 == shm_local_rank )
+        shm_unlink(name);
+    if( !ok ) {
+        if( MAP_FAILED != segment ) munmap(segment, shm_segment_size);
+        parsec_debug_verbose(3, parsec_comm_output_stream, "SHM: could not map the segment %s, shared memory engine disabled", name);
+        goto disable;
+    }
+    shm_segment = segment;
+
+    /* Check that each process can read the memory of the others */
+#if defined(PR_SET_PTRACER)
+    (void)prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0);
+#endif
+    me[0] = getpid();
+    me[1] = (int64_t)(uintptr_t)&shm_engine_probe;
+    me[2] = context->my_rank;
+    info = (int64_t*)malloc(3 * shm_nb_local * sizeof(int64_t));
+    MPI_Allgather(me, 3, MPI_INT64_T, info, 3, MPI_INT64_T, shm_node_comm);
+    shm_peers = (shm_engine_peer_t*)calloc(shm_nb_local, sizeof(shm_engine_peer_t));
+    ok = 1;
+    for( i = 0; i < shm_nb_local; i++ ) {
+        struct iovec local = { &probe, sizeof(uint64_t) };
+        struct iovec remote = { (void*)(uintptr_t)info[3 * i + 1], sizeof(uint64_t) };
+
+        shm_peers[i].pid  = (pid_t)info[3 * i];
+        shm_peers[i].rank = (int)info[3 * i + 2];
+        if( (i != shm_local_rank) &&
+            ((sizeof(uint64_t) != process_vm_readv(shm_peers[i].pid, &local, 1, &remote, 1, 0)) ||
+             (shm_engine_probe != probe)) ) {
+            parsec_debug_verbose(3, parsec_comm_output_stream, "SHM: cannot read the memory of process %d (rank %d): %s",
+                                 (int)shm_peers[i].pid, shm_peers[i].rank, strerror(errno));
+            ok = 0;
+        }
+    }
+    free(info);
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, shm_node_comm);
+    if( !ok ) {
+        parsec_debug_verbose(3, parsec_comm_output_stream, "SHM: single copy transfers are not permitted, shared memory engine disabled");
+        munmap(shm_segment, shm_segment_size); shm_segment = NULL;
+        free(shm_peers); shm_peers = NULL;
+        goto disable;
+    }
+
+    /* The ring from the process i to the process j is the (j * nb_local + i)-th */
+    shm_peer_of_rank = (int*)malloc(context->nb_nodes * sizeof(int));
+    for( i = 0; i < context->nb_nodes; i++ )
+        shm_peer_of_rank[i] = -1;
+    for( i = 0; i < shm_nb_local; i++ ) {
+        if( i != shm_local_rank )
+            shm_peer_of_rank[shm_peers[i].rank] = i;
+        ring = (char*)shm_segment + ((size_t)i * shm_nb_local + shm_local_rank) * ring_stride;
+        shm_peers[i].out.ctrl = (shm_engine_ring_ctrl_t*)ring;
+        shm_peers[i].out.data = ring + sizeof(shm_engine_ring_ctrl_t);
+        ring = (char*)shm_segment + ((size_t)shm_local_rank * shm_nb_local + i) * ring_stride;
+        shm_peers[i].in.ctrl = (shm_engine_ring_ctrl_t*)ring;
+        shm_peers[i].in.data = ring + sizeof(shm_engine_ring_ctrl_t);
+        PARSEC_OBJ_CONSTRUCT(&shm_peers[i].pending, parsec_list_t);
+        parsec_atomic_lock_init(&shm_peers[i].out_lock);
+    }
+    shm_nb_pending = 0;
+    memset(shm_engine_tags, 0, sizeof(shm_engine_tags));
+
+    shm_engine_mem_reg_handle_mempool = (parsec_mempool_t*) malloc (sizeof(parsec_mempool_t));
+    parsec_mempool_construct(shm_engine_mem_reg_handle_mempool,
+                             PARSEC_OBJ_CLASS(shm_engine_mem_reg_handle_t), sizeof(shm_engine_mem_reg_handle_t),
+                             offsetof(shm_engine_mem_reg_handle_t, mempool_owner),
+                             1);
+
+    shm_engine.tag_register        = shm_engine_tag_register;
+    shm_engine.tag_unregister      = shm_engine_tag_unregister;
+    shm_engine.mem_register        = shm_engine_mem_register;
+    shm_engine.mem_unregister      = shm_engine_mem_unregister;
+    shm_engine.get_mem_handle_size = shm_engine_get_mem_reg_handle_size;
+    shm_engine.mem_retrieve        = shm_engine_mem_retrieve;
+    shm_engine.put                 = shm_engine_put;
+    shm_engine.get                 = shm_engine_get;
+    shm_engine.progress            = shm_engine_progress;
+    shm_engine.enable              = shm_engine_enable;
+    shm_engine.disable             = shm_engine_disable;
+    /* The messages are packed as for the MPI engine, and local copies are local */
+    shm_engine.pack                = parsec_ce.pack;
+    shm_engine.pack_size           = parsec_ce.pack_size;
+    shm_engine.unpack              = parsec_ce.unpack;
+    shm_engine.reshape             = parsec_ce.reshape;
+    shm_engine.sync                = parsec_ce.sync;
+    shm_engine.can_serve           = shm_engine_can_serve;
+    shm_engine.send_am             = shm_engine_send_active_message;
+    shm_engine.am_adopt            = NULL;  /* the messages are delivered in place in the rings */
+
+    shm_engine.parsec_context      = context;
+    shm_engine.capabilites.sided   = 2;
+    shm_engine.capabilites.supports_noncontiguous_datatype = 1;
+
+    PARSEC_DEBUG_VERBOSE(10, parsec_comm_output_stream, "rank %d ENABLE SHM communication engine with %d processes on the node (rings of %zu bytes)",
+                         parsec_debug_rank, shm_nb_local, shm_ring_size);
+    shm_engine_up = 1;
+    return &shm_engine;
+
+  disable:
+    MPI_Comm_free(&shm_node_comm);
+    shm_engine_up = 0;
+    return NULL;
+}
+
+int
+shm_engine_fini(parsec_comm_engine_t *ce)
+{
+    shm_engine_pending_msg_t *msg;
+    int i;
+
+    (void)ce;
+    if( 1 == shm_engine_up ) {
+        for( i = 0; i < shm_nb_local; i++ ) {
+            while( NULL != (msg = (shm_engine_pending_msg_t*)parsec_list_nolock_pop_front(&shm_peers[i].pending)) ) {
+                PARSEC_OBJ_DESTRUCT(&msg->super);
+                free(msg);
+            }
+            PARSEC_OBJ_DESTRUCT(&shm_peers[i].pending);
+        }
+        free(shm_peers); shm_peers = NULL;
+        free(shm_peer_of_rank); shm_peer_of_rank = NULL;
+        munmap(shm_segment, shm_segment_size); shm_segment = NULL;
+
+        parsec_mempool_destruct(shm_engine_mem_reg_handle_mempool);
+        free(shm_engine_mem_reg_handle_mempool); shm_engine_mem_reg_handle_mempool = NULL;
+
+        MPI_Comm_free(&shm_node_comm);
+    }
+    shm_nb_local = 0;
+    shm_local_rank = -1;
+    shm_nb_pending = 0;
+    shm_engine_up = -1;
+    return 1;
+}
+
+int
+shm_engine_is_local(int rank)
+{
+    return (1 == shm_engine_up) && (-1 != shm_peer_of_rank[rank]);
+}
+
+static int
+shm_engine_tag_register(parsec_ce_tag_t tag,
+                        parsec_ce_am_callback_t callback,
+                        void *cb_data,
+                        size_t msg_length)
+{
+    if( tag >= PARSEC_MAX_REGISTERED_TAGS ) {
+        parsec_warning("Tag is out of range, it has to be between %d - %d\n", 0, PARSEC_MAX_REGISTERED_TAGS);
+        return PARSEC_ERR_VALUE_OUT_OF_BOUNDS;
+    }
+    if( NULL != shm_engine_tags[tag].cb ) {
+        parsec_warning("Tag: %d is already registered\n", (int)tag);
+        return PARSEC_ERR_EXISTS;
+    }
+    /* A ring must hold at least two of the largest messages */
+    if( 2 * SHM_ENGINE_RECORD_SIZE(msg_length) > shm_ring_size ) {
+        parsec_warning("SHM: messages of %zu bytes on tag %d do not fit in the rings of %zu bytes (see runtime_comm_shm_ring_size)\n",
+                       msg_length, (int)tag, shm_ring_size);
+        return PARSEC_ERR_VALUE_OUT_OF_BOUNDS;
+    }
+    shm_engine_tags[tag].cb         = callback;
+    shm_engine_tags[tag].cb_data    = cb_data;
+    shm_engine_tags[tag].msg_length = msg_length;
+    return PARSEC_SUCCESS;
+}
+
+static int
+shm_engine_tag_unregister(parsec_ce_tag_t tag)
+{
+    if( NULL == shm_engine_tags[tag].cb ) {
+        parsec_inform("Tag %d is not registered\n", (int)tag);
+        return 0;
+    }
+    shm_engine_tags[tag].cb = NULL;
+    return 1;
+}
+
+static int
+shm_engine_mem_register(void *mem, parsec_mem_type_t mem_type,
+                        size_t count, parsec_datatype_t datatype,
+                        size_t mem_size,
+                        parsec_ce_mem_reg_handle_t *lreg,
+                        size_t *lreg_size)
+{
+    shm_engine_mem_reg_handle_t *handle;
+
+    handle = (shm_engine_mem_reg_handle_t*)parsec_thread_mempool_allocate(shm_engine_mem_reg_handle_mempool->thread_mempools);
+    handle->self = handle;
+    handle->mem  = mem;
+    if( PARSEC_MEM_TYPE_CONTIGUOUS == mem_type ) {
+        handle->datatype = MPI_BYTE;
+        handle->count    = mem_size;
+    } else {
+        handle->datatype = datatype;
+        handle->count    = count;
+    }
+    *lreg = handle;
+    *lreg_size = sizeof(shm_engine_mem_reg_handle_t);
+    return 1;
+}
+
+static int
+shm_engine_mem_unregister(parsec_ce_mem_reg_handle_t *lreg)
+{
+    shm_engine_mem_reg_handle_t *handle = (shm_engine_mem_reg_handle_t *) *lreg;
+    parsec_thread_mempool_free(shm_engine_mem_reg_handle_mempool->thread_mempools, handle->self);
+    return 1;
+}
+
+static int
+shm_engine_get_mem_reg_handle_size(void)
+{
+    return sizeof(shm_engine_mem_reg_handle_t);
+}
+
+static int
+shm_engine_mem_retrieve(parsec_ce_mem_reg_handle_t lreg,
+                        void **mem, parsec_datatype_t *datatype, int *count)
+{
+    shm_engine_mem_reg_handle_t *handle = (shm_engine_mem_reg_handle_t *) lreg;
+    *mem = handle->mem;
+    *datatype = handle->datatype;
+    *count = handle->count;
+    return 1;
+}
+
+/* The receiver reads the data from our memory, and acknowledges it. The
+ * local callback is triggered by the acknowledgement, and the remote one
+ * (r_tag, a callback of the receiver) once the receiver read the data. */
+static int
+shm_engine_put(parsec_comm_engine_t *ce,
+               parsec_ce_mem_reg_handle_t lreg,
+               ptrdiff_t ldispl,
+               parsec_ce_mem_reg_handle_t rreg,
+               ptrdiff_t rdispl,
+               size_t size,
+               int remote,
+               parsec_ce_onesided_callback_t l_cb, void *l_cb_data,
+               parsec_ce_tag_t r_tag, void *r_cb_data, size_t r_cb_data_size)
+{
+    shm_engine_peer_t *peer = &shm_peers[shm_peer_of_rank[remote]];
+    shm_engine_req_t *req = (shm_engine_req_t*)malloc(sizeof(shm_engine_req_t));
+    shm_engine_put_msg_t put;
+    size_t bytes;
+    void *addr;
+
+    (void)ce;
+    memset(req, 0, sizeof(shm_engine_req_t));
+    req->l_cb      = l_cb;
+    req->l_cb_data = l_cb_data;
+    req->lreg      = ((shm_engine_mem_reg_handle_t*)lreg)->self;
+    req->ldispl    = ldispl;
+    req->rreg      = rreg;
+    req->rdispl    = rdispl;
+    req->size      = size;
+    req->remote    = remote;
+    addr = shm_engine_expose((shm_engine_mem_reg_handle_t*)lreg, ldispl, &bytes, &req->staging);
+
+    put.addr         = (uint64_t)(uintptr_t)addr;
+    put.bytes        = bytes;
+    put.sender_req   = (uint64_t)(uintptr_t)req;
+    put.rreg         = (uint64_t)(uintptr_t)((shm_engine_mem_reg_handle_t*)rreg)->self;
+    put.rdispl       = rdispl;
+    put.r_cb         = (uint64_t)r_tag;
+    put.receiver_req = 0;
+    shm_engine_send(peer, SHM_ENGINE_TAG_PUT, &put, sizeof(put), r_cb_data, r_cb_data_size);
+    return 1;
+}
+
+/* The owner of the data exposes them in answer, as for a PUT: the local
+ * callback is triggered once we read them, and the remote one (r_tag, a
+ * callback of the owner) by our acknowledgement. */
+static int
+shm_engine_get(parsec_comm_engine_t *ce,
+               parsec_ce_mem_reg_handle_t lreg,
+               ptrdiff_t ldispl,
+               parsec_ce_mem_reg_handle_t rreg,
+               ptrdiff_t rdispl,
+               size_t size,
+               int remote,
+               parsec_ce_onesided_callback_t l_cb, void *l_cb_data,
+               parsec_ce_tag_t r_tag, void *r_cb_data, size_t r_cb_data_size)
+{
+    shm_engine_peer_t *peer = &shm_peers[shm_peer_of_rank[remote]];
+    shm_engine_req_t *req = (shm_engine_req_t*)malloc(sizeof(shm_engine_req_t));
+    shm_engine_get_msg_t get;
+
+    (void)ce;
+    memset(req, 0, sizeof(shm_engine_req_t));
+    req->l_cb      = l_cb;
+    req->l_cb_data = l_cb_data;
+    req->lreg      = ((shm_engine_mem_reg_handle_t*)lreg)->self;
+    req->ldispl    = ldispl;
+    req->rreg      = rreg;
+    req->rdispl    = rdispl;
+    req->size      = size;
+    req->remote    = remote;
+
+    get.owner_reg    = (uint64_t)(uintptr_t)((shm_engine_mem_reg_handle_t*)rreg)->self;
+    get.owner_displ  = rdispl;
+    get.receiver_req = (uint64_t)(uintptr_t)req;
+    get.r_cb         = (uint64_t)r_tag;
+    shm_engine_send(peer, SHM_ENGINE_TAG_GET, &get, sizeof(get), r_cb_data, r_cb_data_size);
+    return 1;
+}
+
+static int
+shm_engine_send_active_message(parsec_comm_engine_t *ce,
+                               parsec_ce_tag_t tag,
+                               int remote,
+                               void *addr, size_t size)
+{
+    (void)ce;
+    assert(shm_engine_tags[tag].msg_length >= size);
+    shm_engine_send(&shm_peers[shm_peer_of_rank[remote]], tag, addr, size, NULL, 0);
+    return 1;
+}
+
+static int
+shm_engine_progress(parsec_comm_engine_t *ce)
+{
+    int i, ret = 0;
+
+    (void)ce;
+    /* The callbacks can send messages, but do not progress the engine */
+    if( shm_in_progress ) return 0;
+    shm_in_progress = 1;
+    for( i = 0; (0 != shm_nb_pending) && (i < shm_nb_local); i++ ) {
+        ret += shm_engine_flush_pending(&shm_peers[i]);
+    }
+    for( i = 0; i < shm_nb_local; i++ ) {
+        if( i == shm_local_rank ) continue;
+        ret += shm_engine_drain(&shm_peers[i]);
+    }
+    shm_in_progress = 0;
+    return ret;
+}
+
+static int
+shm_engine_enable(parsec_comm_engine_t *ce)
+{
+    (void) ce;
+    return 1;
+}
+
+static int
+shm_engine_disable(parsec_comm_engine_t *ce)
+{
+    (void) ce;
+    return 1;
+}
+
+/* The transfers are never delayed, there is always room for more */
+static int
+shm_engine_can_serve(parsec_comm_engine_t *ce)
+{
+    (void) ce;
+    return 1;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+#ifndef __USE_PARSEC_SHM_ENGINE_H__
+#define __USE_PARSEC_SHM_ENGINE_H__
+
+#include "parsec/parsec_comm_engine.h"
+
+/* ------- Shared memory implementation, for the processes of a node ------- */
+
+/**
+ * Collective over the communicator of the context: each process of a node
+ * maps a shared segment holding a ring of active messages for each pair of
+ * processes of the node, and checks that it can read the memory of the
+ * others with a single copy. Returns NULL on all the processes of a node
+ * where the engine is disabled or cannot be used.
+ */
+parsec_comm_engine_t * shm_engine_init(parsec_context_t *parsec_context);
+int shm_engine_fini(parsec_comm_engine_t *comm_engine);
+
+/* Returns 1 if the rank (in the communicator of the context) is served by
+ * the shared memory engine, 0 otherwise */
+int shm_engine_is_local(int rank);
+
+#endif /* __USE_PARSEC_SHM_ENGINE_H__ */
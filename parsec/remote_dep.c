@@ -152,6 +152,7 @@ parsec_remote_deps_t* remote_deps_allocate( parsec_lifo_t* lifo )
     if( NULL == remote_deps ) {
         char *ptr;
         remote_deps = (parsec_remote_deps_t*)parsec_lifo_item_alloc( lifo, parsec_remote_dep_context.elem_size );
+        PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_REMOTE_DEPS, parsec_remote_dep_context.elem_size);
         PARSEC_VALGRIND_MEMPOOL_ALLOC(lifo,
                                       ((unsigned char *)remote_deps)+sizeof(parsec_list_item_t),
                                       parsec_remote_dep_context.elem_size - sizeof(parsec_list_item_t));
@@ -633,6 +634,7 @@ void remote_deps_allocation_fini(void)
     if(1 == parsec_remote_dep_inited) {
         parsec_remote_deps_t* rdeps;
         while(NULL != (rdeps = (parsec_remote_deps_t*) parsec_lifo_pop(&parsec_remote_dep_context.freelist))) {
+            PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_REMOTE_DEPS, -(int64_t)parsec_remote_dep_context.elem_size);
             free(rdeps);
         }
         PARSEC_OBJ_DESTRUCT(&parsec_remote_dep_context.freelist);
@@ -704,5 +706,35 @@ int remote_dep_bind_thread(parsec_context_t* context)
     return 0;
 }
 
+/* Bind a communication progress thread on the cores of a virtual process */
+int remote_dep_bind_progress_thread(parsec_context_t* context, int vp)
+{
+#if defined(PARSEC_HAVE_HWLOC) && defined(PARSEC_HAVE_HWLOC_BITMAP)
+    parsec_vp_t* vproc = context->virtual_processes[vp];
+    hwloc_cpuset_t cpuset = hwloc_bitmap_alloc();
+    char *str = NULL;
+    int i;
+
+    for(i = 0; i < vproc->nb_cores; i++) {
+        if( vproc->execution_streams[i]->core_id >= 0 )
+            hwloc_bitmap_set(cpuset, vproc->execution_streams[i]->core_id);
+    }
+    if( !hwloc_bitmap_iszero(cpuset) && (parsec_bindthread_mask(cpuset) > -1) ) {
+        hwloc_bitmap_asprintf(&str, cpuset);
+    }
+    parsec_debug_verbose(4, parsec_comm_output_stream,
+                         "Communication progress thread bound on the cpu mask %s of the virtual process %d",
+                         str? str: "NOT BOUND", vp);
+    if(str) free(str);
+    hwloc_bitmap_free(cpuset);
+#else /* NO PARSEC_HAVE_HWLOC */
+    /* Without hwloc the thread can only be bound to a single core, and it
+     * would compete with the computation thread there. Let it float. */
+    parsec_debug_verbose(4, parsec_comm_output_stream, "Communication progress thread of the virtual process %d floats", vp);
+    (void)context; (void)vp;
+#endif /* NO PARSEC_HAVE_HWLOC */
+    return 0;
+}
+
 #endif /* DISTRIBUTED */
 
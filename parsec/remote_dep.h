@@ -41,9 +41,11 @@ typedef unsigned long remote_dep_datakey_t;
 typedef struct remote_dep_wire_activate_s {
     remote_dep_datakey_t deps;         /**< a pointer to the dep structure on the source */
     remote_dep_datakey_t output_mask;  /**< the mask of the output dependencies satisfied by this activation message */
+    remote_dep_datakey_t eager_mask;   /**< the outputs whose data follow the message (eager protocol) */
     uint32_t             taskpool_id;
     uint32_t             task_class_id;
     uint32_t             length;
+    uint32_t             eager_offset; /**< the padding aligning the data that follow the message */
     parsec_assignment_t  locals[MAX_LOCAL_COUNT];
 } remote_dep_wire_activate_t;
 
@@ -254,6 +256,13 @@ extern int parsec_comm_gets;
 extern int parsec_comm_puts_max;
 extern int parsec_comm_puts;
 
+/* The outputs sent eagerly behind the activations (and their bytes), and
+ * the ones received, copied out of the message or adopting it */
+extern int64_t parsec_comm_eager_sent;
+extern int64_t parsec_comm_eager_sent_bytes;
+extern int64_t parsec_comm_eager_copied;
+extern int64_t parsec_comm_eager_adopted;
+
 /**
  * The order is important as it will be used to compute the index in the
  * pending array of messages.
@@ -342,6 +351,7 @@ int remote_dep_dequeue_off(parsec_context_t* context);
 int remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es, int cycles);
 
 int remote_dep_bind_thread(parsec_context_t* context);
+int remote_dep_bind_progress_thread(parsec_context_t* context, int vp);
 int remote_dep_complete_and_cleanup(parsec_remote_deps_t** deps,
                                 int ncompleted);
 
@@ -1,6 +1,7 @@
 #include "parsec/parsec_config.h"
 
 #include <mpi.h>
+#include <limits.h>
 #include "profiling.h"
 #include "parsec/class/list.h"
 #include "parsec/utils/output.h"
@@ -11,7 +12,11 @@
 #include "parsec/papi_sde.h"
 #include "parsec/interfaces/dtd/insert_function_internal.h"
 #include "parsec/remote_dep.h"
+#include "parsec/scheduling.h"
 #include "parsec/class/dequeue.h"
+#if defined(PARSEC_DIST_WITH_SHM)
+#include "parsec/parsec_shm_engine.h"
+#endif  /* defined(PARSEC_DIST_WITH_SHM) */
 
 #include "parsec/parsec_binary_profile.h"
 
@@ -28,6 +33,11 @@ int parsec_comm_gets      = 0;
 int parsec_comm_puts_max  = DEP_NB_CONCURRENT * MAX_PARAM_COUNT;
 int parsec_comm_puts      = 0;
 
+int64_t parsec_comm_eager_sent       = 0;
+int64_t parsec_comm_eager_sent_bytes = 0;
+int64_t parsec_comm_eager_copied     = 0;
+int64_t parsec_comm_eager_adopted    = 0;
+
 /**
  * Number of data movements to be extracted at each step. Bigger the number
  * larger the amount spent in ordering the tasks, but greater the potential
@@ -36,11 +46,21 @@ int parsec_comm_puts      = 0;
 static void remote_dep_mpi_params(parsec_context_t* context);
 static int parsec_param_nb_tasks_extracted = 20;
 /* For the meaning of aggregate, short and eager, refer to the
- * param register help text for comm_aggregate, and
- * comm_short_limit respectively.
+ * param register help text for comm_aggregate, comm_short_limit and
+ * comm_eager_limit respectively.
  */
 static size_t parsec_param_short_limit = RDEP_MSG_SHORT_LIMIT;
+#define RDEP_MSG_EAGER_LIMIT (64*1024)
+static size_t parsec_param_eager_limit = RDEP_MSG_EAGER_LIMIT;
 static int parsec_param_enable_aggregate = 0;
+/* Number of progress threads sending the activations, in addition to the
+ * communication thread. See the param register help text for
+ * comm_progress_threads. */
+static int parsec_param_comm_progress_threads = 0;
+/* How long (in microseconds) the activations can wait in the coalescing
+ * buffer of their peer. See the param register help text for
+ * comm_coalesce_window. */
+static int parsec_param_comm_coalesce_window = 0;
 
 parsec_mempool_t *parsec_remote_dep_cb_data_mempool = NULL;
 
@@ -78,6 +98,13 @@ remote_dep_cmd_to_string(remote_dep_wire_activate_t* origin,
 #define dep_count sizeof(remote_dep_wire_activate_t)
 #define dep_extent dep_count
 #define DEP_SHORT_BUFFER_SIZE (dep_extent+RDEP_MSG_SHORT_LIMIT)
+/* The largest activation message sent through the MPI engine, room for the
+ * data sent eagerly included. The shared memory engine takes messages of
+ * DEP_SHORT_BUFFER_SIZE bytes, in its rings. */
+static int remote_dep_activate_size = DEP_SHORT_BUFFER_SIZE;
+/* The data sent eagerly start aligned on a cache line in the messages, so
+ * that the receiver can adopt the message buffer instead of copying them */
+#define RDEP_EAGER_ALIGNMENT 64
 #if PARSEC_SIZEOF_VOID_P == 4
 #define datakey_dtt parsec_datatype_int32_t
 #else
@@ -85,6 +112,57 @@ remote_dep_cmd_to_string(remote_dep_wire_activate_t* origin,
 #endif
 #define datakey_count 3
 
+/**
+ * Each activation message starts with a batch header, the number of
+ * activations it carries, packed in remote_dep_batch_header_size bytes.
+ */
+static int remote_dep_batch_header_size = 0;
+
+/**
+ * The activations toward a peer are packed in its coalescing buffer, and
+ * wait there until the buffer is full, the first of them has waited
+ * comm_coalesce_window microseconds, or the thread sending them has
+ * nothing else to do. The commands of the packed activations are kept in
+ * the ring until the message is sent.
+ */
+typedef struct remote_dep_coalesce_s {
+    parsec_list_item_t  super;     /* in the pending list of the coalescer */
+    int                 peer;
+    int                 position;
+    int                 count;
+    int                 pending;   /* in the pending list of the coalescer */
+    int                 size;      /* of the buffer */
+    uint64_t            start;     /* when the first activation was packed (us) */
+    parsec_list_item_t *ring;
+    char                buffer[];
+} remote_dep_coalesce_t;
+
+/**
+ * The coalescing buffers of a thread sending activations (the communication
+ * thread, or a progress thread). A peer is only served by one of them.
+ */
+typedef struct remote_dep_coalescer_s {
+    remote_dep_coalesce_t **buffers;  /* one for each peer, allocated on first use */
+    remote_dep_coalesce_t  *immediate; /* sent as soon as packed, allocated on first use */
+    parsec_list_t           pending;  /* the buffers holding activations, oldest first */
+} remote_dep_coalescer_t;
+
+static remote_dep_coalescer_t dep_coalescer;  /* of the communication thread */
+
+/**
+ * The largest activation message toward the peer, and the room for the data
+ * sent eagerly in it: the shared memory engine only takes short messages.
+ */
+static inline int remote_dep_activate_size_peer(int peer)
+{
+    return (&parsec_ce == parsec_comm_engine_peer(peer)) ? remote_dep_activate_size : (int)DEP_SHORT_BUFFER_SIZE;
+}
+
+static inline size_t remote_dep_eager_limit_peer(int peer)
+{
+    return (&parsec_ce == parsec_comm_engine_peer(peer)) ? parsec_param_eager_limit : parsec_param_short_limit;
+}
+
 static pthread_t dep_thread_id;
 parsec_dequeue_t dep_cmd_queue;
 parsec_list_t    dep_cmd_fifo;             /* ordered non threaded fifo */
@@ -99,20 +177,45 @@ static dep_cmd_item_t** parsec_mpi_same_pos_items;
 static int parsec_mpi_same_pos_items_size = 0;
 
 static int mpi_initialized = 0;
+static int mpi_thread_multiple = 0;
 #if defined(PARSEC_REMOTE_DEP_USE_THREADS)
 static pthread_mutex_t mpi_thread_mutex;
 static pthread_cond_t mpi_thread_condition;
 #endif
 
+/**
+ * A progress context takes over the activations toward a slice of the peers
+ * (the peers p such that p % remote_dep_nb_progress_ctx == id) from the
+ * communication thread. It has its own command queue, ordered fifo and
+ * aggregation state, and sends directly from its own thread, which requires
+ * MPI_THREAD_MULTIPLE. The communication thread keeps everything else: the
+ * incoming messages, the data transfers and the progress of the requests.
+ */
+typedef struct remote_dep_progress_ctx_s {
+    pthread_t                  thread_id;
+    int                        id;
+    volatile int32_t           running;
+    parsec_dequeue_t           cmd_queue;
+    parsec_list_t              cmd_fifo;
+    dep_cmd_item_t           **same_pos_items;  /* one for each peer */
+    remote_dep_coalescer_t     coalescer;
+    parsec_execution_stream_t  es;
+} remote_dep_progress_ctx_t;
+
+static remote_dep_progress_ctx_t *remote_dep_progress_ctx = NULL;
+static volatile int32_t remote_dep_nb_progress_ctx = 0;
+
 parsec_execution_stream_t parsec_comm_es = {
     .th_id = 0,
     .core_id = -1,
     .socket_id = -1,
+    .numa_id = 0,
 #if defined(PARSEC_PROF_TRACE)
     .es_profile = NULL,
 #endif /* PARSEC_PROF_TRACE */
     .scheduler_object = NULL,
     .next_task = NULL,
+    .gathered_rings = NULL,
 #if defined(PARSEC_SIM)
     .largest_simulation_date = 0,
 #endif
@@ -160,9 +263,16 @@ remote_dep_release_incoming(parsec_execution_stream_t* es,
                             remote_dep_datakey_t complete_mask);
 
 static int remote_dep_nothread_send(parsec_execution_stream_t* es,
-                                    dep_cmd_item_t **head_item);
+                                    dep_cmd_item_t **head_item,
+                                    remote_dep_coalescer_t *coalescer);
+static void remote_dep_coalescer_init(remote_dep_coalescer_t *coalescer, int nb_peers);
+static void remote_dep_coalescer_fini(remote_dep_coalescer_t *coalescer, int nb_peers);
+static void remote_dep_coalescer_flush(parsec_execution_stream_t* es,
+                                       remote_dep_coalescer_t *coalescer, int all);
 static int remote_dep_ce_init(parsec_context_t* context);
 static int remote_dep_ce_fini(parsec_context_t* context);
+static void remote_dep_progress_ctx_init(parsec_context_t* context);
+static void remote_dep_progress_ctx_fini(parsec_context_t* context);
 
 static int local_dep_nothread_reshape(parsec_execution_stream_t* es,
                                       dep_cmd_item_t *item);
@@ -242,8 +352,28 @@ static void remote_dep_mpi_params(parsec_context_t* context) {
         parsec_param_short_limit = RDEP_MSG_SHORT_LIMIT;
     }
 #endif
+    parsec_mca_param_reg_sizet_name("runtime", "comm_eager_limit", "The maximum size in bytes of the data sent eagerly behind an activation message through the MPI engine, "
+                                  "when they are stored in a single block of memory (0 disables the eager protocol). "
+                                  "Between the processes of a node, the shared memory engine keeps them under comm_short_limit.",
+                                  false, false, parsec_param_eager_limit, &parsec_param_eager_limit);
+    if( parsec_param_eager_limit > (size_t)(INT_MAX / 2) )
+        parsec_param_eager_limit = INT_MAX / 2;
+    remote_dep_activate_size = (int)(dep_extent + ((parsec_param_eager_limit > RDEP_MSG_SHORT_LIMIT) ?
+                                                   parsec_param_eager_limit : RDEP_MSG_SHORT_LIMIT));
     parsec_mca_param_reg_int_name("runtime", "comm_aggregate", "Aggregate multiple dependencies in the same short message (1=true,0=false).",
                                   false, false, parsec_param_enable_aggregate, &parsec_param_enable_aggregate);
+    parsec_mca_param_reg_int_name("runtime", "comm_progress_threads", "Number of progress threads sending the activations, in addition to the communication thread. "
+                                  "Each of them owns a slice of the peers and is bound next to a virtual process. Requires MPI_THREAD_MULTIPLE.\n"
+                                  "  0: the communication thread sends all the activations.\n"
+                                  " -1: one progress thread for each virtual process.\n"
+                                  " >0: the number of progress threads.",
+                                  false, false, parsec_param_comm_progress_threads, &parsec_param_comm_progress_threads);
+    parsec_mca_param_reg_int_name("runtime", "comm_coalesce_window", "How long (in microseconds) the activations toward a peer can wait for others in the same message. "
+                                  "The message leaves earlier when it is full, or when the thread sending it has nothing else to do. "
+                                  "0 sends the activations as soon as they are packed (aggregated only when comm_aggregate is set).",
+                                  false, false, parsec_param_comm_coalesce_window, &parsec_param_comm_coalesce_window);
+    if( parsec_param_comm_coalesce_window < 0 )
+        parsec_param_comm_coalesce_window = 0;
 }
 
 int
@@ -289,6 +419,7 @@ remote_dep_dequeue_init(parsec_context_t* context)
         context->comm_ctx = (intptr_t)MPI_COMM_WORLD;
     }
 
+    mpi_thread_multiple = (thread_level_support >= MPI_THREAD_MULTIPLE);
     if(parsec_param_comm_thread_multiple) {
         if( thread_level_support >= MPI_THREAD_MULTIPLE ) {
             context->flags |= PARSEC_CONTEXT_FLAG_COMM_MT;
@@ -546,7 +677,12 @@ remote_dep_dequeue_send(parsec_execution_stream_t* es, int rank,
     /* if MPI is multithreaded do not thread-shift the send activate */
     if( parsec_comm_es.virtual_process->parsec_context->flags & PARSEC_CONTEXT_FLAG_COMM_MT ) {
         parsec_list_item_singleton(&item->pos_list); /* NOTE: this disables aggregation in MT cases. */
-        remote_dep_nothread_send(es, &item);
+        remote_dep_nothread_send(es, &item, NULL);
+    }
+    else if( 0 < remote_dep_nb_progress_ctx ) {
+        /* shift the send activate to the progress thread owning the peer */
+        parsec_dequeue_push_back(&remote_dep_progress_ctx[rank % remote_dep_nb_progress_ctx].cmd_queue,
+                                 (parsec_list_item_t*)item);
     }
     else {
         parsec_dequeue_push_back(&dep_cmd_queue, (parsec_list_item_t*)item);
@@ -884,6 +1020,7 @@ remote_dep_get_datatypes(parsec_execution_stream_t* es,
                     char* packed_buffer;
                     /* Copy the short data to some temp storage */
                     packed_buffer = malloc(origin->msg.length);
+                    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_REMOTE_DEPS, origin->msg.length);
                     memcpy(packed_buffer, origin->eager_msg + *position, origin->msg.length);
                     *position += origin->msg.length;  /* move to the next order */
                     origin->taskpool = (parsec_taskpool_t*)packed_buffer;  /* temporary storage */
@@ -1071,6 +1208,43 @@ remote_dep_release_incoming(parsec_execution_stream_t* es,
     return NULL;
 }
 
+/**
+ * Add a command behind the pending commands of the same category (the first
+ * of them is same_pos_items[position]) if they have a higher priority, or
+ * make it the new head of the category. A new head goes in the temp_list,
+ * waiting to be sorted into the ordered fifo.
+ */
+static void
+remote_dep_cmd_push_ordered(dep_cmd_item_t** same_pos_items, int position,
+                            parsec_list_t* temp_list, dep_cmd_item_t* item)
+{
+    dep_cmd_item_t* same_pos = same_pos_items[position];
+
+    parsec_list_item_singleton(&item->pos_list);
+    if((NULL != same_pos) && (same_pos->priority >= item->priority)) {
+        /* insert the item in the peer list */
+        parsec_list_item_ring_push_sorted(&same_pos->pos_list, &item->pos_list, dep_mpi_pos_list);
+    } else {
+        if(NULL != same_pos) {
+            /* this is the new head of the list. */
+            parsec_list_item_ring_push(&same_pos->pos_list, &item->pos_list);
+            /* Remove previous elem from the priority list. The element
+             might be either in the ordered fifo if it is old enough to be
+             pushed there, or in the temp_list waiting to be moved
+             upstream. Pay attention from which queue it is removed. */
+#if defined(PARSEC_DEBUG_PARANOID)
+            parsec_list_nolock_remove((struct parsec_list_t*)same_pos->super.belong_to, (parsec_list_item_t*)same_pos);
+#else
+            parsec_list_nolock_remove(NULL, (parsec_list_item_t*)same_pos);
+#endif
+            parsec_list_item_singleton((parsec_list_item_t*)same_pos);
+        }
+        same_pos_items[position] = item;
+        /* And add ourselves in the temp list */
+        parsec_list_nolock_push_front(temp_list, (parsec_list_item_t*)item);
+    }
+}
+
 int
 remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es,
                                      int cycles)
@@ -1084,7 +1258,10 @@ remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es,
     PARSEC_OBJ_CONSTRUCT(&temp_list, parsec_list_t);
  check_pending_queues:
     if( cycles >= 0 )
-        if( 0 == cycles--) return executed_tasks;  /* report how many events were progressed */
+        if( 0 == cycles--) {
+            remote_dep_coalescer_flush(es, &dep_coalescer, 1);
+            return executed_tasks;  /* report how many events were progressed */
+        }
 
     /* Move a number of transfers from the shared dequeue into our ordered lifo. */
     how_many = 0;
@@ -1098,34 +1275,9 @@ remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es,
             break;
         }
         how_many++;
-        same_pos = NULL;
         /* Find the position in the array of the first possible item in the same category */
         position = (DEP_ACTIVATE == item->action) ? item->cmd.activate.peer : (context->nb_nodes + item->action);
-
-        parsec_list_item_singleton(&item->pos_list);
-        same_pos = parsec_mpi_same_pos_items[position];
-        if((NULL != same_pos) && (same_pos->priority >= item->priority)) {
-            /* insert the item in the peer list */
-            parsec_list_item_ring_push_sorted(&same_pos->pos_list, &item->pos_list, dep_mpi_pos_list);
-        } else {
-            if(NULL != same_pos) {
-                /* this is the new head of the list. */
-                parsec_list_item_ring_push(&same_pos->pos_list, &item->pos_list);
-                /* Remove previous elem from the priority list. The element
-                 might be either in the dep_cmd_fifo if it is old enough to be
-                 pushed there, or in the temp_list waiting to be moved
-                 upstream. Pay attention from which queue it is removed. */
-#if defined(PARSEC_DEBUG_PARANOID)
-                parsec_list_nolock_remove((struct parsec_list_t*)same_pos->super.belong_to, (parsec_list_item_t*)same_pos);
-#else
-                parsec_list_nolock_remove(NULL, (parsec_list_item_t*)same_pos);
-#endif
-                parsec_list_item_singleton((parsec_list_item_t*)same_pos);
-            }
-            parsec_mpi_same_pos_items[position] = item;
-            /* And add ourselves in the temp list */
-            parsec_list_nolock_push_front(&temp_list, (parsec_list_item_t*)item);
-        }
+        remote_dep_cmd_push_ordered(parsec_mpi_same_pos_items, position, &temp_list, item);
         if(how_many > parsec_param_nb_tasks_extracted)
             break;
     }
@@ -1137,8 +1289,11 @@ remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es,
         /* Insert them into the locally ordered cmd_fifo */
         parsec_list_nolock_chain_sorted(&dep_cmd_fifo, items, dep_cmd_prio);
     }
+    remote_dep_coalescer_flush(es, &dep_coalescer, 0);
     /* Extract the head of the list and point the array to the correct value */
     if(NULL == (item = (dep_cmd_item_t*)parsec_list_nolock_pop_front(&dep_cmd_fifo)) ) {
+        /* nothing else to do, don't hold the activations any longer */
+        remote_dep_coalescer_flush(es, &dep_coalescer, 1);
         /* only progress MPI if necessary */
         if (context->nb_nodes > 1) {
             ret = remote_dep_mpi_progress(es);
@@ -1160,6 +1315,7 @@ remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es,
     position = (DEP_ACTIVATE == item->action) ? item->cmd.activate.peer : (context->nb_nodes + item->action);
     switch(item->action) {
     case DEP_CTL:
+        remote_dep_coalescer_flush(es, &dep_coalescer, 1);
         ret = item->cmd.ctl.enable;
         PARSEC_OBJ_DESTRUCT(&temp_list);
         PARSEC_DEBUG_VERBOSE(10, parsec_comm_output_stream, "rank %d DISABLE MPI communication engine", parsec_debug_rank);
@@ -1172,7 +1328,7 @@ remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es,
         remote_dep_mpi_release_delayed_deps(es, item);
         break;
     case DEP_ACTIVATE:
-        remote_dep_nothread_send(es, &item);
+        remote_dep_nothread_send(es, &item, &dep_coalescer);
         same_pos = item;
         goto have_same_pos;
     case DEP_MEMCPY:
@@ -1203,6 +1359,131 @@ remote_dep_dequeue_nothread_progress(parsec_execution_stream_t* es,
 }
 
 
+/**
+ * Main loop of a progress thread: order the activations toward its peers by
+ * priority, and send them (aggregated by peer when allowed) until it is
+ * asked to leave and nothing is left to send. The thread shares the cores of
+ * a virtual process, so it always backs off when idle.
+ */
+static void* remote_dep_progress_main(remote_dep_progress_ctx_t* pctx)
+{
+    parsec_context_t* context = pctx->es.virtual_process->parsec_context;
+    parsec_list_item_t *items;
+    dep_cmd_item_t *item;
+    parsec_list_t temp_list;
+    int how_many, peer, running;
+
+    remote_dep_bind_progress_thread(context, pctx->id % context->nb_vp);
+    parsec_set_my_execution_stream(&pctx->es);
+    PARSEC_PAPI_SDE_THREAD_INIT();
+
+    PARSEC_OBJ_CONSTRUCT(&temp_list, parsec_list_t);
+    while( 1 ) {
+        running = pctx->running;
+        how_many = 0;
+        while( NULL != (item = (dep_cmd_item_t*)parsec_dequeue_try_pop_front(&pctx->cmd_queue)) ) {
+            assert(DEP_ACTIVATE == item->action);
+            remote_dep_cmd_push_ordered(pctx->same_pos_items, item->cmd.activate.peer, &temp_list, item);
+            if( ++how_many > parsec_param_nb_tasks_extracted )
+                break;
+        }
+        if( !parsec_list_nolock_is_empty(&temp_list) ) {
+            parsec_list_nolock_sort(&temp_list, dep_cmd_prio);
+            items = parsec_list_nolock_unchain(&temp_list);
+            parsec_list_nolock_chain_sorted(&pctx->cmd_fifo, items, dep_cmd_prio);
+        }
+        remote_dep_coalescer_flush(&pctx->es, &pctx->coalescer, 0);
+        if( NULL == (item = (dep_cmd_item_t*)parsec_list_nolock_pop_front(&pctx->cmd_fifo)) ) {
+            /* nothing else to do, don't hold the activations any longer */
+            remote_dep_coalescer_flush(&pctx->es, &pctx->coalescer, 1);
+            if( !running ) break;
+            struct timespec ts;
+            ts.tv_sec = 0; ts.tv_nsec = comm_yield_ns;
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        peer = item->cmd.activate.peer;
+        remote_dep_nothread_send(&pctx->es, &item, &pctx->coalescer);
+        /* item is now the next pending activation toward the same peer, if any */
+        if( NULL != item )
+            parsec_list_nolock_push_front(&temp_list, (parsec_list_item_t*)item);
+        pctx->same_pos_items[peer] = item;
+    }
+    PARSEC_OBJ_DESTRUCT(&temp_list);
+
+    PARSEC_PAPI_SDE_THREAD_FINI();
+    return (void*)pctx;
+}
+
+/**
+ * Start the progress threads requested by comm_progress_threads. They are
+ * only useful when the activations are funnelled through the communication
+ * thread, and they need MPI_THREAD_MULTIPLE to send on their own.
+ */
+static void remote_dep_progress_ctx_init(parsec_context_t* context)
+{
+    remote_dep_progress_ctx_t* pctx;
+    int i, nb = parsec_param_comm_progress_threads;
+
+    if( -1 == nb ) nb = context->nb_vp;
+    /* there is no use for more slices than peers */
+    if( nb > context->nb_nodes - 1 ) nb = context->nb_nodes - 1;
+    if( 0 >= nb ) return;
+    if( !mpi_thread_multiple ) {
+        parsec_warning("Requested %d communication progress threads, but MPI is not initialized with MPI_THREAD_MULTIPLE.\n"
+                       "\t* PaRSEC will continue with the communication thread sending all the activations.\n", nb);
+        return;
+    }
+    if( context->flags & PARSEC_CONTEXT_FLAG_COMM_MT ) {
+        PARSEC_DEBUG_VERBOSE(4, parsec_comm_output_stream, "MPI: the computation threads send the activations, no communication progress thread is started");
+        return;
+    }
+
+    remote_dep_progress_ctx = (remote_dep_progress_ctx_t*)calloc(nb, sizeof(remote_dep_progress_ctx_t));
+    for( i = 0; i < nb; i++ ) {
+        pctx = &remote_dep_progress_ctx[i];
+        pctx->id = i;
+        pctx->running = 1;
+        PARSEC_OBJ_CONSTRUCT(&pctx->cmd_queue, parsec_dequeue_t);
+        PARSEC_OBJ_CONSTRUCT(&pctx->cmd_fifo, parsec_list_t);
+        pctx->same_pos_items = (dep_cmd_item_t**)calloc(context->nb_nodes, sizeof(dep_cmd_item_t*));
+        remote_dep_coalescer_init(&pctx->coalescer, context->nb_nodes);
+        memcpy(&pctx->es, &parsec_comm_es, sizeof(parsec_execution_stream_t));
+#if defined(PARSEC_PROF_TRACE)
+        pctx->es.es_profile = parsec_profiling_stream_init(2*1024*1024, "MPI progress thread %d", i);
+#endif  /* defined(PARSEC_PROF_TRACE) */
+        pthread_create(&pctx->thread_id, NULL,
+                       (void* (*)(void*))remote_dep_progress_main, (void*)pctx);
+    }
+    parsec_mfence();  /* the contexts are ready before the senders can see them */
+    remote_dep_nb_progress_ctx = nb;
+    PARSEC_DEBUG_VERBOSE(4, parsec_comm_output_stream, "MPI: %d communication progress threads started", nb);
+}
+
+static void remote_dep_progress_ctx_fini(parsec_context_t* context)
+{
+    remote_dep_progress_ctx_t* pctx;
+    int i, nb = remote_dep_nb_progress_ctx;
+    void *ret;
+
+    if( 0 == nb ) return;
+    remote_dep_nb_progress_ctx = 0;
+    parsec_mfence();
+    for( i = 0; i < nb; i++ ) {
+        pctx = &remote_dep_progress_ctx[i];
+        pctx->running = 0;
+        pthread_join(pctx->thread_id, &ret);
+        assert((remote_dep_progress_ctx_t*)ret == pctx);
+        assert(NULL == parsec_dequeue_pop_front(&pctx->cmd_queue));
+        PARSEC_OBJ_DESTRUCT(&pctx->cmd_queue);
+        PARSEC_OBJ_DESTRUCT(&pctx->cmd_fifo);
+        free(pctx->same_pos_items);
+        remote_dep_coalescer_fini(&pctx->coalescer, context->nb_nodes);
+    }
+    free(remote_dep_progress_ctx); remote_dep_progress_ctx = NULL;
+    (void)context; (void)ret;
+}
+
 #ifdef PARSEC_PROF_TRACE
 int MPI_Activate_sk, MPI_Activate_ek;
 int MPI_Data_ctl_sk, MPI_Data_ctl_ek;
@@ -1288,12 +1569,54 @@ int remote_dep_mpi_on(parsec_context_t* context)
     return 0;
 }
 
+/**
+ * Returns the size of count elements of the datatype if they form a single
+ * block of memory starting at their address, or 0 otherwise.
+ */
+static size_t remote_dep_mpi_dense_size(parsec_datatype_t dtt, uint64_t count)
+{
+    MPI_Aint lb, extent, true_lb, true_extent;
+    int size;
+
+    if( (PARSEC_DATATYPE_NULL == dtt) || (0 == count) )
+        return 0;
+    MPI_Type_size(dtt, &size);
+    MPI_Type_get_extent(dtt, &lb, &extent);
+    MPI_Type_get_true_extent(dtt, &true_lb, &true_extent);
+    if( (0 != lb) || (0 != true_lb) || (size != extent) || (size != true_extent) )
+        return 0;
+    return (size_t)size * count;
+}
+
+/**
+ * Returns the size of the data of an output if they can be sent eagerly,
+ * behind the activation message, or 0 otherwise. Only PTG taskpools send
+ * eagerly, and the data must be available (no reshaping pending) and stored
+ * as a single block of memory, so that a memcpy is their packed form.
+ */
+static size_t remote_dep_mpi_eager_size(parsec_taskpool_t* tp,
+                                        parsec_dep_data_description_t* data)
+{
+#if defined(PARSEC_PROF_DRY_DEP)
+    (void)tp; (void)data;
+    return 0;
+#else
+    /* DTD receivers may not know the successors yet, keep the rendezvous */
+    if( PARSEC_TASKPOOL_TYPE_PTG != tp->taskpool_type )
+        return 0;
+    if( (NULL == data->data) || (NULL != data->data_future) )  /* controls have no data */
+        return 0;
+    return remote_dep_mpi_dense_size(data->remote.src_datatype, data->remote.src_count);
+#endif  /* defined(PARSEC_PROF_DRY_DEP) */
+}
+
 /**
  * Given a remote_dep_wire_activate message it packs as much as possible
  * into the provided buffer. If possible (short allowed and enough room
  * in the buffer) some of the arguments will also be packed. Beware, the
- * remote_dep_wire_activate message itself must be updated with the
- * correct length before packing.
+ * remote_dep_wire_activate message must be updated with the correct length
+ * before packing; this is done on a copy, as the progress threads can pack
+ * the same message for different peers at the same time.
  *
  * @returns 1 if the message can't be packed due to lack of space, or 0
  * otherwise.
@@ -1306,8 +1629,11 @@ static int remote_dep_mpi_pack_dep(int peer,
 {
     parsec_remote_deps_t *deps = (parsec_remote_deps_t*)item->cmd.activate.task.source_deps;
     remote_dep_wire_activate_t* msg = &deps->msg;
-    int k, dsize, saved_position = *position;
+    remote_dep_wire_activate_t wire;
+    int k, dsize, eager_size = 0, eager_budget, eager_offset = 0, saved_position = *position;
     uint32_t peer_bank, peer_mask, expected = 0;
+    remote_dep_datakey_t eager_mask = 0;
+    size_t bytes;
 #if defined(PARSEC_DEBUG) || defined(PARSEC_DEBUG_NOISIER)
     char tmp[MAX_TASK_STRLEN];
     remote_dep_cmd_to_string(&deps->msg, tmp, 128);
@@ -1318,7 +1644,29 @@ static int remote_dep_mpi_pack_dep(int peer,
 
     parsec_ce.pack_size(&parsec_ce, dep_count, dep_dtt, &dsize);
     dsize += deps->taskpool->tdm.module->outgoing_message_piggyback_size;
-    if( (length - (*position)) < dsize ) {  /* no room. bail out */
+
+    /* Select the data following the message: they must fit in the eager
+     * limit of the peer, even alone in a new buffer (behind the batch header
+     * and the alignment). Each of them starts aligned in the message. */
+    eager_budget = (int)remote_dep_eager_limit_peer(peer) - remote_dep_batch_header_size
+        - (int)deps->taskpool->tdm.module->outgoing_message_piggyback_size - (RDEP_EAGER_ALIGNMENT - 1);
+    for(k = 0; (eager_budget > 0) && (deps->outgoing_mask >> k); k++) {
+        if( !((1U << k) & deps->outgoing_mask )) continue;
+        if( !(deps->output[k].rank_bits[peer_bank] & peer_mask) ) continue;
+        bytes = remote_dep_mpi_eager_size(deps->taskpool, &deps->output[k].data);
+        if( 0 == bytes ) continue;
+        bytes = PARSEC_ALIGN(bytes, RDEP_EAGER_ALIGNMENT, size_t);
+        if( bytes > (size_t)eager_budget ) continue;
+        eager_mask |= (1U << k);
+        eager_size += (int)bytes;
+        eager_budget -= (int)bytes;
+    }
+    if( 0 != eager_mask ) {
+        eager_offset = (int)PARSEC_ALIGN(*position + dsize, RDEP_EAGER_ALIGNMENT, size_t) - (*position + dsize);
+        eager_size += eager_offset;
+    }
+
+    if( (length - (*position)) < (dsize + eager_size) ) {  /* no room. bail out */
         PARSEC_DEBUG_VERBOSE(20, parsec_debug_output, "Can't pack at %d/%d. Bail out!", *position, length);
         return 1;
     }
@@ -1326,7 +1674,11 @@ static int remote_dep_mpi_pack_dep(int peer,
     *position += dsize;
     assert((0 != msg->output_mask) &&   /* this should be preset */
            (msg->output_mask & deps->outgoing_mask) == deps->outgoing_mask);
-    msg->length = deps->taskpool->tdm.module->outgoing_message_piggyback_size;
+    wire = *msg;
+    wire.length = deps->taskpool->tdm.module->outgoing_message_piggyback_size + eager_size;
+    wire.eager_mask = eager_mask;
+    wire.eager_offset = eager_offset;
+    *position += eager_offset;
     item->cmd.activate.task.output_mask = 0;  /* clean start */
     /* Treat for special cases: CTL, Short, etc... */
     for(k = 0; deps->outgoing_mask >> k; k++) {
@@ -1342,6 +1694,18 @@ static int remote_dep_mpi_pack_dep(int peer,
             continue;
         }
 
+        if( (1U << k) & eager_mask ) {
+            /* Copy the data behind the message, the receiver will not ask for them */
+            bytes = remote_dep_mpi_eager_size(deps->taskpool, &deps->output[k].data);
+            memcpy(packed_buffer + *position, deps->output[k].data.data->device_private, bytes);
+            *position += (int)PARSEC_ALIGN(bytes, RDEP_EAGER_ALIGNMENT, size_t);
+            (void)parsec_atomic_fetch_inc_int64(&parsec_comm_eager_sent);
+            (void)parsec_atomic_fetch_add_int64(&parsec_comm_eager_sent_bytes, (int64_t)bytes);
+            PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "DATA\t%s\tparam %d\tdeps %p sent eagerly (%zu bytes)",
+                                 tmp, k, deps, bytes);
+            continue;
+        }
+
 #if defined(PARSEC_DEBUG) || defined(PARSEC_DEBUG_NOISIER)
         if(PARSEC_DATATYPE_NULL == deps->output[k].data.remote.src_datatype) {
             parsec_fatal("Output %d of %s has not defined a datatype: check that the data collection does"
@@ -1362,11 +1726,10 @@ static int remote_dep_mpi_pack_dep(int peer,
     parsec_debug_verbose(6, parsec_debug_output, "MPI:\tTO\t%d\tActivate\t% -8s\n"
           "    \t\t\twith datakey %lx\tmask %lx\t(tag=%d) eager mask %lu length %d",
           peer, tmp, msg->deps, msg->output_mask, -1,
-          msg->output_mask ^ item->cmd.activate.task.output_mask, msg->length);
+          msg->output_mask ^ item->cmd.activate.task.output_mask, wire.length);
 #endif
-    /* And now pack the updated message (msg->length and msg->output_mask) itself. */
-    parsec_ce.pack(&parsec_ce, msg, dep_count, dep_dtt, packed_buffer, length, &saved_position);
-    msg->length = dsize + deps->taskpool->tdm.module->outgoing_message_piggyback_size;
+    /* And now pack the updated message (length and output_mask) itself. */
+    parsec_ce.pack(&parsec_ce, &wire, dep_count, dep_dtt, packed_buffer, length, &saved_position);
     deps->taskpool->tdm.module->outgoing_message_pack(deps->taskpool, peer, packed_buffer, &saved_position, length);
     return 0;
 }
@@ -1440,58 +1803,98 @@ static int local_dep_nothread_reshape(parsec_execution_stream_t* es,
     return (MPI_SUCCESS == rc ? 0 : -1);
 }
 
+/* Monotonic clock in microseconds, for the coalescing windows */
+static inline uint64_t remote_dep_coalesce_now(void)
+{
+#if defined(PARSEC_HAVE_CLOCK_GETTIME)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec;
+#endif  /* defined(PARSEC_HAVE_CLOCK_GETTIME) */
+}
+
+/* A buffer for the activations toward the peer, or any peer if -1 */
+static remote_dep_coalesce_t *remote_dep_coalesce_new(int peer)
+{
+    int size = (-1 == peer) ? remote_dep_activate_size : remote_dep_activate_size_peer(peer);
+    remote_dep_coalesce_t *co = (remote_dep_coalesce_t*)malloc(sizeof(remote_dep_coalesce_t) + size);
+
+    PARSEC_OBJ_CONSTRUCT(&co->super, parsec_list_item_t);
+    co->peer = peer; co->count = 0; co->position = 0; co->ring = NULL; co->pending = 0;
+    co->size = size;
+    return co;
+}
+
+static void remote_dep_coalesce_free(remote_dep_coalesce_t *co)
+{
+    assert(0 == co->count);
+    PARSEC_OBJ_DESTRUCT(&co->super);
+    free(co);
+}
+
+static void remote_dep_coalescer_init(remote_dep_coalescer_t *coalescer, int nb_peers)
+{
+    coalescer->buffers = (remote_dep_coalesce_t**)calloc(nb_peers, sizeof(remote_dep_coalesce_t*));
+    coalescer->immediate = NULL;
+    PARSEC_OBJ_CONSTRUCT(&coalescer->pending, parsec_list_t);
+}
+
+static void remote_dep_coalescer_fini(remote_dep_coalescer_t *coalescer, int nb_peers)
+{
+    int i;
+
+    assert(parsec_list_nolock_is_empty(&coalescer->pending));
+    for( i = 0; i < nb_peers; i++ ) {
+        if( NULL == coalescer->buffers[i] ) continue;
+        remote_dep_coalesce_free(coalescer->buffers[i]);
+    }
+    free(coalescer->buffers); coalescer->buffers = NULL;
+    if( NULL != coalescer->immediate ) {
+        remote_dep_coalesce_free(coalescer->immediate);
+        coalescer->immediate = NULL;
+    }
+    PARSEC_OBJ_DESTRUCT(&coalescer->pending);
+}
+
 /**
- * Starting with a particular item pack as many remote_dep_wire_activate
- * messages with the same destination (from the item ring associated with
- * pos_list) into a buffer. Upon completion the entire buffer is send to the
- * remote peer, the completed messages are released and the header is updated to
- * the next unsent message.
+ * Send the activations packed in a coalescing buffer as a single message,
+ * then release the commands they came from. The buffer is empty and ready
+ * for the next activations toward the same peer.
  */
-static int remote_dep_nothread_send(parsec_execution_stream_t* es,
-                                    dep_cmd_item_t **head_item)
+static void remote_dep_coalesce_send(parsec_execution_stream_t* es,
+                                     remote_dep_coalesce_t *co)
 {
-    (void)es;
     parsec_remote_deps_t *deps;
-    dep_cmd_item_t *item = *head_item;
-    parsec_list_item_t* ring = NULL;
-    char packed_buffer[DEP_SHORT_BUFFER_SIZE];
-    int peer, position = 0;
+    parsec_comm_engine_t *ce = parsec_comm_engine_peer(co->peer);
+    parsec_list_item_t* ring = co->ring;
+    dep_cmd_item_t *item;
+    int32_t count = co->count;
+    int position = 0;
 #ifdef PARSEC_PROF_TRACE
     static int save_act = 0;
     int event_id = parsec_atomic_fetch_inc_int32(&save_act);
 #endif  /* PARSEC_PROF_TRACE */
 
-    peer = item->cmd.activate.peer;  /* this doesn't change */
-    deps = (parsec_remote_deps_t*)item->cmd.activate.task.source_deps;
-
-  pack_more:
-    assert(peer == item->cmd.activate.peer);
-    deps = (parsec_remote_deps_t*)item->cmd.activate.task.source_deps;
-
-    parsec_list_item_singleton((parsec_list_item_t*)item);
-    if( 0 == remote_dep_mpi_pack_dep(peer, item, packed_buffer,
-                                     DEP_SHORT_BUFFER_SIZE, &position) ) {
-        /* space left on the buffer. Move to the next item with the same destination */
-        dep_cmd_item_t* next = (dep_cmd_item_t*)parsec_list_item_ring_chop(&item->pos_list);
-        if( NULL == ring ) ring = (parsec_list_item_t*)item;
-        else parsec_list_item_ring_push(ring, (parsec_list_item_t*)item);
-        if( NULL != next ) {
-            item = container_of(next, dep_cmd_item_t, pos_list);
-            assert(DEP_ACTIVATE == item->action);
-            if( parsec_param_enable_aggregate )
-                goto pack_more;
-        } else item = NULL;
-    }
-    *head_item = item;
-    assert(NULL != ring);
+    assert(0 < co->count && NULL != ring);
+    /* the batch header was reserved when the first activation was packed */
+    parsec_ce.pack(&parsec_ce, &count, 1, parsec_datatype_int32_t,
+                   co->buffer, remote_dep_batch_header_size, &position);
+    deps = (parsec_remote_deps_t*)((dep_cmd_item_t*)ring)->cmd.activate.task.source_deps;
 
     TAKE_TIME_WITH_INFO(es->es_profile, MPI_Activate_sk, 0,
                         es->virtual_process->parsec_context->my_rank,
-                        peer, deps->msg, position, MPI_PACKED, MPI_COMM_WORLD);
-    parsec_ce.send_am(&parsec_ce, PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG, peer, packed_buffer, position);
+                        co->peer, deps->msg, co->position, MPI_PACKED, MPI_COMM_WORLD);
+    ce->send_am(ce, PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG, co->peer, co->buffer, co->position);
     TAKE_TIME(es->es_profile, MPI_Activate_ek, event_id);
-    DEBUG_MARK_CTL_MSG_ACTIVATE_SENT(peer, (void*)&deps->msg, &deps->msg);
+    DEBUG_MARK_CTL_MSG_ACTIVATE_SENT(co->peer, (void*)&deps->msg, &deps->msg);
 
+    co->ring = NULL;
+    co->count = 0;
+    co->position = 0;
     do {
         item = (dep_cmd_item_t*)ring;
         ring = parsec_list_item_ring_chop(ring);
@@ -1501,6 +1904,104 @@ static int remote_dep_nothread_send(parsec_execution_stream_t* es,
 
         remote_dep_complete_and_cleanup(&deps, 1);
     } while( NULL != ring );
+    (void)es;
+}
+
+/**
+ * Send the coalescing buffers whose window expired, or all of them if
+ * requested (the thread has nothing else to do, or is about to stop).
+ */
+static void remote_dep_coalescer_flush(parsec_execution_stream_t* es,
+                                       remote_dep_coalescer_t *coalescer, int all)
+{
+    remote_dep_coalesce_t *co;
+    uint64_t now = 0;
+
+    if( parsec_list_nolock_is_empty(&coalescer->pending) ) return;
+    if( !all ) now = remote_dep_coalesce_now();
+    while( NULL != (co = (remote_dep_coalesce_t*)PARSEC_LIST_ITERATOR_FIRST(&coalescer->pending))
+           && (co != (remote_dep_coalesce_t*)PARSEC_LIST_ITERATOR_END(&coalescer->pending)) ) {
+        /* the oldest buffer is first, the others expire later */
+        if( !all && (now - co->start) < (uint64_t)parsec_param_comm_coalesce_window )
+            break;
+        parsec_list_nolock_remove(&coalescer->pending, &co->super);
+        co->pending = 0;
+        remote_dep_coalesce_send(es, co);
+    }
+}
+
+/**
+ * Starting with a particular item pack as many remote_dep_wire_activate
+ * messages with the same destination (from the item ring associated with
+ * pos_list) into the coalescing buffer of the peer, behind a batch header
+ * holding their count. Without a coalescer, or without a coalescing window,
+ * the buffer is sent right away; otherwise it is sent when full, and the
+ * rest waits for remote_dep_coalescer_flush. The completed messages are
+ * released once sent and the header is updated to the next unpacked message.
+ */
+static int remote_dep_nothread_send(parsec_execution_stream_t* es,
+                                    dep_cmd_item_t **head_item,
+                                    remote_dep_coalescer_t *coalescer)
+{
+    dep_cmd_item_t *item = *head_item;
+    remote_dep_coalesce_t *co, *transient = NULL;
+    int peer, aggregate = parsec_param_enable_aggregate;
+
+    peer = item->cmd.activate.peer;  /* this doesn't change */
+    if( NULL == coalescer ) {
+        /* a computation thread, without buffer of its own */
+        co = transient = remote_dep_coalesce_new(-1);
+    } else if( 0 == parsec_param_comm_coalesce_window ) {
+        if( NULL == (co = coalescer->immediate) )
+            co = coalescer->immediate = remote_dep_coalesce_new(-1);
+        coalescer = NULL;
+    } else {
+        if( NULL == (co = coalescer->buffers[peer]) )
+            co = coalescer->buffers[peer] = remote_dep_coalesce_new(peer);
+        aggregate = 1;  /* coalescing implies aggregating the ring */
+    }
+    co->peer = peer;
+
+  pack_more:
+    assert(peer == item->cmd.activate.peer);
+    if( 0 == co->count ) {
+        co->position = remote_dep_batch_header_size;
+        co->start = (NULL != coalescer) ? remote_dep_coalesce_now() : 0;
+    }
+    parsec_list_item_singleton((parsec_list_item_t*)item);
+    if( 0 == remote_dep_mpi_pack_dep(peer, item, co->buffer,
+                                     remote_dep_activate_size_peer(peer), &co->position) ) {
+        /* space left on the buffer. Move to the next item with the same destination */
+        dep_cmd_item_t* next = (dep_cmd_item_t*)parsec_list_item_ring_chop(&item->pos_list);
+        if( NULL == co->ring ) co->ring = (parsec_list_item_t*)item;
+        else parsec_list_item_ring_push(co->ring, (parsec_list_item_t*)item);
+        co->count++;
+        if( NULL != next ) {
+            item = container_of(next, dep_cmd_item_t, pos_list);
+            assert(DEP_ACTIVATE == item->action);
+            if( aggregate )
+                goto pack_more;
+        } else item = NULL;
+    } else if( NULL != coalescer && 0 < co->count ) {
+        /* the buffer is full: send it and start a new one with this item */
+        if( co->pending ) {
+            parsec_list_nolock_remove(&coalescer->pending, &co->super);
+            co->pending = 0;
+        }
+        remote_dep_coalesce_send(es, co);
+        goto pack_more;
+    }
+    *head_item = item;
+    assert(0 < co->count);
+
+    if( NULL == coalescer ) {
+        remote_dep_coalesce_send(es, co);
+        if( NULL != transient )
+            remote_dep_coalesce_free(transient);
+    } else if( !co->pending ) {
+        parsec_list_nolock_push_back(&coalescer->pending, &co->super);
+        co->pending = 1;
+    }
     return 0;
 }
 
@@ -1517,6 +2018,8 @@ static int remote_dep_mpi_progress(parsec_execution_stream_t* es)
     if( !PARSEC_THREAD_IS_MASTER(es) ) return 0;
 
     ret = parsec_ce.progress(&parsec_ce);
+    if( NULL != parsec_ce_local )
+        ret += parsec_ce_local->progress(parsec_ce_local);
 
     if(parsec_ce.can_serve(&parsec_ce) && !parsec_list_nolock_is_empty(&dep_activates_fifo)) {
             parsec_remote_deps_t* deps = (parsec_remote_deps_t*)parsec_list_nolock_pop_front(&dep_activates_fifo);
@@ -1597,6 +2100,7 @@ remote_dep_mpi_put_start(parsec_execution_stream_t* es,
     remote_dep_wire_get_t* task = &(item->cmd.activate.task);
 #if !defined(PARSEC_PROF_DRY_DEP)
     parsec_remote_deps_t* deps = (parsec_remote_deps_t*) (uintptr_t) task->source_deps;
+    parsec_comm_engine_t *ce = parsec_comm_engine_peer(item->cmd.activate.peer);
     int k, nbdtt;
     void* dataptr;
     MPI_Datatype dtt;
@@ -1673,8 +2177,8 @@ remote_dep_mpi_put_start(parsec_execution_stream_t* es,
         parsec_ce_mem_reg_handle_t source_memory_handle;
         size_t source_memory_handle_size;
 
-        if(parsec_ce.capabilites.supports_noncontiguous_datatype) {
-            parsec_ce.mem_register(dataptr, PARSEC_MEM_TYPE_NONCONTIGUOUS,
+        if(ce->capabilites.supports_noncontiguous_datatype) {
+            ce->mem_register(dataptr, PARSEC_MEM_TYPE_NONCONTIGUOUS,
                                    nbdtt, dtt,
                                    -1,
                                    &source_memory_handle, &source_memory_handle_size);
@@ -1682,7 +2186,7 @@ remote_dep_mpi_put_start(parsec_execution_stream_t* es,
             /* TODO: Implement converter to pack and unpack */
             int dtt_size;
             parsec_type_size(dtt, &dtt_size);
-            parsec_ce.mem_register(dataptr, PARSEC_MEM_TYPE_CONTIGUOUS,
+            ce->mem_register(dataptr, PARSEC_MEM_TYPE_CONTIGUOUS,
                                    -1, NULL, // TODO JS: this interface is so broken, fix it!
                                    dtt_size, // TODO JS: what about nbdtt? Is it ok to ignore it?!
                                    &source_memory_handle, &source_memory_handle_size);
@@ -1707,7 +2211,7 @@ remote_dep_mpi_put_start(parsec_execution_stream_t* es,
                             item->cmd.activate.peer, deps->msg, nbdtt, dtt, MPI_COMM_WORLD);
 
         /* the remote side should send us 8 bytes as the callback data to be passed back to them */
-        parsec_ce.put(&parsec_ce, source_memory_handle, 0,
+        ce->put(ce, source_memory_handle, 0,
                       remote_memory_handle, 0,
                       0, item->cmd.activate.peer,
                       remote_dep_mpi_put_end_cb, cb_data,
@@ -1756,6 +2260,106 @@ remote_dep_mpi_put_end_cb(parsec_comm_engine_t *ce,
 }
 
 
+/**
+ * The activation message being delivered to remote_dep_mpi_save_activate_cb,
+ * whose buffer the data sent eagerly in it can adopt. Once adopted, the
+ * buffer is released with the last of the copies using it, and with the
+ * end of the callback.
+ */
+typedef struct remote_dep_eager_msg_s {
+    parsec_comm_engine_t *ce;
+    char                 *msg;
+    int32_t              *refcount;   /* in front of the adopted buffer, or NULL */
+} remote_dep_eager_msg_t;
+
+static remote_dep_eager_msg_t remote_dep_eager_msg = { NULL, NULL, NULL };
+
+static void remote_dep_eager_msg_release(void *cb_data)
+{
+    int32_t *refcount = (int32_t*)cb_data;
+    if( 1 == parsec_atomic_fetch_dec_int32(refcount) ) {
+        free(refcount);
+    }
+}
+
+/**
+ * Try to hand the data of the output, in the message at packed_buffer +
+ * position, to the local tasks without copying them: they must be aligned
+ * as the arena of the dependency requires, and fill their copy.
+ */
+static parsec_data_copy_t* remote_dep_mpi_eager_adopt(parsec_dep_type_description_t* remote,
+                                                      char* packed_buffer, int position, size_t bytes)
+{
+    remote_dep_eager_msg_t *em = &remote_dep_eager_msg;
+    parsec_data_copy_t *dc;
+    char *ptr = packed_buffer + position;
+    void *buffer;
+
+    if( (packed_buffer != em->msg) || (NULL == em->ce->am_adopt) || (NULL == remote->arena) ||
+        (0 != remote->dst_displ) || (bytes < remote->arena->elem_size * remote->dst_count) ||
+        (0 != ((uintptr_t)ptr % remote->arena->alignment)) )
+        return NULL;
+    if( NULL == em->refcount ) {
+        /* The reference counter goes in front of the message, where the
+         * batch header was read */
+        assert(remote_dep_batch_header_size >= (int)sizeof(int32_t));
+        if( NULL == (buffer = em->ce->am_adopt(em->ce, em->msg)) )
+            return NULL;
+        assert(buffer == (void*)em->msg);
+        em->refcount = (int32_t*)buffer;
+        *em->refcount = 1;  /* for the callback */
+    }
+    (void)parsec_atomic_fetch_inc_int32(em->refcount);
+    dc = parsec_arena_adopt_copy(remote->arena, ptr, remote->dst_count, 0, remote->dst_datatype,
+                                 remote_dep_eager_msg_release, em->refcount);
+    if( NULL == dc ) {
+        remote_dep_eager_msg_release(em->refcount);
+        return NULL;
+    }
+    dc->coherency_state = PARSEC_DATA_COHERENCY_EXCLUSIVE;
+    return dc;
+}
+
+/**
+ * Extract the data of the output k sent eagerly behind the activation
+ * message directly into the copy that will be released to the local tasks.
+ * The sender copied them from a single block of memory, so they are already
+ * in their packed form, and when they are suitably aligned the copy adopts
+ * the message buffer instead.
+ */
+static void remote_dep_mpi_eager_unpack(parsec_remote_deps_t* deps, int k,
+                                        char* packed_buffer, int length, int* position)
+{
+    parsec_dep_type_description_t* remote = &deps->output[k].data.remote;
+    size_t bytes;
+    void* dataptr;
+
+    assert(NULL == deps->output[k].data.data);
+    bytes = remote_dep_mpi_dense_size(remote->dst_datatype, remote->dst_count);
+    if( (0 != bytes) &&
+        (NULL != (deps->output[k].data.data = remote_dep_mpi_eager_adopt(remote, packed_buffer, *position, bytes))) ) {
+        assert((*position + (int)bytes) <= length);
+        *position += (int)PARSEC_ALIGN(bytes, RDEP_EAGER_ALIGNMENT, size_t);
+        parsec_comm_eager_adopted++;
+        return;
+    }
+    deps->output[k].data.data = remote_dep_copy_allocate(remote);
+    assert(NULL != deps->output[k].data.data);
+    dataptr = PARSEC_DATA_COPY_GET_PTR(deps->output[k].data.data);
+    if( 0 != bytes ) {
+        assert((*position + (int)bytes) <= length);
+        memcpy(dataptr, packed_buffer + *position, bytes);
+        *position += (int)PARSEC_ALIGN(bytes, RDEP_EAGER_ALIGNMENT, size_t);
+    } else {
+        /* the sender aligned the data as a memcpy of them */
+        int start = *position;
+        parsec_ce.unpack(&parsec_ce, packed_buffer, length, position,
+                         dataptr, remote->dst_count, remote->dst_datatype);
+        *position = start + (int)PARSEC_ALIGN(*position - start, RDEP_EAGER_ALIGNMENT, size_t);
+    }
+    parsec_comm_eager_copied++;
+}
+
 /**
  * An activation message has been received, and the remote_dep_wire_activate_t
  * part has already been extracted into the deps->msg. This function handles the
@@ -1788,6 +2392,9 @@ static void remote_dep_mpi_recv_activate(parsec_execution_stream_t* es,
     deps->taskpool->tdm.module->incoming_message_start(deps->taskpool, deps->from, packed_buffer, position,
                                                        length, deps);
         
+    assert((deps->msg.eager_mask & deps->incoming_mask) == deps->msg.eager_mask);
+    if( 0 != deps->msg.eager_mask )
+        *position += deps->msg.eager_offset;
     for(k = 0; deps->incoming_mask>>k; k++) {
         if(!(deps->incoming_mask & (1U<<k))) continue;
         /* Check for CTL and data that do not carry payload */
@@ -1798,6 +2405,14 @@ static void remote_dep_mpi_recv_activate(parsec_execution_stream_t* es,
             complete_mask |= (1U<<k);
             continue;
         }
+        /* The data sent eagerly go from the message to their final copy */
+        if( (1U<<k) & deps->msg.eager_mask ) {
+            remote_dep_mpi_eager_unpack(deps, k, packed_buffer, length, position);
+            PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "MPI:\tHERE\t%d\tGet EAGER\t% -8s\tk=%d\twith datakey %lx at %p",
+                    deps->from, tmp, k, deps->msg.deps, deps->output[k].data.data);
+            complete_mask |= (1U<<k);
+            continue;
+        }
     }
     assert(length == *position);
 
@@ -1840,9 +2455,25 @@ remote_dep_mpi_save_activate_cb(parsec_comm_engine_t *ce, parsec_ce_tag_t tag,
     char tmp[MAX_TASK_STRLEN];
 #endif
     int position = 0, length = msg_size, rc;
+    int32_t n, count, vp;
     parsec_remote_deps_t* deps = NULL;
-
-    while(position < length) {
+    remote_dep_eager_msg_t outer;
+    parsec_task_t **outer_rings = es->gathered_rings, **ready_rings = NULL;
+
+    /* The batch header gives the number of activations in the message */
+    ce->unpack(ce, msg, length, &position, &count, 1, parsec_datatype_int32_t);
+    assert(remote_dep_batch_header_size == position);
+    if( count > 1 ) {
+        /* The tasks released by the whole batch are scheduled at once */
+        ready_rings = (parsec_task_t**)alloca(sizeof(parsec_task_t*) * es->virtual_process->parsec_context->nb_vp);
+        for( vp = 0; vp < es->virtual_process->parsec_context->nb_vp; ready_rings[vp++] = NULL );
+        es->gathered_rings = ready_rings;
+    }
+    outer = remote_dep_eager_msg;
+    remote_dep_eager_msg.ce       = ce;
+    remote_dep_eager_msg.msg      = (char*)msg;
+    remote_dep_eager_msg.refcount = NULL;
+    for( n = 0; n < count; n++ ) {
         deps = remote_deps_allocate(&parsec_remote_dep_context.freelist);
 
         ce->unpack(ce, msg, length, &position, &deps->msg, dep_count, dep_dtt);
@@ -1862,6 +2493,7 @@ remote_dep_mpi_save_activate_cb(parsec_comm_engine_t *ce, parsec_ce_tag_t tag,
                     0, deps->msg.deps, deps->msg.output_mask);
             /* Copy the eager data to some temp storage */
             packed_buffer = malloc(deps->msg.length);
+            PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_REMOTE_DEPS, deps->msg.length);
             memcpy(packed_buffer, msg + position, deps->msg.length);
             position += deps->msg.length;  /* move to the next order */
             deps->taskpool = (parsec_taskpool_t*)packed_buffer;  /* temporary storage */
@@ -1881,9 +2513,15 @@ remote_dep_mpi_save_activate_cb(parsec_comm_engine_t *ce, parsec_ce_tag_t tag,
         /* Import the activation message and prepare for the reception */
         remote_dep_mpi_recv_activate(es, deps, msg,
                                      position + deps->msg.length, &position);
-        assert( parsec_param_enable_aggregate || (position == length));
     }
     assert(position == length);
+    es->gathered_rings = outer_rings;
+    if( NULL != ready_rings )
+        __parsec_schedule_vp(es, ready_rings, 0);
+    /* The copies adopting the message may outlive the callback */
+    if( NULL != remote_dep_eager_msg.refcount )
+        remote_dep_eager_msg_release(remote_dep_eager_msg.refcount);
+    remote_dep_eager_msg = outer;
     PARSEC_PINS(es, ACTIVATE_CB_END, NULL);
     return 1;
 }
@@ -1925,6 +2563,7 @@ remote_dep_mpi_new_taskpool(parsec_execution_stream_t* es,
             }
 
             remote_dep_mpi_recv_activate(es, deps, buffer, deps->msg.length, &position);
+            PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_REMOTE_DEPS, -(int64_t)deps->msg.length);
             free(buffer);
             (void)rc;
         }
@@ -1956,6 +2595,7 @@ remote_dep_mpi_release_delayed_deps(parsec_execution_stream_t* es,
 
     assert(deps != NULL);
     remote_dep_mpi_recv_activate(es, deps, buffer, deps->msg.length, &position);
+    PARSEC_MEM_FOOTPRINT_ADD(PARSEC_MEM_FOOTPRINT_REMOTE_DEPS, -(int64_t)deps->msg.length);
     free(buffer);
     PARSEC_PINS(es, ACTIVATE_CB_END, NULL);
 }
@@ -1965,6 +2605,7 @@ static void remote_dep_mpi_get_start(parsec_execution_stream_t* es,
 {
     remote_dep_wire_activate_t* task = &(deps->msg);
     int from = deps->from, k, count, nbdtt;
+    parsec_comm_engine_t *ce = parsec_comm_engine_peer(from);
     remote_dep_wire_get_t msg;
     MPI_Datatype dtt;
 #if defined(PARSEC_DEBUG_NOISIER)
@@ -2017,8 +2658,8 @@ static void remote_dep_mpi_get_start(parsec_execution_stream_t* es,
         parsec_ce_mem_reg_handle_t receiver_memory_handle;
         size_t receiver_memory_handle_size;
 
-        if(parsec_ce.capabilites.supports_noncontiguous_datatype) {
-            parsec_ce.mem_register(PARSEC_DATA_COPY_GET_PTR(deps->output[k].data.data), PARSEC_MEM_TYPE_NONCONTIGUOUS,
+        if(ce->capabilites.supports_noncontiguous_datatype) {
+            ce->mem_register(PARSEC_DATA_COPY_GET_PTR(deps->output[k].data.data), PARSEC_MEM_TYPE_NONCONTIGUOUS,
                                    nbdtt, dtt,
                                    -1,
                                    &receiver_memory_handle, &receiver_memory_handle_size);
@@ -2026,7 +2667,7 @@ static void remote_dep_mpi_get_start(parsec_execution_stream_t* es,
             /* TODO: Implement converter to pack and unpack */
             int dtt_size;
             parsec_type_size(dtt, &dtt_size);
-            parsec_ce.mem_register(PARSEC_DATA_COPY_GET_PTR(deps->output[k].data.data), PARSEC_MEM_TYPE_CONTIGUOUS,
+            ce->mem_register(PARSEC_DATA_COPY_GET_PTR(deps->output[k].data.data), PARSEC_MEM_TYPE_CONTIGUOUS,
                                    -1, NULL,
                                    dtt_size,
                                    &receiver_memory_handle, &receiver_memory_handle_size);
@@ -2062,7 +2703,7 @@ static void remote_dep_mpi_get_start(parsec_execution_stream_t* es,
                 receiver_memory_handle_size );
 
         /* Send AM */
-        parsec_ce.send_am(&parsec_ce, PARSEC_CE_REMOTE_DEP_GET_DATA_TAG, from, buf, buf_size);
+        ce->send_am(ce, PARSEC_CE_REMOTE_DEP_GET_DATA_TAG, from, buf, buf_size);
         TAKE_TIME(es->es_profile, MPI_Data_ctl_ek, event_id);
 
         free(buf);
@@ -2087,7 +2728,7 @@ remote_dep_mpi_get_end_cb(parsec_comm_engine_t *ce,
                           int src,
                           void *cb_data)
 {
-    (void) ce; (void) tag; (void) msg_size; (void) cb_data; (void) src;
+    (void) tag; (void) msg_size; (void) cb_data; (void) src;
     parsec_execution_stream_t* es = &parsec_comm_es;
 
     /* We send 8 bytes to the source to give it back to us when the PUT is completed,
@@ -2109,7 +2750,7 @@ remote_dep_mpi_get_end_cb(parsec_comm_engine_t *ce,
     TAKE_TIME(es->es_profile, MPI_Data_pldr_ek, callback_data->k);
     remote_dep_mpi_get_end(es, callback_data->k, deps);
 
-    parsec_ce.mem_unregister(&callback_data->memory_handle);
+    ce->mem_unregister(&callback_data->memory_handle);
     parsec_thread_mempool_free(parsec_remote_dep_cb_data_mempool->thread_mempools, callback_data);
 
     parsec_comm_gets--;
@@ -2149,10 +2790,12 @@ remote_dep_ce_init(parsec_context_t* context)
     parsec_mpi_same_pos_items_size = context->nb_nodes + (int)DEP_LAST;
     parsec_mpi_same_pos_items = (dep_cmd_item_t**)calloc(parsec_mpi_same_pos_items_size,
                                                         sizeof(dep_cmd_item_t*));
+    remote_dep_coalescer_init(&dep_coalescer, context->nb_nodes);
+    parsec_ce.pack_size(&parsec_ce, 1, parsec_datatype_int32_t, &remote_dep_batch_header_size);
 
     /* Register Persistant requests */
     rc = parsec_ce.tag_register(PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG, remote_dep_mpi_save_activate_cb, context,
-                                DEP_SHORT_BUFFER_SIZE * sizeof(char));
+                                remote_dep_activate_size * sizeof(char));
     if( PARSEC_SUCCESS != rc ) {
         parsec_warning("[CE] Failed to register communication tag PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG (error %d)\n", rc);
         parsec_comm_engine_fini(&parsec_ce);
@@ -2166,34 +2809,68 @@ remote_dep_ce_init(parsec_context_t* context)
         parsec_comm_engine_fini(&parsec_ce);
         return rc;
     }
+#if defined(PARSEC_DIST_WITH_SHM)
+    if( NULL != parsec_ce_local ) {
+        /* The same tags for the processes of the same node. The decision
+         * does not depend on the process, all of them keep the engine or
+         * none of them do. */
+        rc = parsec_ce_local->tag_register(PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG, remote_dep_mpi_save_activate_cb, context,
+                                           DEP_SHORT_BUFFER_SIZE * sizeof(char));
+        if( PARSEC_SUCCESS == rc ) {
+            rc = parsec_ce_local->tag_register(PARSEC_CE_REMOTE_DEP_GET_DATA_TAG, remote_dep_mpi_save_put_cb, context,
+                                               4096);
+            if( PARSEC_SUCCESS != rc )
+                parsec_ce_local->tag_unregister(PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG);
+        }
+        if( PARSEC_SUCCESS != rc ) {
+            parsec_warning("[CE] Failed to register the communication tags on the shared memory engine (error %d), using MPI within the node\n", rc);
+            shm_engine_fini(parsec_ce_local);
+            parsec_ce_local = NULL;
+        }
+    }
+#endif  /* defined(PARSEC_DIST_WITH_SHM) */
 
     parsec_remote_dep_cb_data_mempool = (parsec_mempool_t*) malloc (sizeof(parsec_mempool_t));
     parsec_mempool_construct(parsec_remote_dep_cb_data_mempool,
                              PARSEC_OBJ_CLASS(remote_dep_cb_data_t), sizeof(remote_dep_cb_data_t),
                              offsetof(remote_dep_cb_data_t, mempool_owner),
                              1);
+    parsec_mempool_set_footprint(parsec_remote_dep_cb_data_mempool, PARSEC_MEM_FOOTPRINT_REMOTE_DEPS);
     /* Lazy or delayed initializations */
     remote_dep_mpi_initialize_execution_stream(context);
 
     remote_dep_mpi_profiling_init();
+    remote_dep_progress_ctx_init(context);
     return 0;
 }
 
 static int
 remote_dep_ce_fini(parsec_context_t* context)
 {
+    remote_dep_progress_ctx_fini(context);
     remote_dep_mpi_profiling_fini();
 
+    parsec_debug_verbose(3, parsec_comm_output_stream,
+                         "MPI:\teager protocol: %"PRId64" outputs sent (%"PRId64" bytes), %"PRId64" received "
+                         "in the message buffer (copy avoided), %"PRId64" copied out of it",
+                         parsec_comm_eager_sent, parsec_comm_eager_sent_bytes,
+                         parsec_comm_eager_adopted, parsec_comm_eager_copied);
+
     // Unregister tags
     parsec_ce.tag_unregister(PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG);
     parsec_ce.tag_unregister(PARSEC_CE_REMOTE_DEP_GET_DATA_TAG);
     //parsec_ce.tag_unregister(PARSEC_CE_REMOTE_DEP_PUT_END_TAG);
+    if( NULL != parsec_ce_local ) {
+        parsec_ce_local->tag_unregister(PARSEC_CE_REMOTE_DEP_ACTIVATE_TAG);
+        parsec_ce_local->tag_unregister(PARSEC_CE_REMOTE_DEP_GET_DATA_TAG);
+    }
 
     parsec_mempool_destruct(parsec_remote_dep_cb_data_mempool);
     free(parsec_remote_dep_cb_data_mempool); parsec_remote_dep_cb_data_mempool = NULL;
 
     free(parsec_mpi_same_pos_items); parsec_mpi_same_pos_items = NULL;
     parsec_mpi_same_pos_items_size = 0;
+    remote_dep_coalescer_fini(&dep_coalescer, context->nb_nodes);
 
     PARSEC_OBJ_DESTRUCT(&dep_activates_fifo);
     PARSEC_OBJ_DESTRUCT(&dep_activates_noobj_fifo);
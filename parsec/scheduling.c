@@ -22,9 +22,11 @@
 #include "parsec/constants.h"
 #include "parsec/interfaces/dtd/insert_function_internal.h"
 #include "parsec/class/list.h"
+#include "parsec/class/parsec_ebr.h"
 #include "parsec/utils/debug.h"
 #include "parsec/dictionary.h"
 #include "parsec/utils/backoff.h"
+#include "parsec/utils/argv.h"
 
 #include <signal.h>
 #if defined(PARSEC_HAVE_STRING_H)
@@ -38,6 +40,11 @@
 #if defined(PARSEC_HAVE_UNISTD_H)
 #include <unistd.h>
 #endif  /* defined(PARSEC_HAVE_UNISTD_H) */
+#if defined(PARSEC_HAVE_FUTEX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif  /* defined(PARSEC_HAVE_FUTEX) */
+#include <time.h>
 #if defined(PARSEC_PROF_RUSAGE_EU) && defined(PARSEC_HAVE_GETRUSAGE) && defined(PARSEC_HAVE_RUSAGE_THREAD) && !defined(__bgp__)
 #include <sys/time.h>
 #include <sys/resource.h>
@@ -68,16 +75,33 @@ static void parsec_rusage_per_es(parsec_execution_stream_t* es, bool print)
                       "Block Input Operations      : %10ld\n"
                       "Block Output Operations     : %10ld\n"
                       "Maximum Resident Memory     : %10ld\n"
+                      "Idle Spin Time (secs)       : %10.3f\n"
+                      "Parked Time (secs)          : %10.3f\n"
+                      "Parks / Wake Ups            : %10u / %u\n"
+                      "Wake Up Latency avg (usecs) : %10.3f\n"
+                      "Wake Up Latency max (usecs) : %10.3f\n"
+                      "Chained Tasks / Chain Cuts  : %10u / %u\n"
+                      "Tasks Handed Off to Other VP: %10u\n"
                       "=============================================================\n"
                       , es->virtual_process->vp_id, es->th_id, es->core_id, es->socket_id,
                       usr, sys, usr + sys,
                       (current.ru_minflt  - es->_es_rusage.ru_minflt), (current.ru_majflt  - es->_es_rusage.ru_majflt),
                       (current.ru_nswap   - es->_es_rusage.ru_nswap) , (current.ru_nvcsw   - es->_es_rusage.ru_nvcsw),
+                      (current.ru_nivcsw  - es->_es_rusage.ru_nivcsw),
                       (current.ru_inblock - es->_es_rusage.ru_inblock), (current.ru_oublock - es->_es_rusage.ru_oublock),
-                      current.ru_maxrss);
+                      current.ru_maxrss,
+                      es->idle_spin_ns / 1e9, es->idle_park_ns / 1e9, es->nb_parks, es->nb_wakeups,
+                      (0 == es->nb_wakeups) ? 0.0 : es->wake_latency_ns / 1e3 / es->nb_wakeups,
+                      es->max_wake_latency_ns / 1e3,
+                      es->nb_chained, es->nb_chain_cuts, es->nb_handoffs);
 
     }
     es->_es_rusage = current;
+    es->idle_spin_ns = es->idle_park_ns = 0;
+    es->nb_parks = es->nb_wakeups = 0;
+    es->wake_latency_ns = es->max_wake_latency_ns = 0;
+    es->nb_chained = es->nb_chain_cuts = 0;
+    es->nb_handoffs = 0;
     return;
 }
 #define parsec_rusage_per_es(eu, b) do { if(parsec_want_rusage > 1) parsec_rusage_per_es(eu, b); } while(0)
@@ -220,20 +244,176 @@ static inline int all_tasks_done(parsec_context_t* context)
     return (context->active_taskpools == 0);
 }
 
+/*
+ * Parking of the idle execution streams.
+ *
+ * A stream that did not find any task for parsec_runtime_park_spin
+ * microseconds announces itself in nb_parked, looks one last time for a task,
+ * and sleeps on the park_seq word of its virtual process. Any thread that
+ * schedules tasks on the virtual process then changes park_seq and wakes up
+ * as many parked streams as it published tasks. The announcement and the
+ * publication are both followed by a full memory barrier, so either the
+ * publisher sees the parked stream, or the stream finds the new task in its
+ * last look. Parked streams also wake up when the context has no more active
+ * taskpools, and after parsec_runtime_park_timeout microseconds in any case.
+ */
+static inline uint64_t parsec_park_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Returns 1 if the stream was woken up by __parsec_park_wake, 0 on timeout */
+static int __parsec_park_wait(parsec_vp_t *vp, int32_t seq)
+{
+    struct timespec ts;
+#if defined(PARSEC_HAVE_FUTEX)
+    ts.tv_sec  = parsec_runtime_park_timeout / 1000000;
+    ts.tv_nsec = (parsec_runtime_park_timeout % 1000000) * 1000;
+    (void)syscall(SYS_futex, &vp->park_seq, FUTEX_WAIT_PRIVATE, seq, &ts, NULL, 0);
+#else
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += parsec_runtime_park_timeout / 1000000;
+    ts.tv_nsec += (parsec_runtime_park_timeout % 1000000) * 1000;
+    if( ts.tv_nsec >= 1000000000 ) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    pthread_mutex_lock(&vp->park_lock);
+    if( vp->park_seq == seq )
+        (void)pthread_cond_timedwait(&vp->park_cond, &vp->park_lock, &ts);
+    pthread_mutex_unlock(&vp->park_lock);
+#endif  /* defined(PARSEC_HAVE_FUTEX) */
+    return vp->park_seq != seq;
+}
+
+static void __parsec_park_wake(parsec_vp_t *vp, int32_t nb)
+{
+    vp->park_wake_ns = parsec_park_now();
+#if defined(PARSEC_HAVE_FUTEX)
+    (void)parsec_atomic_fetch_inc_int32(&vp->park_seq);
+    (void)syscall(SYS_futex, &vp->park_seq, FUTEX_WAKE_PRIVATE, nb, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&vp->park_lock);
+    vp->park_seq++;
+    if( nb >= vp->nb_parked ) {
+        pthread_cond_broadcast(&vp->park_cond);
+    } else {
+        for( ; nb > 0; nb-- ) pthread_cond_signal(&vp->park_cond);
+    }
+    pthread_mutex_unlock(&vp->park_lock);
+#endif  /* defined(PARSEC_HAVE_FUTEX) */
+}
+
+/* Called after nb tasks have been published on the virtual process vp */
+static inline void __parsec_park_notify(parsec_vp_t *vp, int32_t nb)
+{
+    int32_t nb_parked;
+    if( parsec_runtime_park_spin < 0 ) return;
+    parsec_mfence();
+    nb_parked = vp->nb_parked;
+    if( 0 == nb_parked ) return;
+    __parsec_park_wake(vp, (nb < nb_parked) ? nb : nb_parked);
+}
+
+/* Wake up all the parked streams of the context, when it runs out of work */
+static void __parsec_park_wake_all(parsec_context_t *context)
+{
+    int p;
+    if( parsec_runtime_park_spin < 0 ) return;
+    parsec_mfence();
+    for( p = 0; p < context->nb_vp; p++ ) {
+        if( 0 != context->virtual_processes[p]->nb_parked )
+            __parsec_park_wake(context->virtual_processes[p], INT32_MAX);
+    }
+}
+
+/*
+ * Park the execution stream until new tasks are scheduled on its virtual
+ * process. Returns the task found by the last look in the scheduler, if any.
+ */
+static parsec_task_t *__parsec_park(parsec_execution_stream_t *es, int32_t *distance)
+{
+    parsec_vp_t *vp = es->virtual_process;
+    parsec_task_t *task;
+    uint64_t start, end, wake;
+    int32_t seq = vp->park_seq;
+
+    (void)parsec_atomic_fetch_inc_int32(&vp->nb_parked);
+    parsec_mfence();
+    task = es->virtual_process->scheduler->module.select(es, distance);
+    if( (NULL == task) && !all_tasks_done(vp->parsec_context) ) {
+        es->nb_parks++;
+        start = parsec_park_now();
+        if( __parsec_park_wait(vp, seq) ) {
+            end = parsec_park_now();
+            wake = vp->park_wake_ns;
+            es->nb_wakeups++;
+            if( (wake >= start) && (end > wake) ) {
+                es->wake_latency_ns += end - wake;
+                if( end - wake > es->max_wake_latency_ns )
+                    es->max_wake_latency_ns = end - wake;
+            }
+        } else {
+            end = parsec_park_now();
+        }
+        es->idle_park_ns += end - start;
+    }
+    (void)parsec_atomic_fetch_dec_int32(&vp->nb_parked);
+    return task;
+}
+
+/*
+ * Returns the number of tasks in a ring of tasks, up to max.
+ */
+static inline int32_t
+__parsec_task_ring_length_upto(parsec_task_t* tasks_ring, int32_t max)
+{
+    parsec_list_item_t *item = &tasks_ring->super;
+    int32_t len = 0;
+    do {
+        len++;
+        item = (parsec_list_item_t*)item->list_next;
+    } while( (item != &tasks_ring->super) && (len < max) );
+    return len;
+}
+
 void parsec_taskpool_termination_detected(parsec_taskpool_t *tp)
 {
     if( NULL != tp->on_complete ) {
         (void)tp->on_complete( tp, tp->on_complete_data );
     }
-    (void)parsec_atomic_fetch_dec_int32( &(tp->context->active_taskpools) );
+    if( 1 == parsec_atomic_fetch_dec_int32( &(tp->context->active_taskpools) ) )
+        __parsec_park_wake_all(tp->context);
     PARSEC_PINS_TASKPOOL_FINI(tp);
 }
 
 parsec_sched_module_t *parsec_current_scheduler           = NULL;
 static parsec_sched_base_component_t *scheduler_component = NULL;
 
+/* The schedulers selected for some virtual processes in addition to the
+ * default one (see parsec_runtime_vp_sched), and their components */
+static int parsec_nb_vp_schedulers = 0;
+static parsec_sched_module_t **parsec_vp_schedulers = NULL;
+static parsec_sched_base_component_t **parsec_vp_scheduler_components = NULL;
+
 void parsec_remove_scheduler( parsec_context_t *parsec )
 {
+    int i, p;
+
+    /* Each module releases the objects of its own virtual processes, so the
+     * virtual processes must know their scheduler until all are removed */
+    for( i = 0; i < parsec_nb_vp_schedulers; i++ ) {
+        parsec_vp_schedulers[i]->module.remove( parsec );
+        mca_component_close( (mca_base_component_t*)parsec_vp_scheduler_components[i] );
+    }
+    free(parsec_vp_schedulers);
+    free(parsec_vp_scheduler_components);
+    parsec_vp_schedulers = NULL;
+    parsec_vp_scheduler_components = NULL;
+    parsec_nb_vp_schedulers = 0;
+
     if( NULL != parsec_current_scheduler ) {
         parsec_current_scheduler->module.remove( parsec );
         assert( NULL != scheduler_component );
@@ -241,6 +421,41 @@ void parsec_remove_scheduler( parsec_context_t *parsec )
         parsec_current_scheduler = NULL;
         scheduler_component = NULL;
     }
+    for( p = 0; p < parsec->nb_vp; p++ ) {
+        parsec->virtual_processes[p]->scheduler = NULL;
+    }
+}
+
+/*
+ * Find the scheduler named name, opening its component if no virtual process
+ * uses it yet. Returns the default scheduler if name is empty, or if no
+ * such scheduler can be used.
+ */
+static parsec_sched_module_t *parsec_vp_scheduler_byname( const char *name )
+{
+    mca_base_component_t *component;
+    mca_base_module_t *module;
+    int i;
+
+    if( ('\0' == name[0]) ||
+        (0 == strcmp(name, scheduler_component->base_version.mca_component_name)) )
+        return parsec_current_scheduler;
+    for( i = 0; i < parsec_nb_vp_schedulers; i++ ) {
+        if( 0 == strcmp(name, parsec_vp_scheduler_components[i]->base_version.mca_component_name) )
+            return parsec_vp_schedulers[i];
+    }
+    component = mca_component_open_byname( "sched", (char*)name );
+    module = (NULL != component) ? mca_component_query( component ) : NULL;
+    if( NULL == module ) {
+        if( NULL != component )
+            mca_component_close( component );
+        parsec_warning("Scheduler %s (runtime_vp_sched) is not available, the default scheduler %s is used instead",
+                       name, scheduler_component->base_version.mca_component_name);
+        return parsec_current_scheduler;
+    }
+    parsec_vp_schedulers[parsec_nb_vp_schedulers] = (parsec_sched_module_t*)module;
+    parsec_vp_scheduler_components[parsec_nb_vp_schedulers] = (parsec_sched_base_component_t*)component;
+    return parsec_vp_schedulers[parsec_nb_vp_schedulers++];
 }
 
 int parsec_set_scheduler( parsec_context_t *parsec )
@@ -248,6 +463,8 @@ int parsec_set_scheduler( parsec_context_t *parsec )
     mca_base_component_t **scheds;
     mca_base_module_t    *new_scheduler = NULL;
     mca_base_component_t *new_component = NULL;
+    char **names = NULL;
+    int p, i, nb_names = 0;
 
     assert(NULL == parsec_current_scheduler);
     scheds = mca_components_open_bytype( "sched" );
@@ -267,10 +484,61 @@ int parsec_set_scheduler( parsec_context_t *parsec )
     parsec_debug_verbose(4, parsec_debug_output, " Installing scheduler %s", parsec_current_scheduler->component->base_version.mca_component_name);
     PROFILING_SAVE_sINFO("sched", (char *)parsec_current_scheduler->component->base_version.mca_component_name);
 
+    if( (NULL != parsec_runtime_vp_sched) && ('\0' != parsec_runtime_vp_sched[0]) ) {
+        names = parsec_argv_split_with_empty( parsec_runtime_vp_sched, ',' );
+        nb_names = parsec_argv_count( names );
+        parsec_vp_schedulers = (parsec_sched_module_t**)calloc(nb_names, sizeof(parsec_sched_module_t*));
+        parsec_vp_scheduler_components = (parsec_sched_base_component_t**)calloc(nb_names, sizeof(parsec_sched_base_component_t*));
+    }
+    for( p = 0; p < parsec->nb_vp; p++ ) {
+        parsec_vp_t *vp = parsec->virtual_processes[p];
+        vp->scheduler = (0 == nb_names) ? parsec_current_scheduler
+                                        : parsec_vp_scheduler_byname( names[(p < nb_names) ? p : nb_names - 1] );
+        if( vp->scheduler != parsec_current_scheduler )
+            parsec_debug_verbose(4, parsec_debug_output, " Virtual process %d uses the scheduler %s",
+                                 p, vp->scheduler->component->base_version.mca_component_name);
+    }
+    parsec_argv_free( names );
+
     parsec_current_scheduler->module.install( parsec );
+    for( i = 0; i < parsec_nb_vp_schedulers; i++ ) {
+        parsec_vp_schedulers[i]->module.install( parsec );
+    }
     return PARSEC_SUCCESS;
 }
 
+#if defined(PARSEC_DEBUG_PARANOID) || defined(PARSEC_DEBUG_NOISIER)
+static void
+__parsec_schedule_debug(parsec_execution_stream_t* es,
+                        parsec_task_t* tasks_ring,
+                        int32_t distance)
+{
+    parsec_task_t* task = tasks_ring;
+    char task_string[MAX_TASK_STRLEN];
+
+    do {
+        (void)parsec_task_snprintf(task_string, MAX_TASK_STRLEN, task);
+#if defined(PARSEC_DEBUG_PARANOID)
+        const struct parsec_flow_s* flow;
+        for( int i = 0; NULL != (flow = task->task_class->in[i]); i++ ) {
+            if( PARSEC_FLOW_ACCESS_NONE == (flow->flow_flags & PARSEC_FLOW_ACCESS_MASK) ) continue;
+            if( NULL != task->data[flow->flow_index].source_repo_entry ) {
+                if( NULL == task->data[flow->flow_index].data_in ) {
+                    PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Task %s has flow %s data_repo != NULL but a data == NULL (%s:%d)",
+                                         task_string,
+                                         flow->name, __FILE__, __LINE__);
+                }
+            }
+        }
+#endif  /* defined(PARSEC_DEBUG_PARANOID) */
+        PARSEC_DEBUG_VERBOSE(10, parsec_debug_output,  "thread %d of VP %d Schedules %s (distance %d)",
+                             es->th_id, es->virtual_process->vp_id,
+                             task_string, distance );
+        task = (parsec_task_t*)task->super.list_next;
+    } while ( task != tasks_ring );
+}
+#endif  /* defined(PARSEC_DEBUG_PARANOID) || defined(PARSEC_DEBUG_NOISIER) */
+
 /*
  * Dispatch a ring of tasks to the requested execution stream, using the provided
  * distance. This function provides little benefit by itself, but it allows to
@@ -288,31 +556,7 @@ __parsec_schedule(parsec_execution_stream_t* es,
     int ret;
 
 #if defined(PARSEC_DEBUG_PARANOID) || defined(PARSEC_DEBUG_NOISIER)
-    {
-        parsec_task_t* task = tasks_ring;
-        char task_string[MAX_TASK_STRLEN];
-
-        do {
-            (void)parsec_task_snprintf(task_string, MAX_TASK_STRLEN, task);
-#if defined(PARSEC_DEBUG_PARANOID)
-            const struct parsec_flow_s* flow;
-            for( int i = 0; NULL != (flow = task->task_class->in[i]); i++ ) {
-                if( PARSEC_FLOW_ACCESS_NONE == (flow->flow_flags & PARSEC_FLOW_ACCESS_MASK) ) continue;
-                if( NULL != task->data[flow->flow_index].source_repo_entry ) {
-                    if( NULL == task->data[flow->flow_index].data_in ) {
-                        PARSEC_DEBUG_VERBOSE(10, parsec_debug_output, "Task %s has flow %s data_repo != NULL but a data == NULL (%s:%d)",
-                                             task_string,
-                                             flow->name, __FILE__, __LINE__);
-                    }
-                }
-            }
-#endif  /* defined(PARSEC_DEBUG_PARANOID) */
-            PARSEC_DEBUG_VERBOSE(10, parsec_debug_output,  "thread %d of VP %d Schedules %s (distance %d)",
-                                 es->th_id, es->virtual_process->vp_id,
-                                 task_string, distance );
-            task = (parsec_task_t*)task->super.list_next;
-        } while ( task != tasks_ring );
-    }
+    __parsec_schedule_debug(es, tasks_ring, distance);
 #endif  /* defined(PARSEC_DEBUG_PARANOID) || defined(PARSEC_DEBUG_NOISIER) */
 
 #if defined(PARSEC_PAPI_SDE)
@@ -324,20 +568,137 @@ __parsec_schedule(parsec_execution_stream_t* es,
     }
 #endif  /* defined(PARSEC_PAPI_SDE) */
 
-    ret = parsec_current_scheduler->module.schedule(es, tasks_ring, distance);
+    if( parsec_runtime_park_spin >= 0 ) {
+        int32_t nb = __parsec_task_ring_length_upto(tasks_ring, es->virtual_process->nb_cores);
+        ret = es->virtual_process->scheduler->module.schedule(es, tasks_ring, distance);
+        __parsec_park_notify(es->virtual_process, nb);
+        return ret;
+    }
+    ret = es->virtual_process->scheduler->module.schedule(es, tasks_ring, distance);
+
+    return ret;
+}
+
+/*
+ * Same as __parsec_schedule, for a ring of nb_tasks tasks sorted by decreasing
+ * priority. The ring is given to the bulk scheduling function of the current
+ * scheduler when it provides one, so that the whole ring can be published at
+ * once.
+ */
+int
+__parsec_schedule_bulk(parsec_execution_stream_t* es,
+                       parsec_task_t* tasks_ring,
+                       int32_t nb_tasks,
+                       int32_t distance)
+{
+    int ret;
+
+#if defined(PARSEC_DEBUG_PARANOID) || defined(PARSEC_DEBUG_NOISIER)
+    __parsec_schedule_debug(es, tasks_ring, distance);
+#endif  /* defined(PARSEC_DEBUG_PARANOID) || defined(PARSEC_DEBUG_NOISIER) */
+#if defined(PARSEC_DEBUG_PARANOID)
+    {
+        int len = 0;
+        parsec_task_t *task = tasks_ring;
+        _LIST_ITEM_ITERATOR(task, &task->super, item, {
+                len++;
+                assert( (item->list_next == &tasks_ring->super) ||
+                        !A_HIGHER_PRIORITY_THAN_B(item->list_next, item, parsec_execution_context_priority_comparator) );
+            });
+        assert( len == nb_tasks );
+    }
+#endif  /* defined(PARSEC_DEBUG_PARANOID) */
+
+    PARSEC_PAPI_SDE_COUNTER_ADD(PARSEC_PAPI_SDE_TASKS_ENABLED, nb_tasks);
 
+    if( NULL != es->virtual_process->scheduler->module.schedule_bulk )
+        ret = es->virtual_process->scheduler->module.schedule_bulk(es, tasks_ring, nb_tasks, distance);
+    else
+        ret = es->virtual_process->scheduler->module.schedule(es, tasks_ring, distance);
+    __parsec_park_notify(es->virtual_process, nb_tasks);
     return ret;
 }
 
+/*
+ * Returns the number of tasks in a ring of tasks.
+ */
+static inline int32_t
+__parsec_task_ring_length(parsec_task_t* tasks_ring)
+{
+    int32_t len = 0;
+    _LIST_ITEM_ITERATOR(tasks_ring, &tasks_ring->super, item, {len++; });
+    return len;
+}
+
+/*
+ * Decide if the first task of the ring of local tasks just released by the
+ * task completed on es should be kept as the next task of es, bypassing the
+ * scheduler. The task class can request it when the task is the only
+ * successor (PARSEC_CHAIN_TASK: the data it reads were just produced on this
+ * stream), or forbid it (PARSEC_NO_CHAIN_TASK); otherwise the
+ * runtime_keep_highest_priority_task parameter decides. In all cases the
+ * chain is cut after parsec_runtime_chain_max_depth tasks, so that the other
+ * ready tasks are not starved.
+ */
+static inline int
+__parsec_chain_task(parsec_execution_stream_t* es, parsec_task_t* ring)
+{
+    uint16_t flags = ring->task_class->flags;
+
+    if( flags & PARSEC_NO_CHAIN_TASK )
+        return 0;
+    if( !parsec_runtime_keep_highest_priority_task &&
+        !((flags & PARSEC_CHAIN_TASK) && (ring->super.list_next == &ring->super)) )
+        return 0;
+    if( (parsec_runtime_chain_max_depth > 0) && (es->chain_depth >= parsec_runtime_chain_max_depth) ) {
+        es->nb_chain_cuts++;
+        return 0;
+    }
+    es->nb_chained++;
+    return 1;
+}
+
+/*
+ * Select the execution stream of vp that receives the next ring of tasks
+ * handed off by another virtual process. The streams of vp take turns, so
+ * that a scheduler with per-stream queues does not see all the tasks coming
+ * from the other virtual processes on its first stream.
+ */
+static inline parsec_execution_stream_t*
+__parsec_handoff_target(parsec_vp_t* vp)
+{
+    uint32_t next = (uint32_t)parsec_atomic_fetch_inc_int32(&vp->handoff_next);
+    return vp->execution_streams[next % (uint32_t)vp->nb_cores];
+}
+
 /*
  * Schedule an array of rings of tasks with one entry per virtual process.
- * If an execution stream is provided, this function will save the highest
+ * If an execution stream is provided, this function may save the highest
  * priority task (assuming the ring is ordered or the first task in the ring
  * otherwise) on the current execution stream virtual process as the next
- * task to be executed on the provided execution stream. Everything else gets
- * pushed into the execution stream 0 of the corresponding virtual process.
- * If the provided execution stream is NULL, all tasks are delivered to their
- * respective vp.
+ * task to be executed on the provided execution stream (see
+ * __parsec_chain_task). The other tasks of its own virtual process get
+ * pushed into the execution stream 0 of this virtual process, or into the
+ * provided execution stream when the highest priority tasks are kept
+ * locally. If the provided execution stream is NULL, all tasks are handed
+ * off to their respective vp.
+ *
+ * The rings of the other virtual processes are handed off to them: as each
+ * virtual process may use a different scheduler (see runtime_vp_sched), a
+ * ring is never given to the scheduler of the calling stream, and no task of
+ * the ring is kept as a next task. The whole ring, still sorted by priority,
+ * goes to the bulk scheduling function of the scheduler of the target
+ * virtual process, on one of its streams (taken in turn, see
+ * __parsec_handoff_target), and the parked streams of the target are woken
+ * up.
+ *
+ * The rings are built with parsec_list_item_ring_push_sorted by the DSLs, and
+ * are thus given to the scheduler through the bulk interface.
+ *
+ * When the stream gathers the tasks (es->gathered_rings is set, e.g. by the
+ * communication engine while it releases a batch of activations), the tasks
+ * are only sorted into the gathered rings, and the caller schedules them all
+ * at once later.
  *
  * Beware, as the manipulation of next_task is not protected, an exeuction
  * stream should never be used concurrently in two call to this function (or
@@ -348,7 +709,10 @@ int __parsec_schedule_vp(parsec_execution_stream_t* es,
                          int32_t distance)
 {
     parsec_execution_stream_t* target_es;
-    const parsec_vp_t** vps = (const parsec_vp_t**)es->virtual_process->parsec_context->virtual_processes;
+    parsec_context_t* context = (NULL != es) ? es->virtual_process->parsec_context
+                                              : parsec_my_execution_stream()->virtual_process->parsec_context;
+    parsec_vp_t** vps = context->virtual_processes;
+    int32_t nb_tasks;
     int ret = 0;
 
 #if  defined(PARSEC_DEBUG_PARANOID)
@@ -357,39 +721,45 @@ int __parsec_schedule_vp(parsec_execution_stream_t* es,
     assert( (NULL == es) || (parsec_my_execution_stream() == es) );
 #endif  /* defined(PARSEC_DEBUG_PARANOID) */
 
-    if( NULL == es || !parsec_runtime_keep_highest_priority_task ) {
-        for(int vp = 0; vp < es->virtual_process->parsec_context->nb_vp; vp++ ) {
-            parsec_task_t* ring = task_rings[vp];
-            if( NULL == ring ) continue;
-
-            target_es = vps[vp]->execution_streams[0];
-
-            ret = __parsec_schedule(target_es, ring, distance);
-            if( 0 != ret )
-                return ret;
-
-            task_rings[vp] = NULL;  /* remove the tasks already scheduled */
+    if( (NULL != es) && (NULL != es->gathered_rings) ) {
+        for(int vp = 0; vp < context->nb_vp; vp++ ) {
+            parsec_task_t *ring = task_rings[vp], *task;
+            while( NULL != (task = ring) ) {
+                ring = (parsec_task_t*)parsec_list_item_ring_chop(&task->super);
+                es->gathered_rings[vp] = (parsec_task_t*)
+                    parsec_list_item_ring_push_sorted((parsec_list_item_t*)es->gathered_rings[vp],
+                                                      &task->super, parsec_execution_context_priority_comparator);
+            }
+            task_rings[vp] = NULL;
         }
-        return ret;
+        return 0;
     }
-    for(int vp = 0; vp < es->virtual_process->parsec_context->nb_vp; vp++ ) {
+
+    for(int vp = 0; vp < context->nb_vp; vp++ ) {
         parsec_task_t* ring = task_rings[vp];
         if( NULL == ring ) continue;
 
-        target_es = vps[vp]->execution_streams[0];
-
-        if( vp == es->virtual_process->vp_id ) {
-            if( NULL == es->next_task ) {
+        if( (NULL != es) && (vp == es->virtual_process->vp_id) ) {
+            target_es = vps[vp]->execution_streams[0];
+            if( parsec_runtime_keep_highest_priority_task )
+                target_es = es;
+            if( (NULL == es->next_task) && __parsec_chain_task(es, ring) ) {
                 es->next_task = ring;
+                target_es = es;
                 ring = (parsec_task_t*)parsec_list_item_ring_chop(&ring->super);
                 if( NULL == ring ) {
                     task_rings[vp] = NULL;  /* remove the tasks already scheduled */
                     continue;
                 }
             }
-            target_es = es;
+            nb_tasks = __parsec_task_ring_length(ring);
+        } else {
+            target_es = __parsec_handoff_target(vps[vp]);
+            nb_tasks = __parsec_task_ring_length(ring);
+            if( NULL != es )
+                es->nb_handoffs += nb_tasks;
         }
-        ret = __parsec_schedule(target_es, ring, distance);
+        ret = __parsec_schedule_bulk(target_es, ring, nb_tasks, distance);
         if( 0 != ret )
             return ret;
 
@@ -485,7 +855,14 @@ int __parsec_task_progress( parsec_execution_stream_t* es,
     switch(rc) {
     case PARSEC_HOOK_RETURN_DONE: {
         if(task->status <= PARSEC_TASK_STATUS_HOOK) {
-            rc = __parsec_execute( es, task );
+            if( NULL != es->virtual_process->scheduler->module.executed ) {
+                parsec_time_t start = take_time();
+                rc = __parsec_execute( es, task );
+                if( PARSEC_HOOK_RETURN_DONE == rc )
+                    es->virtual_process->scheduler->module.executed(es, task, diff_time(start, take_time()));
+            } else {
+                rc = __parsec_execute( es, task );
+            }
         }
         /* We're good to go ... */
         switch(rc) {
@@ -540,8 +917,9 @@ int __parsec_context_wait( parsec_execution_stream_t* es )
     parsec_context_t* parsec_context = es->virtual_process->parsec_context;
     int32_t my_barrier_counter = parsec_context->__parsec_internal_finalization_counter;
     parsec_task_t* task;
-    int nbiterations = 0, distance, rc;
+    int nbiterations = 0, distance, rc, can_park;
     struct timespec rqtp;
+    uint64_t idle_since = 0, now;
 
     rqtp.tv_sec = 0;
     misses_in_a_row = 1;
@@ -593,6 +971,14 @@ int __parsec_context_wait( parsec_execution_stream_t* es )
         return -1;
     }
   skip_first_barrier:
+    can_park = (parsec_runtime_park_spin >= 0);
+#if defined(DISTRIBUTED)
+    /* The master thread cannot park if it is in charge of the communications */
+    if( (1 == parsec_communication_engine_up) &&
+        (es->virtual_process[0].parsec_context->nb_nodes == 1) &&
+        PARSEC_THREAD_IS_MASTER(es) )
+        can_park = 0;
+#endif /* defined(DISTRIBUTED) */
     while( !all_tasks_done(parsec_context) ) {
 
         if(PARSEC_THREAD_IS_MASTER(es)) {
@@ -611,20 +997,41 @@ int __parsec_context_wait( parsec_execution_stream_t* es )
         }
 #endif /* defined(DISTRIBUTED) */
 
+        task = NULL;
         if( misses_in_a_row > 1 ) {
-            rqtp.tv_nsec = parsec_exponential_backoff(es, misses_in_a_row);
-            nanosleep(&rqtp, NULL);
+            now = parsec_park_now();
+            if( can_park && (now - idle_since >= (uint64_t)parsec_runtime_park_spin * 1000) ) {
+                es->idle_spin_ns += now - idle_since;
+                task = __parsec_park(es, &distance);
+                idle_since = parsec_park_now();
+                misses_in_a_row = 1;
+            } else {
+                rqtp.tv_nsec = parsec_exponential_backoff(es, misses_in_a_row);
+                nanosleep(&rqtp, NULL);
+            }
         }
         misses_in_a_row++;  /* assume we fail to extract a task */
 
-        if( NULL == (task = es->next_task) ) {
-            task = parsec_current_scheduler->module.select(es, &distance);
+        if( NULL == task ) {  /* the last look before parking did not find any task */
+            if( NULL == (task = es->next_task) ) {
+                task = es->virtual_process->scheduler->module.select(es, &distance);
+                es->chain_depth = 0;
+            } else {
+                es->next_task = NULL;
+                es->chain_depth++;
+                distance = 1;
+            }
         } else {
-            es->next_task = NULL;
-            distance = 1;
+            es->chain_depth = 0;
         }
 
-        if( task != NULL ) {
+        if( NULL == task ) {
+            if( 0 == idle_since ) idle_since = parsec_park_now();
+        } else {
+            if( 0 != idle_since ) {
+                es->idle_spin_ns += parsec_park_now() - idle_since;
+                idle_since = 0;
+            }
             misses_in_a_row = 0;  /* reset the misses counter */
 
             rc = __parsec_task_progress(es, task, distance);
@@ -632,9 +1039,25 @@ int __parsec_context_wait( parsec_execution_stream_t* es )
 
             nbiterations++;
         }
+        /* Between two tasks, this stream does not read any lock-free structure */
+        parsec_ebr_quiescent();
+    }
+
+    if( 0 != idle_since ) {
+        es->idle_spin_ns += parsec_park_now() - idle_since;
     }
 
     parsec_rusage_per_es(es, true);
+    if( (parsec_want_rusage > 1) && (NULL != es->virtual_process->scheduler->module.display_stats) ) {
+        es->virtual_process->scheduler->module.display_stats(es);
+    }
+
+    /* Return to the other streams the elements this stream freed for them */
+    parsec_thread_mempool_flush(es->context_mempool);
+    for(int pi = 0; pi <= MAX_PARAM_COUNT; pi++) {
+        parsec_thread_mempool_flush(es->datarepo_mempools[pi]);
+    }
+    parsec_thread_mempool_flush(es->dependencies_mempool);
 
     /* We're all done ? */
     parsec_barrier_wait( &(parsec_context->barrier) );
@@ -797,6 +1220,9 @@ int parsec_context_wait( parsec_context_t* context )
         return PARSEC_ERR_NOT_SUPPORTED;
     }
 
+    if( 0 == active )
+        __parsec_park_wake_all(context);
+
     ret = __parsec_context_wait( context->virtual_processes[0]->execution_streams[0] );
 
     context->__parsec_internal_finalization_counter++;
@@ -40,14 +40,37 @@ int __parsec_schedule( parsec_execution_stream_t*,
                        parsec_task_t*,
                        int32_t distance);
 
+/**
+ * Same as __parsec_schedule, for a ring of tasks sorted by decreasing
+ * priority and whose length is known. Schedulers that support it can
+ * then publish the whole ring with a constant number of atomic operations.
+ *
+ * @param[in] es The execution stream where the task is to be proposed
+ *             for scheduling.
+ * @param[in] task_ring A ring of tasks sorted by decreasing priority.
+ * @param[in] nb_tasks The number of tasks in task_ring.
+ * @param[in] distance Suggested distance to the current state where the tasks
+ *             are to be pushed.
+ *
+ * @return PARSEC_SUCCESS    If the tasks have been scheduled.
+ * @return less than PARSEC_SUCCESS  If something went wrong.
+ */
+int __parsec_schedule_bulk( parsec_execution_stream_t*,
+                            parsec_task_t*,
+                            int32_t nb_tasks,
+                            int32_t distance);
+
 /**
  * Schedule an array of rings of tasks with one entry per virtual
- * process. Each entry contains a ring of tasks similar to __parsec_schedule.
+ * process. Each entry contains a ring of tasks similar to __parsec_schedule,
+ * sorted by decreasing priority, and is given to __parsec_schedule_bulk.
  * By default this version will save the highest priority task
  * (assuming the ring is ordered or the first task in the ring otherwise)
  * on the current execution stream virtual process as the next task to be
- * executed on the current execution stream. Everything else gets pushed
- * into the execution stream 0 of the corresponding virtual process.
+ * executed on the current execution stream. The other tasks of the current
+ * virtual process get pushed into its execution stream 0, and the rings of
+ * the other virtual processes are handed off to the scheduler of these
+ * virtual processes, on each of their execution streams in turn.
  *
  * @param[in] es The execution stream where the tasks were discovered, or
  *             generated.
@@ -154,7 +177,9 @@ int parsec_taskpool_update_runtime_nbtask(parsec_taskpool_t *tp, int32_t nb_task
 void parsec_taskpool_termination_detected(parsec_taskpool_t *tp);
 
 /**
- * Loads the scheduler as selected using the MCA logic
+ * Loads the scheduler as selected using the MCA logic, and the schedulers
+ * of the virtual processes that do not use this default scheduler (see
+ * runtime_vp_sched)
  * You better not call this while computations are in progress,
  *  i.e. it should be safe to call this when the main thread is
  *  not yet inside parsec_progress, but *before* any call to
@@ -167,11 +192,13 @@ void parsec_taskpool_termination_detected(parsec_taskpool_t *tp);
 int parsec_set_scheduler( parsec_context_t *parsec );
 
 /**
- *  Removes the current scheduler (cleanup)
+ *  Removes the current scheduler, and the schedulers of the virtual
+ *  processes (cleanup)
  */
 void parsec_remove_scheduler( parsec_context_t *parsec );
 
 struct parsec_sched_module_s;
+/** The default scheduler. Each virtual process uses its own (vp->scheduler) */
 extern struct parsec_sched_module_s *parsec_current_scheduler;
 
 
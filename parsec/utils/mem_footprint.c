@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/parsec_config.h"
+
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "parsec/sys/atomic.h"
+#include "parsec/sys/tls.h"
+#include "parsec/utils/debug.h"
+#include "parsec/utils/mem_footprint.h"
+
+int parsec_mem_footprint_enabled = 1;
+int parsec_mem_footprint_dump_period = 0;
+
+/**
+ * The changes of a thread that are not yet published. These are chained
+ * when the thread first updates a counter, and are kept until the end of
+ * the process, as the current footprint includes the changes of the
+ * threads that are gone.
+ */
+typedef struct parsec_mem_footprint_thread_s {
+    struct parsec_mem_footprint_thread_s *next;
+    volatile int64_t                      pending[PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS];
+} parsec_mem_footprint_thread_t;
+
+static const char *parsec_mem_footprint_names[PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS] = {
+    "tasks", "datarepo", "hash_tables", "arenas", "dependencies", "dtd_tiles", "remote_deps"
+};
+
+static volatile int64_t parsec_mem_footprint_published[PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS];
+static volatile int64_t parsec_mem_footprint_hwm[PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS];
+static parsec_mem_footprint_thread_t * volatile parsec_mem_footprint_threads = NULL;
+static volatile int64_t parsec_mem_footprint_last_dump = 0;
+
+static PARSEC_TLS_DECLARE(parsec_mem_footprint_tls);
+static volatile int32_t parsec_mem_footprint_tls_ready = 0;
+
+static parsec_mem_footprint_thread_t *parsec_mem_footprint_thread(void)
+{
+    parsec_mem_footprint_thread_t *t;
+
+    /* The allocators may be used before parsec_init, create the key on first use */
+    if( 2 != parsec_mem_footprint_tls_ready ) {
+        if( parsec_atomic_cas_int32(&parsec_mem_footprint_tls_ready, 0, 1) ) {
+            PARSEC_TLS_KEY_CREATE(parsec_mem_footprint_tls);
+            parsec_atomic_wmb();
+            parsec_mem_footprint_tls_ready = 2;
+        }
+        while( 2 != parsec_mem_footprint_tls_ready ) ;
+    }
+    t = (parsec_mem_footprint_thread_t*)PARSEC_TLS_GET_SPECIFIC(parsec_mem_footprint_tls);
+    if( NULL != t ) return t;
+
+    t = (parsec_mem_footprint_thread_t*)calloc(1, sizeof(parsec_mem_footprint_thread_t));
+    do {
+        t->next = parsec_mem_footprint_threads;
+    } while( !parsec_atomic_cas_ptr(&parsec_mem_footprint_threads, t->next, t) );
+    PARSEC_TLS_SET_SPECIFIC(parsec_mem_footprint_tls, t);
+    return t;
+}
+
+void parsec_mem_footprint_update(parsec_mem_footprint_subsystem_t subsystem, int64_t bytes)
+{
+    parsec_mem_footprint_thread_t *t = parsec_mem_footprint_thread();
+    int64_t pending = t->pending[subsystem] + bytes, current, hwm, last, now;
+
+    if( (pending < PARSEC_MEM_FOOTPRINT_BATCH) && (pending > -PARSEC_MEM_FOOTPRINT_BATCH) ) {
+        t->pending[subsystem] = pending;
+        return;
+    }
+    t->pending[subsystem] = 0;
+    current = parsec_atomic_fetch_add_int64(&parsec_mem_footprint_published[subsystem], pending) + pending;
+    while( current > (hwm = parsec_mem_footprint_hwm[subsystem]) ) {
+        if( parsec_atomic_cas_int64(&parsec_mem_footprint_hwm[subsystem], hwm, current) )
+            break;
+    }
+
+    if( parsec_mem_footprint_dump_period > 0 ) {
+        now = (int64_t)time(NULL);
+        last = parsec_mem_footprint_last_dump;
+        if( (now - last >= parsec_mem_footprint_dump_period) &&
+            parsec_atomic_cas_int64(&parsec_mem_footprint_last_dump, last, now) ) {
+            parsec_mem_footprint_dump("periodic");
+        }
+    }
+}
+
+int64_t parsec_mem_footprint_current(parsec_mem_footprint_subsystem_t subsystem)
+{
+    parsec_mem_footprint_thread_t *t;
+    int64_t current = parsec_mem_footprint_published[subsystem];
+
+    for( t = parsec_mem_footprint_threads; NULL != t; t = t->next )
+        current += t->pending[subsystem];
+    return current;
+}
+
+int64_t parsec_mem_footprint_high_water_mark(parsec_mem_footprint_subsystem_t subsystem)
+{
+    int64_t current = parsec_mem_footprint_current(subsystem);
+    int64_t hwm = parsec_mem_footprint_hwm[subsystem];
+    /* The changes that are not published yet may be above the mark */
+    return current > hwm ? current : hwm;
+}
+
+const char *parsec_mem_footprint_name(parsec_mem_footprint_subsystem_t subsystem)
+{
+    return parsec_mem_footprint_names[subsystem];
+}
+
+void parsec_mem_footprint_dump(const char *title)
+{
+    int64_t current, hwm, total = 0;
+    int s;
+
+    parsec_inform("Memory footprint of the runtime (%s):", title);
+    for( s = 0; s < PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS; s++ ) {
+        current = parsec_mem_footprint_current((parsec_mem_footprint_subsystem_t)s);
+        hwm = parsec_mem_footprint_high_water_mark((parsec_mem_footprint_subsystem_t)s);
+        total += current;
+        parsec_inform("  %-12s %14"PRId64" bytes (high-water mark %14"PRId64" bytes)",
+                      parsec_mem_footprint_names[s], current, hwm);
+    }
+    parsec_inform("  %-12s %14"PRId64" bytes", "total", total);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#ifndef _PARSEC_MEM_FOOTPRINT_H_
+#define _PARSEC_MEM_FOOTPRINT_H_
+
+#include "parsec/parsec_config.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+BEGIN_C_DECLS
+
+/**
+ * @defgroup parsec_internal_mem_footprint Memory Footprint
+ * @ingroup parsec_internal
+ * @{
+ *
+ *  @brief Accounting of the memory the runtime allocates for itself
+ *
+ *  @details
+ *    The allocators of the runtime report the memory they get from, and
+ *    give back to, the system, per subsystem. Each thread accumulates
+ *    its changes in its own counters, and publishes them in the global
+ *    counters (and their high-water marks) when they reach
+ *    PARSEC_MEM_FOOTPRINT_BATCH bytes, so the current footprint is exact
+ *    when read, and the high-water marks are within
+ *    PARSEC_MEM_FOOTPRINT_BATCH bytes per thread.
+ */
+
+/**
+ * The subsystems whose memory is accounted
+ */
+typedef enum parsec_mem_footprint_subsystem_e {
+    PARSEC_MEM_FOOTPRINT_TASKS,         /**< Memory pools of the tasks */
+    PARSEC_MEM_FOOTPRINT_DATAREPO,      /**< Memory pools of the data repository entries */
+    PARSEC_MEM_FOOTPRINT_HASH_TABLES,   /**< Heads and buckets (or slots) of the hash tables */
+    PARSEC_MEM_FOOTPRINT_ARENAS,        /**< Chunks of the arenas and segments of the size-class pool */
+    PARSEC_MEM_FOOTPRINT_DEPENDENCIES,  /**< Dependency tracking of the task classes */
+    PARSEC_MEM_FOOTPRINT_DTD_TILES,     /**< Tiles of the DTD interface */
+    PARSEC_MEM_FOOTPRINT_REMOTE_DEPS,   /**< Remote dependencies and their packed buffers */
+    PARSEC_MEM_FOOTPRINT_NB_SUBSYSTEMS  /**< This must remain last */
+} parsec_mem_footprint_subsystem_t;
+
+/** Number of bytes a thread accumulates before it publishes them */
+#define PARSEC_MEM_FOOTPRINT_BATCH (64*1024)
+
+/** Accounting is enabled (the default), see the runtime_mem_footprint MCA parameter */
+PARSEC_DECLSPEC extern int parsec_mem_footprint_enabled;
+/** Period (in seconds) of the dump of the footprint, 0 for none */
+PARSEC_DECLSPEC extern int parsec_mem_footprint_dump_period;
+
+/**
+ * @brief Account bytes allocated (positive) or released (negative)
+ *   by a subsystem. Thread-safe; the thread that releases some memory
+ *   does not need to be the one that allocated it.
+ */
+void parsec_mem_footprint_update(parsec_mem_footprint_subsystem_t subsystem, int64_t bytes);
+
+#define PARSEC_MEM_FOOTPRINT_ADD(subsystem, bytes) do {                           \
+        if( parsec_mem_footprint_enabled )                                       \
+            parsec_mem_footprint_update((subsystem), (int64_t)(bytes));          \
+    } while(0)
+
+/**
+ * @brief Returns the number of bytes currently allocated by a subsystem
+ */
+int64_t parsec_mem_footprint_current(parsec_mem_footprint_subsystem_t subsystem);
+
+/**
+ * @brief Returns the maximal number of bytes allocated by a subsystem
+ *   since the start of the process
+ */
+int64_t parsec_mem_footprint_high_water_mark(parsec_mem_footprint_subsystem_t subsystem);
+
+/**
+ * @brief Returns the name of a subsystem
+ */
+const char *parsec_mem_footprint_name(parsec_mem_footprint_subsystem_t subsystem);
+
+/**
+ * @brief Prints the current footprint and the high-water mark of each
+ *   subsystem, with parsec_inform, after the header title.
+ */
+void parsec_mem_footprint_dump(const char *title);
+
+/** @} */
+
+END_C_DECLS
+
+#endif  /* _PARSEC_MEM_FOOTPRINT_H_ */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2014 The University of Tennessee and The University
+ * Copyright (c) 2012-2022 The University of Tennessee and The University
  *                         of Tennessee Research Foundation.  All rights
  *                         reserved.
  */
@@ -24,6 +24,107 @@ static inline segment_t *SEGMENT_AT_TID(zone_malloc_t *gdata, int tid)
     return &gdata->segments[tid];
 }
 
+/* Index of the most significant (resp. least significant) bit set in x, x != 0 */
+static inline int zone_fls(uint32_t x)
+{
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(x);
+#else
+    int b = 0;
+    while( x >>= 1 ) b++;
+    return b;
+#endif  /* defined(__GNUC__) */
+}
+
+static inline int zone_ffs(uint32_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int b = 0;
+    while( !(x & 1) ) { x >>= 1; b++; }
+    return b;
+#endif  /* defined(__GNUC__) */
+}
+
+/* Size list of the free segments of nb_units units */
+static inline void zone_mapping(uint32_t nb_units, int *fl, int *sl)
+{
+    int b;
+    if( nb_units < ZONE_SL_COUNT ) {
+        *fl = 0;
+        *sl = (int)nb_units;
+        return;
+    }
+    b = zone_fls(nb_units);
+    *fl = b - ZONE_SL_LOG2 + 1;
+    *sl = (int)(nb_units >> (b - ZONE_SL_LOG2)) - ZONE_SL_COUNT;
+}
+
+static void zone_insert_free(zone_malloc_t *gdata, int tid)
+{
+    segment_t *segment = &gdata->segments[tid];
+    int fl, sl, head;
+
+    zone_mapping(segment->nb_units, &fl, &sl);
+    head = gdata->free_heads[fl][sl];
+    segment->status    = SEGMENT_EMPTY;
+    segment->prev_free = -1;
+    segment->next_free = head;
+    if( -1 != head )
+        gdata->segments[head].prev_free = tid;
+    gdata->free_heads[fl][sl] = tid;
+    gdata->fl_bitmap     |= 1u << fl;
+    gdata->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void zone_remove_free(zone_malloc_t *gdata, int tid)
+{
+    segment_t *segment = &gdata->segments[tid];
+    int fl, sl;
+
+    zone_mapping(segment->nb_units, &fl, &sl);
+    if( -1 != segment->next_free )
+        gdata->segments[segment->next_free].prev_free = segment->prev_free;
+    if( -1 != segment->prev_free ) {
+        gdata->segments[segment->prev_free].next_free = segment->next_free;
+    } else {
+        gdata->free_heads[fl][sl] = segment->next_free;
+        if( -1 == segment->next_free ) {
+            gdata->sl_bitmap[fl] &= ~(1u << sl);
+            if( 0 == gdata->sl_bitmap[fl] )
+                gdata->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+/* First free segment of the smallest size list whose segments all have at least nb_units units */
+static int zone_find_free(zone_malloc_t *gdata, uint32_t nb_units)
+{
+    uint32_t map;
+    int fl, sl;
+
+    if( nb_units >= ZONE_SL_COUNT ) {
+        /* Round up to the next size list */
+        nb_units += (1u << (zone_fls(nb_units) - ZONE_SL_LOG2)) - 1;
+    }
+    zone_mapping(nb_units, &fl, &sl);
+    if( fl >= ZONE_FL_COUNT )
+        return -1;
+    map = gdata->sl_bitmap[fl] & (~0u << sl);
+    if( 0 == map ) {
+        if( fl + 1 >= ZONE_FL_COUNT )
+            return -1;
+        map = gdata->fl_bitmap & (~0u << (fl + 1));
+        if( 0 == map )
+            return -1;
+        fl = zone_ffs(map);
+        map = gdata->sl_bitmap[fl];
+    }
+    sl = zone_ffs(map);
+    return gdata->free_heads[fl][sl];
+}
+
 zone_malloc_t* zone_malloc_init(void* base_ptr, int _max_segment, size_t _unit_size)
 {
     zone_malloc_t *gdata;
@@ -38,8 +139,14 @@ zone_malloc_t* zone_malloc_init(void* base_ptr, int _max_segment, size_t _unit_s
     gdata->base               = base_ptr;
     gdata->unit_size          = _unit_size;
     gdata->max_segment        = _max_segment;
+    gdata->used_units         = 0;
 
-    gdata->next_tid = 0;
+    gdata->fl_bitmap = 0;
+    for(int fl = 0; fl < ZONE_FL_COUNT; fl++) {
+        gdata->sl_bitmap[fl] = 0;
+        for(int sl = 0; sl < ZONE_SL_COUNT; sl++)
+            gdata->free_heads[fl][sl] = -1;
+    }
     gdata->segments = (segment_t *)malloc(sizeof(segment_t) * _max_segment);
 #if defined(PARSEC_DEBUG)
     for(int i = 0; i < _max_segment; i++) {
@@ -47,9 +154,9 @@ zone_malloc_t* zone_malloc_init(void* base_ptr, int _max_segment, size_t _unit_s
     }
 #endif /* defined(PARSEC_DEBUG) */
     head = SEGMENT_AT_TID(gdata, 0);
-    head->status = SEGMENT_EMPTY;
     head->nb_units = _max_segment;
     head->nb_prev  = 1; /**< This is to force SEGMENT_OF_TID( 0 - prev ) to return NULL */
+    zone_insert_free(gdata, 0);
 
     return gdata;
 }
@@ -71,53 +178,51 @@ void* zone_malloc_fini(zone_malloc_t** gdata)
 void *zone_malloc(zone_malloc_t *gdata, size_t size)
 {
     segment_t *current_segment, *next_segment, *new_segment;
-    int next_tid, current_tid, new_tid;
-    int cycled_through = 0, nb_units;
-
-    /* Let's start with the last remembered free slot */
-    current_tid = gdata->next_tid;
-    nb_units = (size + gdata->unit_size - 1) / gdata->unit_size;
-
-    do {
-        current_segment = SEGMENT_AT_TID(gdata, current_tid);
-        if( NULL == current_segment ) {
-            /* Maybe there is a free slot in the beginning. Let's cycle at least once before we bail out */
-            if( cycled_through == 0 ) {
-                current_tid = 0;
-                cycled_through = 1;
-                current_segment = SEGMENT_AT_TID(gdata, current_tid);
-            } else {
-                return NULL;
-            }
-        }
-
-        if( current_segment->status == SEGMENT_EMPTY && current_segment->nb_units >= nb_units ) {
-            current_segment->status = SEGMENT_FULL;
-            if( current_segment->nb_units > nb_units ) {
-                next_tid = current_tid + current_segment->nb_units;
+    int next_tid, current_tid, new_tid, fl, sl;
+    size_t units;
+    int32_t nb_units;
 
-                next_segment = SEGMENT_AT_TID(gdata, next_tid);
-                if( NULL != next_segment )
-                    next_segment->nb_prev -= nb_units;
-
-                new_tid = current_tid + nb_units;
-                new_segment = SEGMENT_AT_TID(gdata, new_tid);
-                new_segment->status = SEGMENT_EMPTY;
-                new_segment->nb_prev  = nb_units;
-                new_segment->nb_units = current_segment->nb_units - nb_units;
+    units = (size + gdata->unit_size - 1) / gdata->unit_size;
+    if( units > (size_t)(gdata->max_segment - gdata->used_units) )
+        return NULL;
+    nb_units = (0 == units) ? 1 : (int32_t)units;
+
+    current_tid = zone_find_free(gdata, (uint32_t)nb_units);
+    if( -1 == current_tid ) {
+        /* The zone is (almost) full: the segments of the size list of the
+         * request may still be large enough */
+        zone_mapping((uint32_t)nb_units, &fl, &sl);
+        for(current_tid = gdata->free_heads[fl][sl];
+            -1 != current_tid;
+            current_tid = gdata->segments[current_tid].next_free) {
+            if( gdata->segments[current_tid].nb_units >= nb_units )
+                break;
+        }
+        if( -1 == current_tid )
+            return NULL;
+    }
 
-                /* new_tid is a free slot, remember for next malloc */
-                gdata->next_tid = new_tid;
+    current_segment = SEGMENT_AT_TID(gdata, current_tid);
+    assert( current_segment->status == SEGMENT_EMPTY && current_segment->nb_units >= nb_units );
+    zone_remove_free(gdata, current_tid);
+    current_segment->status = SEGMENT_FULL;
+    if( current_segment->nb_units > nb_units ) {
+        next_tid = current_tid + current_segment->nb_units;
 
-                current_segment->nb_units = nb_units;
-            }
-            return (void*)(gdata->base + (current_tid * gdata->unit_size));
-        }
+        next_segment = SEGMENT_AT_TID(gdata, next_tid);
+        if( NULL != next_segment )
+            next_segment->nb_prev -= nb_units;
 
-        current_tid += current_segment->nb_units;
-    } while( current_tid != gdata->next_tid );
+        new_tid = current_tid + nb_units;
+        new_segment = SEGMENT_AT_TID(gdata, new_tid);
+        new_segment->nb_prev  = nb_units;
+        new_segment->nb_units = current_segment->nb_units - nb_units;
+        zone_insert_free(gdata, new_tid);
 
-    return NULL;
+        current_segment->nb_units = nb_units;
+    }
+    gdata->used_units += nb_units;
+    return (void*)(gdata->base + (current_tid * gdata->unit_size));
 }
 
 void zone_free(zone_malloc_t *gdata, void *add)
@@ -141,7 +246,7 @@ void zone_free(zone_malloc_t *gdata, void *add)
         return;
     }
 
-    current_segment->status = SEGMENT_EMPTY;
+    gdata->used_units -= current_segment->nb_units;
 
     prev_tid = current_tid - current_segment->nb_prev;
     prev_segment = SEGMENT_AT_TID(gdata, prev_tid);
@@ -151,45 +256,58 @@ void zone_free(zone_malloc_t *gdata, void *add)
 
     if( NULL != prev_segment && prev_segment->status == SEGMENT_EMPTY ) {
         /* We can merge prev and current */
+        zone_remove_free(gdata, prev_tid);
         if( NULL != next_segment ) {
             next_segment->nb_prev += prev_segment->nb_units;
         }
         prev_segment->nb_units += current_segment->nb_units;
+#if defined(PARSEC_DEBUG)
+        current_segment->status = SEGMENT_UNDEFINED;
+#endif /* defined(PARSEC_DEBUG) */
 
         /* Pretend we are now our prev, so that we merge with next if needed */
         current_segment = prev_segment;
         current_tid     = prev_tid;
     }
 
-    /* current_tid is a free slot, remember for next malloc */
-    gdata->next_tid = current_tid;
-
     if( NULL != next_segment && next_segment->status == SEGMENT_EMPTY ) {
         /* We can merge current and next */
-        next_tid += next_segment->nb_units;
+        zone_remove_free(gdata, next_tid);
         current_segment->nb_units += next_segment->nb_units;
+#if defined(PARSEC_DEBUG)
+        next_segment->status = SEGMENT_UNDEFINED;
+#endif /* defined(PARSEC_DEBUG) */
+        next_tid = current_tid + current_segment->nb_units;
         next_segment = SEGMENT_AT_TID(gdata, next_tid);
         if( NULL != next_segment ) {
             next_segment->nb_prev = current_segment->nb_units;
         }
     }
+
+    zone_insert_free(gdata, current_tid);
 }
 
 size_t zone_in_use(zone_malloc_t *gdata)
 {
-    size_t ret = 0;
-    segment_t *current_segment;
-    int current_tid;
-    for(current_tid = 0;
-        (current_segment = SEGMENT_AT_TID(gdata, current_tid)) != NULL;
-        current_tid += current_segment->nb_units) {
-        if( current_segment->status == SEGMENT_FULL ) {
-            ret += gdata->unit_size * current_segment->nb_units;
-        }
-    }
-    return ret;
+    return gdata->unit_size * (size_t)gdata->used_units;
 }
 
+size_t zone_largest_free(zone_malloc_t *gdata)
+{
+    int32_t largest = 0;
+    int fl, sl, tid;
+
+    if( 0 == gdata->fl_bitmap )
+        return 0;
+    /* The largest segment is in the last non empty size list */
+    fl = zone_fls(gdata->fl_bitmap);
+    sl = zone_fls(gdata->sl_bitmap[fl]);
+    for(tid = gdata->free_heads[fl][sl]; -1 != tid; tid = gdata->segments[tid].next_free) {
+        if( gdata->segments[tid].nb_units > largest )
+            largest = gdata->segments[tid].nb_units;
+    }
+    return gdata->unit_size * (size_t)largest;
+}
 
 size_t zone_debug(zone_malloc_t *gdata, int level, int output_id, const char *prefix)
 {
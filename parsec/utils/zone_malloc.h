@@ -18,10 +18,22 @@ BEGIN_C_DECLS
 #define SEGMENT_FULL       2
 #define SEGMENT_UNDEFINED  3
 
+/**
+ * The free segments are kept in segregated lists, indexed by their size
+ * (two-level segregated fit): a first level for the power of two of the
+ * number of units, split in ZONE_SL_COUNT second level ranges. Sizes
+ * below ZONE_SL_COUNT units all have their own list in the first row.
+ */
+#define ZONE_SL_LOG2       4
+#define ZONE_SL_COUNT      (1 << ZONE_SL_LOG2)
+#define ZONE_FL_COUNT      (32 - ZONE_SL_LOG2)
+
 typedef struct segment {
     int status;     /* True if this segment is full, false if it is free */
     int32_t nb_units;   /* Number of units on this segment */
     int32_t nb_prev;    /* Number of units on the segment before */
+    int32_t prev_free;  /* Previous free segment of the same size list (-1 if none) */
+    int32_t next_free;  /* Next free segment of the same size list (-1 if none) */
 } segment_t;
 
 typedef struct zone_malloc_s {
@@ -29,7 +41,10 @@ typedef struct zone_malloc_s {
     segment_t *segments;             /* Array of available segments */
     size_t     unit_size;            /* Basic Unit                */
     int        max_segment;          /* Maximum number of segment */
-    int        next_tid;             /* Next TID to look at for a malloc */
+    int32_t    used_units;           /* Number of units currently allocated */
+    uint32_t   fl_bitmap;            /* Bit fl is set if a list of row fl is not empty */
+    uint32_t   sl_bitmap[ZONE_FL_COUNT];                /* Bit sl of row fl is set if free_heads[fl][sl] is not empty */
+    int32_t    free_heads[ZONE_FL_COUNT][ZONE_SL_COUNT]; /* First free segment of each size list (-1 if none) */
 } zone_malloc_t;
 
 
@@ -46,14 +61,18 @@ zone_malloc_t* zone_malloc_init(void* base_ptr, int _max_segment, size_t _unit_s
 void* zone_malloc_fini(zone_malloc_t** gdata);
 
 /**
- * Allocate a memory area of length size bytes. In worst case the search is linear
- * with the number of existing allocations.
+ * Allocate a memory area of length size bytes. The search does not depend on
+ * the number of existing allocations: the first segment of the smallest
+ * size list whose segments are all large enough is split. Only when there
+ * is no such segment, the size list of the request itself is searched,
+ * before returning NULL.
  */
 void *zone_malloc(zone_malloc_t *gdata, size_t size);
 
 /**
  * Release a specific memory zone. When possible this memory zone is
- * merged with similar memory zones surrounding its position.
+ * merged with similar memory zones surrounding its position, in constant
+ * time.
  */
 void zone_free(zone_malloc_t *gdata, void *add);
 
@@ -62,6 +81,12 @@ void zone_free(zone_malloc_t *gdata, void *add);
  */
 size_t zone_in_use(zone_malloc_t *gdata);
 
+/**
+ * Computes the size of the largest free memory area, that is the largest
+ * allocation that can succeed (up to the rounding of the size lists).
+ */
+size_t zone_largest_free(zone_malloc_t *gdata);
+
 /**
  * Prints information on the amount of available blocks
  * Do not print anything if prefix is NULL
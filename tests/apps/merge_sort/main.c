@@ -18,7 +18,8 @@ int main(int argc, char *argv[])
 {
     parsec_context_t* parsec;
     int rank = 0, world = 1, cores = -1;
-    int nt = 1234, nb = 5, rc;
+    int nt = 1234, nb = 5, rc, i, pargc = 0;
+    char **pargv = NULL;
     parsec_tiled_matrix_t *dcA;
     parsec_taskpool_t *msort;
 
@@ -44,7 +45,15 @@ int main(int argc, char *argv[])
         }
     }
 
-    parsec = parsec_init(cores, &argc, &argv);
+    /* The PaRSEC arguments follow the number of tiles, after -- */
+    for(i = 1; i < argc; i++) {
+        if( strcmp(argv[i], "--") == 0 ) {
+            pargc = argc - i;
+            pargv = &argv[i];
+            break;
+        }
+    }
+    parsec = parsec_init(cores, &pargc, &pargv);
     if( NULL == parsec ) {
         exit(1);
     }
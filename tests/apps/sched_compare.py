@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+##
+# Compare the schedulers on the merge_sort and haar_tree applications.
+#
+# Each application is run several times with each scheduler (selected with
+# the PARSEC_MCA_mca_sched environment variable), and the wall-clock time of
+# the runs is reported. The default compares the critical-path scheduler
+# (heft) with the priority-based schedulers pbq and spq.
+#
+# The number of cores is given on the command line of the applications, as
+# haar_tree asks for a single core itself, and the report shows the number
+# of threads the runtime actually started (from its virtual process map).
+#
+# Usage: sched_compare.py [-b build_dir] [-s heft,pbq,spq] [-c cores] [-r repeat]
+#                         [-n merge_sort_tiles]
+##
+
+import argparse
+import os
+import re
+import statistics
+import subprocess
+import sys
+import time
+
+APPS = {
+    "merge_sort": ("tests/apps/merge_sort/merge_sort", lambda args: [str(args.tiles)]),
+    "haar_tree":  ("tests/apps/haar_tree/project",     lambda args: ["-x"]),
+}
+
+
+VP_THREADS = re.compile(r"Virtual Process of index \d+ has (\d+) threads")
+
+
+def run(binary, argv, sched, cores):
+    env = dict(os.environ)
+    env["PARSEC_MCA_mca_sched"] = sched
+    parsec_argv = ["--", "-V", "display:flat"]
+    if cores > 0:
+        parsec_argv += ["-c", str(cores)]
+    start = time.perf_counter()
+    proc = subprocess.run([binary] + argv + parsec_argv, env=env,
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    elapsed = time.perf_counter() - start
+    stderr = proc.stderr.decode(errors="replace")
+    if proc.returncode != 0:
+        sys.stderr.write(stderr)
+        raise RuntimeError("%s failed with scheduler %s (exit code %d)" %
+                           (binary, sched, proc.returncode))
+    used = sum(int(n) for n in VP_THREADS.findall(stderr))
+    return elapsed, used
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("-b", "--build-dir", default=".",
+                        help="PaRSEC build directory (default: current directory)")
+    parser.add_argument("-s", "--schedulers", default="heft,pbq,spq",
+                        help="comma-separated list of schedulers (default: heft,pbq,spq)")
+    parser.add_argument("-c", "--cores", type=int, default=0,
+                        help="number of cores given to the runtime (default: all)")
+    parser.add_argument("-r", "--repeat", type=int, default=5,
+                        help="number of runs per application and scheduler (default: 5)")
+    parser.add_argument("-n", "--tiles", type=int, default=20000,
+                        help="number of tiles to sort in merge_sort (default: 20000)")
+    args = parser.parse_args()
+
+    print("%-12s %-8s %6s %10s %10s %10s" % ("app", "sched", "cores", "min(s)", "median(s)", "mean(s)"))
+    for app, (path, make_argv) in APPS.items():
+        binary = os.path.join(args.build_dir, path)
+        if not os.access(binary, os.X_OK):
+            sys.stderr.write("%s: %s not found, skipped\n" % (app, binary))
+            continue
+        for sched in args.schedulers.split(","):
+            runs = [run(binary, make_argv(args), sched, args.cores) for _ in range(args.repeat)]
+            times = [t for t, _ in runs]
+            used = sorted(set(c for _, c in runs))
+            if (args.cores > 0) and (used != [args.cores]):
+                sys.stderr.write("%s: %d cores requested, %s used with scheduler %s\n" %
+                                 (app, args.cores, "/".join(map(str, used)), sched))
+            print("%-12s %-8s %6s %10.4f %10.4f %10.4f" % (app, sched, "/".join(map(str, used)),
+                                                         min(times),
+                                                         statistics.median(times),
+                                                         statistics.mean(times)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -5,6 +5,14 @@ add_test(class/rwlock ${SHM_TEST_CMD_LIST} class/rwlock -c 4)
 add_test(class/lifo ${SHM_TEST_CMD_LIST} class/lifo -c 4)
 add_test(class/list ${SHM_TEST_CMD_LIST} class/list -c 4)
 add_test(class/hash ${SHM_TEST_CMD_LIST} class/hash -\# 65536 -r 4 -n)
+add_test(class/hash:bench ${SHM_TEST_CMD_LIST} class/hash -b -m 1 -M 4 -\# 65536 -r 2)
+add_test(class/hash:batch ${SHM_TEST_CMD_LIST} class/hash -B -m 1 -M 4 -\# 65536 -r 4)
+add_test(class/ebr ${SHM_TEST_CMD_LIST} class/ebr -c 4)
+add_test(class/wsdeque ${SHM_TEST_CMD_LIST} class/wsdeque -c 4)
+add_test(class/multiqueue ${SHM_TEST_CMD_LIST} class/multiqueue -c 4)
+add_test(class/mempool ${SHM_TEST_CMD_LIST} class/mempool -c 4)
+add_test(class/mempool:lifo ${SHM_TEST_CMD_LIST} class/mempool -c 4 -l)
+add_test(class/zone_malloc ${SHM_TEST_CMD_LIST} class/zone_malloc -z 16384 -n 50000 -c)
 add_test(class/future ${SHM_TEST_CMD_LIST} class/future -c 4)
 add_test(class/future_datacopy ${SHM_TEST_CMD_LIST} class/future_datacopy)
 
@@ -13,5 +21,6 @@ if(TARGET atomics_inline)
 endif()
 add_test(class/rwlock:inline ${SHM_TEST_CMD_LIST} class/rwlock_inline -c 4)
 add_test(class/lifo:inline ${SHM_TEST_CMD_LIST} class/lifo_inline -c 4)
+add_test(class/lifo:locked ${SHM_TEST_CMD_LIST} class/lifo_locked -c 4)
 add_test(class/list:inline ${SHM_TEST_CMD_LIST} class/list_inline -c 4)
 add_test(class/hash:inline ${SHM_TEST_CMD_LIST} class/hash_inline -\# 65536 -r 4 -n)
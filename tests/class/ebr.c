@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/runtime.h"
+#undef NDEBUG
+#include <pthread.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#if defined(PARSEC_HAVE_MPI)
+#include <mpi.h>
+#endif
+
+#include "parsec/class/parsec_ebr.h"
+#include "parsec/class/lifo.h"
+#include "parsec/class/barrier.h"
+#include "parsec/os-spec-timing.h"
+
+#define ALIVE 0xa11fe
+#define DEAD  0xdead
+
+static unsigned int NBTIMES = 200000;
+static unsigned int nbthreads = 1;
+
+typedef struct {
+    parsec_list_item_t super;
+    volatile uint64_t  magic;
+    uint64_t           value;
+} obj_t;
+
+static obj_t * volatile shared = NULL;
+/* The released objects are poisoned and kept here, so that a reader that
+ * reads one after its release sees the poison instead of freed memory */
+static parsec_lifo_t graveyard;
+static parsec_barrier_t barrier;
+static volatile int32_t nb_retired = 0;
+static volatile int32_t nb_released = 0;
+
+static void fatal(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+    raise(SIGABRT);
+}
+
+static obj_t *new_obj(uint64_t value)
+{
+    obj_t *obj = (obj_t*)parsec_lifo_item_alloc(&graveyard, sizeof(obj_t));
+    obj->magic = ALIVE;
+    obj->value = value;
+    return obj;
+}
+
+static void release_obj(void *ptr)
+{
+    obj_t *obj = (obj_t*)ptr;
+    if( ALIVE != obj->magic )
+        fatal(" ! Error: object %p (value %"PRIu64") released twice\n", ptr, obj->value);
+    obj->magic = DEAD;
+    parsec_lifo_push(&graveyard, &obj->super);
+    (void)parsec_atomic_fetch_inc_int32(&nb_released);
+}
+
+/*
+ * Each thread replaces the shared object once every 8 iterations, and
+ * otherwise reads it (twice, with a nested critical section) and checks
+ * that it was not released.
+ */
+static void *churn(void *_arg)
+{
+    uint64_t *rtime = (uint64_t*)_arg;
+    unsigned int me = (unsigned int)*rtime, r, k;
+    parsec_time_t start, end;
+    obj_t *obj, *old;
+
+    parsec_barrier_wait(&barrier);
+    start = take_time();
+    for(r = 0; r < NBTIMES; r++) {
+        if( 0 == ((r + me) & 7) ) {
+            obj = new_obj(((uint64_t)me << 32) | r);
+            do {
+                old = shared;
+            } while( !parsec_atomic_cas_ptr(&shared, old, obj) );
+            (void)parsec_atomic_fetch_inc_int32(&nb_retired);
+            parsec_ebr_retire(old, release_obj);
+        } else {
+            parsec_ebr_enter();
+            obj = shared;
+            for(k = 0; k < 16; k++) {
+                if( ALIVE != obj->magic )
+                    fatal(" ! Error: object %p (value %"PRIu64") read after its release\n", (void*)obj, obj->value);
+            }
+            parsec_ebr_enter();
+            if( ALIVE != shared->magic || ALIVE != obj->magic )
+                fatal(" ! Error: object read after its release in a nested critical section\n");
+            parsec_ebr_exit();
+            parsec_ebr_exit();
+        }
+        parsec_ebr_quiescent();
+    }
+    end = take_time();
+    *rtime = diff_time(start, end);
+    return NULL;
+}
+
+static void usage(const char *name, const char *msg)
+{
+    if( NULL != msg ) {
+        fprintf(stderr, "%s\n", msg);
+    }
+    fprintf(stderr,
+            "Usage: \n"
+            "   %s [-c cores|-N nbtimes|-h|-?]\n"
+            " where\n"
+            "   -c cores:   cores (integer >0) defines the number of cores to test\n"
+            "   -N nbtimes: nbtimes (integer >0) defines the number of iterations of each thread (default %u)\n",
+            name, NBTIMES);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t *threads;
+    uint64_t *times;
+    uint64_t max_time = 0;
+    unsigned int e;
+    int32_t released;
+    parsec_list_item_t *item;
+    int ch;
+    char *m;
+
+#if defined(PARSEC_HAVE_MPI)
+    {
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    }
+#endif
+    while( (ch = getopt(argc, argv, "c:N:h?")) != -1 ) {
+        switch(ch) {
+        case 'c':
+            nbthreads = strtol(optarg, &m, 0);
+            if( (0 == nbthreads) || (m[0] != '\0') ) usage(argv[0], "invalid -c value");
+            break;
+        case 'N':
+            NBTIMES = strtol(optarg, &m, 0);
+            if( (0 == NBTIMES) || (m[0] != '\0') ) usage(argv[0], "invalid -N value");
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage(argv[0], NULL);
+            break;
+        }
+    }
+
+    PARSEC_OBJ_CONSTRUCT(&graveyard, parsec_lifo_t);
+    shared = new_obj(0);
+
+    printf("Sequential test.\n");
+    printf(" - retire an object in a critical section, and check it is released after the critical section only\n");
+    parsec_ebr_enter();
+    parsec_ebr_retire(shared, release_obj);
+    nb_retired++;
+    if( 0 != nb_released )
+        fatal(" ! Error: an object was released in the critical section that retired it\n");
+    parsec_ebr_exit();
+    parsec_ebr_quiescent();
+    if( 1 != nb_released )
+        fatal(" ! Error: %d objects were released at the first quiescent point, expected 1\n", nb_released);
+    shared = new_obj(0);
+
+    printf("Parallel test.\n");
+    printf(" - %u threads replace a shared object or read it in critical sections %u times\n",
+           nbthreads, NBTIMES);
+    parsec_barrier_init(&barrier, NULL, nbthreads);
+    threads = (pthread_t*)calloc(sizeof(pthread_t), nbthreads);
+    times = (uint64_t*)calloc(sizeof(uint64_t), nbthreads);
+    for(e = 0; e < nbthreads; e++) {
+        times[e] = e;
+        pthread_create(&threads[e], NULL, churn, &times[e]);
+    }
+    for(e = 0; e < nbthreads; e++) {
+        pthread_join(threads[e], NULL);
+        if( max_time < times[e] ) max_time = times[e];
+    }
+    released = nb_released;
+    if( released <= 1 )
+        fatal(" ! Error: no object was released while the threads were running\n");
+    parsec_ebr_fini();
+    if( nb_released != nb_retired )
+        fatal(" ! Error: %d objects were released, %d were retired\n", nb_released, nb_retired);
+    printf("== %d objects retired, %d released while the threads were running\n", nb_retired, released);
+    printf("== Time to run %u iterations per thread for %u threads:\n"
+           "== MAX %"PRIu64" %s\n",
+           NBTIMES, nbthreads, max_time, TIMER_UNIT);
+
+    release_obj(shared);
+    while( NULL != (item = parsec_lifo_pop(&graveyard)) )
+        parsec_lifo_item_free(item);
+    PARSEC_OBJ_DESTRUCT(&graveyard);
+    parsec_barrier_destroy(&barrier);
+    free(threads);
+    free(times);
+
+#if defined(PARSEC_HAVE_MPI)
+    MPI_Finalize();
+#endif
+    return 0;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2021 The University of Tennessee and The University
+ * Copyright (c) 2017-2022 The University of Tennessee and The University
  *                         of Tennessee Research Foundation.  All rights
  *                         reserved.
  */
@@ -20,6 +20,7 @@
 #include "parsec/utils/debug.h"
 
 #include "parsec/class/parsec_hash_table.h"
+#include "parsec/class/parsec_oa_hash_table.h"
 
 #define START_BASE 4
 #define START_MASK (0xFFFFFFFF >> (32-START_BASE))
@@ -295,6 +296,273 @@ static void *do_test(void *_param)
     return (void*)(uintptr_t)duration;
 }
 
+/*
+ * Throughput benchmark (-b): the same workload runs on the chained hash table
+ * (parsec_hash_table_t) and on the open addressing one (parsec_oa_hash_table_t),
+ * starting from a small table so that both are resized during the insertions.
+ */
+static parsec_oa_hash_table_t oa_hash_table;
+
+typedef struct {
+    const char *name;
+    void  (*init)(void);
+    void  (*fini)(void);
+    void  (*insert)(parsec_hash_table_item_t *item);
+    void *(*find)(parsec_key_t key);
+    void *(*remove)(parsec_key_t key);
+} bench_table_t;
+
+static void chained_init(void) { parsec_hash_table_init(&hash_table, offsetof(empty_hash_item_t, ht_item), 3, key_functions, NULL); }
+static void chained_fini(void) { parsec_hash_table_fini(&hash_table); }
+static void chained_insert(parsec_hash_table_item_t *item) { parsec_hash_table_insert(&hash_table, item); }
+static void *chained_find(parsec_key_t key) { return parsec_hash_table_find(&hash_table, key); }
+static void *chained_remove(parsec_key_t key) { return parsec_hash_table_remove(&hash_table, key); }
+
+static void oa_init(void)
+{
+    if( PARSEC_SUCCESS != parsec_oa_hash_table_init(&oa_hash_table, offsetof(empty_hash_item_t, ht_item), 3, key_functions, NULL) ) {
+        fprintf(stderr, "Error: the open addressing hash table could not be initialized\n");
+        exit(1);
+    }
+}
+static void oa_fini(void) { parsec_oa_hash_table_fini(&oa_hash_table); }
+static void oa_insert(parsec_hash_table_item_t *item) { parsec_oa_hash_table_insert(&oa_hash_table, item); }
+static void *oa_find(parsec_key_t key) { return parsec_oa_hash_table_find(&oa_hash_table, key); }
+static void *oa_remove(parsec_key_t key) { return parsec_oa_hash_table_remove(&oa_hash_table, key); }
+
+static const bench_table_t bench_tables[] = {
+    { "chained", chained_init, chained_fini, chained_insert, chained_find, chained_remove },
+    { "oa",      oa_init,      oa_fini,      oa_insert,      oa_find,      oa_remove      },
+};
+#define NB_BENCH_TABLES ((int)(sizeof(bench_tables) / sizeof(bench_tables[0])))
+#define NB_BENCH_PHASES 4
+static const char *bench_phases[NB_BENCH_PHASES] = { "insert", "find", "churn", "remove" };
+
+/* All the items, thread id owns the items id, id + nbthreads, ... */
+static empty_hash_item_t *bench_items = NULL;
+static const bench_table_t *bench_table = NULL;
+static uint64_t bench_ns[NB_BENCH_PHASES];
+static volatile int32_t bench_errors = 0;
+
+static void bench_error(const char *phase, int t, void *rc, void *expected)
+{
+    if( parsec_atomic_fetch_inc_int32(&bench_errors) < 10 ) {
+        fprintf(stderr, "Error in implementation of the %s hash table during %s: item with key %"PRIu64" returned %p, expected %p\n",
+                bench_table->name, phase, (uint64_t)bench_items[t].ht_item.key, rc, expected);
+    }
+}
+
+static void *do_bench_test(void *_param)
+{
+    param_t *param = (param_t*)_param;
+    int id = param->id;
+    int nbthreads = param->nbthreads;
+    int nbtests = param->nb_tests;
+    parsec_time_t t0 = take_time();
+    int t, phase = 0;
+    void *rc;
+
+    parsec_bindthread(id%nbcores, 0);
+
+#define BENCH_PHASE_START()                             \
+    parsec_barrier_wait(&barrier1);                     \
+    if( 0 == id ) t0 = take_time();
+#define BENCH_PHASE_END()                               \
+    parsec_barrier_wait(&barrier2);                     \
+    if( 0 == id ) bench_ns[phase] = diff_time(t0, take_time()); \
+    phase++;
+
+    /* Each thread inserts its items */
+    BENCH_PHASE_START();
+    for(t = id; t < nbtests; t += nbthreads) {
+        bench_table->insert(&bench_items[t].ht_item);
+    }
+    BENCH_PHASE_END();
+
+    /* Each thread looks up all the items, starting from different ones */
+    BENCH_PHASE_START();
+    for(int i = 0; i < nbtests; i++) {
+        t = (i + id * (nbtests / nbthreads)) % nbtests;
+        rc = bench_table->find(bench_items[t].ht_item.key);
+        if( rc != &bench_items[t] ) bench_error("find", t, rc, &bench_items[t]);
+    }
+    BENCH_PHASE_END();
+
+    /* Each thread removes and inserts back its items, leaving tombstones */
+    BENCH_PHASE_START();
+    for(t = id; t < nbtests; t += nbthreads) {
+        rc = bench_table->remove(bench_items[t].ht_item.key);
+        if( rc != &bench_items[t] ) bench_error("churn", t, rc, &bench_items[t]);
+        rc = bench_table->find(bench_items[t].ht_item.key);
+        if( NULL != rc ) bench_error("churn", t, rc, NULL);
+        bench_table->insert(&bench_items[t].ht_item);
+    }
+    BENCH_PHASE_END();
+
+    /* Each thread removes its items */
+    BENCH_PHASE_START();
+    for(t = id; t < nbtests; t += nbthreads) {
+        rc = bench_table->remove(bench_items[t].ht_item.key);
+        if( rc != &bench_items[t] ) bench_error("remove", t, rc, &bench_items[t]);
+    }
+    BENCH_PHASE_END();
+#undef BENCH_PHASE_START
+#undef BENCH_PHASE_END
+
+    return NULL;
+}
+
+/* Runs the benchmark on all the tables, and prints the best throughput of the
+ * nb_loops runs of each phase, in millions of operations per second */
+static int bench_run(pthread_t *threads, param_t *params, int nbthreads, int nb_tests, int nb_loops)
+{
+    /* Operations of each phase: the churn does a remove, a find and an insert per item */
+    double nb_ops[NB_BENCH_PHASES] = { nb_tests, (double)nb_tests * nbthreads, 3.0 * nb_tests, nb_tests };
+    double best[NB_BENCH_PHASES];
+    int tab, l, p, e;
+
+    for(tab = 0; tab < NB_BENCH_TABLES; tab++) {
+        bench_table = &bench_tables[tab];
+        for(p = 0; p < NB_BENCH_PHASES; p++) best[p] = 0.0;
+        for(l = 0; l < nb_loops; l++) {
+            bench_table->init();
+            for(e = 0; e < nbthreads-1; e++) {
+                pthread_create(&threads[e], NULL, do_bench_test, &params[e]);
+            }
+            do_bench_test(&params[nbthreads-1]);
+            for(e = 0; e < nbthreads-1; e++) {
+                pthread_join(threads[e], NULL);
+            }
+            bench_table->fini();
+            for(p = 0; p < NB_BENCH_PHASES; p++) {
+                if( bench_ns[p] > 0 && nb_ops[p] * 1e3 / bench_ns[p] > best[p] )
+                    best[p] = nb_ops[p] * 1e3 / bench_ns[p];
+            }
+        }
+        printf("%-8s %3d threads", bench_table->name, nbthreads);
+        for(p = 0; p < NB_BENCH_PHASES; p++) {
+            printf(" %s %8.2f", bench_phases[p], best[p]);
+        }
+        printf(" Mop/s\n");
+        fflush(stdout);
+    }
+    return bench_errors;
+}
+
+/*
+ * Batch operations test (-B): each thread inserts its items, finds all the
+ * items and removes its items with the batch operations, in batches of
+ * varying sizes, starting from a small table so that it is resized during
+ * the insertions.
+ */
+static volatile int32_t batch_errors = 0;
+
+static void batch_error(const char *op, int id, parsec_key_t key, void *rc, void *expected)
+{
+    if( parsec_atomic_fetch_inc_int32(&batch_errors) < 10 ) {
+        fprintf(stderr, "Error in implementation of the batch %s on thread %d: item with key %"PRIu64" returned %p, expected %p\n",
+                op, id, (uint64_t)key, rc, expected);
+    }
+}
+
+/* Counts the elements a batch find applied to */
+static void batch_count_applied(void *item, void *cb_data)
+{
+    (void)item;
+    (*(int*)cb_data)++;
+}
+
+static void *do_batch_test(void *_param)
+{
+    param_t *param = (param_t*)_param;
+    int id = param->id;
+    int nbthreads = param->nbthreads;
+    int nbtests = param->nb_tests / nbthreads + (id < (param->nb_tests % nbthreads));
+    parsec_hash_table_item_t **items;
+    empty_hash_item_t *item_array;
+    parsec_key_t *keys;
+    void **found;
+    int l, t, i, nb, size, applied;
+
+    parsec_bindthread(id%nbcores, 0);
+
+    item_array = malloc(sizeof(empty_hash_item_t)*nbtests);
+    items = malloc(sizeof(parsec_hash_table_item_t*)*nbtests);
+    keys = malloc(sizeof(parsec_key_t)*param->nb_tests);
+    found = malloc(sizeof(void*)*param->nb_tests);
+    for(t = 0; t < nbtests; t++) {
+        item_array[t].ht_item.key = param->keys[nbthreads * t + id];
+        item_array[t].thread_id = id;
+        item_array[t].nbthreads = nbthreads;
+        item_array[t].thread_key = nbthreads * t + id;
+        items[t] = &item_array[t].ht_item;
+    }
+    for(t = 0; t < param->nb_tests; t++) {
+        keys[t] = param->keys[t];
+    }
+
+    for(l = 0; l < param->nb_loops; l++) {
+        if( 0 == id ) {
+            parsec_hash_table_init(&hash_table, offsetof(empty_hash_item_t, ht_item), 3, key_functions, NULL);
+        }
+        parsec_barrier_wait(&barrier1);
+
+        /* The batch sizes go from 1 to 97, to use both the sort on the stack and on the heap */
+        for(t = 0, size = 1 + id; t < nbtests; t += nb, size = 1 + (size + 7) % 97) {
+            nb = (nbtests - t < size) ? nbtests - t : size;
+            parsec_hash_table_insert_many(&hash_table, nb, &items[t]);
+        }
+        parsec_barrier_wait(&barrier2);
+
+        for(t = 0, size = 1 + id; t < param->nb_tests; t += nb, size = 1 + (size + 13) % 97) {
+            nb = (param->nb_tests - t < size) ? param->nb_tests - t : size;
+            parsec_hash_table_find_many(&hash_table, nb, &keys[t], &found[t]);
+        }
+        for(t = 0; t < param->nb_tests; t++) {
+            if( NULL == found[t] || ((empty_hash_item_t*)found[t])->thread_key != t ||
+                ((empty_hash_item_t*)found[t])->ht_item.key != keys[t] )
+                batch_error("find", id, keys[t], found[t], NULL);
+        }
+        applied = 0;
+        parsec_hash_table_find_many_apply(&hash_table, param->nb_tests, keys, found,
+                                          batch_count_applied, &applied);
+        if( applied != param->nb_tests )
+            batch_error("find and apply", id, keys[0], (void*)(intptr_t)applied, (void*)(intptr_t)param->nb_tests);
+        parsec_barrier_wait(&barrier1);
+
+        for(t = 0, size = 1 + id; t < nbtests; t += nb, size = 1 + (size + 11) % 97) {
+            nb = (nbtests - t < size) ? nbtests - t : size;
+            for(i = 0; i < nb; i++) {
+                keys[i] = item_array[t + i].ht_item.key;
+            }
+            parsec_hash_table_remove_many(&hash_table, nb, keys, found);
+            for(i = 0; i < nb; i++) {
+                if( found[i] != &item_array[t + i] )
+                    batch_error("remove", id, keys[i], found[i], &item_array[t + i]);
+            }
+            parsec_hash_table_find_many(&hash_table, nb, keys, found);
+            for(i = 0; i < nb; i++) {
+                if( NULL != found[i] )
+                    batch_error("find after remove", id, keys[i], found[i], NULL);
+            }
+        }
+        for(t = 0; t < param->nb_tests; t++) {
+            keys[t] = param->keys[t];
+        }
+        parsec_barrier_wait(&barrier2);
+
+        if( 0 == id ) {
+            parsec_hash_table_fini(&hash_table);
+        }
+    }
+
+    free(item_array);
+    free(items);
+    free(keys);
+    free(found);
+    return NULL;
+}
+
 typedef struct node_s {
     uint64_t value;
     struct node_s *smaller;
@@ -384,6 +652,8 @@ int main(int argc, char *argv[])
     int md_tuning_inc = 1;
     int md_tuning;
     int simple_perf = 0;
+    int bench = 0;
+    int batch = 0;
     bool use_handle = 0;
     int nb_tests = 30000;
     int nb_loops = 300;
@@ -406,7 +676,7 @@ int main(int argc, char *argv[])
         fprintf(stderr, "Warning: unable to find the hash table hint, tuning behavior will be disabled\n");
     }
     
-    while( (ch = getopt(argc, argv, "c:m:M:t:T:i:d:D:I:#:r:hnpH?")) != -1 ) {
+    while( (ch = getopt(argc, argv, "c:m:M:t:T:i:d:D:I:#:r:hnpbBH?")) != -1 ) {
         switch(ch) {
         case 'c':
             ch = strtol(optarg, &m, 0);
@@ -492,6 +762,12 @@ int main(int argc, char *argv[])
         case 'p':
             simple_perf = 1;
             break;
+        case 'b':
+            bench = 1;
+            break;
+        case 'B':
+            batch = 1;
+            break;
         case 'H':
             use_handle = true;
             break;
@@ -504,6 +780,9 @@ int main(int argc, char *argv[])
                     "          [-d max_table_depth_min -D max_table_depth_max -I max_table_depth_inc]\n"
                     "          [-# number of items to insert][-r number of loops of the test][-n use a new hash table for each test]\n"
                     "          [-p (run simple performance test)]\n"
+                    "          [-b (compare the throughput of the chained and open addressing tables,\n"
+                    "               doubling the number of threads from min to max, e.g. -m 1 -M 64)]\n"
+                    "          [-B (test the batch insertions, lookups and removals)]\n"
                     "          [-H (use key handles for locking buckets)]\n", argv[0]);
             exit(1);
             break;
@@ -567,6 +846,62 @@ int main(int argc, char *argv[])
     keys = calloc(sizeof(uint64_t), nb_tests);
     init_keys(keys, nb_tests);
 
+    if( bench ) {
+        int errors = 0;
+        bench_items = calloc(sizeof(empty_hash_item_t), nb_tests);
+        for(e = 0; e < nb_tests; e++) {
+            bench_items[e].ht_item.key = keys[e];
+            bench_items[e].thread_key = e;
+        }
+        printf("Best throughput of %d runs with %d items\n", nb_loops, nb_tests);
+        for( nbthreads = minthreads; nbthreads < maxthreads; nbthreads = 2 * (nbthreads + 1) - 1 ) {
+            for(e = 0; e < nbthreads+1; e++) {
+                params[e].id = e;
+                params[e].nbthreads = nbthreads+1;
+                params[e].nb_tests = nb_tests;
+            }
+            parsec_barrier_init(&barrier1, NULL, nbthreads+1);
+            parsec_barrier_init(&barrier2, NULL, nbthreads+1);
+            errors += bench_run(threads, params, nbthreads+1, nb_tests, nb_loops);
+            parsec_barrier_destroy(&barrier1);
+            parsec_barrier_destroy(&barrier2);
+        }
+        free(bench_items);
+        free(threads);
+        free(keys);
+        free(params);
+        return (0 == errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if( batch ) {
+        for( nbthreads = minthreads; nbthreads < maxthreads; nbthreads++) {
+            for(e = 0; e < nbthreads+1; e++) {
+                params[e].id = e;
+                params[e].nbthreads = nbthreads+1;
+                params[e].keys = keys;
+                params[e].nb_tests = nb_tests;
+                params[e].nb_loops = nb_loops;
+            }
+            parsec_barrier_init(&barrier1, NULL, nbthreads+1);
+            parsec_barrier_init(&barrier2, NULL, nbthreads+1);
+            for(e = 0; e < nbthreads; e++) {
+                pthread_create(&threads[e], NULL, do_batch_test, &params[e]);
+            }
+            do_batch_test(&params[nbthreads]);
+            for(e = 0; e < nbthreads; e++) {
+                pthread_join(threads[e], NULL);
+            }
+            parsec_barrier_destroy(&barrier1);
+            parsec_barrier_destroy(&barrier2);
+            printf("%lu threads: %d batch errors\n", (long)(nbthreads+1), batch_errors);
+            fflush(stdout);
+        }
+        free(threads);
+        free(keys);
+        free(params);
+        return (0 == batch_errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     for(md_tuning = md_tuning_min; md_tuning < md_tuning_max; md_tuning += md_tuning_inc) {
         for(mc_tuning = mc_tuning_min; mc_tuning < mc_tuning_max; mc_tuning += mc_tuning_inc) {
             if(mc_hint_index > 0) {
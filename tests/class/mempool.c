@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/runtime.h"
+#undef NDEBUG
+#include <pthread.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#if defined(PARSEC_HAVE_MPI)
+#include <mpi.h>
+#endif
+
+#include "parsec/mempool.h"
+#include "parsec/class/lifo.h"
+#include "parsec/class/barrier.h"
+#include "parsec/os-spec-timing.h"
+
+static unsigned int NBELT = 256;
+static unsigned int NBTIMES = 2000;
+static unsigned int MAXIDLE = 1;
+static unsigned int nbthreads = 1;
+
+static parsec_mempool_t mempool;
+static parsec_lifo_t *mailboxes;
+static parsec_barrier_t barrier;
+
+typedef struct {
+    parsec_list_item_t        super;
+    parsec_thread_mempool_t  *owner;
+    uint32_t                  stamp;
+    uint32_t                  check;
+    volatile int32_t          live;
+} elt_t;
+
+static void elt_construct(elt_t *elt)
+{
+    elt->live = 0;
+}
+PARSEC_OBJ_CLASS_INSTANCE(elt_t, parsec_list_item_t, elt_construct, NULL);
+
+static void fatal(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+    raise(SIGABRT);
+}
+
+static elt_t *get_elt(parsec_thread_mempool_t *tm, uint32_t stamp)
+{
+    elt_t *elt = (elt_t*)parsec_thread_mempool_allocate(tm);
+    if( NULL == elt )
+        fatal(" ! Error: allocation failed\n");
+    if( !parsec_atomic_cas_int32(&elt->live, 0, 1) )
+        fatal(" ! Error: element %p (stamp %x) allocated twice\n", (void*)elt, elt->stamp);
+    elt->stamp = stamp;
+    elt->check = ~stamp;
+    return elt;
+}
+
+static void put_elt(elt_t *elt)
+{
+    if( elt->check != ~elt->stamp )
+        fatal(" ! Error: element %p (stamp %x) is corrupt\n", (void*)elt, elt->stamp);
+    if( !parsec_atomic_cas_int32(&elt->live, 1, 0) )
+        fatal(" ! Error: element %p (stamp %x) freed twice\n", (void*)elt, elt->stamp);
+    parsec_mempool_free(&mempool, elt);
+}
+
+static void drain(parsec_lifo_t *mailbox)
+{
+    elt_t *elt;
+    while( NULL != (elt = (elt_t*)parsec_lifo_pop(mailbox)) )
+        put_elt(elt);
+}
+
+/*
+ * Each thread allocates NBELT elements at each round, frees half of them,
+ * and sends the other half to the next thread, that frees them.
+ */
+static void *churn(void *_arg)
+{
+    uint64_t *rtime = (uint64_t*)_arg;
+    unsigned int me = (unsigned int)*rtime, r, e;
+    parsec_thread_mempool_t *tm = &mempool.thread_mempools[me];
+    elt_t **local = (elt_t**)malloc(NBELT * sizeof(elt_t*));
+    parsec_time_t start, end;
+    unsigned int nb_local;
+
+    parsec_thread_mempool_bind(tm);
+    parsec_barrier_wait(&barrier);
+    start = take_time();
+    for(r = 0; r < NBTIMES; r++) {
+        nb_local = 0;
+        for(e = 0; e < NBELT; e++) {
+            elt_t *elt = get_elt(tm, (me << 24) | (e & 0xffffff));
+            if( e & 1 )
+                parsec_lifo_push(&mailboxes[(me + 1) % nbthreads], &elt->super);
+            else
+                local[nb_local++] = elt;
+        }
+        for(e = 0; e < nb_local; e++)
+            put_elt(local[e]);
+        drain(&mailboxes[me]);
+    }
+    parsec_barrier_wait(&barrier);
+    drain(&mailboxes[me]);
+    parsec_thread_mempool_flush(tm);
+    end = take_time();
+    *rtime = diff_time(start, end);
+    free(local);
+    return NULL;
+}
+
+static void usage(const char *name, const char *msg)
+{
+    if( NULL != msg ) {
+        fprintf(stderr, "%s\n", msg);
+    }
+    fprintf(stderr,
+            "Usage: \n"
+            "   %s [-c cores|-n nbelt|-N nbtimes|-i idle|-l|-h|-?]\n"
+            " where\n"
+            "   -c cores:   cores (integer >0) defines the number of cores to test\n"
+            "   -n nbelt:   nbelt (integer >0) defines the number of elements each thread allocates per round (default %u)\n"
+            "   -N nbtimes: nbtimes (integer >0) defines the number of rounds (default %u)\n"
+            "   -i idle:    number of idle slabs kept by each thread (default %u)\n"
+            "   -l:         use the LIFO mode instead of the slab mode\n",
+            name, NBELT, NBTIMES, MAXIDLE);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t *threads;
+    uint64_t *times;
+    uint64_t max_time = 0;
+    parsec_thread_mempool_t *tm;
+    elt_t **elts, *elt;
+    unsigned int e, nb, use_slabs = 1;
+    int ch;
+    char *m;
+
+#if defined(PARSEC_HAVE_MPI)
+    {
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    }
+#endif
+    while( (ch = getopt(argc, argv, "c:n:N:i:lh?")) != -1 ) {
+        switch(ch) {
+        case 'c':
+            nbthreads = strtol(optarg, &m, 0);
+            if( (0 == nbthreads) || (m[0] != '\0') ) usage(argv[0], "invalid -c value");
+            break;
+        case 'n':
+            NBELT = strtol(optarg, &m, 0);
+            if( (0 == NBELT) || (m[0] != '\0') ) usage(argv[0], "invalid -n value");
+            break;
+        case 'N':
+            NBTIMES = strtol(optarg, &m, 0);
+            if( (0 == NBTIMES) || (m[0] != '\0') ) usage(argv[0], "invalid -N value");
+            break;
+        case 'i':
+            MAXIDLE = strtol(optarg, &m, 0);
+            if( m[0] != '\0' ) usage(argv[0], "invalid -i value");
+            break;
+        case 'l':
+            use_slabs = 0;
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage(argv[0], NULL);
+            break;
+        }
+    }
+
+    /* One more thread mempool for the main thread */
+    parsec_mempool_construct(&mempool, PARSEC_OBJ_CLASS(elt_t), sizeof(elt_t),
+                             offsetof(elt_t, owner), nbthreads + 1);
+    if( use_slabs )
+        parsec_mempool_slab_enable(&mempool, MAXIDLE);
+    tm = &mempool.thread_mempools[nbthreads];
+
+    if( use_slabs ) {
+        printf("Sequential test.\n");
+        printf(" - allocate from a thread mempool the main thread does not own\n");
+        elt = get_elt(&mempool.thread_mempools[0], 0);
+        if( elt->owner != mempool.shared )
+            fatal(" ! Error: an unbound thread did not allocate from the shared LIFO\n");
+        put_elt(elt);
+
+        parsec_thread_mempool_bind(tm);
+        nb = 8 * mempool.slab_capacity;
+        printf(" - allocate %u elements (%u slabs), free them, and check that idle slabs are released\n",
+               nb, nb / mempool.slab_capacity);
+        elts = (elt_t**)malloc(nb * sizeof(elt_t*));
+        for(e = 0; e < nb; e++) {
+            elts[e] = get_elt(&mempool.thread_mempools[0], e);
+            if( elts[e]->owner != tm )
+                fatal(" ! Error: the main thread did not allocate from its own thread mempool\n");
+        }
+        if( tm->nb_slabs != 8 )
+            fatal(" ! Error: %u slabs were allocated for %u elements, expected 8\n", tm->nb_slabs, nb);
+        for(e = 0; e < nb; e++)
+            put_elt(elts[e]);
+        if( tm->nb_slabs > MAXIDLE + 1 )
+            fatal(" ! Error: %u slabs are still allocated, for at most %u idle slabs\n", tm->nb_slabs, MAXIDLE);
+        printf(" - reallocate them, and check that the remaining slabs are reused\n");
+        for(e = 0; e < nb; e++)
+            elts[e] = get_elt(tm, e);
+        if( tm->nb_slabs != 8 )
+            fatal(" ! Error: %u slabs are allocated for %u elements, expected 8\n", tm->nb_slabs, nb);
+        for(e = 0; e < nb; e++)
+            put_elt(elts[e]);
+        free(elts);
+    }
+
+    printf("Parallel test.\n");
+    printf(" - %u threads allocate %u elements %u times, free half of them and send the other half to another thread\n",
+           nbthreads, NBELT, NBTIMES);
+    mailboxes = (parsec_lifo_t*)malloc(nbthreads * sizeof(parsec_lifo_t));
+    for(e = 0; e < nbthreads; e++)
+        PARSEC_OBJ_CONSTRUCT(&mailboxes[e], parsec_lifo_t);
+    parsec_barrier_init(&barrier, NULL, nbthreads);
+    threads = (pthread_t*)calloc(sizeof(pthread_t), nbthreads);
+    times = (uint64_t*)calloc(sizeof(uint64_t), nbthreads);
+    for(e = 0; e < nbthreads; e++) {
+        times[e] = e;
+        pthread_create(&threads[e], NULL, churn, &times[e]);
+    }
+    for(e = 0; e < nbthreads; e++) {
+        pthread_join(threads[e], NULL);
+        if( max_time < times[e] ) max_time = times[e];
+    }
+    if( use_slabs ) {
+        uint64_t remote = 0, batches = 0;
+        for(e = 0; e < nbthreads; e++) {
+            remote += mempool.thread_mempools[e].nb_remote_frees;
+            batches += mempool.thread_mempools[e].nb_returned_batches;
+        }
+        if( (nbthreads > 1) && (remote != (uint64_t)nbthreads * NBTIMES * (NBELT / 2)) )
+            fatal(" ! Error: %"PRIu64" remote frees, expected %"PRIu64"\n",
+                  remote, (uint64_t)nbthreads * NBTIMES * (NBELT / 2));
+        printf("== %"PRIu64" remote frees in %"PRIu64" batches\n", remote, batches);
+    }
+    printf("== Time to allocate and free %u elements %u times per thread for %u threads (%s mode):\n"
+           "== MAX %"PRIu64" %s\n",
+           NBELT, NBTIMES, nbthreads, use_slabs ? "slab" : "LIFO",
+           max_time, TIMER_UNIT);
+
+    for(e = 0; e < nbthreads; e++)
+        PARSEC_OBJ_DESTRUCT(&mailboxes[e]);
+    free(mailboxes);
+    free(threads);
+    free(times);
+    parsec_barrier_destroy(&barrier);
+    parsec_mempool_destruct(&mempool);
+
+#if defined(PARSEC_HAVE_MPI)
+    MPI_Finalize();
+#endif
+    return 0;
+}
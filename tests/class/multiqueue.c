@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/runtime.h"
+#undef NDEBUG
+#include <pthread.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <inttypes.h>
+#if defined(PARSEC_HAVE_MPI)
+#include <mpi.h>
+#endif
+
+#include "parsec/class/multiqueue.h"
+#include "parsec/sys/atomic.h"
+#include "parsec/constants.h"
+#include "parsec/os-spec-timing.h"
+
+static unsigned int NBELT = 8192;
+static unsigned int NBROUNDS = 20;
+
+static void fatal(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+    raise(SIGABRT);
+}
+
+typedef struct {
+    parsec_list_item_t list;
+    int priority;
+    unsigned int base;
+} elt_t;
+
+static elt_t *elts = NULL;
+static volatile int32_t *seen = NULL;
+
+/* Fenwick tree over the priorities still in the queue, to compute the
+ * rank of the popped elements */
+static unsigned int *fenwick = NULL;
+
+static void fenwick_add(unsigned int p, int v)
+{
+    for( p++; p <= NBELT; p += p & (-p) ) fenwick[p] += v;
+}
+
+static unsigned int fenwick_count_below(unsigned int p)
+{
+    unsigned int c = 0;
+    for( ; p > 0; p -= p & (-p) ) c += fenwick[p];
+    return c;
+}
+
+/* Give the elements a random permutation of the priorities 0..NBELT-1 */
+static void shuffle_priorities(parsec_multiqueue_thread_t *th)
+{
+    unsigned int e, j;
+    int tmp;
+    for(e = 0; e < NBELT; e++) elts[e].priority = (int)e;
+    for(e = NBELT - 1; e > 0; e--) {
+        j = parsec_multiqueue_rand(&th->seed) % (e + 1);
+        tmp = elts[e].priority; elts[e].priority = elts[j].priority; elts[j].priority = tmp;
+    }
+}
+
+/* Push all the elements, pop them back and measure the rank error */
+static void check_rank_error(int nb_heaps, parsec_multiqueue_thread_t *th)
+{
+    parsec_multiqueue_t mq;
+    unsigned int e, rank, max_rank = 0;
+    uint64_t sum_rank = 0;
+    elt_t *elt;
+
+    PARSEC_OBJ_CONSTRUCT(&mq, parsec_multiqueue_t);
+    parsec_multiqueue_init(&mq, nb_heaps, offsetof(elt_t, priority));
+    memset(fenwick, 0, (NBELT + 1) * sizeof(unsigned int));
+    shuffle_priorities(th);
+    for(e = 0; e < NBELT; e++) {
+        parsec_multiqueue_push(&mq, &elts[e].list, th);
+        fenwick_add(elts[e].priority, 1);
+    }
+    if( parsec_multiqueue_approx_size(&mq) != (long long int)NBELT )
+        fatal(" ! Error: the queue holds %lld elements -- expecting %u\n",
+              parsec_multiqueue_approx_size(&mq), NBELT);
+    for(e = 0; e < NBELT; e++) {
+        elt = (elt_t*)parsec_multiqueue_pop(&mq, th);
+        if( NULL == elt )
+            fatal(" ! Error: there are only %u elements in the queue -- expecting %u\n", e, NBELT);
+        /* Number of elements still in the queue with a higher priority */
+        rank = (NBELT - e) - fenwick_count_below(elt->priority + 1);
+        fenwick_add(elt->priority, -1);
+        if( rank > max_rank ) max_rank = rank;
+        sum_rank += rank;
+    }
+    if( NULL != parsec_multiqueue_pop(&mq, th) )
+        fatal(" ! Error: the queue should be empty\n");
+    if( (1 == nb_heaps) && (0 != max_rank) )
+        fatal(" ! Error: a queue with a single heap is not a strict priority queue (max rank error %u)\n", max_rank);
+    printf(" - %3d heaps: rank error avg %.2f max %u\n", nb_heaps, (double)sum_rank / NBELT, max_rank);
+    PARSEC_OBJ_DESTRUCT(&mq);
+}
+
+static void check_ring(parsec_multiqueue_thread_t *th)
+{
+    parsec_multiqueue_t mq;
+    parsec_list_item_t *ring = NULL;
+    elt_t *elt;
+    unsigned int e;
+
+    printf(" - push %u elements as a ring in a single heap and pop them back by priority\n", NBELT);
+    PARSEC_OBJ_CONSTRUCT(&mq, parsec_multiqueue_t);
+    parsec_multiqueue_init(&mq, 1, offsetof(elt_t, priority));
+    shuffle_priorities(th);
+    for(e = 0; e < NBELT; e++) {
+        PARSEC_LIST_ITEM_SINGLETON(&elts[e].list);
+        ring = (NULL == ring) ? &elts[e].list : parsec_list_item_ring_push(ring, &elts[e].list);
+    }
+    parsec_multiqueue_push_ring(&mq, ring, th);
+    for(e = NBELT; e > 0; e--) {
+        elt = (elt_t*)parsec_multiqueue_pop(&mq, th);
+        if( NULL == elt )
+            fatal(" ! Error: there are only %u elements in the queue -- expecting %u\n", NBELT - e, NBELT);
+        if( elt->priority != (int)(e - 1) )
+            fatal(" ! Error: popped priority %d, expecting %u\n", elt->priority, e - 1);
+    }
+    PARSEC_OBJ_DESTRUCT(&mq);
+}
+
+static parsec_multiqueue_t queue;
+static pthread_mutex_t heavy_synchro_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  heavy_synchro_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int    heavy_synchro = 0;
+static pthread_barrier_t round_barrier;
+static unsigned int nbthreads = 1;
+static volatile int32_t nb_busy = 0;  /* failed trylocks of all the threads */
+
+static void take(elt_t *elt)
+{
+    if( elt->base >= NBELT )
+        fatal(" ! Error: base of the element %u is outside boundaries\n", elt->base);
+    if( 0 != parsec_atomic_fetch_inc_int32(&seen[elt->base]) )
+        fatal(" ! Error: the element %u was taken at least twice\n", elt->base);
+}
+
+/* Each thread pushes its share of the elements, popping one every other
+ * push, then everybody drains the queue */
+static void *worker(void *params)
+{
+    unsigned int id = (unsigned int)(uintptr_t)params;
+    parsec_multiqueue_thread_t th = { 0x9e3779b9u * (id + 1), 0 };
+    unsigned int r, e;
+    elt_t *elt;
+
+    pthread_mutex_lock(&heavy_synchro_lock);
+    while( heavy_synchro == 0 ) {
+        pthread_cond_wait(&heavy_synchro_cond, &heavy_synchro_lock);
+    }
+    pthread_mutex_unlock(&heavy_synchro_lock);
+
+    for(r = 0; r < NBROUNDS; r++) {
+        pthread_barrier_wait(&round_barrier);
+        for(e = id; e < NBELT; e += nbthreads) {
+            parsec_multiqueue_push(&queue, &elts[e].list, &th);
+            if( e & 1 ) {
+                elt = (elt_t*)parsec_multiqueue_pop(&queue, &th);
+                if( NULL != elt ) take(elt);
+            }
+        }
+        while( NULL != (elt = (elt_t*)parsec_multiqueue_pop(&queue, &th)) ) {
+            take(elt);
+        }
+        pthread_barrier_wait(&round_barrier);
+        if( 0 == id ) {
+            if( 0 != parsec_multiqueue_approx_size(&queue) )
+                fatal(" ! Error: the queue is not empty after all threads drained it\n");
+            for(e = 0; e < NBELT; e++) {
+                if( 1 != seen[e] )
+                    fatal(" ! Error: element %u was taken %d times during round %u\n", e, seen[e], r);
+            }
+            memset((void*)seen, 0, NBELT * sizeof(int32_t));
+        }
+    }
+    parsec_atomic_fetch_add_int32(&nb_busy, (int32_t)th.nb_busy);
+    return NULL;
+}
+
+static void usage(const char *name, const char *msg)
+{
+    if( NULL != msg ) {
+        fprintf(stderr, "%s\n", msg);
+    }
+    fprintf(stderr,
+            "Usage: \n"
+            "   %s [-c cores|-n nbelt|-N nbrounds|-h|-?]\n"
+            " where\n"
+            "   -c cores:    cores (integer >0) defines the number of threads to test\n"
+            "   -n nbelt:    nbelt (integer >=128) defines the number of elements to use (default %u)\n"
+            "   -N nbrounds: nbrounds (integer >0) defines the number of times the threads push all the elements (default %u)\n",
+            name,
+            NBELT,
+            NBROUNDS);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t *threads;
+    parsec_time_t start, end;
+    parsec_multiqueue_thread_t th = { 2463534242u, 0 };
+    unsigned int e;
+    int ch, nb_heaps;
+    char *m;
+
+#if defined(PARSEC_HAVE_MPI)
+    {
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    }
+#endif
+    while( (ch = getopt(argc, argv, "c:n:N:h?")) != -1 ) {
+        switch(ch) {
+        case 'c': {
+            long nth = strtol(optarg, &m, 0);
+            if( (nth <= 0) || (m[0] != '\0') ) {
+                usage(argv[0], "invalid -c value");
+            }
+            nbthreads = nth;
+            break;
+        }
+        case 'n':
+            NBELT = strtol(optarg, &m, 0);
+            if( (NBELT < 128) || (m[0] != '\0') ) {
+                usage(argv[0], "invalid -n value");
+            }
+            break;
+        case 'N':
+            NBROUNDS = strtol(optarg, &m, 0);
+            if( (NBROUNDS <= 0) || (m[0] != '\0') ) {
+                usage(argv[0], "invalid -N value");
+            }
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage(argv[0], NULL);
+            break;
+        }
+    }
+
+    threads = (pthread_t*)calloc(sizeof(pthread_t), nbthreads);
+    elts = (elt_t*)calloc(sizeof(elt_t), NBELT);
+    seen = (volatile int32_t*)calloc(sizeof(int32_t), NBELT);
+    fenwick = (unsigned int*)calloc(sizeof(unsigned int), NBELT + 1);
+    for(e = 0; e < NBELT; e++) {
+        PARSEC_OBJ_CONSTRUCT(&elts[e].list, parsec_list_item_t);
+        elts[e].base = e;
+    }
+
+    printf("Sequential test.\n");
+    check_ring(&th);
+    printf(" - push %u elements and pop them back, measuring the rank error\n", NBELT);
+    for(nb_heaps = 1; nb_heaps <= 64; nb_heaps *= 4) {
+        check_rank_error(nb_heaps, &th);
+    }
+
+    printf("Parallel test.\n");
+    printf(" - %u threads push and pop %u elements, %u times, in %u heaps\n",
+           nbthreads, NBELT, NBROUNDS, 2 * nbthreads);
+    PARSEC_OBJ_CONSTRUCT(&queue, parsec_multiqueue_t);
+    parsec_multiqueue_init(&queue, 2 * nbthreads, offsetof(elt_t, priority));
+    pthread_barrier_init(&round_barrier, NULL, nbthreads);
+    for(e = 1; e < nbthreads; e++) {
+        pthread_create(&threads[e], NULL, worker, (void*)(uintptr_t)e);
+    }
+
+    pthread_mutex_lock(&heavy_synchro_lock);
+    heavy_synchro = 1;
+    pthread_cond_broadcast(&heavy_synchro_cond);
+    pthread_mutex_unlock(&heavy_synchro_lock);
+
+    start = take_time();
+    worker((void*)(uintptr_t)0);
+    end = take_time();
+
+    for(e = 1; e < nbthreads; e++) {
+        pthread_join(threads[e], NULL);
+    }
+    printf("== %u rounds of %u elements in %"PRIu64" %s, %d failed trylocks\n",
+           NBROUNDS, NBELT, diff_time(start, end), TIMER_UNIT, nb_busy);
+
+    pthread_barrier_destroy(&round_barrier);
+    PARSEC_OBJ_DESTRUCT(&queue);
+    free(elts);
+    free((void*)seen);
+    free(fenwick);
+    free(threads);
+
+    printf(" - all tests passed\n");
+
+#if defined(PARSEC_HAVE_MPI)
+    MPI_Finalize();
+#endif
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/runtime.h"
+#undef NDEBUG
+#include <pthread.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#if defined(PARSEC_HAVE_MPI)
+#include <mpi.h>
+#endif
+
+#include "parsec/class/wsdeque.h"
+#include "parsec/sys/atomic.h"
+#include "parsec/constants.h"
+#include "parsec/os-spec-timing.h"
+
+static unsigned int NBELT = 8192;
+static unsigned int NBROUNDS = 100;
+
+static void fatal(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+    raise(SIGABRT);
+}
+
+static parsec_wsdeque_t deque;
+
+typedef struct {
+    parsec_list_item_t list;
+    unsigned int base;
+} elt_t;
+
+static elt_t *elts = NULL;
+static volatile int32_t *seen = NULL;
+
+static void check_sequential(void)
+{
+    parsec_list_item_t *ring = NULL;
+    elt_t *elt;
+    unsigned int e;
+
+    printf(" - push %u elements and pop them back in reverse order\n", NBELT);
+    for(e = 0; e < NBELT; e++) {
+        if( PARSEC_SUCCESS != parsec_wsdeque_push(&deque, &elts[e].list) )
+            fatal(" ! Error: unable to push element %u in an unbounded dequeue\n", e);
+    }
+    if( parsec_wsdeque_approx_size(&deque) != (long long int)NBELT )
+        fatal(" ! Error: the dequeue holds %lld elements -- expecting %u\n",
+              parsec_wsdeque_approx_size(&deque), NBELT);
+    for(e = NBELT; e > 0; e--) {
+        elt = (elt_t*)parsec_wsdeque_pop(&deque);
+        if( NULL == elt )
+            fatal(" ! Error: there are only %u elements in the dequeue -- expecting %u\n", NBELT - e, NBELT);
+        if( elt->base != e - 1 )
+            fatal(" ! Error: popped element %u, expecting %u\n", elt->base, e - 1);
+    }
+    if( NULL != parsec_wsdeque_pop(&deque) || !parsec_wsdeque_is_empty(&deque) )
+        fatal(" ! Error: the dequeue should be empty\n");
+
+    printf(" - push %u elements as a ring and steal them back in order\n", NBELT);
+    for(e = 0; e < NBELT; e++) {
+        PARSEC_LIST_ITEM_SINGLETON(&elts[e].list);
+        ring = (NULL == ring) ? &elts[e].list : parsec_list_item_ring_push(ring, &elts[e].list);
+    }
+    if( NULL != parsec_wsdeque_push_ring(&deque, ring) )
+        fatal(" ! Error: unable to push the ring in an unbounded dequeue\n");
+    for(e = 0; e < NBELT; e++) {
+        elt = (elt_t*)parsec_wsdeque_steal(&deque);
+        if( NULL == elt )
+            fatal(" ! Error: there are only %u elements in the dequeue -- expecting %u\n", e, NBELT);
+        if( elt->base != e )
+            fatal(" ! Error: stolen element %u, expecting %u\n", elt->base, e);
+    }
+    if( NULL != parsec_wsdeque_steal(&deque) )
+        fatal(" ! Error: the dequeue should be empty\n");
+}
+
+static void check_bounded(void)
+{
+    parsec_wsdeque_t bounded;
+    parsec_list_item_t *ring = NULL, *left;
+    unsigned int e, n;
+
+    printf(" - push a ring of 64 elements in a dequeue bounded to 32 elements\n");
+    PARSEC_OBJ_CONSTRUCT(&bounded, parsec_wsdeque_t);
+    parsec_wsdeque_init(&bounded, 4, 32);
+    for(e = 0; e < 64; e++) {
+        PARSEC_LIST_ITEM_SINGLETON(&elts[e].list);
+        ring = (NULL == ring) ? &elts[e].list : parsec_list_item_ring_push(ring, &elts[e].list);
+    }
+    left = parsec_wsdeque_push_ring(&bounded, ring);
+    if( NULL == left )
+        fatal(" ! Error: a bounded dequeue accepted more elements than its bound\n");
+    if( ((elt_t*)left)->base != 32 )
+        fatal(" ! Error: the first element left out is %u, expecting 32\n", ((elt_t*)left)->base);
+    n = 0;
+    _LIST_ITEM_ITERATOR(left, left, item, { (void)item; n++; });
+    if( 32 != n )
+        fatal(" ! Error: %u elements were left out, expecting 32\n", n);
+    if( PARSEC_ERR_OUT_OF_RESOURCE != parsec_wsdeque_push(&bounded, &elts[100].list) )
+        fatal(" ! Error: a full bounded dequeue accepted an element\n");
+    for(e = 0; e < 32; e++) {
+        if( NULL == parsec_wsdeque_pop(&bounded) )
+            fatal(" ! Error: the bounded dequeue lost element %u\n", e);
+    }
+    PARSEC_OBJ_DESTRUCT(&bounded);
+}
+
+static pthread_mutex_t heavy_synchro_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  heavy_synchro_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int    heavy_synchro = 0;
+static volatile int32_t round_done = 0;
+static volatile int32_t nb_taken = 0;
+
+static void take(elt_t *elt)
+{
+    if( elt->base >= NBELT )
+        fatal(" ! Error: base of the element %u is outside boundaries\n", elt->base);
+    if( 0 != parsec_atomic_fetch_inc_int32(&seen[elt->base]) )
+        fatal(" ! Error: the element %u was taken at least twice\n", elt->base);
+    parsec_atomic_fetch_inc_int32(&nb_taken);
+}
+
+static void *thief(void *params)
+{
+    uint64_t *p = (uint64_t*)params;
+    uint64_t stolen = 0;
+    unsigned int r;
+    elt_t *elt;
+
+    pthread_mutex_lock(&heavy_synchro_lock);
+    while( heavy_synchro == 0 ) {
+        pthread_cond_wait(&heavy_synchro_cond, &heavy_synchro_lock);
+    }
+    pthread_mutex_unlock(&heavy_synchro_lock);
+
+    for(r = 0; r < NBROUNDS; r++) {
+        while( round_done <= (int32_t)r ) {
+            elt = (elt_t*)parsec_wsdeque_steal(&deque);
+            if( NULL != elt ) {
+                take(elt);
+                stolen++;
+            }
+        }
+    }
+    *p = stolen;
+    return NULL;
+}
+
+static void usage(const char *name, const char *msg)
+{
+    if( NULL != msg ) {
+        fprintf(stderr, "%s\n", msg);
+    }
+    fprintf(stderr,
+            "Usage: \n"
+            "   %s [-c cores|-n nbelt|-N nbrounds|-h|-?]\n"
+            " where\n"
+            "   -c cores:    cores (integer >0) defines the number of threads to test (one owner, the others steal)\n"
+            "   -n nbelt:    nbelt (integer >=128) defines the number of elements to use (default %u)\n"
+            "   -N nbrounds: nbrounds (integer >0) defines the number of times the owner pushes all the elements (default %u)\n",
+            name,
+            NBELT,
+            NBROUNDS);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t *threads;
+    uint64_t *stolen;
+    uint64_t sum_stolen;
+    parsec_time_t start, end;
+    unsigned int e, r, nbthreads = 1;
+    elt_t *elt;
+    int ch;
+    char *m;
+
+#if defined(PARSEC_HAVE_MPI)
+    {
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    }
+#endif
+    while( (ch = getopt(argc, argv, "c:n:N:h?")) != -1 ) {
+        switch(ch) {
+        case 'c': {
+            long nth = strtol(optarg, &m, 0);
+            if( (nth <= 0) || (m[0] != '\0') ) {
+                usage(argv[0], "invalid -c value");
+            }
+            nbthreads = nth;
+            break;
+        }
+        case 'n':
+            NBELT = strtol(optarg, &m, 0);
+            if( (NBELT < 128) || (m[0] != '\0') ) {
+                usage(argv[0], "invalid -n value");
+            }
+            break;
+        case 'N':
+            NBROUNDS = strtol(optarg, &m, 0);
+            if( (NBROUNDS <= 0) || (m[0] != '\0') ) {
+                usage(argv[0], "invalid -N value");
+            }
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage(argv[0], NULL);
+            break;
+        }
+    }
+
+    threads = (pthread_t*)calloc(sizeof(pthread_t), nbthreads);
+    stolen = (uint64_t*)calloc(sizeof(uint64_t), nbthreads);
+    elts = (elt_t*)calloc(sizeof(elt_t), NBELT);
+    seen = (volatile int32_t*)calloc(sizeof(int32_t), NBELT);
+    for(e = 0; e < NBELT; e++) {
+        PARSEC_OBJ_CONSTRUCT(&elts[e].list, parsec_list_item_t);
+        elts[e].base = e;
+    }
+
+    PARSEC_OBJ_CONSTRUCT(&deque, parsec_wsdeque_t);
+    parsec_wsdeque_init(&deque, 16, 0);
+
+    printf("Sequential test.\n");
+    check_sequential();
+    check_bounded();
+
+    printf("Parallel test.\n");
+    printf(" - owner pushes and pops %u elements, %u times, while %u threads steal\n",
+           NBELT, NBROUNDS, nbthreads - 1);
+    for(e = 1; e < nbthreads; e++) {
+        pthread_create(&threads[e], NULL, thief, &stolen[e]);
+    }
+
+    pthread_mutex_lock(&heavy_synchro_lock);
+    heavy_synchro = 1;
+    pthread_cond_broadcast(&heavy_synchro_cond);
+    pthread_mutex_unlock(&heavy_synchro_lock);
+
+    start = take_time();
+    for(r = 0; r < NBROUNDS; r++) {
+        memset((void*)seen, 0, NBELT * sizeof(int32_t));
+        nb_taken = 0;
+        parsec_mfence();
+        for(e = 0; e < NBELT; e++) {
+            if( PARSEC_SUCCESS != parsec_wsdeque_push(&deque, &elts[e].list) )
+                fatal(" ! Error: unable to push element %u in an unbounded dequeue\n", e);
+            if( 0 == (rand() % 4) ) {
+                elt = (elt_t*)parsec_wsdeque_pop(&deque);
+                if( NULL != elt ) take(elt);
+            }
+        }
+        while( NULL != (elt = (elt_t*)parsec_wsdeque_pop(&deque)) ) {
+            take(elt);
+        }
+        /* Thieves may still hold an element they took but did not account yet */
+        while( nb_taken != (int32_t)NBELT ) {
+            if( !parsec_wsdeque_is_empty(&deque) )
+                fatal(" ! Error: the dequeue is not empty after the owner popped all elements\n");
+        }
+        for(e = 0; e < NBELT; e++) {
+            if( 1 != seen[e] )
+                fatal(" ! Error: element %u was taken %d times during round %u\n", e, seen[e], r);
+        }
+        parsec_atomic_fetch_inc_int32(&round_done);
+    }
+    end = take_time();
+
+    sum_stolen = 0;
+    for(e = 1; e < nbthreads; e++) {
+        pthread_join(threads[e], NULL);
+        sum_stolen += stolen[e];
+    }
+    printf("== %u rounds of %u elements in %"PRIu64" %s, %"PRIu64" elements stolen\n",
+           NBROUNDS, NBELT, diff_time(start, end), TIMER_UNIT, sum_stolen);
+
+    PARSEC_OBJ_DESTRUCT(&deque);
+    free(elts);
+    free((void*)seen);
+    free(stolen);
+    free(threads);
+
+    printf(" - all tests passed\n");
+
+#if defined(PARSEC_HAVE_MPI)
+    MPI_Finalize();
+#endif
+    return 0;
+}
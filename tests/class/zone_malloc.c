@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+/**
+ * Fragmentation and throughput benchmark of the zone allocator: replays an
+ * allocation trace on a zone, and reports the time spent in zone_malloc and
+ * zone_free, the number of failed allocations, and the fragmentation of the
+ * free memory (1 - largest free area / free memory) along the trace.
+ *
+ * The trace is read from a file (-t), with one operation per line:
+ *    a <id> <bytes>      allocate bytes, and name the allocation id
+ *    f <id>              free the allocation id
+ * or generated: allocations of random sizes (a few tile sizes, and sizes
+ * drawn uniformly on a logarithmic scale) fill the zone up to a target
+ * occupancy, then allocations and frees of random live areas alternate.
+ * A generated trace can be saved (-o) to be replayed later.
+ *
+ * With -c, the areas are checked for overlaps and the allocator counters
+ * against a shadow copy of the zone, outside of the timed sections.
+ */
+
+#include "parsec/parsec_config.h"
+#undef NDEBUG
+#include <stdarg.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "parsec/utils/zone_malloc.h"
+#include "parsec/os-spec-timing.h"
+
+static int    NBUNITS  = 65536;
+static size_t UNITSIZE = 256;
+static int    NBOPS    = 200000;
+static int    FILL     = 90;
+static uint32_t SEED   = 2463534242u;
+
+typedef struct {
+    char     op;
+    int      id;
+    size_t   size;
+} trace_op_t;
+
+typedef struct {
+    void    *ptr;
+    size_t   size;
+} live_t;
+
+static void fatal(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+    raise(SIGABRT);
+}
+
+static uint32_t xorshift32(uint32_t *seed)
+{
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+static size_t random_size(uint32_t *seed)
+{
+    static const size_t tiles[] = { 64*64*8, 128*128*8, 192*192*8, 256*256*8 };
+    size_t max = (size_t)NBUNITS * UNITSIZE / 64;
+    double l;
+
+    if( xorshift32(seed) & 1 ) {
+        size_t t = tiles[xorshift32(seed) % (sizeof(tiles) / sizeof(tiles[0]))];
+        if( t <= max ) return t;
+    }
+    /* log-uniform between 8 bytes and 1/64 of the zone */
+    l = log(8.0) + (log((double)max) - log(8.0)) * (xorshift32(seed) / 4294967296.0);
+    return (size_t)exp(l);
+}
+
+static trace_op_t *generate_trace(int *nb_ops, int *nb_ids)
+{
+    trace_op_t *trace = (trace_op_t*)malloc(NBOPS * sizeof(trace_op_t));
+    int *live = (int*)malloc(NBOPS * sizeof(int));
+    size_t *sizes = (size_t*)malloc(NBOPS * sizeof(size_t));
+    size_t target = (size_t)NBUNITS * UNITSIZE / 100 * FILL, in_use = 0;
+    int n, nb_live = 0, id = 0, l;
+    uint32_t seed = SEED;
+
+    for(n = 0; n < NBOPS; n++) {
+        if( (0 == nb_live) || ((in_use < target) && (n < NBOPS - nb_live)) ) {
+            trace[n].op = 'a';
+            trace[n].id = id;
+            trace[n].size = sizes[id] = random_size(&seed);
+            in_use += sizes[id];
+            live[nb_live++] = id++;
+        } else {
+            l = xorshift32(&seed) % nb_live;
+            trace[n].op = 'f';
+            trace[n].id = live[l];
+            trace[n].size = 0;
+            in_use -= sizes[live[l]];
+            live[l] = live[--nb_live];
+        }
+    }
+    free(live);
+    free(sizes);
+    *nb_ops = NBOPS;
+    *nb_ids = id;
+    return trace;
+}
+
+static trace_op_t *read_trace(const char *name, int *nb_ops, int *nb_ids)
+{
+    FILE *f = fopen(name, "r");
+    trace_op_t *trace = NULL;
+    int n = 0, max = 0, id;
+    unsigned long long size;
+    char op;
+
+    if( NULL == f ) {
+        fatal(" ! Error: cannot open the trace %s\n", name);
+        return NULL;
+    }
+    *nb_ids = 0;
+    while( fscanf(f, " %c %d", &op, &id) == 2 ) {
+        size = 0;
+        if( ('a' == op) && (fscanf(f, " %llu", &size) != 1) )
+            fatal(" ! Error: line %d of %s: allocation without a size\n", n + 1, name);
+        if( (('a' != op) && ('f' != op)) || (id < 0) )
+            fatal(" ! Error: line %d of %s: invalid operation\n", n + 1, name);
+        if( n == max ) {
+            max = (0 == max) ? 4096 : 2 * max;
+            trace = (trace_op_t*)realloc(trace, max * sizeof(trace_op_t));
+        }
+        trace[n].op = op;
+        trace[n].id = id;
+        trace[n].size = (size_t)size;
+        if( id >= *nb_ids ) *nb_ids = id + 1;
+        n++;
+    }
+    fclose(f);
+    *nb_ops = n;
+    return trace;
+}
+
+static void write_trace(const char *name, trace_op_t *trace, int nb_ops)
+{
+    FILE *f = fopen(name, "w");
+    if( NULL == f ) {
+        fatal(" ! Error: cannot create the trace %s\n", name);
+        return;
+    }
+    for(int n = 0; n < nb_ops; n++) {
+        if( 'a' == trace[n].op )
+            fprintf(f, "a %d %zu\n", trace[n].id, trace[n].size);
+        else
+            fprintf(f, "f %d\n", trace[n].id);
+    }
+    fclose(f);
+}
+
+/* Marks the units of [ptr, ptr+size) as owned by id+1 (or as free, if id < 0) */
+static void shadow_update(int32_t *shadow, char *base, void *ptr, size_t size, int id)
+{
+    size_t first = ((char*)ptr - base) / UNITSIZE;
+    size_t last = first + (size + UNITSIZE - 1) / UNITSIZE;
+    if( last == first ) last++;
+    if( last > (size_t)NBUNITS )
+        fatal(" ! Error: area %d [%p, +%zu) is out of the zone\n", id, ptr, size);
+    for(size_t u = first; u < last; u++) {
+        if( id >= 0 ) {
+            if( 0 != shadow[u] )
+                fatal(" ! Error: area %d overlaps area %d at unit %zu\n", id, shadow[u] - 1, u);
+            shadow[u] = id + 1;
+        } else {
+            shadow[u] = 0;
+        }
+    }
+}
+
+static void usage(const char *name, const char *msg)
+{
+    if( NULL != msg ) {
+        fprintf(stderr, "%s\n", msg);
+    }
+    fprintf(stderr,
+            "Usage: \n"
+            "   %s [-z units|-u unit_size|-t trace|-n nbops|-f fill|-s seed|-o trace|-c|-h|-?]\n"
+            " where\n"
+            "   -z units:     number of units of the zone (default %d)\n"
+            "   -u unit_size: size of the units, in bytes (default %zu)\n"
+            "   -t trace:     replay this trace instead of generating one\n"
+            "   -n nbops:     number of operations of the generated trace (default %d)\n"
+            "   -f fill:      target occupancy of the zone, in percent, of the generated trace (default %d)\n"
+            "   -s seed:      seed of the generated trace (default %u)\n"
+            "   -o trace:     save the trace in this file\n"
+            "   -c:           check the areas for overlaps (slower)\n",
+            name, NBUNITS, UNITSIZE, NBOPS, FILL, SEED);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *trace_in = NULL, *trace_out = NULL;
+    trace_op_t *trace;
+    live_t *live;
+    int32_t *shadow = NULL;
+    zone_malloc_t *zone;
+    char *base;
+    parsec_time_t start;
+    uint64_t t, malloc_time = 0, free_time = 0, max_malloc = 0, max_free = 0;
+    size_t in_use = 0, peak = 0, free_mem, largest;
+    double frag, frag_sum = 0.0, frag_max = 0.0;
+    int nb_ops = 0, nb_ids = 0, n, ch, check = 0;
+    int nb_mallocs = 0, nb_frees = 0, nb_failed = 0, nb_samples = 0;
+    char *m;
+
+    while( (ch = getopt(argc, argv, "z:u:t:n:f:s:o:ch?")) != -1 ) {
+        switch(ch) {
+        case 'z':
+            NBUNITS = strtol(optarg, &m, 0);
+            if( (NBUNITS <= 0) || (m[0] != '\0') ) usage(argv[0], "invalid -z value");
+            break;
+        case 'u':
+            UNITSIZE = strtoul(optarg, &m, 0);
+            if( (0 == UNITSIZE) || (m[0] != '\0') ) usage(argv[0], "invalid -u value");
+            break;
+        case 't':
+            trace_in = optarg;
+            break;
+        case 'n':
+            NBOPS = strtol(optarg, &m, 0);
+            if( (NBOPS <= 0) || (m[0] != '\0') ) usage(argv[0], "invalid -n value");
+            break;
+        case 'f':
+            FILL = strtol(optarg, &m, 0);
+            if( (FILL <= 0) || (FILL > 100) || (m[0] != '\0') ) usage(argv[0], "invalid -f value");
+            break;
+        case 's':
+            SEED = strtoul(optarg, &m, 0);
+            if( (0 == SEED) || (m[0] != '\0') ) usage(argv[0], "invalid -s value");
+            break;
+        case 'o':
+            trace_out = optarg;
+            break;
+        case 'c':
+            check = 1;
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage(argv[0], NULL);
+            break;
+        }
+    }
+
+    if( NULL != trace_in )
+        trace = read_trace(trace_in, &nb_ops, &nb_ids);
+    else
+        trace = generate_trace(&nb_ops, &nb_ids);
+    if( NULL != trace_out )
+        write_trace(trace_out, trace, nb_ops);
+
+    /* The zone is never accessed, unless it is checked */
+    base = check ? (char*)malloc((size_t)NBUNITS * UNITSIZE) : (char*)(uintptr_t)UNITSIZE;
+    zone = zone_malloc_init(base, NBUNITS, UNITSIZE);
+    live = (live_t*)calloc(nb_ids, sizeof(live_t));
+    if( check )
+        shadow = (int32_t*)calloc(NBUNITS, sizeof(int32_t));
+
+    printf("Replay %d operations (%d areas) on a zone of %d units of %zu bytes.\n",
+           nb_ops, nb_ids, NBUNITS, UNITSIZE);
+    for(n = 0; n < nb_ops; n++) {
+        int id = trace[n].id;
+        if( 'a' == trace[n].op ) {
+            if( NULL != live[id].ptr )
+                fatal(" ! Error: operation %d allocates the live area %d\n", n, id);
+            start = take_time();
+            live[id].ptr = zone_malloc(zone, trace[n].size);
+            t = diff_time(start, take_time());
+            malloc_time += t;
+            if( t > max_malloc ) max_malloc = t;
+            nb_mallocs++;
+            if( NULL == live[id].ptr ) {
+                nb_failed++;
+                continue;
+            }
+            live[id].size = trace[n].size;
+            in_use += trace[n].size;
+            if( in_use > peak ) peak = in_use;
+            if( check ) {
+                shadow_update(shadow, base, live[id].ptr, live[id].size, id);
+                memset(live[id].ptr, id & 0xff, live[id].size);
+            }
+        } else {
+            /* Frees of failed allocations are skipped */
+            if( NULL == live[id].ptr )
+                continue;
+            if( check ) {
+                for(size_t b = 0; b < live[id].size; b++)
+                    if( ((unsigned char*)live[id].ptr)[b] != (id & 0xff) )
+                        fatal(" ! Error: area %d was overwritten at byte %zu\n", id, b);
+                shadow_update(shadow, base, live[id].ptr, live[id].size, -1);
+            }
+            start = take_time();
+            zone_free(zone, live[id].ptr);
+            t = diff_time(start, take_time());
+            free_time += t;
+            if( t > max_free ) max_free = t;
+            nb_frees++;
+            in_use -= live[id].size;
+            live[id].ptr = NULL;
+        }
+        if( 0 == (n & 63) ) {
+            free_mem = (size_t)NBUNITS * UNITSIZE - zone_in_use(zone);
+            largest = zone_largest_free(zone);
+            frag = (0 == free_mem) ? 0.0 : 1.0 - (double)largest / (double)free_mem;
+            frag_sum += frag;
+            if( frag > frag_max ) frag_max = frag;
+            nb_samples++;
+            if( check && (free_mem != zone_debug(zone, 0, 0, NULL)) )
+                fatal(" ! Error: operation %d: %zu bytes are in use, but zone_debug finds %zu free bytes\n",
+                      n, zone_in_use(zone), zone_debug(zone, 0, 0, NULL));
+        }
+    }
+
+    printf("== %d allocations (%d failed), %d frees, peak %zu bytes (%.1f%% of the zone)\n",
+           nb_mallocs, nb_failed, nb_frees, peak, 100.0 * peak / ((double)NBUNITS * UNITSIZE));
+    printf("== zone_malloc: average %.1f, max %"PRIu64" %s\n",
+           nb_mallocs ? (double)malloc_time / nb_mallocs : 0.0, max_malloc, TIMER_UNIT);
+    printf("== zone_free:   average %.1f, max %"PRIu64" %s\n",
+           nb_frees ? (double)free_time / nb_frees : 0.0, max_free, TIMER_UNIT);
+    printf("== fragmentation (1 - largest free area / free memory): average %.3f, max %.3f\n",
+           nb_samples ? frag_sum / nb_samples : 0.0, frag_max);
+
+    for(n = 0; n < nb_ids; n++) {
+        if( NULL != live[n].ptr )
+            zone_free(zone, live[n].ptr);
+    }
+    if( (0 != zone_in_use(zone)) ||
+        ((size_t)NBUNITS * UNITSIZE != zone_debug(zone, 0, 0, NULL)) ||
+        ((size_t)NBUNITS * UNITSIZE != zone_largest_free(zone)) )
+        fatal(" ! Error: the zone is not entirely free after all the areas were released\n");
+
+    zone_malloc_fini(&zone);
+    if( check )
+        free(base);
+    free(shadow);
+    free(live);
+    free(trace);
+    return 0;
+}
@@ -14,6 +14,17 @@ parsec_addtest_cmd(collections/reshape:mt ${SHM_TEST_CMD_LIST} collections/resha
 if( MPI_C_FOUND )
   parsec_addtest_cmd(collections/reshape:mp ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10)
   parsec_addtest_cmd(collections/reshape:mp:mt ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10 -m 1 )
+  parsec_addtest_cmd(collections/reshape:mp:mt:progress ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10 -m 1 -- --mca runtime_comm_thread_multiple 0 --mca runtime_comm_progress_threads 2)
+  parsec_addtest_cmd(collections/reshape:mp:coalesce ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10 -- --mca runtime_comm_coalesce_window 50)
+  parsec_addtest_cmd(collections/reshape:mp:rendezvous ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10 -- --mca runtime_comm_short_limit 0 --mca runtime_comm_eager_limit 0)
+  if( PARSEC_DIST_WITH_SHM )
+    # The processes of the node communicate through MPI, and through small rings that fill up
+    parsec_addtest_cmd(collections/reshape:mp:noshm ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10 -- --mca runtime_comm_shm 0)
+    # All the PUTs are synchronous and reuse their tags
+    parsec_addtest_cmd(collections/reshape:mp:noshm:sync ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10 -- --mca runtime_comm_shm 0 --mca mpi_put_sync_limit 0)
+    parsec_addtest_cmd(collections/reshape:mp:noshm:eager ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 512 -t 64 -c 4 -- --mca runtime_comm_shm 0)
+    parsec_addtest_cmd(collections/reshape:mp:mt:shm_ring ${MPI_TEST_CMD_LIST} 4 collections/reshape/reshape -N 120 -t 9 -c 10 -m 1 -- --mca runtime_comm_shm_ring_size 16384)
+  endif( PARSEC_DIST_WITH_SHM )
 endif( MPI_C_FOUND)
 
 parsec_addtest_cmd(collections/reshape/input_single_copy ${SHM_TEST_CMD_LIST} collections/reshape/input_dep_reshape_single_copy -N 12 -t 2 -c 2)
@@ -23,16 +34,19 @@ if( MPI_C_FOUND )
   parsec_addtest_cmd(collections/reshape/input_single_copy:mp:mt ${MPI_TEST_CMD_LIST} 4 collections/reshape/input_dep_reshape_single_copy -N 12 -t 2 -c 2 -m 1 )
 endif( MPI_C_FOUND)
 
-#These tests will fail with runtime_comm_short_limit != 0. Explanation on testing_remote_multiple_outs_same_pred_flow.c
+#These tests will fail with runtime_comm_short_limit or runtime_comm_eager_limit != 0. Explanation on testing_remote_multiple_outs_same_pred_flow.c
 parsec_addtest_cmd(collections/reshape/remote_multiple_outs_same_pred_flow ${SHM_TEST_CMD_LIST} collections/reshape/remote_multiple_outs_same_pred_flow -N 320 -t 9 -c 10 -- --mca runtime_comm_short_limit 0)
 parsec_addtest_cmd(collections/reshape/remote_multiple_outs_same_pred_flow:mt ${SHM_TEST_CMD_LIST} collections/reshape/remote_multiple_outs_same_pred_flow -N 320 -t 9 -c 10 -m 1 -- --mca runtime_comm_short_limit 0)
 if( MPI_C_FOUND )
-  parsec_addtest_cmd(collections/reshape/remote_multiple_outs_same_pred_flow:mp ${MPI_TEST_CMD_LIST} 4 collections/reshape/remote_multiple_outs_same_pred_flow -N 320 -t 9 -c 10  -- --mca runtime_comm_short_limit 0)
-  parsec_addtest_cmd(collections/reshape/remote_multiple_outs_same_pred_flow:mp:mt ${MPI_TEST_CMD_LIST} 4 collections/reshape/remote_multiple_outs_same_pred_flow -N 320 -t 9 -c 10 -m 1  -- --mca runtime_comm_short_limit 0)
+  parsec_addtest_cmd(collections/reshape/remote_multiple_outs_same_pred_flow:mp ${MPI_TEST_CMD_LIST} 4 collections/reshape/remote_multiple_outs_same_pred_flow -N 320 -t 9 -c 10  -- --mca runtime_comm_short_limit 0 --mca runtime_comm_eager_limit 0)
+  parsec_addtest_cmd(collections/reshape/remote_multiple_outs_same_pred_flow:mp:mt ${MPI_TEST_CMD_LIST} 4 collections/reshape/remote_multiple_outs_same_pred_flow -N 320 -t 9 -c 10 -m 1  -- --mca runtime_comm_short_limit 0 --mca runtime_comm_eager_limit 0)
 endif( MPI_C_FOUND)
 
 parsec_addtest_cmd(collections/reshape/avoidable ${SHM_TEST_CMD_LIST} collections/reshape/avoidable_reshape -N 100 -t 2 -c 10)
 
+# Arena chunks from the size-class pool
+parsec_addtest_cmd(collections/reshape:size_classes ${SHM_TEST_CMD_LIST} collections/reshape/reshape -N 120 -t 9 -c 10 -- --mca arena_size_classes 1)
+
 if( MPI_C_FOUND )
   parsec_addtest_cmd(collections/matrix/band ${MPI_TEST_CMD_LIST} 8 collections/two_dim_band/testing_band -N 3200 -T 160 -P 4 -s 5 -S 10 -p 2 -f 2 -F 10 -b 2)
 else( MPI_C_FOUND )
@@ -1 +1,5 @@
+parsec_addtest_cmd(runtime/data_pool ${SHM_TEST_CMD_LIST} runtime/data_pool -c 4 -N 20000)
+parsec_addtest_cmd(runtime/data_pool:nopool ${SHM_TEST_CMD_LIST} runtime/data_pool -c 4 -N 20000 -- --mca runtime_data_pool 0)
+parsec_addtest_cmd(runtime/arena_limit ${SHM_TEST_CMD_LIST} runtime/arena_limit)
+
 include(runtime/scheduling/Testings.cmake)
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/runtime.h"
+#undef NDEBUG
+#include <stdarg.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#if defined(PARSEC_HAVE_MPI)
+#include <mpi.h>
+#endif
+
+#include "parsec/arena.h"
+#include "parsec/data_internal.h"
+#include "parsec/utils/debug.h"
+
+/*
+ * Checks the accounting of an arena limited to MAX_ELEMS elements: the
+ * allocations beyond the limit, or whose memory cannot be obtained, fail
+ * without leaking their elements, and the arena serves the whole limit
+ * again once the copies are released.
+ */
+
+#define MAX_ELEMS 4
+
+static size_t elem_size = 1024;
+static int malloc_fails = 0;
+
+static void fatal(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+    raise(SIGABRT);
+}
+
+static void *failing_malloc(size_t size)
+{
+    if( malloc_fails )
+        return NULL;
+    return malloc(size);
+}
+
+static void check_used(parsec_arena_t *arena, int expected, const char *when)
+{
+    if( arena->used != expected )
+        fatal(" ! Error: %d elements used %s, expected %d\n", (int)arena->used, when, expected);
+}
+
+/* Allocates the whole limit in copies of count elements, checks that one
+ * more element is refused, and releases them */
+static void exhaust(parsec_arena_t *arena, size_t count)
+{
+    parsec_data_copy_t *copies[MAX_ELEMS], *extra;
+    size_t c, nb = MAX_ELEMS / count;
+
+    for(c = 0; c < nb; c++) {
+        copies[c] = parsec_arena_get_copy(arena, count, 0, parsec_datatype_int8_t);
+        if( NULL == copies[c] )
+            fatal(" ! Error: copy %zu of %zu elements refused below the limit\n", c, count);
+    }
+    check_used(arena, (int)(nb * count), "at the limit");
+    extra = parsec_arena_get_copy(arena, 1, 0, parsec_datatype_int8_t);
+    if( NULL != extra )
+        fatal(" ! Error: the arena allocated beyond its limit\n");
+    check_used(arena, (int)(nb * count), "after a refusal at the limit");
+    for(c = 0; c < nb; c++)
+        PARSEC_DATA_COPY_RELEASE(copies[c]);
+    check_used(arena, 0, "after the release of all the copies");
+}
+
+int main(int argc, char *argv[])
+{
+    parsec_context_t *parsec;
+    parsec_arena_t *arena;
+    parsec_data_copy_t *copy;
+    size_t count;
+
+#if defined(PARSEC_HAVE_MPI)
+    {
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    }
+#endif
+
+    parsec = parsec_init(1, &argc, &argv);
+    if( NULL == parsec )
+        fatal(" ! Error: parsec_init failed\n");
+
+    /* No cache, every released chunk returns its elements to the limit */
+    arena = PARSEC_OBJ_NEW(parsec_arena_t);
+    parsec_arena_construct_ex(arena, elem_size, PARSEC_ARENA_ALIGNMENT_SSE,
+                              MAX_ELEMS * elem_size, 0);
+    arena->data_malloc = failing_malloc;
+    arena->data_free   = free;
+
+    for(count = 1; count <= MAX_ELEMS; count *= 2)
+        exhaust(arena, count);
+
+    malloc_fails = 1;
+    for(count = 1; count <= MAX_ELEMS; count *= 2) {
+        copy = parsec_arena_get_copy(arena, count, 0, parsec_datatype_int8_t);
+        if( NULL != copy )
+            fatal(" ! Error: a copy of %zu elements was allocated without memory\n", count);
+        check_used(arena, 0, "after an allocation failure");
+    }
+    malloc_fails = 0;
+
+    for(count = 1; count <= MAX_ELEMS; count *= 2)
+        exhaust(arena, count);
+    printf("The arena recovered its %d elements after the refused allocations\n", MAX_ELEMS);
+
+    /* The context runs no taskpool, but it must be started to be finalized */
+    parsec_context_start(parsec);
+    parsec_context_wait(parsec);
+
+    PARSEC_OBJ_RELEASE(arena);
+    parsec_fini(&parsec);
+
+#if defined(PARSEC_HAVE_MPI)
+    MPI_Finalize();
+#endif
+    return 0;
+}
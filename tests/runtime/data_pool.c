@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/runtime.h"
+#undef NDEBUG
+#include <pthread.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#if defined(PARSEC_HAVE_MPI)
+#include <mpi.h>
+#endif
+
+#include "parsec/arena.h"
+#include "parsec/data_internal.h"
+#include "parsec/class/barrier.h"
+#include "parsec/os-spec-timing.h"
+#include "parsec/utils/debug.h"
+#include "parsec/utils/mca_param.h"
+
+/*
+ * Stresses the allocation of the temporary data copies, in the patterns of
+ * the runtime:
+ *  - remote receptions: each thread keeps a window of copies from an
+ *    arena, as the receptions in flight, and releases the oldest one to
+ *    receive a new one;
+ *  - reshapes: each thread repeatedly copies a tile into a new copy from
+ *    an arena, and releases it once consumed.
+ * Each copy comes with its parsec_data_t. The number of data and copies
+ * allocated with malloc, and of those recycled from the data pools, is
+ * reported for each pattern. With the data pools enabled, every object
+ * allocated or recycled must be released to the pools, and the objects
+ * left in the caches of the threads of a pattern must be reused by the
+ * next one once these threads have exited.
+ */
+
+static unsigned int NBTIMES = 100000;
+static unsigned int nbthreads = 1;
+static unsigned int window = 16;
+static size_t elem_size = 1024;
+
+static parsec_arena_t *arena;
+static parsec_barrier_t barrier;
+
+static void fatal(const char *format, ...)
+{
+    va_list va;
+    va_start(va, format);
+    vprintf(format, va);
+    va_end(va);
+    raise(SIGABRT);
+}
+
+static void *recv_pattern(void *_arg)
+{
+    uint64_t *rtime = (uint64_t*)_arg;
+    parsec_data_copy_t **inflight = (parsec_data_copy_t**)calloc(window, sizeof(parsec_data_copy_t*));
+    parsec_time_t start, end;
+    unsigned int r, w;
+
+    parsec_barrier_wait(&barrier);
+    start = take_time();
+    for(r = 0; r < NBTIMES; r++) {
+        w = r % window;
+        if( NULL != inflight[w] )
+            PARSEC_DATA_COPY_RELEASE(inflight[w]);
+        inflight[w] = parsec_arena_get_copy(arena, 1, 0, parsec_datatype_int8_t);
+        if( NULL == inflight[w] )
+            fatal(" ! Error: no copy could be allocated\n");
+        ((unsigned int*)inflight[w]->device_private)[0] = r;
+    }
+    for(w = 0; w < window; w++) {
+        if( NULL != inflight[w] )
+            PARSEC_DATA_COPY_RELEASE(inflight[w]);
+    }
+    end = take_time();
+    *rtime = diff_time(start, end);
+    free(inflight);
+    return NULL;
+}
+
+static void *reshape_pattern(void *_arg)
+{
+    uint64_t *rtime = (uint64_t*)_arg;
+    char *tile = (char*)malloc(elem_size);
+    parsec_data_copy_t *copy;
+    parsec_time_t start, end;
+    unsigned int r;
+
+    memset(tile, (int)*rtime, elem_size);
+    parsec_barrier_wait(&barrier);
+    start = take_time();
+    for(r = 0; r < NBTIMES; r++) {
+        copy = parsec_arena_get_copy(arena, 1, 0, parsec_datatype_int8_t);
+        if( NULL == copy )
+            fatal(" ! Error: no copy could be allocated\n");
+        memcpy(copy->device_private, tile, elem_size);
+        if( NULL == copy->original || copy != copy->original->device_copies[0] )
+            fatal(" ! Error: copy %p is not attached to its data\n", (void*)copy);
+        PARSEC_DATA_COPY_RELEASE(copy);
+    }
+    end = take_time();
+    *rtime = diff_time(start, end);
+    free(tile);
+    return NULL;
+}
+
+static void check_balance(const char *what, uint64_t allocated, uint64_t recycled, uint64_t released)
+{
+    if( allocated + recycled != released )
+        fatal(" ! Error: %"PRIu64" %s were allocated and %"PRIu64" recycled, but %"PRIu64" were released\n",
+              allocated, what, recycled, released);
+}
+
+/* With reuse_all, the pools hold enough objects from the previous patterns
+ * for the threads of this one, and none must be allocated */
+static void run_pattern(const char *name, void *(*pattern)(void*), int pool_enabled, int reuse_all)
+{
+    pthread_t *threads = (pthread_t*)calloc(sizeof(pthread_t), nbthreads);
+    uint64_t *times = (uint64_t*)calloc(sizeof(uint64_t), nbthreads);
+    parsec_data_pool_stats_t before, after;
+    uint64_t max_time = 0, allocated, recycled;
+    uint64_t data_allocated, data_recycled;
+    unsigned int e;
+
+    parsec_data_pool_stats(&before);
+    parsec_barrier_init(&barrier, NULL, nbthreads);
+    for(e = 0; e < nbthreads; e++) {
+        times[e] = e;
+        pthread_create(&threads[e], NULL, pattern, &times[e]);
+    }
+    for(e = 0; e < nbthreads; e++) {
+        pthread_join(threads[e], NULL);
+        if( max_time < times[e] ) max_time = times[e];
+    }
+    parsec_barrier_destroy(&barrier);
+    parsec_data_pool_stats(&after);
+
+    allocated = after.copies_allocated - before.copies_allocated;
+    recycled = after.copies_recycled - before.copies_recycled;
+    data_allocated = after.data_allocated - before.data_allocated;
+    data_recycled = after.data_recycled - before.data_recycled;
+    if( allocated + recycled != (uint64_t)NBTIMES * nbthreads )
+        fatal(" ! Error: %"PRIu64" copies were allocated or recycled, expected %"PRIu64"\n",
+              allocated + recycled, (uint64_t)NBTIMES * nbthreads);
+    if( pool_enabled && (0 == recycled) )
+        fatal(" ! Error: no copy was recycled with the data pools enabled\n");
+    if( !pool_enabled && (0 != recycled) )
+        fatal(" ! Error: %"PRIu64" copies were recycled with the data pools disabled\n", recycled);
+    if( pool_enabled ) {
+        check_balance("copies", allocated, recycled,
+                      after.copies_released - before.copies_released);
+        check_balance("data", data_allocated, data_recycled,
+                      after.data_released - before.data_released);
+    }
+    if( reuse_all && (0 != allocated + data_allocated) )
+        fatal(" ! Error: %"PRIu64" copies and %"PRIu64" data were allocated instead of reusing those of the exited threads\n",
+              allocated, data_allocated);
+
+    printf("== %s: %u copies per thread for %u threads in MAX %"PRIu64" %s\n"
+           "==   copies: %"PRIu64" allocated, %"PRIu64" recycled\n"
+           "==   data:   %"PRIu64" allocated, %"PRIu64" recycled\n",
+           name, NBTIMES, nbthreads, max_time, TIMER_UNIT,
+           allocated, recycled, data_allocated, data_recycled);
+    free(threads);
+    free(times);
+}
+
+static void usage(const char *name, const char *msg)
+{
+    if( NULL != msg ) {
+        fprintf(stderr, "%s\n", msg);
+    }
+    fprintf(stderr,
+            "Usage: \n"
+            "   %s [-c cores|-N nbtimes|-w window|-s size|-h|-?] [-- parsec options]\n"
+            " where\n"
+            "   -c cores:   cores (integer >0) defines the number of threads allocating copies\n"
+            "   -N nbtimes: nbtimes (integer >0) defines the number of copies allocated by each thread (default %u)\n"
+            "   -w window:  window (integer >0) defines the number of receptions in flight of each thread (default %u)\n"
+            "   -s size:    size (integer >0) defines the size in bytes of each copy (default %zu)\n",
+            name, NBTIMES, window, elem_size);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    parsec_context_t *parsec;
+    int ch, idx, pool_enabled = 1;
+    int parsec_argc = 0;
+    char **parsec_argv = NULL;
+    char *m;
+
+#if defined(PARSEC_HAVE_MPI)
+    {
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    }
+#endif
+    while( (ch = getopt(argc, argv, "c:N:w:s:h?")) != -1 ) {
+        switch(ch) {
+        case 'c':
+            nbthreads = strtol(optarg, &m, 0);
+            if( (0 == nbthreads) || (m[0] != '\0') ) usage(argv[0], "invalid -c value");
+            break;
+        case 'N':
+            NBTIMES = strtol(optarg, &m, 0);
+            if( (0 == NBTIMES) || (m[0] != '\0') ) usage(argv[0], "invalid -N value");
+            break;
+        case 'w':
+            window = strtol(optarg, &m, 0);
+            if( (0 == window) || (m[0] != '\0') ) usage(argv[0], "invalid -w value");
+            break;
+        case 's':
+            elem_size = strtoul(optarg, &m, 0);
+            if( (elem_size < sizeof(unsigned int)) || (m[0] != '\0') ) usage(argv[0], "invalid -s value");
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage(argv[0], NULL);
+            break;
+        }
+    }
+    /* The parsec options follow --, which takes the place of the program name */
+    if( (optind > 1) && (0 == strcmp(argv[optind - 1], "--")) ) {
+        parsec_argc = argc - optind + 1;
+        parsec_argv = &argv[optind - 1];
+    }
+
+    parsec = parsec_init(1, &parsec_argc, &parsec_argv);
+    if( NULL == parsec )
+        fatal(" ! Error: parsec_init failed\n");
+    idx = parsec_mca_param_find("runtime", NULL, "data_pool");
+    if( idx >= 0 )
+        parsec_mca_param_lookup_int(idx, &pool_enabled);
+    printf("Data pools %s\n", pool_enabled ? "enabled" : "disabled");
+
+    arena = PARSEC_OBJ_NEW(parsec_arena_t);
+    parsec_arena_construct(arena, elem_size, PARSEC_ARENA_ALIGNMENT_SSE);
+
+    /* The context runs no taskpool, but it must be started to be finalized */
+    parsec_context_start(parsec);
+    run_pattern("remote receptions", recv_pattern, pool_enabled, 0);
+    /* Each thread of the receptions held window copies at once, a thread of
+     * the reshapes holds only one */
+    run_pattern("reshapes", reshape_pattern, pool_enabled,
+                pool_enabled && (window >= nbthreads));
+    parsec_context_wait(parsec);
+
+    PARSEC_OBJ_RELEASE(arena);
+    parsec_fini(&parsec);
+
+#if defined(PARSEC_HAVE_MPI)
+    MPI_Finalize();
+#endif
+    return 0;
+}
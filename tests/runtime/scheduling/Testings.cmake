@@ -7,3 +7,31 @@ if( MPI_C_FOUND )
         parsec_addtest_cmd(runtime/scheduling:mp:${_sched} ${MPI_TEST_CMD_LIST} 2 runtime/scheduling/schedmicro -t 10 -l 8 -n 512 -- --mca mca_sched ${_sched})
     ENDFOREACH()
 endif( MPI_C_FOUND )
+
+# Bounded buffers that resize themselves, with a short window to force many resizes
+FOREACH(_sched lfq ltq)
+  if( _sched IN_LIST MCA_sched )
+    parsec_addtest_cmd(runtime/scheduling:sp:${_sched}:adaptive ${MPI_TEST_CMD_LIST} 1 runtime/scheduling/schedmicro -t 10 -l 8 -n 512 -- --mca mca_sched ${_sched} --mca parsec_hbbuffer_adaptive 1 --mca parsec_hbbuffer_adapt_window 4)
+  endif()
+ENDFOREACH()
+
+# Idle threads park as soon as they miss a task, with a short timeout
+parsec_addtest_cmd(runtime/scheduling:sp:park ${MPI_TEST_CMD_LIST} 1 runtime/scheduling/schedmicro -t 10 -l 8 -n 512 -- --mca runtime_park_spin 0 --mca runtime_park_timeout 1000)
+if( MPI_C_FOUND )
+  parsec_addtest_cmd(runtime/scheduling:mp:park ${MPI_TEST_CMD_LIST} 2 runtime/scheduling/schedmicro -t 10 -l 8 -n 512 -- --mca runtime_park_spin 0 --mca runtime_park_timeout 1000)
+endif( MPI_C_FOUND )
+
+# DAG shapes benchmark, with small DAGs
+FOREACH(_sched ${MCA_sched})
+  parsec_addtest_cmd(runtime/scheduling:bench:${_sched} ${MPI_TEST_CMD_LIST} 1 runtime/scheduling/schedbench -r 1 -w 16 -d 16 -- --mca mca_sched ${_sched})
+ENDFOREACH()
+
+# Different schedulers on the virtual processes, tasks are handed off between them
+FOREACH(_vp_sched "llp,lfq" "lfq,mq")
+  string(REPLACE "," "_" _name ${_vp_sched})
+  parsec_addtest_cmd(runtime/scheduling:sp:vp_sched:${_name} ${MPI_TEST_CMD_LIST} 1 runtime/scheduling/schedmicro -t 10 -l 8 -n 512 -- -V rr:2:1:1 --mca runtime_vp_sched ${_vp_sched})
+ENDFOREACH()
+
+# Tasks and data repository entries allocated from per-thread slabs, without idle slabs kept
+parsec_addtest_cmd(runtime/scheduling:sp:mempool_slab ${MPI_TEST_CMD_LIST} 1 runtime/scheduling/schedmicro -t 10 -l 8 -n 512 -- --mca runtime_mempool_slab 1 --mca runtime_mempool_slab_idle 0)
+parsec_addtest_cmd(runtime/scheduling:sp:mempool_slab:vp ${MPI_TEST_CMD_LIST} 1 runtime/scheduling/schedmicro -t 10 -l 8 -n 512 -- -V rr:2:1:1 --mca runtime_mempool_slab 1)
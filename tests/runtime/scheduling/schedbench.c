@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+/**
+ * Scheduler benchmark: runs a set of DAG shapes with the scheduler
+ * selected by the MCA parameters, and prints one CSV line per run with the
+ * throughput, the ready-to-exec latency of the tasks and the number of
+ * stolen tasks (see schedbench.h). Use schedbench.py to compare all the
+ * schedulers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parsec/runtime.h"
+#include "parsec/utils/debug.h"
+#include "parsec/scheduling.h"
+#include "parsec/mca/sched/sched.h"
+#include "parsec/class/multiqueue.h"
+#include "parsec/vpmap.h"
+#include "schedbench.h"
+#include "schedmicro_data.h"
+#if defined(PARSEC_HAVE_MPI)
+#include <mpi.h>
+#endif  /* defined(PARSEC_HAVE_MPI) */
+
+static const struct {
+    const char       *name;
+    schedbench_new_t  new_tp;
+    int             (*nb_tasks)(int width, int depth);
+} shapes[] = {
+    { "chain",  schedbench_chain_new,  schedbench_chain_nb_tasks  },
+    { "fanout", schedbench_fanout_new, schedbench_fanout_nb_tasks },
+    { "btree",  schedbench_btree_new,  schedbench_btree_nb_tasks  },
+    { "rdag",   schedbench_rdag_new,   schedbench_rdag_nb_tasks   },
+    { "prio",   schedbench_prio_new,   schedbench_prio_nb_tasks   },
+};
+#define NB_SHAPES ((int)(sizeof(shapes) / sizeof(shapes[0])))
+
+static int WIDTH       =   64;
+static int DEPTH       =  256;
+static int REPEAT      =    5;
+static int GRAIN_NS    =    0;
+static uint32_t SEED   = 2463534242u;
+
+static int cmp_uint64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of the sorted values v[0..n-1], in microseconds */
+static double percentile_us(const uint64_t *v, int n, double q)
+{
+    int r;
+    if( 0 == n ) return -1.0;
+    r = (int)(q * n + 0.999999) - 1;
+    if( r < 0 ) r = 0;
+    return v[r] / 1e3;
+}
+
+static void bench_reset(schedbench_t *b, int nb_tasks, int depth, int width, uint32_t *seed)
+{
+    int l;
+    b->nb_tasks = nb_tasks;
+    b->grain_ns = GRAIN_NS;
+    memset(b->done_ns, 0, nb_tasks * sizeof(uint64_t));
+    memset(b->priority, 0, nb_tasks * sizeof(int32_t));
+    memset(b->stolen, 0, nb_tasks * sizeof(uint8_t));
+    memset(b->stream, 0, nb_tasks * sizeof(parsec_execution_stream_t*));
+    for( l = 0; l < nb_tasks; l++ ) b->latency_ns[l] = SCHEDBENCH_NO_LATENCY;
+    /* Two different shifts per level (when the width allows it) */
+    for( l = 0; l < depth; l++ ) {
+        b->offsets[2*l]   = parsec_multiqueue_rand(seed) % width;
+        b->offsets[2*l+1] = (width > 1) ? (b->offsets[2*l] + 1 + parsec_multiqueue_rand(seed) % (width - 1)) % width : 0;
+    }
+}
+
+static void bench_report(const char *shape, const char *sched, int run, schedbench_t *b, uint64_t elapsed_ns)
+{
+    uint64_t *all = (uint64_t*)malloc(b->nb_tasks * sizeof(uint64_t));
+    uint64_t *hp  = (uint64_t*)malloc(b->nb_tasks * sizeof(uint64_t));
+    int t, nall = 0, nhp = 0, steals = 0;
+    double hp_p99;
+
+    for( t = 0; t < b->nb_tasks; t++ ) {
+        steals += b->stolen[t];
+        if( SCHEDBENCH_NO_LATENCY == b->latency_ns[t] ) continue;
+        all[nall++] = b->latency_ns[t];
+        if( b->priority[t] > 0 ) hp[nhp++] = b->latency_ns[t];
+    }
+    qsort(all, nall, sizeof(uint64_t), cmp_uint64);
+    qsort(hp, nhp, sizeof(uint64_t), cmp_uint64);
+    hp_p99 = percentile_us(hp, nhp, 0.99);
+
+    printf("%s,%s,%d,%d,%d,%d,%d,%.6f,%.1f,%.3f,%.3f,", shape, sched,
+           vpmap_get_nb_total_threads(), WIDTH, DEPTH, b->nb_tasks, run,
+           elapsed_ns / 1e9, b->nb_tasks / (elapsed_ns / 1e9),
+           percentile_us(all, nall, 0.50), percentile_us(all, nall, 0.99));
+    if( hp_p99 >= 0.0 ) printf("%.3f", hp_p99);
+    printf(",%d\n", steals);
+    fflush(stdout);
+    free(all);
+    free(hp);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-s shape,...] [-w width] [-d depth] [-r repeat] [-g grain] [-S seed] [-H] [-- <parsec parameters>]\n"
+            "  -s: DAG shapes to run, among chain,fanout,btree,rdag,prio (default: all)\n"
+            "  -w: number of tasks that can run concurrently (default %d)\n"
+            "  -d: length of the DAGs (default %d)\n"
+            "  -r: number of runs of each shape (default %d)\n"
+            "  -g: busy time of each task, in nanoseconds (default %d)\n"
+            "  -S: seed of the random DAGs (default %u)\n"
+            "  -H: do not print the CSV header\n",
+            name, WIDTH, DEPTH, REPEAT, GRAIN_NS, SEED);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    parsec_context_t* parsec;
+    int rank, world, rc, s, run, header = 1, max_tasks = 0;
+    const char *selected = NULL, *sched;
+    parsec_data_collection_t *dcA;
+    parsec_taskpool_t *tp;
+    schedbench_t bench;
+    uint64_t start, end;
+    uint32_t seed;
+    int parsec_argc = 0;
+    char **parsec_argv = NULL;
+
+#if defined(PARSEC_HAVE_MPI)
+    {
+        int provided;
+        MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    }
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    world = 1;
+    rank = 0;
+#endif
+    for(int a = 1; a < argc; a++) {
+        if(strcmp(argv[a], "--") == 0) {
+            parsec_argc = argc - a;
+            parsec_argv = &argv[a];
+            break;
+        }
+        if( (a + 1 < argc) && (strcmp(argv[a], "-s") == 0) ) { selected = argv[++a]; continue; }
+        if( (a + 1 < argc) && (strcmp(argv[a], "-w") == 0) ) { WIDTH = atoi(argv[++a]); continue; }
+        if( (a + 1 < argc) && (strcmp(argv[a], "-d") == 0) ) { DEPTH = atoi(argv[++a]); continue; }
+        if( (a + 1 < argc) && (strcmp(argv[a], "-r") == 0) ) { REPEAT = atoi(argv[++a]); continue; }
+        if( (a + 1 < argc) && (strcmp(argv[a], "-g") == 0) ) { GRAIN_NS = atoi(argv[++a]); continue; }
+        if( (a + 1 < argc) && (strcmp(argv[a], "-S") == 0) ) { SEED = strtoul(argv[++a], NULL, 0); continue; }
+        if( strcmp(argv[a], "-H") == 0 ) { header = 0; continue; }
+        usage(argv[0]);
+    }
+    if( (WIDTH <= 0) || (DEPTH <= 0) || (REPEAT <= 0) || (GRAIN_NS < 0) || (0 == SEED) ) {
+        usage(argv[0]);
+    }
+
+    parsec = parsec_init(0, &parsec_argc, &parsec_argv);
+    if( NULL == parsec ) {
+        exit(-1);
+    }
+    sched = parsec_current_scheduler->component->base_version.mca_component_name;
+
+    for( s = 0; s < NB_SHAPES; s++ ) {
+        if( shapes[s].nb_tasks(WIDTH, DEPTH) > max_tasks )
+            max_tasks = shapes[s].nb_tasks(WIDTH, DEPTH);
+    }
+    bench.done_ns    = (uint64_t*)malloc(max_tasks * sizeof(uint64_t));
+    bench.latency_ns = (uint64_t*)malloc(max_tasks * sizeof(uint64_t));
+    bench.priority   = (int32_t*)malloc(max_tasks * sizeof(int32_t));
+    bench.stolen     = (uint8_t*)malloc(max_tasks * sizeof(uint8_t));
+    bench.stream     = (parsec_execution_stream_t**)malloc(max_tasks * sizeof(parsec_execution_stream_t*));
+    bench.offsets    = (int*)malloc(2 * DEPTH * sizeof(int));
+
+    /* All the tasks run on the owner of A(0) */
+    dcA = create_and_distribute_data(rank, world, 1, 1);
+    parsec_data_collection_set_key(dcA, "A");
+
+    if( (0 == rank) && header ) {
+        printf("shape,sched,nb_cores,width,depth,nb_tasks,run,time_s,tasks_per_s,"
+               "lat_p50_us,lat_p99_us,hp_lat_p99_us,steals\n");
+    }
+    for( s = 0; s < NB_SHAPES; s++ ) {
+        if( (NULL != selected) && (NULL == strstr(selected, shapes[s].name)) ) continue;
+        /* Each shape draws the same random DAGs, whatever the other shapes */
+        seed = SEED;
+        for( run = 0; run < REPEAT; run++ ) {
+            bench_reset(&bench, shapes[s].nb_tasks(WIDTH, DEPTH), DEPTH, WIDTH, &seed);
+            tp = shapes[s].new_tp(dcA, &bench, WIDTH, DEPTH);
+            rc = parsec_context_add_taskpool(parsec, tp);
+            PARSEC_CHECK_ERROR(rc, "parsec_context_add_taskpool");
+
+            start = schedbench_now();
+            rc = parsec_context_start(parsec);
+            PARSEC_CHECK_ERROR(rc, "parsec_context_start");
+            rc = parsec_context_wait(parsec);
+            end = schedbench_now();
+            PARSEC_CHECK_ERROR(rc, "parsec_context_wait");
+
+            parsec_taskpool_free(tp);
+            if( 0 == rank ) {
+                bench_report(shapes[s].name, sched, run, &bench, end - start);
+            }
+        }
+    }
+
+    free_data(dcA);
+    free(bench.done_ns);
+    free(bench.latency_ns);
+    free(bench.priority);
+    free(bench.stolen);
+    free(bench.stream);
+    free(bench.offsets);
+
+    parsec_fini(&parsec);
+#ifdef PARSEC_HAVE_MPI
+    MPI_Finalize();
+#endif
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#ifndef _schedbench_h
+#define _schedbench_h
+
+#include "parsec/runtime.h"
+#include "parsec/data_distribution.h"
+#include "parsec/execution_stream.h"
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Measures of one run of a DAG shape. Each task has a unique index in
+ * [0, nb_tasks) and calls schedbench_run() from its body with the index
+ * of its predecessors. The task becomes ready when its last predecessor
+ * completes: the ready-to-exec latency is the time between the end of
+ * the body of this predecessor and the beginning of the body of the task,
+ * it covers the release of the dependencies, the scheduler queues and the
+ * selection. A task is counted as stolen when it is not executed by the
+ * stream that executed this predecessor.
+ */
+typedef struct schedbench_s {
+    int       nb_tasks;
+    uint64_t  grain_ns;      /**< Busy time of each task body */
+    uint64_t *done_ns;       /**< Date of the end of the body of each task */
+    uint64_t *latency_ns;    /**< Ready-to-exec latency, SCHEDBENCH_NO_LATENCY for the tasks without predecessor */
+    int32_t  *priority;      /**< Priority of each task */
+    uint8_t  *stolen;        /**< Was the task executed by another stream than its last predecessor */
+    parsec_execution_stream_t **stream;  /**< Stream that executed each task */
+    int      *offsets;       /**< Shape-specific random draws (see rdag.jdf) */
+} schedbench_t;
+
+#define SCHEDBENCH_NO_LATENCY UINT64_MAX
+
+static inline uint64_t schedbench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Record the measures of task id, last is its last predecessor (or -1) */
+static inline void schedbench_exec(schedbench_t *b, parsec_execution_stream_t *es,
+                                   int id, int priority, uint64_t start, int last)
+{
+    if( last >= 0 ) {
+        b->latency_ns[id] = (start > b->done_ns[last]) ? start - b->done_ns[last] : 0;
+        b->stolen[id] = (b->stream[last] != es);
+    }
+    b->priority[id] = priority;
+    b->stream[id] = es;
+    if( b->grain_ns > 0 ) {
+        while( schedbench_now() - start < b->grain_ns ) /* busy wait */;
+    }
+    b->done_ns[id] = schedbench_now();
+}
+
+/**
+ * To be called from the body of the tasks.
+ *
+ * @param [INOUT] b        the measures of the run
+ * @param [IN] es          the stream executing the task
+ * @param [IN] id          the index of the task
+ * @param [IN] priority    the priority of the task
+ * @param [IN] preds       the index of the predecessors of the task
+ * @param [IN] nb_preds    the number of predecessors
+ */
+static inline void schedbench_run(schedbench_t *b, parsec_execution_stream_t *es,
+                                  int id, int priority, const int *preds, int nb_preds)
+{
+    uint64_t start = schedbench_now();
+    int p, last = -1;
+
+    for( p = 0; p < nb_preds; p++ ) {
+        if( (last < 0) || (b->done_ns[preds[p]] > b->done_ns[last]) )
+            last = preds[p];
+    }
+    schedbench_exec(b, es, id, priority, start, last);
+}
+
+/** Same as schedbench_run(), the predecessors are [first, first + nb_preds) */
+static inline void schedbench_run_range(schedbench_t *b, parsec_execution_stream_t *es,
+                                        int id, int priority, int first, int nb_preds)
+{
+    uint64_t start = schedbench_now();
+    int p, last = -1;
+
+    for( p = first; p < first + nb_preds; p++ ) {
+        if( (last < 0) || (b->done_ns[p] > b->done_ns[last]) )
+            last = p;
+    }
+    schedbench_exec(b, es, id, priority, start, last);
+}
+
+/**
+ * Constructors of the DAG shapes. All the tasks run on the rank that owns
+ * A(0).
+ *
+ * @param [IN] A     the data, already distributed and allocated
+ * @param [IN] b     the measures, allocated with enough room for all the tasks
+ * @param [IN] width the maximal number of tasks that can run concurrently
+ * @param [IN] depth the length of the DAG
+ *
+ * @return the parsec object to schedule.
+ */
+typedef parsec_taskpool_t *(*schedbench_new_t)(parsec_data_collection_t *A, schedbench_t *b, int width, int depth);
+
+/** Chains: width independent chains of depth tasks */
+parsec_taskpool_t *schedbench_chain_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth);
+/** Fan-out/fan-in: depth stages, a single task spawns width tasks, that a single task joins */
+parsec_taskpool_t *schedbench_fanout_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth);
+/** Binary trees: depth broadcast then reduction trees of width leaves (rounded down to a power of 2) */
+parsec_taskpool_t *schedbench_btree_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth);
+/** Random DAG: depth levels of width tasks, each task depends on two random tasks of the previous level */
+parsec_taskpool_t *schedbench_rdag_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth);
+/** Priority inversion: a high priority chain of depth tasks, each releasing width low priority tasks */
+parsec_taskpool_t *schedbench_prio_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth);
+
+/** Number of tasks of the shapes */
+int schedbench_chain_nb_tasks(int width, int depth);
+int schedbench_fanout_nb_tasks(int width, int depth);
+int schedbench_btree_nb_tasks(int width, int depth);
+int schedbench_rdag_nb_tasks(int width, int depth);
+int schedbench_prio_nb_tasks(int width, int depth);
+
+#endif
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+##
+# Run the scheduler benchmark (schedbench) with each scheduler.
+#
+# schedbench runs a set of DAG shapes (chains, fan-out/fan-in, binary trees,
+# random DAGs, priority inversion) with the scheduler selected by the MCA
+# parameters. This script runs it once per scheduler, and gathers the CSV
+# lines of all the runs (tasks/s, ready-to-exec latency percentiles and
+# steal counts) in a single report. With -m, the median of the runs of each
+# shape and scheduler is reported instead of every run.
+#
+# By default, all the schedulers built with PaRSEC (the MCA_sched list of the
+# CMake cache of the build directory) are compared.
+#
+# Usage: schedbench.py [-b build_dir] [-s sched,...] [-c cores] [-o report.csv]
+#                      [-m] [-- schedbench options]
+##
+
+import argparse
+import csv
+import io
+import os
+import statistics
+import subprocess
+import sys
+
+METRICS = ["time_s", "tasks_per_s", "lat_p50_us", "lat_p99_us", "hp_lat_p99_us", "steals"]
+
+
+def built_schedulers(build_dir):
+    cache = os.path.join(build_dir, "CMakeCache.txt")
+    with open(cache) as f:
+        for line in f:
+            if line.startswith("MCA_sched:"):
+                value = line.rstrip("\n").split("=", 1)[1]
+                return [s for s in value.split(";") if s]
+    raise RuntimeError("no MCA_sched list in %s" % cache)
+
+
+def run(binary, argv, sched, cores):
+    env = dict(os.environ)
+    env["PARSEC_MCA_mca_sched"] = sched
+    if cores > 0:
+        env["PARSEC_MCA_runtime_num_cores"] = str(cores)
+    proc = subprocess.run([binary] + argv, env=env,
+                          stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if proc.returncode != 0:
+        sys.stderr.write(proc.stderr.decode(errors="replace"))
+        raise RuntimeError("%s failed with scheduler %s (exit code %d)" %
+                           (binary, sched, proc.returncode))
+    return list(csv.DictReader(io.StringIO(proc.stdout.decode())))
+
+
+def median_rows(rows):
+    groups = {}
+    for row in rows:
+        groups.setdefault((row["shape"], row["sched"]), []).append(row)
+    for runs in groups.values():
+        row = dict(runs[0])
+        row["run"] = "median"
+        for m in METRICS:
+            values = [float(r[m]) for r in runs if r[m] != ""]
+            row[m] = "%g" % statistics.median(values) if values else ""
+        yield row
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("-b", "--build-dir", default=".",
+                        help="PaRSEC build directory (default: current directory)")
+    parser.add_argument("-s", "--schedulers", default=None,
+                        help="comma-separated list of schedulers (default: all the built ones)")
+    parser.add_argument("-c", "--cores", type=int, default=0,
+                        help="number of cores given to the runtime (default: all)")
+    parser.add_argument("-o", "--output", default=None,
+                        help="CSV report (default: standard output)")
+    parser.add_argument("-m", "--median", action="store_true",
+                        help="report the median of the runs instead of each run")
+    parser.add_argument("options", nargs=argparse.REMAINDER,
+                        help="options given to schedbench (after --)")
+    args = parser.parse_args()
+
+    binary = os.path.join(args.build_dir, "tests/runtime/scheduling/schedbench")
+    if not os.access(binary, os.X_OK):
+        sys.stderr.write("%s not found\n" % binary)
+        return 1
+    # argparse keeps the "--" that starts the remainder, the next ones are
+    # for schedbench (its own separator before the PaRSEC arguments)
+    options = args.options[1:] if args.options[:1] == ["--"] else args.options
+    scheds = args.schedulers.split(",") if args.schedulers else built_schedulers(args.build_dir)
+
+    rows = []
+    for sched in scheds:
+        rows += run(binary, options, sched, args.cores)
+    if args.median:
+        rows = list(median_rows(rows))
+    if not rows:
+        return 0
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.DictWriter(out, fieldnames=list(rows[0].keys()))
+    writer.writeheader()
+    writer.writerows(rows)
+    if args.output:
+        out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ */
+
+#include "parsec/runtime.h"
+#include <stdio.h>
+
+#include "parsec/data_distribution.h"
+#include "parsec/arena.h"
+
+#include "schedbench.h"
+#include "chain.h"
+#include "fanout.h"
+#include "btree.h"
+#include "rdag.h"
+#include "prio.h"
+
+#if defined(PARSEC_HAVE_MPI)
+/* The datatype is irrelevant as the shapes do not do communications between nodes */
+static void schedbench_adt_construct(parsec_arena_datatype_t *adt)
+{
+    MPI_Aint extent;
+#if defined(PARSEC_HAVE_MPI_20)
+    MPI_Aint lb = 0;
+    MPI_Type_get_extent(MPI_BYTE, &lb, &extent);
+#else
+    MPI_Type_extent(MPI_BYTE, &extent);
+#endif  /* defined(PARSEC_HAVE_MPI_20) */
+    parsec_arena_datatype_construct(adt, extent, PARSEC_ARENA_ALIGNMENT_SSE, MPI_BYTE);
+}
+#define SCHEDBENCH_ADT_CONSTRUCT(tp, name) \
+    schedbench_adt_construct(&(tp)->arenas_datatypes[PARSEC_##name##_DEFAULT_ADT_IDX])
+#else
+#define SCHEDBENCH_ADT_CONSTRUCT(tp, name) do {} while(0)
+#endif  /* defined(PARSEC_HAVE_MPI) */
+
+/* Largest l such that 2^l <= width */
+static int schedbench_levels(int width)
+{
+    int levels = 0;
+    while( (2 << levels) <= width ) levels++;
+    return levels;
+}
+
+int schedbench_chain_nb_tasks(int width, int depth)
+{
+    return width * depth;
+}
+
+parsec_taskpool_t *schedbench_chain_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth)
+{
+    parsec_chain_taskpool_t *tp = parsec_chain_new(width, depth, A, b);
+    SCHEDBENCH_ADT_CONSTRUCT(tp, chain);
+    return (parsec_taskpool_t*)tp;
+}
+
+int schedbench_fanout_nb_tasks(int width, int depth)
+{
+    return depth * (width + 1) + 1;
+}
+
+parsec_taskpool_t *schedbench_fanout_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth)
+{
+    parsec_fanout_taskpool_t *tp = parsec_fanout_new(width, depth, A, b);
+    SCHEDBENCH_ADT_CONSTRUCT(tp, fanout);
+    return (parsec_taskpool_t*)tp;
+}
+
+int schedbench_btree_nb_tasks(int width, int depth)
+{
+    return depth * 2 * ((2 << schedbench_levels(width)) - 1);
+}
+
+parsec_taskpool_t *schedbench_btree_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth)
+{
+    parsec_btree_taskpool_t *tp = parsec_btree_new(schedbench_levels(width), depth, A, b);
+    SCHEDBENCH_ADT_CONSTRUCT(tp, btree);
+    return (parsec_taskpool_t*)tp;
+}
+
+int schedbench_rdag_nb_tasks(int width, int depth)
+{
+    return width * depth;
+}
+
+parsec_taskpool_t *schedbench_rdag_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth)
+{
+    parsec_rdag_taskpool_t *tp = parsec_rdag_new(width, depth, A, b);
+    SCHEDBENCH_ADT_CONSTRUCT(tp, rdag);
+    return (parsec_taskpool_t*)tp;
+}
+
+int schedbench_prio_nb_tasks(int width, int depth)
+{
+    return depth * (width + 1);
+}
+
+parsec_taskpool_t *schedbench_prio_new(parsec_data_collection_t *A, schedbench_t *b, int width, int depth)
+{
+    parsec_prio_taskpool_t *tp = parsec_prio_new(width, depth, A, b);
+    SCHEDBENCH_ADT_CONSTRUCT(tp, prio);
+    return (parsec_taskpool_t*)tp;
+}